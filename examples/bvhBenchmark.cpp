@@ -0,0 +1,113 @@
+﻿#include "../ff/objects/mesh.h"
+#include "../ff/scene/scene.h"
+#include "../ff/camera/perspectiveCamera.h"
+#include "../ff/material/meshBasicMaterial.h"
+#include "../ff/geometries/boxGeometry.h"
+#include "../ff/math/frustum.h"
+#include "../ff/math/ray.h"
+#include "../ff/tools/timer.h"
+
+/// GRID * GRID * LAYERS个物体
+const uint32_t GRID = 100;
+const uint32_t LAYERS = 5;
+
+/// 每帧移动的物体数量
+const uint32_t MOVING = 500;
+
+uint32_t FRAME_COUNT = 200;
+
+/// 对比逐个物体的视景体剪裁与BVH查询的开销，不需要opengl上下文
+int main() {
+	auto boxGeometry = ff::BoxGeometry::create(1.0f, 1.0f, 1.0f);
+	auto material = ff::MeshBasicMaterial::create();
+
+	auto scene = ff::Scene::create();
+
+	std::vector<ff::Mesh::Ptr> meshes;
+	for (uint32_t i = 0; i < GRID; ++i) {
+		for (uint32_t j = 0; j < GRID; ++j) {
+			for (uint32_t k = 0; k < LAYERS; ++k) {
+				auto mesh = ff::Mesh::create(boxGeometry, material);
+				mesh->setPosition(((float)i - GRID / 2.0f) * 3.0f, (float)k * 3.0f, ((float)j - GRID / 2.0f) * 3.0f);
+
+				scene->addChild(mesh);
+				meshes.push_back(mesh);
+			}
+		}
+	}
+
+	auto camera = ff::PerspectiveCamera::create(0.1f, 100.0f, 16.0f / 9.0f, 60.0f);
+	auto frustum = ff::Frustum::create();
+
+	const auto& bvh = scene->getBVH();
+	std::vector<const ff::SceneBVH::Entry*> visible;
+	std::vector<ff::SceneBVH::RaycastHit> hits;
+
+	std::mt19937 random(7);
+	std::uniform_int_distribution<uint32_t> pick(0, (uint32_t)meshes.size() - 1);
+
+	uint64_t linearTime = 0;
+	uint64_t updateTime = 0;
+	uint64_t queryTime = 0;
+	uint64_t rayTime = 0;
+	uint64_t linearVisible = 0;
+	uint64_t bvhVisible = 0;
+	uint64_t visitedNodes = 0;
+
+	for (uint32_t frame = 0; frame < FRAME_COUNT; ++frame) {
+		const float angle = (float)frame / FRAME_COUNT * 6.2831853f;
+		camera->setPosition(0.0f, 10.0f, 0.0f);
+		camera->lookAt(glm::vec3(std::cos(angle), 10.0f, std::sin(angle)), glm::vec3(0.0f, 1.0f, 0.0f));
+
+		for (uint32_t i = 0; i < MOVING; ++i) {
+			const auto& mesh = meshes[pick(random)];
+			const auto position = mesh->getPosition();
+			mesh->setPosition(position.x, position.y, position.z + 0.1f);
+		}
+
+		scene->updateWorldMatrix(true, true);
+		camera->updateWorldMatrix(true, true);
+
+		frustum->setFromProjectionMatrix(camera->getProjectionMatrix() * camera->getWorldMatrixInverse());
+
+		/// 逐个物体变换包围球并测试
+		ff::Timer timer;
+		uint32_t count = 0;
+		for (const auto& mesh : meshes) {
+			if (frustum->intersectObject(mesh.get())) ++count;
+		}
+		linearTime += timer.elapsed_micro();
+		linearVisible += count;
+
+		timer.reset();
+		bvh->update(scene);
+		updateTime += timer.elapsed_micro();
+
+		timer.reset();
+		bvh->intersectFrustum(frustum, visible);
+		queryTime += timer.elapsed_micro();
+		bvhVisible += visible.size();
+
+		timer.reset();
+		for (uint32_t i = 0; i < 100; ++i) {
+			ff::Ray ray(camera->getWorldPosition(), glm::vec3(std::cos(angle + i * 0.01f), -0.2f, std::sin(angle + i * 0.01f)));
+			bvh->intersectRay(ray, hits);
+		}
+		rayTime += timer.elapsed_micro();
+
+		visitedNodes += bvh->getStats().mVisitedNodes;
+	}
+
+	const auto& stats = bvh->getStats();
+	std::cout << "objects: " << stats.mEntries << " nodes: " << stats.mNodes
+		<< " builds: " << stats.mBuilds << " background builds: " << stats.mBackgroundBuilds << std::endl;
+	std::cout << "linear frustum culling average: " << (double)linearTime / FRAME_COUNT << " us"
+		<< " visible: " << linearVisible / FRAME_COUNT << std::endl;
+	std::cout << "bvh update average: " << (double)updateTime / FRAME_COUNT << " us"
+		<< " query average: " << (double)queryTime / FRAME_COUNT << " us"
+		<< " visible: " << bvhVisible / FRAME_COUNT
+		<< " visited nodes: " << visitedNodes / FRAME_COUNT << std::endl;
+	std::cout << "100 ray queries average: " << (double)rayTime / FRAME_COUNT << " us" << std::endl;
+
+	return 0;
+}
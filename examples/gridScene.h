@@ -0,0 +1,83 @@
+﻿#pragma once
+#include "../ff/core/attribute.h"
+#include "../ff/core/geometry.h"
+#include "../ff/objects/mesh.h"
+#include "../ff/scene/scene.h"
+#include "../ff/camera/perspectiveCamera.h"
+#include "../ff/render/renderer.h"
+#include "../ff/material/material.h"
+#include "../ff/global/constant.h"
+#include "../ff/geometries/boxGeometry.h"
+#include "../ff/lights/directionalLight.h"
+#include "../ff/lights/ambientLight.h"
+
+/// 基准测试类示例共用的场景：grid * grid个独立的立方体Mesh铺在z = 0平面上，一个平行光与一个环境光，
+/// 以及沿z轴正对网格的透视相机；每个Mesh一次DrawCall
+struct GridScene {
+	ff::Scene::Ptr				mScene{ nullptr };
+	ff::PerspectiveCamera::Ptr	mCamera{ nullptr };
+	std::vector<ff::Mesh::Ptr>	mCubes{};
+
+	/// \brief 所有立方体绕同一个轴旋转，每一帧所有物体的worldMatrix都会变化
+	void rotate() {
+		for (auto& cube : mCubes) {
+			cube->rotateAroundAxis(glm::vec3(1.0, 1.0, 0.0), 1.0f);
+		}
+	}
+};
+
+/// \brief 创建网格场景
+/// \param grid 每行每列的立方体数量
+/// \param materials 第(i, j)个立方体使用materials[(i + j) % materials.size()]
+/// \param aspect 相机的宽高比
+/// \param cameraDistance 相机到网格平面的距离
+inline GridScene createGridScene(uint32_t grid, const std::vector<ff::Material::Ptr>& materials, float aspect, float cameraDistance) {
+	GridScene gridScene;
+
+	auto boxGeometry = ff::BoxGeometry::create(1.0, 1.0, 1.0);
+	gridScene.mScene = ff::Scene::create();
+
+	for (uint32_t i = 0; i < grid; ++i) {
+		for (uint32_t j = 0; j < grid; ++j) {
+			auto cube = ff::Mesh::create(boxGeometry, materials[(i + j) % materials.size()]);
+			cube->setPosition(((float)i - grid / 2.0f) * 1.5f, ((float)j - grid / 2.0f) * 1.5f, 0.0f);
+
+			gridScene.mScene->addChild(cube);
+			gridScene.mCubes.push_back(cube);
+		}
+	}
+
+	auto directionalLight = ff::DirectionalLight::create();
+	directionalLight->setPosition(0.0f, 0.0f, 4.0f);
+	directionalLight->lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+	auto ambientLight = ff::AmbientLight::create();
+	ambientLight->mIntensity = 0.2;
+
+	gridScene.mScene->addChild(directionalLight);
+	gridScene.mScene->addChild(ambientLight);
+
+	gridScene.mCamera = ff::PerspectiveCamera::create(0.1f, 500.0f, aspect, 60.0f);
+	gridScene.mCamera->setPosition(0.0f, 0.0f, cameraDistance);
+
+	return gridScene;
+}
+
+/// \brief 创建离屏的Renderer
+/// \param width
+/// \param height
+/// \param majorVersion 上下文的版本号，multi-draw indirect等功能需要4.3以上
+/// \param minorVersion
+inline ff::Renderer::Ptr createOffscreenRenderer(uint32_t width, uint32_t height, uint32_t majorVersion = 3, uint32_t minorVersion = 3) {
+	ff::Renderer::Descriptor rDc;
+	rDc.mWidth = width;
+	rDc.mHeight = height;
+	rDc.mOffscreen = true;
+	rDc.mContextMajorVersion = majorVersion;
+	rDc.mContextMinorVersion = minorVersion;
+
+	auto renderer = ff::Renderer::create(rDc);
+	renderer->setClearColor(0.94, 1.0, 0.94, 1.0);
+
+	return renderer;
+}
@@ -0,0 +1,98 @@
+﻿#include "../ff/core/attribute.h"
+#include "../ff/core/geometry.h"
+#include "../ff/objects/instancedMesh.h"
+#include "../ff/scene/scene.h"
+#include "../ff/camera/perspectiveCamera.h"
+#include "../ff/render/renderer.h"
+#include "../ff/material/meshPhongMaterial.h"
+#include "../ff/log/debugLog.h"
+#include "../ff/global/constant.h"
+#include "../ff/geometries/boxGeometry.h"
+#include "../ff/lights/directionalLight.h"
+#include "../ff/lights/ambientLight.h"
+
+uint32_t WIDTH = 800;
+uint32_t HEIGHT = 600;
+
+/// 一个InstancedMesh，GRID * GRID个立方体，只需要一次DrawCall
+const uint32_t GRID = 32;
+
+ff::InstancedMesh::Ptr cubes = nullptr;
+
+static void onMouseMove(double xpos, double ypos) {
+}
+
+static void onMouseAction(ff::MouseAction action) {
+}
+
+static void onKeyboardAction(KeyBoardState action) {
+}
+
+static void onResize(int width, int height) {
+}
+
+float angle = 0.0f;
+void rotateCubes() {
+	angle += 0.01f;
+
+	for (uint32_t i = 0; i < GRID; ++i) {
+		for (uint32_t j = 0; j < GRID; ++j) {
+			glm::mat4 matrix = glm::translate(glm::mat4(1.0f), glm::vec3((float)i - GRID / 2.0f, (float)j - GRID / 2.0f, 0.0f) * 1.5f);
+			matrix = glm::rotate(matrix, angle + (float)(i + j) * 0.1f, glm::vec3(1.0f, 1.0f, 0.0f));
+
+			cubes->setMatrixAt(i * GRID + j, matrix);
+		}
+	}
+}
+
+int main() {
+	auto boxGeometry = ff::BoxGeometry::create(1.0, 1.0, 1.0);
+	auto material = ff::MeshPhongMaterial::create();
+
+	cubes = ff::InstancedMesh::create(boxGeometry, material, GRID * GRID);
+	for (uint32_t i = 0; i < GRID; ++i) {
+		for (uint32_t j = 0; j < GRID; ++j) {
+			cubes->setColorAt(i * GRID + j, glm::vec3((float)i / GRID, (float)j / GRID, 1.0f));
+		}
+	}
+	rotateCubes();
+
+	auto directionalLight = ff::DirectionalLight::create();
+	directionalLight->setPosition(0.0f, 0.0f, 4.0f);
+	directionalLight->mColor = glm::vec3(1.0f, 1.0f, 1.0f);
+	directionalLight->mIntensity = 1.0;
+	directionalLight->lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+	auto ambientLight = ff::AmbientLight::create();
+	ambientLight->mColor = glm::vec3(1.0f, 1.0f, 1.0f);
+	ambientLight->mIntensity = 0.2;
+
+	auto scene = ff::Scene::create();
+	scene->addChild(cubes);
+	scene->addChild(directionalLight);
+	scene->addChild(ambientLight);
+
+	auto camera = ff::PerspectiveCamera::create(0.1f, 200.0f, (float)WIDTH / (float)(HEIGHT), 60.0f);
+	camera->setPosition(0.0f, 0.0f, 50.0f);
+
+	ff::Renderer::Descriptor rDc;
+	rDc.mWidth = WIDTH;
+	rDc.mHeight = HEIGHT;
+	ff::Renderer::Ptr renderer = ff::Renderer::create(rDc);
+	renderer->setClearColor(0.94, 1.0, 0.94, 1.0);
+
+	renderer->setMouseActionCallback(onMouseAction);
+	renderer->setKeyboardActionCallBack(onKeyboardAction);
+	renderer->setFrameSizeCallBack(onResize);
+	renderer->setMouseMoveCallBack(onMouseMove);
+
+	while (true) {
+		if (!renderer->render(scene, camera)) {
+			break;
+		}
+
+		renderer->swap();
+
+		rotateCubes();
+	}
+}
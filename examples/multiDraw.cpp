@@ -0,0 +1,40 @@
+﻿#include "../ff/material/meshPhongMaterial.h"
+#include "../ff/tools/timer.h"
+#include "gridScene.h"
+
+uint32_t WIDTH = 256;
+uint32_t HEIGHT = 256;
+
+/// GRID * GRID个独立的Mesh，对比逐个绘制与multi-draw indirect的帧时间
+const uint32_t GRID = 100;
+
+/// 每种模式渲染多少帧
+uint32_t FRAME_COUNT = 200;
+
+/// multi-draw indirect示例：离屏创建4.5上下文(Mesa llvmpipe即可运行)
+int main() {
+	/// 所有Mesh共用一个材质，整个网格可以合并为一组
+	auto gridScene = createGridScene(GRID, { ff::MeshPhongMaterial::create() }, (float)WIDTH / (float)(HEIGHT), 150.0f);
+	auto renderer = createOffscreenRenderer(WIDTH, HEIGHT, 4, 5);
+
+	for (const bool multiDraw : { false, true }) {
+		renderer->mMultiDrawIndirect = multiDraw;
+
+		ff::Timer timer;
+		for (uint32_t i = 0; i < FRAME_COUNT; ++i) {
+			renderer->render(gridScene.mScene, gridScene.mCamera);
+			renderer->swap();
+
+			gridScene.rotate();
+		}
+		glFinish();
+
+		const auto elapsed = timer.elapsed_micro();
+		const auto& pass = renderer->getRenderInfo().mPasses[ff::DriverInfo::OpaquePass];
+		std::cout << (multiDraw ? "multi-draw indirect" : "per-object draw")
+			<< " average: " << (double)elapsed / FRAME_COUNT << " us"
+			<< " opaque calls: " << pass.mCalls << " triangles: " << pass.mTriangels << std::endl;
+	}
+
+	return 0;
+}
@@ -0,0 +1,96 @@
+﻿#include "../ff/objects/mesh.h"
+#include "../ff/scene/scene.h"
+#include "../ff/camera/perspectiveCamera.h"
+#include "../ff/material/meshBasicMaterial.h"
+#include "../ff/geometries/boxGeometry.h"
+#include "../ff/tools/softwareOcclusion.h"
+#include "../ff/tools/timer.h"
+
+/// GRID * GRID栋建筑作为遮挡物，每个街区当中放置PROPS个小物体
+const uint32_t GRID = 16;
+const uint32_t PROPS = 16;
+
+const float BLOCK = 10.0f;
+
+uint32_t FRAME_COUNT = 200;
+
+/// 软件遮挡剔除的开销与剔除率，不需要opengl上下文
+/// 相机站在街道上沿着街区平移，建筑挡住了后面街区的大部分小物体
+int main() {
+	auto buildingGeometry = ff::BoxGeometry::create(BLOCK * 0.6f, 30.0f, BLOCK * 0.6f);
+	auto propGeometry = ff::BoxGeometry::create(0.5f, 0.5f, 0.5f);
+	auto material = ff::MeshBasicMaterial::create();
+
+	auto scene = ff::Scene::create();
+
+	std::vector<ff::Mesh::Ptr> buildings;
+	std::vector<ff::Mesh::Ptr> props;
+
+	std::mt19937 random(7);
+	std::uniform_real_distribution<float> offset(-BLOCK * 0.45f, BLOCK * 0.45f);
+
+	for (uint32_t i = 0; i < GRID; ++i) {
+		for (uint32_t j = 0; j < GRID; ++j) {
+			const float x = ((float)i - GRID / 2.0f) * BLOCK;
+			const float z = -(float)j * BLOCK - BLOCK;
+
+			auto building = ff::Mesh::create(buildingGeometry, material);
+			building->setPosition(x, 15.0f, z);
+			building->mOccluder = true;
+
+			scene->addChild(building);
+			buildings.push_back(building);
+
+			for (uint32_t k = 0; k < PROPS; ++k) {
+				auto prop = ff::Mesh::create(propGeometry, material);
+				prop->setPosition(x + offset(random), 0.25f, z + offset(random));
+
+				scene->addChild(prop);
+				props.push_back(prop);
+			}
+		}
+	}
+
+	auto camera = ff::PerspectiveCamera::create(0.1f, 500.0f, 16.0f / 9.0f, 60.0f);
+
+	auto occlusion = ff::SoftwareOcclusion::create();
+
+	uint64_t rasterizeTime = 0;
+	uint64_t testTime = 0;
+	uint64_t culled = 0;
+	uint64_t triangles = 0;
+
+	for (uint32_t frame = 0; frame < FRAME_COUNT; ++frame) {
+		camera->setPosition(((float)frame / FRAME_COUNT - 0.5f) * BLOCK * GRID * 0.5f, 1.7f, 0.0f);
+		scene->updateWorldMatrix(true, true);
+		camera->updateWorldMatrix(true, true);
+
+		const auto viewProjection = camera->getProjectionMatrix() * camera->getWorldMatrixInverse();
+
+		ff::Timer timer;
+		occlusion->begin(viewProjection);
+		for (const auto& building : buildings) {
+			occlusion->rasterizeOccluder(building.get());
+		}
+		occlusion->finish();
+		rasterizeTime += timer.elapsed_micro();
+
+		timer.reset();
+		for (const auto& prop : props) {
+			occlusion->isOccluded(prop.get());
+		}
+		testTime += timer.elapsed_micro();
+
+		culled += occlusion->getStats().mCulled;
+		triangles += occlusion->getStats().mTriangles;
+	}
+
+	std::cout << "software occlusion " << occlusion->getWidth() << "x" << occlusion->getHeight()
+		<< " occluders: " << buildings.size() << " triangles: " << triangles / FRAME_COUNT << std::endl;
+	std::cout << "rasterize + hi-z average: " << (double)rasterizeTime / FRAME_COUNT << " us"
+		<< " test average: " << (double)testTime / FRAME_COUNT << " us"
+		<< " per object: " << (double)testTime / FRAME_COUNT / props.size() << " us" << std::endl;
+	std::cout << "culled: " << culled / FRAME_COUNT << "/" << props.size() << std::endl;
+
+	return 0;
+}
@@ -0,0 +1,111 @@
+﻿#include "../ff/core/attribute.h"
+#include "../ff/core/geometry.h"
+#include "../ff/objects/mesh.h"
+#include "../ff/scene/scene.h"
+#include "../ff/camera/perspectiveCamera.h"
+#include "../ff/render/renderer.h"
+#include "../ff/material/meshBasicMaterial.h"
+#include "../ff/global/constant.h"
+#include "../ff/geometries/boxGeometry.h"
+#include "../ff/tools/timer.h"
+
+uint32_t WIDTH = 256;
+uint32_t HEIGHT = 256;
+
+/// 渲染多少帧用于统计帧时间
+uint32_t FRAME_COUNT = 1000;
+
+/// 离屏渲染示例：没有窗体，渲染若干帧统计平均帧时间，并将最后一帧输出为ppm缩略图
+int main() {
+	auto boxGeometry = ff::BoxGeometry::create(1.0, 1.0, 1.0);
+	auto material = ff::MeshBasicMaterial::create();
+
+	auto cube = ff::Mesh::create(boxGeometry, material);
+
+	auto scene = ff::Scene::create();
+	scene->addChild(cube);
+
+	auto camera = ff::PerspectiveCamera::create(0.1f, 100.0f, (float)WIDTH / (float)(HEIGHT), 60.0f);
+	camera->setPosition(0.0f, 0.0f, 2.0f);
+
+	ff::Renderer::Descriptor rDc;
+	rDc.mWidth = WIDTH;
+	rDc.mHeight = HEIGHT;
+	rDc.mOffscreen = true;
+	ff::Renderer::Ptr renderer = ff::Renderer::create(rDc);
+	renderer->setClearColor(0.94, 1.0, 0.94, 1.0);
+
+	/// 统计按照深度排序时的状态切换次数，用于与当前的排序布局对比
+	renderer->mSortStatistics = true;
+
+	ff::Timer timer;
+	for (uint32_t i = 0; i < FRAME_COUNT; ++i) {
+		renderer->render(scene, camera);
+		renderer->swap();
+
+		cube->rotateAroundAxis(glm::vec3(1.0, 1.0, 1.0), 0.6f);
+	}
+	glFinish();
+
+	const auto elapsed = timer.elapsed_micro();
+	std::cout << "frames: " << FRAME_COUNT << " average: " << (double)elapsed / FRAME_COUNT << " us" << std::endl;
+
+	/// 每个渲染阶段的DrawCall、三角形数量以及GPU耗时
+	const char* passNames[] = { "shadow", "background", "depthPrePass", "opaque", "transparent" };
+	const auto& info = renderer->getRenderInfo();
+	for (uint32_t i = 0; i < ff::DriverInfo::PassCount; ++i) {
+		const auto& pass = info.mPasses[i];
+		std::cout << passNames[i] << " calls: " << pass.mCalls << " triangles: " << pass.mTriangels
+			<< " gpu: " << pass.mGPUTime << " ms" << std::endl;
+	}
+
+	/// 非透明队列的状态切换次数，可以对比scene->mOpaqueSortLayout设置为StateFirst的效果
+	const auto& sorted = info.mOpaqueStateChanges;
+	const auto& depthOrder = info.mDepthOrderStateChanges;
+	std::cout << "opaque binds program: " << sorted.mPrograms << "/" << depthOrder.mPrograms
+		<< " vao: " << sorted.mVAOs << "/" << depthOrder.mVAOs
+		<< " texture: " << sorted.mTextures << "/" << depthOrder.mTextures << " (sorted/depth order)" << std::endl;
+
+	/// 本帧管线状态的变化次数以及对应的opengl调用次数
+	std::cout << "pipeline state changes: " << info.mPipelineChanges
+		<< " gl calls: " << info.mPipelineStateCalls << std::endl;
+	std::cout << "frame graph passes: " << info.mGraphPasses << " culled: " << info.mGraphCulledPasses
+		<< " transient targets: " << info.mGraphTransientTargets << " pooled: " << info.mGraphPooledTargets << std::endl;
+	std::cout << "occlusion queries: " << info.mOcclusionQueries << " culled: " << info.mOcclusionCulled
+		<< " conditional draws: " << info.mOcclusionConditionalDraws << std::endl;
+	std::cout << "software occluders: " << info.mSoftwareOccluders << " culled: " << info.mSoftwareOcclusionCulled << std::endl;
+	std::cout << "bvh refitted: " << info.mBVHRefitted << " visited nodes: " << info.mBVHVisitedNodes << std::endl;
+	std::cout << "shadow maps rendered: " << info.mShadowMapsRendered << " reused: " << info.mShadowMapsReused << std::endl;
+
+	/// 开启FF_ENABLE_PROFILER编译时，输出各个阶段的耗时分布
+	for (const auto& statistic : renderer->getProfileStatistics()) {
+		std::cout << std::string(statistic.mDepth * 2, ' ') << statistic.mName
+			<< " p50: " << statistic.mP50 << " ms"
+			<< " p95: " << statistic.mP95 << " ms"
+			<< " p99: " << statistic.mP99 << " ms" << std::endl;
+	}
+
+	/// 开启FF_ENABLE_GL_TRACE编译时，输出每个opengl入口的调用次数与冗余绑定次数
+	const auto& glTrace = renderer->getGLTrace();
+	for (uint32_t i = 0; i < glTrace.mCalls.size(); ++i) {
+		std::cout << ff::GLTrace::getInstance()->getEntryName(i) << " calls: " << glTrace.mCalls[i]
+			<< " redundant: " << glTrace.mRedundantBinds[i] << std::endl;
+	}
+
+	/// 回读默认RenderTarget中的像素，输出缩略图
+	std::vector<byte> pixels;
+	renderer->readPixels(pixels);
+
+	std::ofstream file("offscreen.ppm", std::ios::binary);
+	file << "P6\n" << WIDTH << " " << HEIGHT << "\n255\n";
+
+	/// OpenGL的像素是自下而上排列的，ppm是自上而下
+	for (int32_t y = HEIGHT - 1; y >= 0; --y) {
+		for (uint32_t x = 0; x < WIDTH; ++x) {
+			const auto pixel = &pixels[(y * WIDTH + x) * 4];
+			file.write(reinterpret_cast<const char*>(pixel), 3);
+		}
+	}
+
+	return 0;
+}
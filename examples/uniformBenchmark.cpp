@@ -0,0 +1,59 @@
+﻿#include "../ff/material/meshPhongMaterial.h"
+#include "../ff/tools/timer.h"
+#include "gridScene.h"
+
+uint32_t WIDTH = 256;
+uint32_t HEIGHT = 256;
+
+/// GRID * GRID个独立的Mesh，每个Mesh一次DrawCall
+const uint32_t GRID = 64;
+
+/// 材质数量，相邻的Mesh使用不同的材质
+const uint32_t MATERIAL_COUNT = 4;
+
+/// 每种模式渲染多少帧
+uint32_t FRAME_COUNT = 200;
+
+/// 对比UniformHandleMap与编译好的uniform表，每次DrawCall在CPU上的开销
+int main() {
+	std::vector<ff::Material::Ptr> materials;
+	for (uint32_t i = 0; i < MATERIAL_COUNT; ++i) {
+		auto material = ff::MeshPhongMaterial::create();
+		material->mShininess = 8.0f * (float)(i + 1);
+		materials.push_back(material);
+	}
+
+	auto gridScene = createGridScene(GRID, materials, (float)WIDTH / (float)(HEIGHT), 100.0f);
+	auto renderer = createOffscreenRenderer(WIDTH, HEIGHT);
+
+	for (const bool compiled : { false, true }) {
+		renderer->mCompiledUniforms = compiled;
+
+		/// 预热一帧，program的编译不计入时间
+		renderer->render(gridScene.mScene, gridScene.mCamera);
+		glFinish();
+
+		uint64_t cpuTime = 0;
+		for (uint32_t i = 0; i < FRAME_COUNT; ++i) {
+			ff::Timer timer;
+			renderer->render(gridScene.mScene, gridScene.mCamera);
+			cpuTime += timer.elapsed_micro();
+
+			renderer->swap();
+
+			gridScene.rotate();
+		}
+		glFinish();
+
+		const auto& info = renderer->getRenderInfo();
+		const auto& pass = info.mPasses[ff::DriverInfo::OpaquePass];
+		const double frameTime = (double)cpuTime / FRAME_COUNT;
+		std::cout << (compiled ? "compiled uniform table" : "UniformHandleMap")
+			<< " render() average: " << frameTime << " us"
+			<< " per draw: " << (pass.mCalls ? frameTime / pass.mCalls : 0.0) << " us"
+			<< " opaque calls: " << pass.mCalls
+			<< " glUniform issued: " << info.mUniformUploads << " skipped: " << info.mUniformSkips << std::endl;
+	}
+
+	return 0;
+}
@@ -37,9 +37,15 @@ namespace ff {
 
 		T getZ(const uint32_t& index) noexcept;
 
+		/// 将第index个顶点的全部itemSize个数据一次性设置进来
+		void setItem(const uint32_t& index, const T* values) noexcept;
+
+		/// 得到第index个顶点的数据首地址，共itemSize个数据
+		const T* getItem(const uint32_t& index) const noexcept;
+
 		auto getID() const noexcept { return mID; }
 
-		auto getData() const noexcept { return mData; }
+		auto getData() const noexcept -> const std::vector<T>& { return mData; }
 
 		auto getCount() const noexcept { return mCount; }
 
@@ -47,6 +53,9 @@ namespace ff {
 
 		bool getNeedsUpdate() const noexcept { return mNeedsUpdate; }
 
+		/// 数据每修改一次加一，不会因为上传而清除
+		auto getVersion() const noexcept -> uint32_t { return mVersion; }
+
 		void clearNeedsUpdate() noexcept { mNeedsUpdate = false; }
 
 		auto getBufferAllocType() const noexcept { return mBufferAllocType; }
@@ -71,6 +80,7 @@ namespace ff {
 		DataType		mDataType{ DataType::FloatType };							/// 记录本Attribute的数据类型float int uint
 
 		bool			mNeedsUpdate{ true };										/// 数据是否需要更新
+		uint32_t		mVersion{ 0 };												/// 数据的版本号
 		Range			mUpdateRange{};												/// 假设数组长度为300个float类型的数组，本次更新，可以只更新55-100个float数据
 	};
 
@@ -110,6 +120,7 @@ namespace ff {
 		/// 假设index = 1 itemsize=3
 		mData[index * mItemSize] = value;
 		mNeedsUpdate = true;
+		++mVersion;
 	}
 
 	template<typename T>
@@ -120,6 +131,7 @@ namespace ff {
 		/// 假设index = 1 itemsize=3
 		mData[index * mItemSize + 1] = value;
 		mNeedsUpdate = true;
+		++mVersion;
 	}
 
 	template<typename T>
@@ -130,6 +142,7 @@ namespace ff {
 		/// 假设index = 1 itemsize=3
 		mData[index * mItemSize + 2] = value;
 		mNeedsUpdate = true;
+		++mVersion;
 	}
 
 	template<typename T>
@@ -149,4 +162,19 @@ namespace ff {
 		assert(index < mCount);
 		return mData[index * mItemSize + 2];
 	}
+
+	template<typename T>
+	void Attribute<T>::setItem(const uint32_t& index, const T* values) noexcept {
+		assert(index < mCount);
+
+		std::copy(values, values + mItemSize, mData.begin() + static_cast<size_t>(index) * mItemSize);
+		mNeedsUpdate = true;
+		++mVersion;
+	}
+
+	template<typename T>
+	const T* Attribute<T>::getItem(const uint32_t& index) const noexcept {
+		assert(index < mCount);
+		return mData.data() + static_cast<size_t>(index) * mItemSize;
+	}
 }
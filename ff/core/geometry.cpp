@@ -68,7 +68,11 @@ namespace ff {
 			mBoundingBox = Box3::create();
 		}
 
+		/// 顶点数据修改之后重新计算，不能保留之前的范围
+		mBoundingBox->makeEmpty();
 		mBoundingBox->setFromAttribute(position);
+
+		mBoundsVersion++;
 	}
 
 	void Geometry::computeBoundingSphere() noexcept {
@@ -37,7 +37,7 @@ namespace ff {
 
 		ID getID() const noexcept;
 
-		auto getIndex() const noexcept { return mIndexAttribute; }
+		auto getIndex() const noexcept -> const Attributei::Ptr& { return mIndexAttribute; }
 
 		void computeBoundingBox() noexcept;
 
@@ -45,6 +45,10 @@ namespace ff {
 
 		Sphere::Ptr getBoundingSphere() const noexcept { return mBoundingSphere; }
 		Box3::Ptr getBoundingBox() const noexcept { return mBoundingBox; }
+
+		/// \brief 包围体的版本号，每次重新计算包围盒或包围球都会增加，物体据此判断缓存的世界包围体是否过期
+		/// \return 
+		auto getBoundsVersion() const noexcept -> uint32_t { return mBoundsVersion; }
 		
 	protected:
 		ID	mID{ 0 };								/// 全局唯一id
@@ -53,5 +57,6 @@ namespace ff {
 
 		Box3::Ptr	mBoundingBox{ nullptr };		/// 包围盒
 		Sphere::Ptr	mBoundingSphere{ nullptr };		/// 包围球
+		uint32_t	mBoundsVersion{ 0 };			/// 包围体的版本号
 	};
 }
\ No newline at end of file
@@ -1,4 +1,5 @@
 ﻿#include "object3D.h"
+#include "../objects/renderableObject.h"
 #include "../tools/identity.h"
 #include "../global/eventDispatcher.h"
 
@@ -169,6 +170,9 @@ namespace ff
 	auto Object3D::setWorldMatrix(const glm::mat4& worldMatrix) noexcept -> void
 	{
 		mWorldMatrix = worldMatrix;
+		mWorldMatrixVersion++;
+
+		markBoundsDirty();
 	}
 
 	auto Object3D::updateMatrix() noexcept -> void
@@ -198,13 +202,27 @@ namespace ff
 		updateMatrix();
 
 		/// 初始化worldMatrix，如果没有父节点，那么二者相等
-		mWorldMatrix = mLocalMatrix;
+		auto worldMatrix = mLocalMatrix;
 
 		/// 如果有父节点，那么需要做成父节点的worldMatrix，从而把上方所有节点的影响带入
 		if (!mParent.expired())
 		{
 			auto parent = mParent.lock();
-			mWorldMatrix = parent->mWorldMatrix * mWorldMatrix;
+			worldMatrix = parent->mWorldMatrix * worldMatrix;
+		}
+
+		/// 只有worldMatrix真正发生变化的时候，才更新版本号，常驻渲染列表依靠版本号判断物体是否移动过
+		if (worldMatrix != mWorldMatrix)
+		{
+			mWorldMatrix = worldMatrix;
+			mWorldMatrixVersion++;
+
+			markBoundsDirty();
+		}
+		/// 原地重新计算了geometry的包围体，子树剪裁会先于物体本身访问祖先的包围盒，所以在每帧的矩阵更新时就要发现
+		else if (mIsRenderableObject && static_cast<RenderableObject*>(this)->isGeometryBoundsChanged())
+		{
+			markBoundsDirty();
 		}
 
 		/// 依次更新子节点的worldMatrix
@@ -270,17 +288,17 @@ namespace ff
 		return mLocalMatrix;
 	}
 
-	auto Object3D::getWorldMatrix() const noexcept -> glm::mat4
+	auto Object3D::getWorldMatrix() const noexcept -> const glm::mat4&
 	{
 		return mWorldMatrix;
 	}
 
-	glm::mat4 Object3D::getModelViewMatrix() const noexcept
+	auto Object3D::getModelViewMatrix() const noexcept -> const glm::mat4&
 	{
 		return mModelViewMatrix;
 	}
 
-	auto Object3D::getNormalMatrix() const noexcept -> glm::mat3
+	auto Object3D::getNormalMatrix() const noexcept -> const glm::mat3&
 	{
 		return mNormalMatrix;
 	}
@@ -302,10 +320,93 @@ namespace ff
 		}
 
 		mChildren.push_back(child);
+		markHierarchyChanged();
+		markBoundsDirty();
 
 		return true;
 	}
 
+	auto Object3D::removeChild(const Object3D::Ptr& child) noexcept -> bool
+	{
+		auto iter = std::find(mChildren.begin(), mChildren.end(), child);
+		if (iter == mChildren.end())
+		{
+			return false;
+		}
+
+		mChildren.erase(iter);
+		child->mParent.reset();
+		markHierarchyChanged();
+		markBoundsDirty();
+
+		return true;
+	}
+
+	/// 自己以及所有的祖先节点的层级版本号都会增加，所以只需要检查场景根节点，就能知道整棵树是否发生过变化
+	auto Object3D::markHierarchyChanged() noexcept -> void
+	{
+		mHierarchyVersion++;
+
+		auto parent = mParent.lock();
+		while (parent != nullptr)
+		{
+			parent->mHierarchyVersion++;
+			parent = parent->mParent.lock();
+		}
+	}
+
+	/// 向上标记，遇到已经为脏的节点就停止，它的祖先节点一定也已经为脏
+	auto Object3D::markBoundsDirty() noexcept -> void
+	{
+		mBoundsDirty = true;
+
+		if (mSubtreeBoundsDirty)
+		{
+			return;
+		}
+		mSubtreeBoundsDirty = true;
+
+		auto parent = mParent.lock();
+		while (parent != nullptr && !parent->mSubtreeBoundsDirty)
+		{
+			parent->mSubtreeBoundsDirty = true;
+			parent = parent->mParent.lock();
+		}
+	}
+
+	auto Object3D::getSubtreeBoundingBox() noexcept -> const Box3&
+	{
+		if (!mSubtreeBoundsDirty)
+		{
+			return mSubtreeBoundingBox;
+		}
+
+		mSubtreeBoundingBox.makeEmpty();
+		mSubtreeCullable = !mIsLight && !mIsSkinnedMesh;
+
+		if (mIsRenderableObject)
+		{
+			mSubtreeBoundingBox.expandByBox(static_cast<RenderableObject*>(this)->getWorldBoundingBox());
+		}
+
+		for (const auto& child : mChildren)
+		{
+			mSubtreeBoundingBox.expandByBox(child->getSubtreeBoundingBox());
+			mSubtreeCullable = mSubtreeCullable && child->mSubtreeCullable;
+		}
+
+		mSubtreeBoundsDirty = false;
+
+		return mSubtreeBoundingBox;
+	}
+
+	auto Object3D::isSubtreeCullable() noexcept -> bool
+	{
+		getSubtreeBoundingBox();
+
+		return mSubtreeCullable;
+	}
+
 	auto Object3D::getChildren() const noexcept -> const std::vector<Object3D::Ptr>&
 	{
 		return mChildren;
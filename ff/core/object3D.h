@@ -1,5 +1,6 @@
 ﻿#pragma once
 #include "../global/base.h"
+#include "../math/box3.h"
 
 namespace ff
 {
@@ -9,6 +10,8 @@ namespace ff
 		bool mIsRenderableObject{false};
 		bool mIsMesh{false};
 		bool mIsSkinnedMesh{false};
+		bool mIsInstancedMesh{false};
+		bool mIsStaticBatchMesh{false};
 		bool mIsBone{false};
 		bool mIsScene{false};
 		bool mIsCamera{false};
@@ -18,6 +21,7 @@ namespace ff
 		bool mIsLight{false};
 		bool mIsAmbientLight{false};
 		bool mIsDirectionalLight{false};
+		bool mIsLOD{false};
 	};
 
 	/// Object3D是所有空间变换、节点结构等的最基础的类型
@@ -107,6 +111,11 @@ namespace ff
 		/// return 防止重复加入和把自己也加进去
 		auto addChild(const Object3D::Ptr& child) noexcept -> bool;
 
+		/// \brief 从当前的Object3D里面，移除子节点
+		/// \param child 子节点
+		/// return 是否确实是本节点的子节点
+		auto removeChild(const Object3D::Ptr& child) noexcept -> bool;
+
 		/// \brief 更新Object3D 的模型坐标系
 		virtual auto updateMatrix() noexcept -> void;
 
@@ -155,15 +164,15 @@ namespace ff
 
 		/// \brief 获得当前OBJ3D的世界坐标系
 		/// \return 
-		auto getWorldMatrix() const noexcept -> glm::mat4;
+		auto getWorldMatrix() const noexcept -> const glm::mat4&;
 
 		/// \brief 获得当前OBJ3D的摄像机坐标系
 		/// \return 
-		auto getModelViewMatrix() const noexcept -> glm::mat4;
+		auto getModelViewMatrix() const noexcept -> const glm::mat4&;
 
 		/// \brief 获得当前OBJ3D的normal矩阵
 		/// \return 
-		auto getNormalMatrix() const noexcept -> glm::mat3;
+		auto getNormalMatrix() const noexcept -> const glm::mat3&;
 
 		/// \brief 获得当前OBJ3D的所有的子节点
 		/// \return 
@@ -173,10 +182,34 @@ namespace ff
 		/// \return 
 		auto getID() const noexcept -> ID;
 
+		/// \brief 获得worldMatrix的版本号，每当worldMatrix发生变化都会增加
+		/// \return 
+		auto getWorldMatrixVersion() const noexcept -> uint32_t { return mWorldMatrixVersion; }
+
+		/// \brief 获得层级结构的版本号，本节点以及任意子孙节点加入或者移除子节点，都会增加
+		/// \return 
+		auto getHierarchyVersion() const noexcept -> uint32_t { return mHierarchyVersion; }
+
+		/// \brief 本节点的包围体需要重新计算，同时标记所有祖先节点的子树包围盒
+		/// worldMatrix的变化、加入移除子节点、InstancedMesh修改实例以及geometry重新计算包围体(在下一次updateWorldMatrix时发现)都会自动调用
+		auto markBoundsDirty() noexcept -> void;
+
+		/// \brief 本节点以及所有子孙可渲染物体在世界空间的轴对齐包围盒，只有被标记过的子树才会重新合并；
+		/// 不区分可见性，子树当中没有可渲染物体时为空
+		/// \return 
+		auto getSubtreeBoundingBox() noexcept -> const Box3&;
+
+		/// \brief 子树是否可以用子树包围盒整体剪裁：灯光与骨骼动画即使不在视景体之内，每帧也需要处理
+		/// \return 
+		auto isSubtreeCullable() noexcept -> bool;
+
 	protected:
 		/// \brief从localMatrix中分解出平移 、旋转、缩放 矩阵 
 		auto decompose() noexcept -> void;
 
+		/// \brief 层级结构发生变化，增加本节点以及所有祖先节点的层级版本号
+		auto markHierarchyChanged() noexcept -> void;
+
 	public:
 		/// visible来表示是否对其进行渲染
 		bool mVisible{true};
@@ -207,9 +240,20 @@ namespace ff
 		/// worldMatrix将模型顶点从模型坐标系，转换到世界坐标系
 		glm::mat4 mWorldMatrix = glm::mat4(1.0f);
 
+		/// worldMatrix以及层级结构的版本号
+		uint32_t mWorldMatrixVersion{0};
+		uint32_t mHierarchyVersion{0};
+
 		/// 保留参数
 		bool mNeedsUpdate{false};
 
+		/// 本节点自己的包围体是否需要重新计算(见RenderableObject)，以及子树包围盒是否需要重新合并
+		/// 一个节点的子树包围盒为脏，则其所有祖先节点也一定为脏
+		mutable bool mBoundsDirty{true};
+		bool mSubtreeBoundsDirty{true};
+		Box3 mSubtreeBoundingBox{};
+		bool mSubtreeCullable{true};
+
 		/// 节点系统
 		/// 父节点采用weakPtr ，防止循环引用
 		std::weak_ptr<Object3D> mParent;
@@ -422,6 +422,7 @@ namespace ff {
 		LessOrEqual,
 		Bigger,
 		BiggerOrEqual,
+		Equal,
 		None
 	};
 
@@ -437,6 +438,8 @@ namespace ff {
 			return GL_LEQUAL;
 		case CompareFunction::BiggerOrEqual:
 			return GL_GEQUAL;
+		case CompareFunction::Equal:
+			return GL_EQUAL;
 		default:
 			return GL_NONE;
 		}
@@ -464,6 +467,15 @@ namespace ff {
 		}
 	}
 
+	/// 渲染列表的排序键布局
+	/// 每个renderItem被打包为一个64位的排序键，从高位到低位依次比较
+	enum class RenderSortLayout
+	{
+		SmallerZFirst,	/// groupOrder | 深度(由近到远) | program | material | geometry，非透明物体使用，利于earlyZ
+		BiggerZFirst,	/// groupOrder | 深度(由远到近) | program | material | geometry，透明物体使用，保证颜色混合正确
+		StateFirst		/// groupOrder | program | material | geometry | 粗粒度深度(由近到远)，非透明物体使用，减少状态切换
+	};
+
 	/// attributes
 	static const std::unordered_map<std::string, uint32_t>  LOCATION_MAP = 
 {
@@ -474,7 +486,9 @@ namespace ff {
 		{"skinIndex", 4},
 		{"skinWeight", 5},
 		{"tangent", 6},
-		{"bitangent", 7}
+		{"bitangent", 7},
+		{"instanceMatrix", 8},		/// mat4占用8 9 10 11四个location
+		{"instanceColor", 12}
 	};
 
 }
\ No newline at end of file
@@ -39,7 +39,13 @@ namespace ff {
 		glm::vec2				mFrameExtent = glm::vec2(1.0, 1.0);
 		std::vector<glm::vec4>	mViewports = { glm::vec4(0.0f, 0.0f, 1.0f, 1.0f) };
 
-		RenderTarget::Ptr		mRenderTarget{ nullptr }; /// 当前的ShadowMap所对应的渲染目标,ShadowMap就放在了他的ColorAttachment
+		RenderTarget::Ptr		mRenderTarget{ nullptr }; /// 当前的ShadowMap所对应的渲染目标,ShadowMap就放在了他的ColorAttachment；由Renderer的FrameGraph每帧分配，显存可能与其他临时目标共用；开启缓存时为DriverShadowMap持有的常驻目标
+
+		/// 光源、阴影相机以及光源视景体内投射阴影的物体都没有变化时，沿用上一帧的ShadowMap
+		bool					mCacheEnabled{ true };
+
+		/// 缓存察觉不到的变化，置为true强制重新绘制一次，绘制之后自动清除
+		bool					mNeedsUpdate{ false };
 
 		/// 1 将物体的顶点，从世界坐标系，转化到光源摄像机的投影坐标系内（NDC坐标组-还没有除以w）
 		/// 2 projectionMatrix * viewMatrix（光源相机）
@@ -38,6 +38,7 @@ namespace ff {
 		bool		mNeedsUpdate{ true };
 
 		/// version 用于首次解析
+		/// raster、blending、depth参数在后端编译为管线状态并缓存，第一次绘制之后再修改它们，需要将version加一
 		uint32_t	mVersion{ 1 };
 
 		/// raster
@@ -63,6 +64,9 @@ namespace ff {
 		CompareFunction mDepthFunction{ CompareFunction::LessOrEqual };
 		double mDepthClearColor{ 1.0 };
 
+		/// 是否写入颜色，关闭之后只影响深度(与模板)
+		bool mColorWrite{ true };
+
 		/// diffuse
 		Texture::Ptr	mDiffuseMap{ nullptr };
 
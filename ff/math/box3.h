@@ -33,11 +33,46 @@ namespace ff {
 			}
 		}
 
-		bool isEmpty() noexcept {
+		/// 清空为无效的包围盒，之后可以重新扩展
+		void makeEmpty() noexcept {
+			mMin = glm::vec3(std::numeric_limits<float>::infinity());
+			mMax = glm::vec3(-std::numeric_limits<float>::infinity());
+		}
+
+		/// 扩展包围盒，使之包含point
+		void expandByPoint(const glm::vec3& point) noexcept {
+			mMin = glm::min(mMin, point);
+			mMax = glm::max(mMax, point);
+		}
+
+		/// 扩展包围盒，使之包含另一个包围盒，空的包围盒不产生影响
+		void expandByBox(const Box3& box) noexcept {
+			mMin = glm::min(mMin, box.mMin);
+			mMax = glm::max(mMax, box.mMax);
+		}
+
+		/// 将局部空间的包围盒box的八个顶点变换到世界空间，重新求轴对齐包围盒
+		void setFromTransformedBox(const Box3& box, const glm::mat4& matrix) noexcept {
+			makeEmpty();
+			if (box.isEmpty()) {
+				return;
+			}
+
+			for (uint32_t i = 0; i < 8; ++i) {
+				const glm::vec3 corner(
+					(i & 1) ? box.mMax.x : box.mMin.x,
+					(i & 2) ? box.mMax.y : box.mMin.y,
+					(i & 4) ? box.mMax.z : box.mMin.z);
+
+				expandByPoint(glm::vec3(matrix * glm::vec4(corner, 1.0f)));
+			}
+		}
+
+		bool isEmpty() const noexcept {
 			return (mMax.x < mMin.x || mMax.y < mMin.y || mMax.z < mMin.z);
 		}
 
-		glm::vec3 getCenter() noexcept {
+		glm::vec3 getCenter() const noexcept {
 			if (isEmpty()) {
 				return glm::vec3(0.0f);
 			}
@@ -3,6 +3,7 @@
 #include "plane.h"
 #include "sphere.h"
 #include "../objects/renderableObject.h"
+#include "../objects/instancedMesh.h"
 
 namespace ff {
 
@@ -14,7 +15,6 @@ namespace ff {
 		}
 
 		Frustum() noexcept {
-			mToolSphere = Sphere::create(glm::vec3(0.0f), 0.0f);
 			for (uint32_t i = 0; i < 6; ++i) {
 				mPlanes.push_back(Plane::create(glm::vec3(0.0f), 0.0f));
 			}
@@ -37,19 +37,20 @@ namespace ff {
 		/// \brief OBJ3D是否在视景体内
 		/// \param object OBJ3D
 		/// \return 
-		auto intersectObject(const RenderableObject::Ptr& object) const noexcept -> bool
+		auto intersectObject(const RenderableObject* object) const noexcept -> bool
 		{
-			auto geometry = object->getGeometry();
-
-			if (geometry->getBoundingSphere() == nullptr) {
-				geometry->computeBoundingSphere();
-			}
-
+			/// 物体缓存了世界空间的包围球(InstancedMesh的包围球包含所有实例)，只有变换或者geometry发生变化时才重新计算
+			return intersectSphere(object->getWorldBoundingSphere());
+		}
 
-			mToolSphere->copy(geometry->getBoundingSphere());
-			mToolSphere->applyMatrix4(object->getWorldMatrix());
+		/// \brief 以子树包围盒判断整棵子树是否可能在视景体内
+		/// \param object 
+		/// \return 
+		auto intersectSubtree(Object3D* object) const noexcept -> bool
+		{
+			const auto& box = object->getSubtreeBoundingBox();
 
-			return intersectSphere(mToolSphere);
+			return !box.isEmpty() && intersectBox(box.mMin, box.mMax);
 		}
 
 		/// \brief 判断包围球是否与视景体相交 
@@ -57,8 +58,16 @@ namespace ff {
 		/// \return 
 		auto intersectSphere(const Sphere::Ptr& sphere) const noexcept -> bool
 		{
-			auto center = sphere->mCenter;
-			auto radius = sphere->mRadius;
+			return intersectSphere(*sphere);
+		}
+
+		/// \brief 判断包围球是否与视景体相交 
+		/// \param sphere 
+		/// \return 
+		auto intersectSphere(const Sphere& sphere) const noexcept -> bool
+		{
+			auto center = sphere.mCenter;
+			auto radius = sphere.mRadius;
 
 			for (uint32_t i = 0; i < 6; ++i) {
 				/// 1 计算包围球的球心到当前平面的距离
@@ -76,8 +85,49 @@ namespace ff {
 			return true;
 		}
 
+		/// \brief 判断轴对齐包围盒是否与视景体相交，只取每个平面法线方向上最远的那个顶点判断
+		/// \param min 
+		/// \param max 
+		/// \return 
+		auto intersectBox(const glm::vec3& min, const glm::vec3& max) const noexcept -> bool
+		{
+			for (uint32_t i = 0; i < 6; ++i) {
+				const auto& normal = mPlanes[i]->mNormal;
+				const glm::vec3 farthest(
+					normal.x >= 0.0f ? max.x : min.x,
+					normal.y >= 0.0f ? max.y : min.y,
+					normal.z >= 0.0f ? max.z : min.z);
+
+				if (mPlanes[i]->distanceToPoint(farthest) < 0.0f) {
+					return false;
+				}
+			}
+
+			return true;
+		}
+
+		/// \brief 判断轴对齐包围盒是否完全在视景体之内，只取每个平面法线反方向上最远的那个顶点判断
+		/// \param min 
+		/// \param max 
+		/// \return 
+		auto containsBox(const glm::vec3& min, const glm::vec3& max) const noexcept -> bool
+		{
+			for (uint32_t i = 0; i < 6; ++i) {
+				const auto& normal = mPlanes[i]->mNormal;
+				const glm::vec3 nearest(
+					normal.x >= 0.0f ? min.x : max.x,
+					normal.y >= 0.0f ? min.y : max.y,
+					normal.z >= 0.0f ? min.z : max.z);
+
+				if (mPlanes[i]->distanceToPoint(nearest) < 0.0f) {
+					return false;
+				}
+			}
+
+			return true;
+		}
+
 	private:
 		std::vector<Plane::Ptr> mPlanes{};
-		Sphere::Ptr mToolSphere{ nullptr };
 	};
 }
\ No newline at end of file
@@ -0,0 +1,84 @@
+﻿#pragma once
+
+#include "../global/base.h"
+
+namespace ff {
+
+	/// 射线：origin + t * direction，t >= 0
+	class Ray {
+	public:
+		using Ptr = std::shared_ptr<Ray>;
+		static Ptr create(const glm::vec3& origin, const glm::vec3& direction) {
+			return std::make_shared<Ray>(origin, direction);
+		}
+
+		Ray(const glm::vec3& origin, const glm::vec3& direction) noexcept {
+			set(origin, direction);
+		}
+
+		~Ray() noexcept {}
+
+		/// \brief 设置射线，方向会被归一化，t即为到起点的距离
+		/// \param origin
+		/// \param direction
+		auto set(const glm::vec3& origin, const glm::vec3& direction) noexcept -> void
+		{
+			mOrigin = origin;
+			mDirection = glm::normalize(direction);
+		}
+
+		/// \brief 射线上距离起点为t的点
+		/// \param t
+		/// \return
+		auto at(float t) const noexcept -> glm::vec3
+		{
+			return mOrigin + mDirection * t;
+		}
+
+		/// \brief 由ndc坐标生成拾取射线，起点在近平面上
+		/// \param ndc 鼠标位置的ndc坐标，[-1,1]
+		/// \param inverseViewProjection (投影矩阵*视图矩阵)的逆矩阵
+		auto setFromNDC(const glm::vec2& ndc, const glm::mat4& inverseViewProjection) noexcept -> void
+		{
+			auto nearPoint = inverseViewProjection * glm::vec4(ndc, -1.0f, 1.0f);
+			auto farPoint = inverseViewProjection * glm::vec4(ndc, 1.0f, 1.0f);
+
+			nearPoint /= nearPoint.w;
+			farPoint /= farPoint.w;
+
+			set(glm::vec3(nearPoint), glm::vec3(farPoint - nearPoint));
+		}
+
+		/// \brief 与轴对齐包围盒求交(slab方法)
+		/// \param min
+		/// \param max
+		/// \param distance 相交时输出进入包围盒的距离，起点在包围盒之内时为0
+		/// \return
+		auto intersectBox(const glm::vec3& min, const glm::vec3& max, float& distance) const noexcept -> bool
+		{
+			/// 方向分量为0时得到正负无穷，比较的结果依然正确
+			const glm::vec3 inverseDirection = 1.0f / mDirection;
+
+			const glm::vec3 t0 = (min - mOrigin) * inverseDirection;
+			const glm::vec3 t1 = (max - mOrigin) * inverseDirection;
+
+			const glm::vec3 tNear = glm::min(t0, t1);
+			const glm::vec3 tFar = glm::max(t0, t1);
+
+			const float enter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+			const float exit = std::min(std::min(tFar.x, tFar.y), tFar.z);
+
+			if (enter > exit) {
+				return false;
+			}
+
+			distance = enter;
+
+			return true;
+		}
+
+	public:
+		glm::vec3	mOrigin = glm::vec3(0.0f);
+		glm::vec3	mDirection = glm::vec3(0.0f, 0.0f, -1.0f);
+	};
+}
@@ -17,6 +17,7 @@ namespace ff {
 		~Group() noexcept {}
 
 		/// bigger first
+		/// 取值范围为[0, DriverRenderList::MAX_GROUP_ORDER(255)]，更大的值在排序时按照255处理
 		uint32_t mGroupOrder{ 0 };
 	};
 }
\ No newline at end of file
@@ -0,0 +1,104 @@
+﻿#include "instancedMesh.h"
+#include <limits>
+
+namespace ff {
+
+	InstancedMesh::InstancedMesh(const Geometry::Ptr& geometry, const Material::Ptr& material, uint32_t count) noexcept:
+		Mesh(geometry, material) {
+		mIsInstancedMesh = true;
+
+		mCapacity = count;
+		mCount = count;
+
+		/// 默认每个实例都是单位矩阵
+		std::vector<float> matrices(static_cast<size_t>(count) * 16, 0.0f);
+		for (uint32_t i = 0; i < count; ++i) {
+			const auto offset = static_cast<size_t>(i) * 16;
+			matrices[offset + 0] = 1.0f;
+			matrices[offset + 5] = 1.0f;
+			matrices[offset + 10] = 1.0f;
+			matrices[offset + 15] = 1.0f;
+		}
+
+		mInstanceMatrix = Attributef::create(matrices, 16, BufferAllocType::DynamicDrawBuffer);
+		mBoundingSphere = Sphere::create(glm::vec3(0.0f), 0.0f);
+	}
+
+	InstancedMesh::~InstancedMesh() noexcept {}
+
+	auto InstancedMesh::setMatrixAt(uint32_t index, const glm::mat4& matrix) noexcept -> void {
+		mInstanceMatrix->setItem(index, glm::value_ptr(matrix));
+		mBoundingSphereNeedsUpdate = true;
+		markBoundsDirty();
+	}
+
+	auto InstancedMesh::getMatrixAt(uint32_t index) const noexcept -> glm::mat4 {
+		return glm::make_mat4(mInstanceMatrix->getItem(index));
+	}
+
+	auto InstancedMesh::setColorAt(uint32_t index, const glm::vec3& color) noexcept -> void {
+		if (mInstanceColor == nullptr) {
+			/// 默认颜色为白色，与不使用实例颜色时的效果一致
+			std::vector<float> colors(static_cast<size_t>(mCapacity) * 3, 1.0f);
+			mInstanceColor = Attributef::create(colors, 3, BufferAllocType::DynamicDrawBuffer);
+		}
+
+		mInstanceColor->setItem(index, glm::value_ptr(color));
+	}
+
+	auto InstancedMesh::setCount(uint32_t count) noexcept -> void {
+		mCount = std::min(count, mCapacity);
+		mBoundingSphereNeedsUpdate = true;
+		markBoundsDirty();
+	}
+
+	/// 1 将geometry的包围球变换到每一个实例上
+	/// 2 先求所有实例包围球的包围盒中心作为球心，再求能够包含所有实例包围球的最小半径
+	auto InstancedMesh::computeBoundingSphere() const noexcept -> void {
+		mBoundingSphereNeedsUpdate = false;
+
+		if (mGeometry->getBoundingSphere() == nullptr) {
+			mGeometry->computeBoundingSphere();
+		}
+
+		const auto& geometrySphere = mGeometry->getBoundingSphere();
+
+		if (mCount == 0) {
+			mBoundingSphere->copy(geometrySphere);
+			return;
+		}
+
+		auto instanceSphere = Sphere::create(glm::vec3(0.0f), 0.0f);
+
+		glm::vec3 minPoint(std::numeric_limits<float>::max());
+		glm::vec3 maxPoint(std::numeric_limits<float>::lowest());
+		for (uint32_t i = 0; i < mCount; ++i) {
+			instanceSphere->copy(geometrySphere);
+			instanceSphere->applyMatrix4(getMatrixAt(i));
+
+			minPoint = glm::min(minPoint, instanceSphere->mCenter - glm::vec3(instanceSphere->mRadius));
+			maxPoint = glm::max(maxPoint, instanceSphere->mCenter + glm::vec3(instanceSphere->mRadius));
+		}
+
+		const auto center = (minPoint + maxPoint) * 0.5f;
+
+		float radius = 0.0f;
+		for (uint32_t i = 0; i < mCount; ++i) {
+			instanceSphere->copy(geometrySphere);
+			instanceSphere->applyMatrix4(getMatrixAt(i));
+
+			radius = std::max(radius, glm::length(instanceSphere->mCenter - center) + instanceSphere->mRadius);
+		}
+
+		mBoundingSphere->mCenter = center;
+		mBoundingSphere->mRadius = radius;
+	}
+
+	auto InstancedMesh::getBoundingSphere() const noexcept -> const Sphere::Ptr& {
+		if (mBoundingSphereNeedsUpdate) {
+			computeBoundingSphere();
+		}
+
+		return mBoundingSphere;
+	}
+}
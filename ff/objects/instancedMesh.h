@@ -0,0 +1,71 @@
+﻿#pragma once
+#include "../global/base.h"
+#include "../math/sphere.h"
+#include "mesh.h"
+
+namespace ff {
+
+	/// 实例化绘制的Mesh，同一个geometry+material绘制count份，每一份拥有自己的变换矩阵(以及可选的颜色)
+	/// 1 实例矩阵以及实例颜色作为divisor为1的顶点属性上传，整个InstancedMesh只需要一次DrawCall
+	/// 2 实例矩阵是相对于本物体模型坐标系的变换，最终的世界矩阵为 worldMatrix * instanceMatrix
+	/// 3 修改了实例矩阵之后，数据会在下一帧自动上传，包围球也会重新计算
+	class InstancedMesh :public Mesh {
+	public:
+		using Ptr = std::shared_ptr<InstancedMesh>;
+		static Ptr create(const Geometry::Ptr& geometry, const Material::Ptr& material, uint32_t count) {
+			return std::make_shared<InstancedMesh>(geometry, material, count);
+		}
+
+		InstancedMesh(const Geometry::Ptr& geometry, const Material::Ptr& material, uint32_t count) noexcept;
+
+		~InstancedMesh() noexcept;
+
+		/// \brief 设置第index个实例的变换矩阵
+		/// \param index
+		/// \param matrix
+		auto setMatrixAt(uint32_t index, const glm::mat4& matrix) noexcept -> void;
+
+		/// \brief 获得第index个实例的变换矩阵
+		/// \param index
+		/// \return
+		auto getMatrixAt(uint32_t index) const noexcept -> glm::mat4;
+
+		/// \brief 设置第index个实例的颜色，第一次调用时才会创建实例颜色属性
+		/// \param index
+		/// \param color
+		auto setColorAt(uint32_t index, const glm::vec3& color) noexcept -> void;
+
+		/// \brief 设置实际绘制的实例数量，不能超过创建时给出的数量
+		/// \param count
+		auto setCount(uint32_t count) noexcept -> void;
+
+		auto getCount() const noexcept -> uint32_t { return mCount; }
+
+		auto getCapacity() const noexcept -> uint32_t { return mCapacity; }
+
+		auto getInstanceMatrix() const noexcept -> const Attributef::Ptr& { return mInstanceMatrix; }
+
+		auto getInstanceColor() const noexcept -> const Attributef::Ptr& { return mInstanceColor; }
+
+		/// \brief 计算包含所有实例的包围球(模型坐标系下)
+		auto computeBoundingSphere() const noexcept -> void;
+
+		/// \brief 获得包含所有实例的包围球，实例矩阵变化之后会重新计算
+		/// \return
+		auto getBoundingSphere() const noexcept -> const Sphere::Ptr&;
+
+	private:
+		/// 实例总数以及实际绘制的数量
+		uint32_t			mCapacity{ 0 };
+		uint32_t			mCount{ 0 };
+
+		/// 每个实例16个float，即一个mat4
+		Attributef::Ptr		mInstanceMatrix{ nullptr };
+
+		/// 每个实例3个float
+		Attributef::Ptr		mInstanceColor{ nullptr };
+
+		Sphere::Ptr			mBoundingSphere{ nullptr };
+		mutable bool		mBoundingSphereNeedsUpdate{ true };
+	};
+}
@@ -0,0 +1,107 @@
+﻿#include "lod.h"
+
+namespace ff {
+
+	LOD::LOD(Metric metric) noexcept {
+		mIsLOD = true;
+		mMetric = metric;
+
+		EventDispatcher::getInstance()->addEventListener("objectDispose", this, &LOD::onObjectDispose);
+	}
+
+	LOD::~LOD() noexcept {
+		EventDispatcher::getInstance()->removeEventListener("objectDispose", this, &LOD::onObjectDispose);
+	}
+
+	auto LOD::onObjectDispose(const EventBase::Ptr& event) -> void {
+		const auto object = static_cast<Object3D*>(event->mTarget);
+
+		/// 只有相机会被记录，其余物体找不到
+		mCurrentLevels.erase(object->getID());
+	}
+
+	auto LOD::addLevel(const Object3D::Ptr& object, float threshold) noexcept -> void {
+		Level level;
+		level.mObject = object;
+		level.mThreshold = threshold;
+
+		/// Distance阈值递增，ScreenSize阈值递减，都是越往后越粗糙
+		const bool byDistance = mMetric == Metric::Distance;
+		auto iter = std::upper_bound(mLevels.begin(), mLevels.end(), threshold, [byDistance](float value, const Level& other) {
+			return byDistance ? value < other.mThreshold : value > other.mThreshold;
+		});
+		mLevels.insert(iter, level);
+
+		addChild(object);
+
+		/// 层级的下标发生了变化，之前的选择结果作废
+		mCurrentLevels.clear();
+	}
+
+	auto LOD::getBoundary(uint32_t level) const noexcept -> float {
+		const float threshold = mLevels[level].mThreshold;
+		if (mMetric == Metric::Distance) {
+			return threshold;
+		}
+
+		/// 屏幕尺寸越小越粗糙，取倒数
+		return 1.0f / std::max(threshold, 1e-6f);
+	}
+
+	auto LOD::select(const Camera* camera) noexcept -> uint32_t {
+		if (mLevels.empty()) {
+			return 0;
+		}
+
+		auto& current = mCurrentLevels[camera->getID()];
+
+		/// 以最精细层级的包围盒作为整个LOD的包围体
+		const auto& box = mLevels[0].mObject->getSubtreeBoundingBox();
+		const glm::vec3 center = box.isEmpty() ? getWorldPosition() : box.getCenter();
+		const float radius = box.isEmpty() ? 0.0f : glm::length(box.mMax - box.mMin) * 0.5f;
+
+		const float distance = glm::length(camera->getWorldPosition() - center);
+
+		float metric = distance;
+		if (mMetric == Metric::ScreenSize) {
+			/// projectionMatrix[1][1]：透视投影为cot(fov / 2)，正交投影为2 / (top - bottom)
+			const float scale = camera->getProjectionMatrix()[1][1];
+			const float size = camera->mIsOrthographicCamera
+				? radius * scale
+				: radius * scale / std::max(distance, 1e-6f);
+
+			metric = 1.0f / std::max(size, 1e-6f);
+		}
+
+		uint32_t level = 0;
+		for (uint32_t i = 1; i < mLevels.size(); ++i) {
+			const float boundary = getBoundary(i) * (i > current ? 1.0f + mHysteresis : 1.0f - mHysteresis);
+			if (metric < boundary) {
+				break;
+			}
+
+			level = i;
+		}
+
+		current = level;
+
+		return level;
+	}
+
+	auto LOD::getCurrentLevel(const Camera* camera) const noexcept -> uint32_t {
+		const auto iter = mCurrentLevels.find(camera->getID());
+		if (iter == mCurrentLevels.end()) {
+			return 0;
+		}
+
+		return std::min(iter->second, static_cast<uint32_t>(mLevels.size()) - 1);
+	}
+
+	auto LOD::getShadowLevel(const Camera* camera) const noexcept -> uint32_t {
+		if (mLevels.empty()) {
+			return 0;
+		}
+
+		return std::min(getCurrentLevel(camera) + mShadowLevelBias, static_cast<uint32_t>(mLevels.size()) - 1);
+	}
+}
@@ -0,0 +1,81 @@
+﻿#pragma once
+#include "../global/base.h"
+#include "../core/object3D.h"
+#include "../camera/camera.h"
+#include "../global/eventDispatcher.h"
+
+namespace ff {
+
+	/// 离散LOD：持有若干个细节层级，每一帧对每个相机只选择其中一个层级绘制
+	/// 1 Distance：相机到第0层级包围盒中心的距离不小于某一层级的阈值，就使用该层级，阈值由近到远递增
+	/// 2 ScreenSize：第0层级包围球投影到屏幕上的半径(占半个视口高度的比例，1为恰好充满屏幕)小于某一层级的阈值，就使用该层级，阈值由大到小递减
+	/// 3 mHysteresis：切换到更粗糙的层级时阈值放宽(1 + h)倍，切换回更精细的层级时收紧(1 - h)倍，避免在阈值附近来回跳变
+	/// 4 阴影使用本相机所选层级之后第mShadowLevelBias个层级，阴影贴图分辨率有限，不需要与主相机相同的细节
+	/// 层级物体作为LOD的子节点加入，不要再通过addChild向LOD加入其他子节点；常驻渲染列表与BVH模式下不支持LOD的嵌套
+	class LOD :public Object3D {
+	public:
+		enum class Metric {
+			Distance,
+			ScreenSize
+		};
+
+		struct Level {
+			Object3D::Ptr	mObject{ nullptr };
+			float			mThreshold{ 0.0f };
+		};
+
+		using Ptr = std::shared_ptr<LOD>;
+		static Ptr create(Metric metric = Metric::Distance) {
+			return std::make_shared<LOD>(metric);
+		}
+
+		LOD(Metric metric) noexcept;
+
+		~LOD() noexcept;
+
+		/// \brief 加入一个层级，按照阈值排序；第0层级的阈值不起作用
+		/// \param object
+		/// \param threshold Distance模式下为距离，ScreenSize模式下为屏幕尺寸
+		auto addLevel(const Object3D::Ptr& object, float threshold) noexcept -> void;
+
+		/// \brief 为相机选择本帧的层级，并记录下来用于之后的滞后判断，调用之前worldMatrix需要是最新的
+		/// \param camera
+		/// \return 层级的下标
+		auto select(const Camera* camera) noexcept -> uint32_t;
+
+		/// \brief 相机最近一次选择的层级，没有选择过时为0
+		/// \param camera
+		/// \return
+		auto getCurrentLevel(const Camera* camera) const noexcept -> uint32_t;
+
+		/// \brief 绘制阴影使用的层级
+		/// \param camera 主相机
+		/// \return
+		auto getShadowLevel(const Camera* camera) const noexcept -> uint32_t;
+
+		auto getLevels() const noexcept -> const std::vector<Level>& { return mLevels; }
+
+		auto getMetric() const noexcept -> Metric { return mMetric; }
+
+		/// \brief 相机析构时移除其记录的层级，阴影、立方体贴图等临时相机不会让记录无限增长
+		auto onObjectDispose(const EventBase::Ptr& event) -> void;
+
+	public:
+		/// 切换层级的滞后比例，0为不滞后
+		float		mHysteresis{ 0.0f };
+
+		/// 阴影比主相机粗糙多少个层级
+		uint32_t	mShadowLevelBias{ 1 };
+
+	private:
+		/// \brief 层级i与更精细层级的分界，统一成越大越粗糙的度量
+		auto getBoundary(uint32_t level) const noexcept -> float;
+
+	private:
+		Metric				mMetric{ Metric::Distance };
+		std::vector<Level>	mLevels{};
+
+		/// 每个相机当前的层级，相机析构时移除
+		std::unordered_map<ID, uint32_t>	mCurrentLevels{};
+	};
+}
@@ -1,4 +1,5 @@
 ﻿#include "renderableObject.h"
+#include "instancedMesh.h"
 
 namespace ff {
 
@@ -11,6 +12,71 @@ namespace ff {
 
 	RenderableObject::~RenderableObject() noexcept {}
 
+	auto RenderableObject::getWorldBoundingSphere() const noexcept -> const Sphere& {
+		updateWorldBounds();
+
+		return mWorldBoundingSphere;
+	}
+
+	auto RenderableObject::getWorldBoundingBox() const noexcept -> const Box3& {
+		updateWorldBounds();
+
+		return mWorldBoundingBox;
+	}
+
+	auto RenderableObject::updateWorldBounds() const noexcept -> void {
+		if (mGeometry->getBoundingSphere() == nullptr) {
+			mGeometry->computeBoundingSphere();
+		}
+
+		if (!mBoundsDirty
+			&& mWorldBoundsMatrixVersion == mWorldMatrixVersion
+			&& mWorldBoundsGeometryVersion == mGeometry->getBoundsVersion()) {
+			return;
+		}
+
+		/// geometry的包围体变了，祖先节点缓存的子树包围盒同样过期；只有缓存被修改，所以这里去掉const
+		if (isGeometryBoundsChanged()) {
+			const_cast<RenderableObject*>(this)->markBoundsDirty();
+		}
+
+		mBoundsDirty = false;
+		mWorldBoundsMatrixVersion = mWorldMatrixVersion;
+		mWorldBoundsGeometryVersion = mGeometry->getBoundsVersion();
+
+		/// InstancedMesh的包围球包含了所有实例，包围盒由包围球得到
+		if (mIsInstancedMesh) {
+			const auto& sphere = static_cast<const InstancedMesh*>(this)->getBoundingSphere();
+
+			mWorldBoundingSphere.copy(sphere);
+			mWorldBoundingSphere.applyMatrix4(mWorldMatrix);
+
+			mWorldBoundingBox.makeEmpty();
+			mWorldBoundingBox.expandByPoint(mWorldBoundingSphere.mCenter - glm::vec3(mWorldBoundingSphere.mRadius));
+			mWorldBoundingBox.expandByPoint(mWorldBoundingSphere.mCenter + glm::vec3(mWorldBoundingSphere.mRadius));
+
+			return;
+		}
+
+		/// 没有position的geometry没有包围体，退化为世界坐标的一个点
+		const auto& sphere = mGeometry->getBoundingSphere();
+		const auto& box = mGeometry->getBoundingBox();
+		if (sphere == nullptr || box == nullptr || box->isEmpty()) {
+			mWorldBoundingSphere.mCenter = glm::vec3(mWorldMatrix[3]);
+			mWorldBoundingSphere.mRadius = 0.0f;
+
+			mWorldBoundingBox.makeEmpty();
+			mWorldBoundingBox.expandByPoint(mWorldBoundingSphere.mCenter);
+
+			return;
+		}
+
+		mWorldBoundingSphere.copy(sphere);
+		mWorldBoundingSphere.applyMatrix4(mWorldMatrix);
+
+		mWorldBoundingBox.setFromTransformedBox(*box, mWorldMatrix);
+	}
+
 	auto RenderableObject::onBeforeRender(Renderer* renderer, Scene* scene, Camera* camera) const -> void
 	{
 		if (mOnBeforeRenderCallback) {
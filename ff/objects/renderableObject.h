@@ -28,11 +28,22 @@ namespace ff {
 
 		/// \brief 获得可渲染物体的 Geometry
 		/// \return 
-		auto getGeometry() const noexcept { return mGeometry; }
+		auto getGeometry() const noexcept -> const Geometry::Ptr& { return mGeometry; }
 
 		/// \brief 获得可渲染物体的 Material
 		/// \return 
-		auto getMaterial() const noexcept { return mMaterial; }
+		auto getMaterial() const noexcept -> const Material::Ptr& { return mMaterial; }
+
+		/// \brief 世界空间的包围球，缓存下来，只有worldMatrix、geometry的包围体发生变化或者markBoundsDirty之后才重新计算
+		/// \return 
+		auto getWorldBoundingSphere() const noexcept -> const Sphere&;
+
+		/// \brief 世界空间的轴对齐包围盒，与包围球一同缓存
+		/// \return 
+		auto getWorldBoundingBox() const noexcept -> const Box3&;
+
+		/// \brief geometry的包围体在上一次计算世界包围体之后是否重新计算过
+		auto isGeometryBoundsChanged() const noexcept -> bool { return mWorldBoundsGeometryVersion != mGeometry->getBoundsVersion(); }
 
 		
 		/// \brief 在本物体渲染前，会调用本函数，允许用户指定渲染前做哪些处理
@@ -45,8 +56,34 @@ namespace ff {
 		/// 在本可绘制物体，进行渲染之前，会回调这个函数进行通知
 		OnBeforeRenderCallback mOnBeforeRenderCallback{ nullptr };
 
+		/// 标记为静态物体，永远不会移动，可以被StaticBatcher合并
+		bool mStatic{ false };
+
+		/// 已经被StaticBatcher合并，由合并之后的StaticBatchMesh代为绘制，本物体只保留用于拾取等用途
+		bool mStaticBatched{ false };
+
+		/// 参与硬件遮挡剔除：绘制之后用包围盒发出遮挡查询，查询结果为被遮挡时，之后的帧跳过本物体的绘制
+		/// 适合在视景体之内经常被墙体等大物体挡住、自身绘制开销又比较大的物体(见DriverOcclusion)
+		bool mOcclusionCulling{ false };
+
+		/// 作为软件遮挡剔除的遮挡物，光栅化进CPU的深度缓冲(见SoftwareOcclusion)，适合墙体、大型建筑等大而简单的物体
+		bool mOccluder{ false };
+
+		/// 光栅化遮挡物时使用的简化geometry，需要完全被原geometry包住，否则会误剔除；为nullptr时使用原geometry
+		Geometry::Ptr mOccluderGeometry{ nullptr };
+
+	private:
+		auto updateWorldBounds() const noexcept -> void;
+
 	protected:
 		Geometry::Ptr mGeometry{ nullptr };
 		Material::Ptr mMaterial{ nullptr };
+
+	private:
+		/// 世界空间的包围体，以及计算时的worldMatrix版本号与geometry包围体版本号
+		mutable Sphere		mWorldBoundingSphere{ glm::vec3(0.0f), 0.0f };
+		mutable Box3		mWorldBoundingBox{};
+		mutable uint32_t	mWorldBoundsMatrixVersion{ 0 };
+		mutable uint32_t	mWorldBoundsGeometryVersion{ 0 };
 	};
 }
\ No newline at end of file
@@ -5,11 +5,7 @@ namespace ff {
 	Skeleton::Skeleton(const std::vector<Bone::Ptr>& bones, const std::vector<glm::mat4>& offsetMatrices) noexcept {
 		mBones = bones;
 		mOffsetMatrices = offsetMatrices;
-
-		UniformHandle boneMatricesUniform;
-		boneMatricesUniform.mValue = std::vector<glm::mat4>();
-
-		mUniforms["boneMatrices"] = boneMatricesUniform;
+		mBoneMatrices.reserve(bones.size());
 	}
 
 	Skeleton::~Skeleton() noexcept {}
@@ -26,13 +22,10 @@ namespace ff {
 
 	//call after scene->updateWorldMatrix
 	void Skeleton::update() noexcept {
-		auto& boneMatricesUniform = mUniforms["boneMatrices"];
-		boneMatricesUniform.mNeedsUpdate = true;
-		clearPureArrayUniform(std::any_cast<std::vector<glm::mat4>>(&boneMatricesUniform.mValue));
+		mBoneMatrices.clear();
 
 		for (uint32_t i = 0; i < mBones.size(); ++i) {
-			auto matrix = mBones[i]->getWorldMatrix() * mOffsetMatrices[i];
-			pushPureArrayUniform(matrix, std::any_cast<std::vector<glm::mat4>>(&boneMatricesUniform.mValue));
+			mBoneMatrices.push_back(mBones[i]->getWorldMatrix() * mOffsetMatrices[i]);
 		}
 	}
 }
\ No newline at end of file
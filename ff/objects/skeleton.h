@@ -26,6 +26,7 @@ namespace ff {
 		std::vector<Bone::Ptr> mBones{};
 		std::vector<glm::mat4> mOffsetMatrices{};
 
-		UniformHandleMap mUniforms{};
+		/// ÿ֡update֮Ĺ󣬼shaderеboneMatrices
+		std::vector<glm::mat4> mBoneMatrices{};
 	};
 }
\ No newline at end of file
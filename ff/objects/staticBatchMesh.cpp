@@ -0,0 +1,65 @@
+﻿#include "staticBatchMesh.h"
+
+namespace ff {
+
+	StaticBatchMesh::StaticBatchMesh(const Geometry::Ptr& geometry, const Material::Ptr& material) noexcept:
+		Mesh(geometry, material) {
+		mIsStaticBatchMesh = true;
+	}
+
+	StaticBatchMesh::~StaticBatchMesh() noexcept {}
+
+	auto StaticBatchMesh::addRange(
+		const RenderableObject::Ptr& source,
+		uint32_t indexOffset,
+		uint32_t indexCount,
+		const Sphere::Ptr& boundingSphere) noexcept -> void {
+		Range range;
+		range.mIndexOffset = indexOffset;
+		range.mIndexCount = indexCount;
+		range.mBoundingSphere = boundingSphere;
+		range.mSource = source;
+
+		mRanges.push_back(range);
+	}
+
+	auto StaticBatchMesh::cull(const Frustum::Ptr& frustum, uint32_t frame) noexcept -> uint32_t {
+		if (mCulledFrustum == frustum.get() && mCulledFrame == frame) {
+			return mVisibleCount;
+		}
+
+		mVisibleCount = cull(frustum);
+		mCulledFrustum = frustum.get();
+		mCulledFrame = frame;
+
+		return mVisibleCount;
+	}
+
+	auto StaticBatchMesh::cull(const Frustum::Ptr& frustum) noexcept -> uint32_t {
+		mCulledFrustum = nullptr;
+
+		mDrawCounts.clear();
+		mDrawOffsets.clear();
+
+		uint32_t visibleCount = 0;
+
+		/// 上一段可见区间的结束位置，子区间在index数组当中首尾相接，连续可见的子区间可以合并为一段
+		uint32_t lastEnd = 0;
+		for (const auto& range : mRanges) {
+			if (!frustum->intersectSphere(range.mBoundingSphere)) continue;
+
+			if (!mDrawCounts.empty() && lastEnd == range.mIndexOffset) {
+				mDrawCounts.back() += static_cast<GLsizei>(range.mIndexCount);
+			}
+			else {
+				mDrawCounts.push_back(static_cast<GLsizei>(range.mIndexCount));
+				mDrawOffsets.push_back(reinterpret_cast<const void*>(static_cast<size_t>(range.mIndexOffset) * sizeof(uint32_t)));
+			}
+
+			lastEnd = range.mIndexOffset + range.mIndexCount;
+			visibleCount += range.mIndexCount;
+		}
+
+		return visibleCount;
+	}
+}
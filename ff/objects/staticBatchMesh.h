@@ -0,0 +1,74 @@
+﻿#pragma once
+#include "../global/base.h"
+#include "../math/sphere.h"
+#include "../math/frustum.h"
+#include "mesh.h"
+
+namespace ff {
+
+	/// StaticBatcher合并之后的Mesh，顶点已经变换到世界坐标系，本身的worldMatrix应保持单位矩阵
+	/// 1 每个源物体在合并之后的index数组当中占据一段连续的子区间，并且记录了其世界坐标系下的包围球
+	/// 2 每次绘制之前，对各个子区间分别进行视景体剪裁，可见的子区间使用一次glMultiDrawElements绘制；
+	///   相机的视景体每帧只剪裁一次，深度预渲染与正式绘制共用结果
+	/// 3 源物体本身的mVisible变化不会影响合并之后的绘制，需要重新合并
+	class StaticBatchMesh :public Mesh {
+	public:
+		struct Range {
+			uint32_t		mIndexOffset{ 0 };		/// 在index数组当中的起始位置（个数，不是字节）
+			uint32_t		mIndexCount{ 0 };
+			Sphere::Ptr		mBoundingSphere{ nullptr };	/// 世界坐标系下的包围球
+
+			/// 源物体，不持有所有权，只用于拾取等用途
+			std::weak_ptr<RenderableObject> mSource{};
+		};
+
+		using Ptr = std::shared_ptr<StaticBatchMesh>;
+		static Ptr create(const Geometry::Ptr& geometry, const Material::Ptr& material) {
+			return std::make_shared<StaticBatchMesh>(geometry, material);
+		}
+
+		StaticBatchMesh(const Geometry::Ptr& geometry, const Material::Ptr& material) noexcept;
+
+		~StaticBatchMesh() noexcept;
+
+		/// \brief 加入一个源物体对应的子区间
+		/// \param source
+		/// \param indexOffset
+		/// \param indexCount
+		/// \param boundingSphere 世界坐标系下的包围球
+		auto addRange(
+			const RenderableObject::Ptr& source,
+			uint32_t indexOffset,
+			uint32_t indexCount,
+			const Sphere::Ptr& boundingSphere) noexcept -> void;
+
+		auto getRanges() const noexcept -> const std::vector<Range>& { return mRanges; }
+
+		/// \brief 对各个子区间进行视景体剪裁，结果供紧随其后的一次绘制使用，相邻的可见子区间会被合并
+		/// \param frustum
+		/// \return 可见的index数量，为0则不需要绘制
+		auto cull(const Frustum::Ptr& frustum) noexcept -> uint32_t;
+
+		/// \brief 同一帧之内使用同一个视景体时只剪裁一次，之后直接返回上一次的结果(深度预渲染与正式绘制共用)
+		/// \param frustum
+		/// \param frame 渲染器的帧号，每次render递增
+		/// \return 可见的index数量，为0则不需要绘制
+		auto cull(const Frustum::Ptr& frustum, uint32_t frame) noexcept -> uint32_t;
+
+		/// \brief 上一次cull之后，需要绘制的各段index数量以及字节偏移，直接用于glMultiDrawElements
+		auto getDrawCounts() const noexcept -> const std::vector<GLsizei>& { return mDrawCounts; }
+
+		auto getDrawOffsets() const noexcept -> const std::vector<const void*>& { return mDrawOffsets; }
+
+	private:
+		std::vector<Range>			mRanges{};
+
+		std::vector<GLsizei>		mDrawCounts{};
+		std::vector<const void*>	mDrawOffsets{};
+
+		/// 当前剪裁结果所对应的视景体与帧号，不带帧号的cull会使其失效
+		const Frustum*	mCulledFrustum{ nullptr };
+		uint32_t		mCulledFrame{ 0 };
+		uint32_t		mVisibleCount{ 0 };
+	};
+}
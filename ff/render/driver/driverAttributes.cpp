@@ -1,4 +1,5 @@
 ﻿#include "driverAttributes.h"
+#include "../../wrapper/glTrace.h"
 
 namespace ff {
 
@@ -6,7 +7,7 @@ namespace ff {
 
 		DriverAttribute::~DriverAttribute() noexcept {
 			if (mHandle) {
-				glDeleteBuffers(1, &mHandle);
+				FF_GL(glDeleteBuffers, 1, &mHandle);
 			}
 		}
 
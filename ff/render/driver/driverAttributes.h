@@ -2,6 +2,7 @@
 #include "../../global/base.h"
 #include "../../core/attribute.h"
 #include "../../global/eventDispatcher.h"
+#include "../../wrapper/glTrace.h"
 
 namespace ff {
 
@@ -92,17 +93,17 @@ namespace ff {
 			dattribute = DriverAttribute::create();
 
 			/// 拿到Attribute里面的数据
-			auto data = attribute->getData();
+			const auto& data = attribute->getData();
 
 			/// 为本Attribute对应的D riverAttribute生成VBO 并且更新数据
-			glGenBuffers(1, &dattribute->mHandle);
+			FF_GL(glGenBuffers, 1, &dattribute->mHandle);
 
 			/// bufferType要么是GL_ARRAY_BUFFER 要么是 GL_ELEMENT_ARRAY_BUFFER
-			glBindBuffer(toGL(bufferType), dattribute->mHandle);
+			FF_GL_BIND(glBindBuffer, toGL(bufferType), dattribute->mHandle);
 
 			/// VBO内存开辟，以及VBO 数据的灌入
-			glBufferData(toGL(bufferType), data.size() * sizeof(T), data.data(), toGL(attribute->getBufferAllocType()));
-			glBindBuffer(toGL(bufferType), 0);
+			FF_GL(glBufferData, toGL(bufferType), data.size() * sizeof(T), data.data(), toGL(attribute->getBufferAllocType()));
+			FF_GL_BIND(glBindBuffer, toGL(bufferType), 0);
 
 			mAttributes.insert(std::make_pair(attribute->getID(), dattribute));
 
@@ -117,14 +118,14 @@ namespace ff {
 
 			/// 获取更新的offset以及Count
 			auto updateRange = attribute->getUpdateRange();
-			auto data = attribute->getData();
+			const auto& data = attribute->getData();
 
 			/// 绑定当前VBO
-			glBindBuffer(toGL(bufferType), dattribute->mHandle);
+			FF_GL_BIND(glBindBuffer, toGL(bufferType), dattribute->mHandle);
 
 			/// 如果用户确实指定的更新的Range
 			if (updateRange.mCount > 0) {
-				glBufferSubData(
+				FF_GL(glBufferSubData,
 					toGL(bufferType),
 					updateRange.mOffset * sizeof(T),
 					updateRange.mCount * sizeof(T),
@@ -132,9 +133,9 @@ namespace ff {
 			}
 			/// 如果用户没有指定的更新的Range，则更新整个VBO
 			else {
-				glBufferData(toGL(bufferType), data.size() * sizeof(T), data.data(), toGL(attribute->getBufferAllocType()));
+				FF_GL(glBufferData, toGL(bufferType), data.size() * sizeof(T), data.data(), toGL(attribute->getBufferAllocType()));
 			}
-			glBindBuffer(toGL(bufferType), 0);
+			FF_GL_BIND(glBindBuffer, toGL(bufferType), 0);
 
 			attribute->clearUpdateRange();
 		}
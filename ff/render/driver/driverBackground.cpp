@@ -13,7 +13,7 @@ namespace ff
 
 	DriverBackground::DriverBackground(Renderer* renderer, const DriverObjects::Ptr& objects) noexcept
 	{
-		mRenderer = renderer;ff\render\driver\driverShadowMap.cpp
+		mRenderer = renderer;
 
 		mObjects = objects;
 	}
@@ -60,9 +60,9 @@ namespace ff
 			};
 
 			/// 在这里要单独对这个mesh进行一次解析，创建其VBO等
-			mObjects->update(mBoxMesh);
+			mObjects->update(mBoxMesh.get());
 		}
 
-		renderList->push(mBoxMesh, mBoxMesh->getGeometry(), mBoxMesh->getMaterial(), 0, 0);
+		renderList->push(mBoxMesh.get(), mBoxMesh->getGeometry().get(), mBoxMesh->getMaterial().get(), 0, 0);
 	}
 }
@@ -1,5 +1,7 @@
 ﻿#include "driverBindingState.h"
 #include "../../core/geometry.h"
+#include "../../tools/profiler.h"
+#include "../../wrapper/glTrace.h"
 
 namespace ff {
 
@@ -7,48 +9,67 @@ namespace ff {
 
 	DriverBindingState::~DriverBindingState() noexcept {
 		if (mVAO) {
-			glDeleteVertexArrays(1, &mVAO);
+			FF_GL(glDeleteVertexArrays, 1, &mVAO);
 		}
 	}
 
 	DriverBindingStates::DriverBindingStates(const DriverAttributes::Ptr& attributes) {
 		mAttributes = attributes;
+
+		EventDispatcher::getInstance()->addEventListener("objectDispose", this, &DriverBindingStates::onObjectDispose);
 	}
 
-	DriverBindingStates::~DriverBindingStates() {}
+	DriverBindingStates::~DriverBindingStates() {
+		EventDispatcher::getInstance()->removeEventListener("objectDispose", this, &DriverBindingStates::onObjectDispose);
+	}
 
 	/// 寻找当前geometry是否曾经生成过一个DriverBindingState，如果没有，则新生成一个，否则把以往的交回去
-	auto DriverBindingStates::getBindingState(const Geometry::Ptr& geometry) noexcept -> DriverBindingState::Ptr
+	auto DriverBindingStates::getBindingState(const Geometry* geometry) noexcept -> const DriverBindingState::Ptr&
 	{
-		DriverBindingState::Ptr state = nullptr;
-
 		auto gKeyIter = mBindingStates.find(geometry->getID());
 		if (gKeyIter == mBindingStates.end()) {
 			gKeyIter = mBindingStates.insert(std::make_pair(geometry->getID(), createBindingState(createVao()))).first;
 		}
 	
-		state = gKeyIter->second;
+		return gKeyIter->second;
+	}
 
-		return state;
+	/// 实例attribute属于InstancedMesh本身，即使两个InstancedMesh共享geometry，也不能共享VAO
+	auto DriverBindingStates::getInstancedBindingState(const InstancedMesh* object) noexcept -> const DriverBindingState::Ptr&
+	{
+		auto oKeyIter = mInstancedBindingStates.find(object->getID());
+		if (oKeyIter == mInstancedBindingStates.end()) {
+			oKeyIter = mInstancedBindingStates.insert(std::make_pair(object->getID(), createBindingState(createVao()))).first;
+		}
+
+		return oKeyIter->second;
 	}
 
 	auto DriverBindingStates::setup(
-		const Geometry::Ptr& geometry,
-		const Attributei::Ptr& index
+		const Geometry* geometry,
+		const Attributei::Ptr& index,
+		const RenderableObject* object
 		) -> void
 	{
+		FF_PROFILE_SCOPE("bindingStates");
+
 		bool updateBufferLayout = false;
 
+		const InstancedMesh* instancedMesh = nullptr;
+		if (object != nullptr && object->mIsInstancedMesh) {
+			instancedMesh = static_cast<const InstancedMesh*>(object);
+		}
+
 		/// 使用geometry寻找对应的DriverBindingState，如果有就给回；如果没有就重新生成，并且VAO也连带生成一个
-		auto state = getBindingState(geometry);
+		const auto& state = instancedMesh != nullptr ? getInstancedBindingState(instancedMesh) : getBindingState(geometry);
 		if (mCurrentBindingState != state) {
 			mCurrentBindingState = state;
 			bindVao(state->mVAO);
 		}
 
-		updateBufferLayout = needsUpdate(geometry, index);
+		updateBufferLayout = needsUpdate(geometry, index, instancedMesh);
 		if (updateBufferLayout) {
-			saveCache(geometry, index);
+			saveCache(geometry, index, instancedMesh);
 		}
 
 		/// 注意！这里处理了indexAttribute到DriverAttribute的对应，即EBO的创建
@@ -59,14 +80,14 @@ namespace ff {
 
 		/// 如果需要更新挂钩关系，那么就要在setupVertexAttributes里面处理
 		if (updateBufferLayout) {
-			setupVertexAttributes(geometry);
+			setupVertexAttributes(geometry, instancedMesh);
 
 			/// 如果有index 则需要进行ebo的绑定
 			if (index != nullptr) {
 				/// 从DriverAttributes里面拿出来indexAttribute对应的DriverAttribute
 				auto bkIndex = mAttributes->get(index);
 				if (bkIndex != nullptr) {
-					glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, bkIndex->mHandle);
+					FF_GL_BIND(glBindBuffer, GL_ELEMENT_ARRAY_BUFFER, bkIndex->mHandle);
 				}
 
 			}
@@ -89,19 +110,21 @@ namespace ff {
 	/// 2 geometry里面的key所对应的attribute发生了变化，即调用了setAttribute,由于同样的key更换了新的attribute
 	/// 则本Attribute会生成新的vbo，所以需要重新绑定
 
-	auto DriverBindingStates::needsUpdate(const Geometry::Ptr& geometry,
-	                                      const Attributei::Ptr& index) const noexcept -> bool
+	/// 3 InstancedMesh的实例attribute发生了变化（比如第一次调用setColorAt，新增了instanceColor）
+	auto DriverBindingStates::needsUpdate(const Geometry* geometry,
+	                                      const Attributei::Ptr& index,
+	                                      const InstancedMesh* instancedMesh) const noexcept -> bool
 	{
 		/// id->名字，value->attribute id
-		auto cachedAttributes = mCurrentBindingState->mAttributes;
+		const auto& cachedAttributes = mCurrentBindingState->mAttributes;
 
 		/// id->名字，value->attribute对象
-		auto geometryAttributes = geometry->getAttributes();
+		const auto& geometryAttributes = geometry->getAttributes();
 
 		uint32_t attributesNum = 0;
 		for (const auto& iter : geometryAttributes) {
-			auto key = iter.first;
-			auto geometryAttribute = iter.second;
+			const auto& key = iter.first;
+			const auto& geometryAttribute = iter.second;
 
 			/// 从缓存里面寻找，但凡有一个attribute没找到，说明就不一样了
 			auto cachedIter = cachedAttributes.find(key);
@@ -119,6 +142,26 @@ namespace ff {
 			attributesNum++;
 		}
 
+		if (instancedMesh != nullptr) {
+			const std::pair<std::string, const Attributef::Ptr&> instanceAttributes[] = {
+				{"instanceMatrix", instancedMesh->getInstanceMatrix()},
+				{"instanceColor", instancedMesh->getInstanceColor()},
+			};
+
+			for (const auto& [key, instanceAttribute] : instanceAttributes) {
+				if (instanceAttribute == nullptr) {
+					continue;
+				}
+
+				auto cachedIter = cachedAttributes.find(key);
+				if (cachedIter == cachedAttributes.end() || cachedIter->second != instanceAttribute->getID()) {
+					return true;
+				}
+
+				attributesNum++;
+			}
+		}
+
 		/// 举例：如果旧的geometry有3个属性，新的geometry去掉了一个，就剩下2个了
 		if (mCurrentBindingState->mAttributesNum != attributesNum) {
 			return true;
@@ -133,14 +176,15 @@ namespace ff {
 		return false;
 	}
 
-	auto DriverBindingStates::saveCache(const Geometry::Ptr& geometry,
-	                                    const Attributei::Ptr& index) const noexcept -> void
+	auto DriverBindingStates::saveCache(const Geometry* geometry,
+	                                    const Attributei::Ptr& index,
+	                                    const InstancedMesh* instancedMesh) const noexcept -> void
 	{
 		/// 首先清空掉bindingState里面的attributes （Map）
 		auto& cachedAttributes = mCurrentBindingState->mAttributes;
 		cachedAttributes.clear();
 
-		auto attributes = geometry->getAttributes();
+		const auto& attributes = geometry->getAttributes();
 		uint32_t attributesNum = 0;
 
 		/// 遍历geometry的每一个attribute
@@ -152,6 +196,18 @@ namespace ff {
 			attributesNum++;
 		}
 
+		if (instancedMesh != nullptr) {
+			if (const auto& instanceMatrix = instancedMesh->getInstanceMatrix(); instanceMatrix != nullptr) {
+				cachedAttributes.insert(std::make_pair("instanceMatrix", instanceMatrix->getID()));
+				attributesNum++;
+			}
+
+			if (const auto& instanceColor = instancedMesh->getInstanceColor(); instanceColor != nullptr) {
+				cachedAttributes.insert(std::make_pair("instanceColor", instanceColor->getID()));
+				attributesNum++;
+			}
+		}
+
 		mCurrentBindingState->mAttributesNum = attributesNum;
 
 		if (index != nullptr) {
@@ -163,9 +219,9 @@ namespace ff {
 	/// 令positionAttribute永远location = 0
 	/// 令normalAttribute永远location = 1....
 	/// 提前设计好的占坑方案
-	auto DriverBindingStates::setupVertexAttributes(const Geometry::Ptr& geometry) const noexcept -> void
+	auto DriverBindingStates::setupVertexAttributes(const Geometry* geometry, const InstancedMesh* instancedMesh) const noexcept -> void
 	{
-		const auto geometryAttributes = geometry->getAttributes();
+		const auto& geometryAttributes = geometry->getAttributes();
 		for (const auto& iter : geometryAttributes) {
 			auto name = iter.first;
 			auto attribute = iter.second;
@@ -188,12 +244,46 @@ namespace ff {
 			auto binding = bindingIter->second;
 
 			/// 开始向vao里面做挂钩关系
-			glBindBuffer(GL_ARRAY_BUFFER, bkAttribute->mHandle);
+			FF_GL_BIND(glBindBuffer, GL_ARRAY_BUFFER, bkAttribute->mHandle);
 			/// 激活对应的binding点
-			glEnableVertexAttribArray(binding);
+			FF_GL(glEnableVertexAttribArray, binding);
 			/// 非 intervalAttribute 的attribute
 			/// 向vao里面记录，对于本binding点所对应的attribute，我们应该如何从bkAttribute->mHandle一个vbo里面读取数据
-			glVertexAttribPointer(binding, itemSize, toGL(dataType), false, itemSize * toSize(dataType), (void*)0);
+			FF_GL(glVertexAttribPointer, binding, itemSize, toGL(dataType), false, itemSize * toSize(dataType), (void*)0);
+		}
+
+		if (instancedMesh != nullptr) {
+			setupInstanceAttribute(instancedMesh->getInstanceMatrix(), LOCATION_MAP.at("instanceMatrix"));
+			setupInstanceAttribute(instancedMesh->getInstanceColor(), LOCATION_MAP.at("instanceColor"));
+		}
+	}
+
+	/// 实例attribute每绘制一个实例才前进一次，即divisor = 1
+	/// 顶点属性每个location最多4个分量，mat4这种itemSize为16的attribute，需要拆成连续4个location，每个location一列vec4
+	auto DriverBindingStates::setupInstanceAttribute(const Attributef::Ptr& attribute, uint32_t binding) const noexcept -> void
+	{
+		if (attribute == nullptr) {
+			return;
+		}
+
+		auto bkAttribute = mAttributes->get(attribute);
+		if (bkAttribute == nullptr) {
+			return;
+		}
+
+		const auto itemSize = attribute->getItemSize();
+		const auto dataType = attribute->getDataType();
+		const auto stride = itemSize * toSize(dataType);
+
+		FF_GL_BIND(glBindBuffer, GL_ARRAY_BUFFER, bkAttribute->mHandle);
+
+		const uint32_t slots = (itemSize + 3) / 4;
+		for (uint32_t i = 0; i < slots; ++i) {
+			const auto slotSize = std::min(itemSize - i * 4, 4u);
+
+			FF_GL(glEnableVertexAttribArray, binding + i);
+			FF_GL(glVertexAttribPointer, binding + i, slotSize, toGL(dataType), false, stride, (void*)(static_cast<size_t>(i) * 4 * toSize(dataType)));
+			FF_GL(glVertexAttribDivisor, binding + i, 1);
 		}
 	}
 
@@ -201,14 +291,14 @@ namespace ff {
 	auto DriverBindingStates::createVao() noexcept -> GLuint
 	{
 		GLuint vao = 0;
-		glGenVertexArrays(1, &vao);
+		FF_GL(glGenVertexArrays, 1, &vao);
 		return vao;
 	}
 
 	/// 真正改变了OpenGL状态机，使之绑定当前的vao
 	auto DriverBindingStates::bindVao(GLuint vao) noexcept -> void
 	{
-		glBindVertexArray(vao);
+		FF_GL_BIND(glBindVertexArray, vao);
 	}
 
 	auto DriverBindingStates::releaseStatesOfGeometry(ID geometryID) noexcept -> void
@@ -219,4 +309,14 @@ namespace ff {
 		}
 	}
 
+	auto DriverBindingStates::onObjectDispose(const EventBase::Ptr& event) -> void
+	{
+		const auto object = static_cast<Object3D*>(event->mTarget);
+
+		auto iter = mInstancedBindingStates.find(object->getID());
+		if (iter != mInstancedBindingStates.end()) {
+			mInstancedBindingStates.erase(iter);
+		}
+	}
+
 }
\ No newline at end of file
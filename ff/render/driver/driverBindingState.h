@@ -5,6 +5,8 @@
 #include "../../core/object3D.h"
 #include "../../core/attribute.h"
 #include "../../material/material.h"
+#include "../../objects/instancedMesh.h"
+#include "../../global/eventDispatcher.h"
 #include "driverAttributes.h"
 #include "driverPrograms.h"
 
@@ -38,6 +40,7 @@ namespace ff {
 	};
 
 	/// 一个VAO与一个Geometry一一对应
+	/// InstancedMesh除了geometry的attribute之外，还有自己独有的实例attribute，所以每个InstancedMesh单独拥有一个VAO
 	class DriverBindingStates {
 	public:
 		/// key:geometry的ID号  value：BindingState这里面蕴含着一个VAO
@@ -52,28 +55,46 @@ namespace ff {
 
 		~DriverBindingStates();
 
-		auto getBindingState(const Geometry::Ptr& geometry) noexcept -> DriverBindingState::Ptr;
+		auto getBindingState(const Geometry* geometry) noexcept -> const DriverBindingState::Ptr&;
 
+		auto getInstancedBindingState(const InstancedMesh* object) noexcept -> const DriverBindingState::Ptr&;
+
+		/// \brief 绑定geometry对应的VAO，如有必要则重新设置VAO与各个VBO的挂钩关系
+		/// \param geometry 
+		/// \param index 
+		/// \param object 如果是InstancedMesh，会同时挂钩其实例attribute
 		auto setup(
-			const Geometry::Ptr& geometry,
-			const Attributei::Ptr& index) -> void ;
+			const Geometry* geometry,
+			const Attributei::Ptr& index,
+			const RenderableObject* object = nullptr) -> void ;
 
 		static auto createBindingState(GLuint vao) noexcept -> DriverBindingState::Ptr;
 
-		auto needsUpdate(const Geometry::Ptr& geometry, const Attributei::Ptr& index) const noexcept -> bool;
+		auto needsUpdate(const Geometry* geometry, const Attributei::Ptr& index, const InstancedMesh* instancedMesh) const noexcept -> bool;
+
+		auto saveCache(const Geometry* geometry, const Attributei::Ptr& index, const InstancedMesh* instancedMesh) const noexcept -> void;
 
-		auto saveCache(const Geometry::Ptr& geometry, const Attributei::Ptr& index) const noexcept -> void;
+		auto setupVertexAttributes(const Geometry* geometry, const InstancedMesh* instancedMesh) const noexcept -> void;
 
-		auto setupVertexAttributes(const Geometry::Ptr& geometry) const noexcept -> void;
+		/// \brief 外部(例如multi-draw indirect)直接绑定了别的VAO之后调用，使下一次setup一定重新绑定VAO
+		auto resetCurrentState() noexcept -> void { mCurrentBindingState = nullptr; }
 
 		static auto createVao() noexcept -> GLuint;
 		static void bindVao(GLuint vao) noexcept;
 
 		auto releaseStatesOfGeometry(ID geometryID) noexcept -> void;
 
+		auto onObjectDispose(const EventBase::Ptr& event) -> void;
+
+	private:
+		auto setupInstanceAttribute(const Attributef::Ptr& attribute, uint32_t binding) const noexcept -> void;
+
 	private:
 		DriverAttributes::Ptr	mAttributes{ nullptr };
 		DriverBindingState::Ptr mCurrentBindingState{ nullptr };
 		GeometryKeyMap	mBindingStates{};
+
+		/// key:InstancedMesh的ID号  value：BindingState
+		std::unordered_map<ID, DriverBindingState::Ptr> mInstancedBindingStates{};
 	};
 }
\ No newline at end of file
@@ -0,0 +1,99 @@
+﻿#include "driverGPUTimer.h"
+#include "../../wrapper/glTrace.h"
+
+namespace ff {
+
+	DriverGPUTimer::DriverGPUTimer(const DriverInfo::Ptr& info) noexcept {
+		mInfo = info;
+
+		for (auto& frame : mFrames) {
+			FF_GL(glGenQueries, DriverInfo::PassCount, frame.mQueries.data());
+		}
+	}
+
+	DriverGPUTimer::~DriverGPUTimer() noexcept {
+		for (auto& frame : mFrames) {
+			FF_GL(glDeleteQueries, DriverInfo::PassCount, frame.mQueries.data());
+		}
+	}
+
+	auto DriverGPUTimer::beginFrame() noexcept -> void
+	{
+		/// 上一帧如果有没结束的阶段，先结束掉
+		end();
+
+		mCurrent = (mCurrent + 1) % QUERY_LATENCY;
+
+		/// 这组查询对象是QUERY_LATENCY帧之前使用的，先尝试回读其结果，再重新使用
+		collect(mCurrent);
+
+		auto& frame = mFrames[mCurrent];
+		frame.mIssued.fill(false);
+		frame.mFrame = mInfo->mRender.mFrame;
+		frame.mPending = false;
+	}
+
+	auto DriverGPUTimer::begin(DriverInfo::Pass pass) noexcept -> void
+	{
+		mInfo->setCurrentPass(pass);
+
+		if (!mEnabled) return;
+
+		end();
+
+		auto& frame = mFrames[mCurrent];
+
+		/// 同一帧之内同一个阶段只计时一次
+		if (frame.mIssued[pass]) return;
+
+		FF_GL(glBeginQuery, GL_TIME_ELAPSED, frame.mQueries[pass]);
+		frame.mIssued[pass] = true;
+		frame.mPending = true;
+
+		mActivePass = static_cast<int32_t>(pass);
+	}
+
+	auto DriverGPUTimer::end() noexcept -> void
+	{
+		if (mActivePass < 0) return;
+
+		FF_GL(glEndQuery, GL_TIME_ELAPSED);
+		mActivePass = -1;
+	}
+
+	auto DriverGPUTimer::collect(uint32_t slot) noexcept -> void
+	{
+		auto& frame = mFrames[slot];
+		if (!frame.mPending) return;
+
+		/// 只要有一个查询还没有完成，就放弃整组结果，绝对不能等待GPU
+		for (uint32_t i = 0; i < DriverInfo::PassCount; ++i) {
+			if (!frame.mIssued[i]) continue;
+
+			GLint available = 0;
+			FF_GL(glGetQueryObjectiv, frame.mQueries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+			if (!available) return;
+		}
+
+		auto& render = mInfo->mRender;
+		render.mGPUTime = 0.0;
+		render.mGPUFrame = frame.mFrame;
+
+		for (uint32_t i = 0; i < DriverInfo::PassCount; ++i) {
+			double time = 0.0;
+
+			if (frame.mIssued[i]) {
+				GLuint64 elapsed = 0;
+				FF_GL(glGetQueryObjectui64v, frame.mQueries[i], GL_QUERY_RESULT, &elapsed);
+
+				/// 纳秒转换为毫秒
+				time = static_cast<double>(elapsed) / 1000000.0;
+			}
+
+			render.mPasses[i].mGPUTime = time;
+			render.mGPUTime += time;
+		}
+
+		frame.mPending = false;
+	}
+}
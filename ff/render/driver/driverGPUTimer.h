@@ -0,0 +1,61 @@
+﻿#pragma once
+#include "../../global/base.h"
+#include "driverInfo.h"
+#include <array>
+
+namespace ff {
+
+	/// 使用GL_TIME_ELAPSED计时查询，统计每个渲染阶段在GPU上的耗时
+	/// 1 查询结果需要等GPU执行完毕才能拿到，如果在当帧读取，CPU就会等待GPU，造成停顿
+	/// 2 所以每一帧使用一组独立的查询对象，环形使用QUERY_LATENCY组，QUERY_LATENCY帧之后再回读
+	/// 3 回读之前先检查GL_QUERY_RESULT_AVAILABLE，如果GPU还没有完成，就放弃这一组结果，保证永远不会停顿
+	/// 4 注意：GL_TIME_ELAPSED查询不能嵌套，各个阶段必须依次begin/end
+	class DriverGPUTimer {
+	public:
+		static constexpr uint32_t QUERY_LATENCY = 4;
+
+		using Ptr = std::shared_ptr<DriverGPUTimer>;
+		static Ptr create(const DriverInfo::Ptr& info) {
+			return std::make_shared<DriverGPUTimer>(info);
+		}
+
+		DriverGPUTimer(const DriverInfo::Ptr& info) noexcept;
+
+		~DriverGPUTimer() noexcept;
+
+		/// \brief 每一帧开始时调用，切换到下一组查询对象，并且回读这组查询对象在QUERY_LATENCY帧之前的结果
+		auto beginFrame() noexcept -> void;
+
+		/// \brief 开始某个渲染阶段的计时，同时设置DriverInfo的当前阶段
+		/// \param pass
+		auto begin(DriverInfo::Pass pass) noexcept -> void;
+
+		/// \brief 结束当前渲染阶段的计时
+		auto end() noexcept -> void;
+
+	public:
+		bool mEnabled{ true };
+
+	private:
+		auto collect(uint32_t slot) noexcept -> void;
+
+	private:
+		struct FrameQueries {
+			std::array<GLuint, DriverInfo::PassCount>	mQueries{};
+
+			/// 本帧之内，哪些阶段真正发出了查询
+			std::array<bool, DriverInfo::PassCount>		mIssued{};
+
+			uint32_t	mFrame{ 0 };
+			bool		mPending{ false };
+		};
+
+		DriverInfo::Ptr mInfo{ nullptr };
+
+		std::array<FrameQueries, QUERY_LATENCY> mFrames{};
+		uint32_t	mCurrent{ 0 };
+
+		/// 当前正在计时的阶段，-1表示没有
+		int32_t		mActivePass{ -1 };
+	};
+}
@@ -51,7 +51,7 @@ namespace ff {
 
 	auto DriverGeometries::update(const Geometry::Ptr& geometry) const noexcept -> void
 	{
-		const auto geometryAttributes = geometry->getAttributes();
+		const auto& geometryAttributes = geometry->getAttributes();
 		for (const auto& iter: geometryAttributes) {
 			/// ֻindexAttribute֮attributes 
 			mAttributes->update(iter.second , BufferType::ArrayBuffer);
@@ -8,22 +8,59 @@ namespace ff {
 
 	auto DriverInfo::update(uint32_t count, uint32_t glMode, uint32_t instanceCount) noexcept -> void
 	{
+		auto& pass = mRender.mPasses[mCurrentPass];
+
 		mRender.mCalls++;
+		pass.mCalls++;
 
+		uint32_t triangles = 0;
 		switch (glMode) {
 		case GL_TRIANGLES:
-			mRender.mTriangels++;
+			triangles = count / 3;
+			break;
+		case GL_TRIANGLE_STRIP:
+		case GL_TRIANGLE_FAN:
+			triangles = count > 2 ? count - 2 : 0;
 			break;
 		default:
 			break;
 		}
+
+		mRender.mTriangels += triangles * instanceCount;
+		pass.mTriangels += triangles * instanceCount;
 	}
 
+	/// GPU耗时由DriverGPUTimer异步回读填写，不在这里清理
 	auto DriverInfo::reset() noexcept -> void
 	{
 		mRender.mFrame++;
 		mRender.mCalls = 0;
 		mRender.mTriangels = 0;
+
+		for (auto& pass : mRender.mPasses) {
+			pass.mCalls = 0;
+			pass.mTriangels = 0;
+		}
+
+		mRender.mOpaqueStateChanges = {};
+		mRender.mDepthOrderStateChanges = {};
+		mRender.mAutoInstancedBatches = 0;
+		mRender.mAutoInstancedObjects = 0;
+		mRender.mUniformUploads = 0;
+		mRender.mUniformSkips = 0;
+		mRender.mPipelineChanges = 0;
+		mRender.mPipelineStateCalls = 0;
+		mRender.mOcclusionQueries = 0;
+		mRender.mOcclusionCulled = 0;
+		mRender.mOcclusionConditionalDraws = 0;
+		mRender.mSoftwareOccluders = 0;
+		mRender.mSoftwareOcclusionCulled = 0;
+		mRender.mBVHRefitted = 0;
+		mRender.mBVHVisitedNodes = 0;
+		mRender.mShadowMapsRendered = 0;
+		mRender.mShadowMapsReused = 0;
+
+		mCurrentPass = OpaquePass;
 	}
 
 }
\ No newline at end of file
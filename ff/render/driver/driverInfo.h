@@ -1,5 +1,6 @@
 ﻿#pragma once
 #include "../../global/base.h"
+#include <array>
 
 namespace ff {
 
@@ -7,15 +8,88 @@ namespace ff {
 	class DriverInfo {
 	public:
 
+		/// 分别统计的渲染阶段
+		enum Pass : uint32_t {
+			ShadowPass = 0,
+			BackgroundPass,
+			DepthPrePass,
+			OpaquePass,
+			TransparentPass,
+			PassCount
+		};
+
 		struct Memory {
 			uint32_t mGeometries{ 0 };
 			uint32_t mTextures{ 0 };
 		};
 
+		struct PassInfo {
+			uint32_t	mCalls{ 0 };
+			uint32_t	mTriangels{ 0 };
+
+			/// GPU耗时（毫秒），来自DriverGPUTimer，为若干帧之前的结果
+			double		mGPUTime{ 0.0 };
+		};
+
+		/// 按照某种绘制顺序，相邻两次DrawCall之间需要切换状态的次数
+		struct StateChanges {
+			uint32_t	mPrograms{ 0 };
+			uint32_t	mVAOs{ 0 };
+			uint32_t	mTextures{ 0 };
+		};
+
 		struct Render {
 			uint32_t	mFrame{ 0 };
 			uint32_t	mCalls{ 0 };
 			uint32_t	mTriangels{ 0 };
+
+			/// 每个阶段的统计数据，下标为Pass
+			std::array<PassInfo, PassCount> mPasses{};
+
+			/// 所有阶段的GPU耗时之和，以及这些GPU耗时所对应的帧号
+			double		mGPUTime{ 0.0 };
+			uint32_t	mGPUFrame{ 0 };
+
+			/// 非透明队列按照本帧实际排序结果，以及按照深度(SmallerZFirst)排序时，需要的program/VAO/纹理绑定次数
+			/// 二者之差即为按照状态排序(StateFirst)节省下来的绑定次数，由DriverRenderList在排序时统计
+			/// 后者需要额外排序一次，只在开启Renderer::mSortStatistics时统计
+			StateChanges	mOpaqueStateChanges{};
+			StateChanges	mDepthOrderStateChanges{};
+
+			/// 自动实例化产生的实例化DrawCall数量，以及被合并进去的物体数量
+			uint32_t	mAutoInstancedBatches{ 0 };
+			uint32_t	mAutoInstancedObjects{ 0 };
+
+			/// uniform表实际调用的glUniform次数，以及值与上一次相同而跳过的次数
+			uint32_t	mUniformUploads{ 0 };
+			uint32_t	mUniformSkips{ 0 };
+
+			/// 管线状态(光栅化、混合、深度)发生变化的次数，以及因此调用的opengl状态函数次数
+			uint32_t	mPipelineChanges{ 0 };
+			uint32_t	mPipelineStateCalls{ 0 };
+
+			/// FrameGraph本帧执行与剔除的Pass数量，临时RenderTarget数量，以及它们实际占用的RenderTarget数量(跨帧保留的池子大小)
+			uint32_t	mGraphPasses{ 0 };
+			uint32_t	mGraphCulledPasses{ 0 };
+			uint32_t	mGraphTransientTargets{ 0 };
+			uint32_t	mGraphPooledTargets{ 0 };
+
+			/// 遮挡剔除本帧发出的包围盒查询数量，因为被遮挡而跳过绘制的物体数量，以及条件绘制的次数
+			uint32_t	mOcclusionQueries{ 0 };
+			uint32_t	mOcclusionCulled{ 0 };
+			uint32_t	mOcclusionConditionalDraws{ 0 };
+
+			/// 软件遮挡剔除本帧光栅化的遮挡物数量，以及在project阶段被剔除的物体数量
+			uint32_t	mSoftwareOccluders{ 0 };
+			uint32_t	mSoftwareOcclusionCulled{ 0 };
+
+			/// 场景BVH本帧包围盒发生变化的物体数量，以及视景体查询访问过的节点数量
+			uint32_t	mBVHRefitted{ 0 };
+			uint32_t	mBVHVisitedNodes{ 0 };
+
+			/// 本帧重新绘制的ShadowMap数量，以及光源与投射阴影的物体都没有变化而沿用上一帧的数量
+			uint32_t	mShadowMapsRendered{ 0 };
+			uint32_t	mShadowMapsReused{ 0 };
 		};
 
 		using Ptr = std::shared_ptr<DriverInfo>;
@@ -27,13 +101,24 @@ namespace ff {
 
 		~DriverInfo() noexcept;
 
+		/// \brief 每一次DrawCall之后调用，统计DrawCall与三角形数量，并计入当前的渲染阶段
+		/// \param count 顶点（索引）数量
+		/// \param glMode 绘制模式，比如GL_TRIANGLES
+		/// \param instanceCount 实例数量
 		auto update(uint32_t count, uint32_t glMode, uint32_t instanceCount) noexcept -> void;
 
 		auto reset() noexcept -> void;
 
+		/// \brief 设置当前的渲染阶段，之后的DrawCall都计入这个阶段
+		/// \param pass
+		auto setCurrentPass(Pass pass) noexcept -> void { mCurrentPass = pass; }
+
 	public:
 		Memory	mMemory{};
 		Render	mRender{};
+
+	private:
+		Pass	mCurrentPass{ OpaquePass };
 	};
 
 }
\ No newline at end of file
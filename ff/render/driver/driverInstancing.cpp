@@ -0,0 +1,156 @@
+﻿#include "driverInstancing.h"
+#include "../../tools/profiler.h"
+
+namespace ff {
+
+	DriverInstancing::DriverInstancing(const DriverObjects::Ptr& objects) noexcept {
+		mObjects = objects;
+	}
+
+	DriverInstancing::~DriverInstancing() noexcept {}
+
+	auto DriverInstancing::canBatch(const RenderItem& item) noexcept -> bool
+	{
+		const auto object = item.mObject;
+
+		return object->mIsMesh
+			&& !object->mIsSkinnedMesh
+			&& !object->mIsInstancedMesh
+			&& !object->mIsStaticBatchMesh
+			&& object->mOnBeforeRenderCallback == nullptr
+			&& !object->mOcclusionCulling;
+	}
+
+	/// 代理物体本身不在场景图当中，worldMatrix永远为单位矩阵，实例矩阵就是各个源物体的世界矩阵
+	auto DriverInstancing::getProxy(Batch& batch, const RenderItem& item) noexcept -> const InstancedMesh::Ptr&
+	{
+		const auto count = static_cast<uint32_t>(batch.mItems.size());
+
+		if (batch.mProxy == nullptr || batch.mProxy->getCapacity() < count) {
+			/// 按照2的幂次分配容量，组内物体数量小幅波动时不需要重新创建
+			uint32_t capacity = 1;
+			while (capacity < count) capacity <<= 1;
+
+			batch.mProxy = InstancedMesh::create(item.mObject->getGeometry(), item.mObject->getMaterial(), capacity);
+		}
+
+		return batch.mProxy;
+	}
+
+	/// 1 统计：找出每个可合并的renderItem所属的组
+	/// 2 合并：物体数量足够的组，写入代理物体的实例矩阵，并向渲染列表加入一个代理renderItem
+	/// 3 重建非透明队列：每一组在其第一个物体的位置放入代理renderItem，组内其他物体去掉
+	auto DriverInstancing::batch(const DriverRenderList::Ptr& renderList) noexcept -> void
+	{
+		FF_PROFILE_SCOPE("autoInstancing");
+
+		mSerial++;
+		mBatches = 0;
+		mBatchedObjects = 0;
+
+		const auto& renderItems = renderList->getRenderItems();
+		const auto& opaques = renderList->getOpaques();
+		const auto opaqueCount = static_cast<uint32_t>(opaques.size());
+
+		mItemBatches.assign(opaqueCount, nullptr);
+
+		/// 1 分组
+		for (uint32_t i = 0; i < opaqueCount; ++i) {
+			const auto& item = renderItems[opaques[i]];
+			if (!canBatch(item)) continue;
+
+			BatchKey key;
+			key.mGeometry = item.mGeometry->getID();
+			key.mMaterial = item.mMaterial->getID();
+			key.mGroupOrder = item.mGroupOrder;
+
+			auto& batch = mBatchMap[key];
+			if (batch.mLastUsed != mSerial) {
+				batch.mLastUsed = mSerial;
+				batch.mItems.clear();
+			}
+
+			batch.mItems.push_back(opaques[i]);
+			mItemBatches[i] = &batch;
+		}
+
+		/// 2 合并，push会改变renderItems的容量，所以这里按值拷贝需要的信息
+		for (uint32_t i = 0; i < opaqueCount; ++i) {
+			auto batch = mItemBatches[i];
+			if (batch == nullptr) continue;
+
+			/// 数量不够，不进行合并
+			if (batch->mItems.size() < mMinInstances) {
+				mItemBatches[i] = nullptr;
+				continue;
+			}
+
+			/// 每一组只在其第一个物体处理一次
+			if (batch->mItems.front() != opaques[i]) continue;
+
+			const auto first = renderItems[opaques[i]];
+			const auto previous = batch->mProxy.get();
+			const auto& proxy = getProxy(*batch, first);
+
+			/// 组内物体与它们的worldMatrix都没有变化时，沿用上一次写入的实例矩阵
+			bool dirty = proxy.get() != previous || batch->mInstances.size() != batch->mItems.size();
+
+			float z = first.mZ;
+			for (uint32_t instance = 0; instance < batch->mItems.size(); ++instance) {
+				const auto& item = renderItems[batch->mItems[instance]];
+				z = std::min(z, item.mZ);
+
+				if (!dirty) {
+					const auto& recorded = batch->mInstances[instance];
+					dirty = recorded.first != item.mObject || recorded.second != item.mObject->getWorldMatrixVersion();
+				}
+			}
+
+			const auto instance = static_cast<uint32_t>(batch->mItems.size());
+			if (dirty) {
+				batch->mInstances.clear();
+				for (uint32_t k = 0; k < instance; ++k) {
+					const auto object = renderItems[batch->mItems[k]].mObject;
+					proxy->setMatrixAt(k, object->getWorldMatrix());
+					batch->mInstances.emplace_back(object, object->getWorldMatrixVersion());
+				}
+				proxy->setCount(instance);
+			}
+
+			/// 实例矩阵发生变化时才会真正上传
+			const auto geometry = mObjects->update(proxy.get());
+
+			batch->mProxyIndex = static_cast<uint32_t>(renderItems.size());
+			renderList->push(proxy.get(), geometry, first.mMaterial, first.mGroupOrder, z, first.mProgramID);
+
+			mBatches++;
+			mBatchedObjects += instance;
+		}
+
+		/// 3 重建非透明队列，push进来的代理renderItem位于原有队列之后，不需要拷贝
+		if (mBatches > 0) {
+			mOpaques.clear();
+			for (uint32_t i = 0; i < opaqueCount; ++i) {
+				const auto batch = mItemBatches[i];
+				if (batch == nullptr) {
+					mOpaques.push_back(opaques[i]);
+				}
+				else if (batch->mItems.front() == opaques[i]) {
+					mOpaques.push_back(batch->mProxyIndex);
+				}
+			}
+
+			renderList->swapOpaques(mOpaques);
+		}
+
+		/// 释放长时间没有用到的代理物体，连带其实例attribute与VAO
+		for (auto iter = mBatchMap.begin(); iter != mBatchMap.end();) {
+			if (mSerial - iter->second.mLastUsed > PROXY_LIFETIME) {
+				iter = mBatchMap.erase(iter);
+			}
+			else {
+				++iter;
+			}
+		}
+	}
+}
@@ -0,0 +1,94 @@
+﻿#pragma once
+#include "../../global/base.h"
+#include "../../objects/instancedMesh.h"
+#include "driverRenderList.h"
+#include "driverObjects.h"
+
+namespace ff {
+
+	/// 自动实例化
+	/// 1 场景中经常有大量Mesh共享同一个geometry与material，逐个绘制会产生大量DrawCall
+	/// 2 projectObject之后，将非透明队列中geometry、material、groupOrder都相同的renderItem归为一组
+	/// 3 每一组使用一个代理InstancedMesh，把组内物体的世界矩阵写入实例矩阵，整组只需要一次DrawCall
+	/// 4 骨骼动画、InstancedMesh、StaticBatchMesh、带有onBeforeRender回调的物体不参与合并；透明物体需要严格的由远到近顺序，也不参与合并
+	class DriverInstancing {
+	public:
+		/// 代理InstancedMesh连续这么多次合并都没有被用到，就释放掉
+		static constexpr uint32_t PROXY_LIFETIME = 60;
+
+		using Ptr = std::shared_ptr<DriverInstancing>;
+		static Ptr create(const DriverObjects::Ptr& objects) {
+			return std::make_shared<DriverInstancing>(objects);
+		}
+
+		DriverInstancing(const DriverObjects::Ptr& objects) noexcept;
+
+		~DriverInstancing() noexcept;
+
+		/// \brief 对渲染列表的非透明队列进行自动实例化合并，需要在排序之前调用
+		/// \param renderList
+		auto batch(const DriverRenderList::Ptr& renderList) noexcept -> void;
+
+		/// \brief 上一次合并产生的实例化DrawCall数量
+		auto getBatches() const noexcept -> uint32_t { return mBatches; }
+
+		/// \brief 上一次合并当中，被合并进实例化DrawCall的物体数量
+		auto getBatchedObjects() const noexcept -> uint32_t { return mBatchedObjects; }
+
+	public:
+		/// 一组之内至少有多少个物体，才会进行合并
+		uint32_t mMinInstances{ 2 };
+
+	private:
+		struct BatchKey {
+			ID			mGeometry{ 0 };
+			ID			mMaterial{ 0 };
+			uint32_t	mGroupOrder{ 0 };
+
+			bool operator==(const BatchKey& other) const noexcept {
+				return mGeometry == other.mGeometry && mMaterial == other.mMaterial && mGroupOrder == other.mGroupOrder;
+			}
+		};
+
+		struct BatchKeyHash {
+			size_t operator()(const BatchKey& key) const noexcept {
+				size_t hash = std::hash<uint64_t>()((static_cast<uint64_t>(key.mGeometry) << 32) | key.mMaterial);
+				return hash ^ (std::hash<uint32_t>()(key.mGroupOrder) + 0x9e3779b9 + (hash << 6) + (hash >> 2));
+			}
+		};
+
+		struct Batch {
+			/// 本次合并当中属于这一组的renderItem下标
+			std::vector<uint32_t>	mItems{};
+
+			/// 代理InstancedMesh跨帧复用，实例数量不够时才会重新创建
+			InstancedMesh::Ptr		mProxy{ nullptr };
+
+			/// 代理中实例矩阵对应的物体及其worldMatrix版本号，都没有变化时不需要重写与上传
+			std::vector<std::pair<const RenderableObject*, uint32_t>>	mInstances{};
+
+			/// 代理renderItem的下标
+			uint32_t				mProxyIndex{ 0 };
+
+			/// 最后一次被使用时的合并序号
+			uint32_t				mLastUsed{ 0 };
+		};
+
+		static auto canBatch(const RenderItem& item) noexcept -> bool;
+
+		auto getProxy(Batch& batch, const RenderItem& item) noexcept -> const InstancedMesh::Ptr&;
+
+	private:
+		DriverObjects::Ptr	mObjects{ nullptr };
+
+		std::unordered_map<BatchKey, Batch, BatchKeyHash> mBatchMap{};
+
+		/// 每一个可以合并的非透明renderItem所属的组，不能合并则为nullptr，跨帧复用
+		std::vector<Batch*>		mItemBatches{};
+		std::vector<uint32_t>	mOpaques{};
+
+		uint32_t	mSerial{ 0 };
+		uint32_t	mBatches{ 0 };
+		uint32_t	mBatchedObjects{ 0 };
+	};
+}
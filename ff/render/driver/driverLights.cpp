@@ -3,26 +3,8 @@
 
 namespace ff {
 
-	DriverLights::DriverLights() noexcept {
-		mState.mLightUniformHandles["ambientLightColor"] = UniformHandle();
-
-		UniformHandle directionalLights;
-		directionalLights.mValue = UniformUnitMap();
-
-		UniformHandle directionalLightShadows;
-		directionalLightShadows.mValue = UniformUnitMap();
-
-		UniformHandle directionalShadowMap;
-		directionalShadowMap.mValue = std::vector<Texture::Ptr>();
-
-		UniformHandle directionalShadowMatrix;
-		directionalShadowMatrix.mValue = std::vector<glm::mat4>();
-
-		mState.mLightUniformHandles["directionalLights"] = directionalLights;
-		mState.mLightUniformHandles["directionalLightShadows"] = directionalLightShadows;
-		mState.mLightUniformHandles["directionalShadowMap"] = directionalShadowMap;
-		mState.mLightUniformHandles["directionalShadowMatrix"] = directionalShadowMatrix;
-	}
+	/// ƽй⡢ӰӰԼⶼmLightsBlockУUniformBufferϴ
+	DriverLights::DriverLights() noexcept {}
 
 	DriverLights::~DriverLights() noexcept {}
 
@@ -40,20 +22,9 @@ namespace ff {
 		std::sort(lights.begin(), lights.end(), shadowCastingLightsFirst);
 
 		/// prepare shadow uniforms
-		auto& lightArray = mState.mLightUniformHandles["directionalLights"];
-
-		/// UniformHandle
-		auto& shadowStructuredArray = mState.mLightUniformHandles["directionalLightShadows"];
-		auto& shadowMapPureArray = mState.mLightUniformHandles["directionalShadowMap"];
-		auto& shadowMatrixPureArray = mState.mLightUniformHandles["directionalShadowMatrix"];
+		auto& lightsBlock = mState.mLightsBlock;
 
-		lightArray.mNeedsUpdate = true;
-		shadowStructuredArray.mNeedsUpdate = true;
-		shadowMapPureArray.mNeedsUpdate = true;
-		shadowMatrixPureArray.mNeedsUpdate = true;
-
-		clearPureArrayUniform(std::any_cast<std::vector<Texture::Ptr>>(&shadowMapPureArray.mValue));
-		clearPureArrayUniform(std::any_cast<std::vector<glm::mat4>>(&shadowMatrixPureArray.mValue));
+		mState.mDirectionalShadowMaps.clear();
 
 		for (const Light::Ptr& light : lights) {
 			auto color = light->mColor;
@@ -69,20 +40,20 @@ namespace ff {
 				b += color.b * intensity;
 			}
 			else if (light->mIsDirectionalLight) {
+				/// UniformBufferе鳤ȹ̶ƽйⲻ
+				if (directionalLightCount >= MAX_DIRECTIONAL_LIGHTS) continue;
 
 				/// add one directionalLight  
-				UniformUnitMap* directionalLightUniform = setArrayStructuredUniform(directionalLightCount, std::any_cast<UniformUnitMap>(&lightArray.mValue));
-
-				(*directionalLightUniform)["color"] = light->mColor * light->mIntensity;
+				lightsBlock.mDirectionalLights[directionalLightCount].mColor = glm::vec4(light->mColor * light->mIntensity, 0.0f);
 
 				if (light->mCastShadow) {
 					LightShadow::Ptr shadow = light->mShadow; 
 
 					/// shadow uniform
-					UniformUnitMap* directionalShadowUniform = setArrayStructuredUniform(directionalLightCount, std::any_cast<UniformUnitMap>(&shadowStructuredArray.mValue));
-					(*directionalShadowUniform)["shadowBias"] = shadow->mBias;
-					(*directionalShadowUniform)["shadowRadius"] = shadow->mRadius;
-					(*directionalShadowUniform)["shadowMapSize"] = shadow->mMapSize;
+					auto& directionalShadow = lightsBlock.mDirectionalLightShadows[directionalLightCount];
+					directionalShadow.mShadowBias = shadow->mBias;
+					directionalShadow.mShadowRadius = shadow->mRadius;
+					directionalShadow.mShadowMapSize = shadow->mMapSize;
 
 					/// matrix and shadowmap will update when rendering shadow map
 
@@ -94,7 +65,7 @@ namespace ff {
 		mState.mDirectionalCount = directionalLightCount;
 		mState.mNumDirectionalShadows = numDirectionalShadows;
 
-		mState.mLightUniformHandles["ambientLightColor"].mValue = glm::vec3(r, g, b);
+		lightsBlock.mAmbientLightColor = glm::vec4(r, g, b, 0.0f);
 
 		if (
 			mState.mCache.mDirectionalCount != mState.mDirectionalCount ||
@@ -112,17 +83,16 @@ namespace ff {
 		auto viewMatrix = camera->getWorldMatrixInverse();
 
 
-		auto& lightArray = mState.mLightUniformHandles["directionalLights"];
+		auto& lightsBlock = mState.mLightsBlock;
 		for (uint32_t i = 0; i < lights.size(); ++i) {
 			auto light = lights[i];
 
 			if (light->mIsDirectionalLight) {
-				auto dLight = std::static_pointer_cast<DirectionalLight>(light);
-				UniformUnitMap* uniform = getArrayStructuredUniform(directionalLength, std::any_cast<UniformUnitMap>(&lightArray.mValue));
+				if (directionalLength >= MAX_DIRECTIONAL_LIGHTS) break;
 
 				auto lightDirection = light->getWorldDirection();
 				auto lightViewDirection = glm::mat3(viewMatrix) * lightDirection;
-				(*uniform)["direction"] = lightViewDirection;
+				lightsBlock.mDirectionalLights[directionalLength].mDirection = glm::vec4(lightViewDirection, 0.0f);
 
 				directionalLength++;
 			}
@@ -21,6 +21,30 @@ namespace ff {
 	///
 	class DriverLights {
 	public:
+		/// UniformBufferƽйĹ̶ȣshaderΪMAX_DIR_LIGHTSƽйᱻ
+		static constexpr uint32_t MAX_DIRECTIONAL_LIGHTS = 4;
+
+		/// ½ṹshaderеLightsBlockstd140һһӦvec3vec4
+		struct DirectionalLightData {
+			glm::vec4 mDirection{ 0.0f };
+			glm::vec4 mColor{ 0.0f };
+		};
+
+		struct DirectionalLightShadowData {
+			float mShadowRadius{ 0.0f };
+			float mShadowBias{ 0.0f };
+			glm::vec2 mShadowMapSize{ 0.0f };
+		};
+
+		struct LightsBlock {
+			DirectionalLightData		mDirectionalLights[MAX_DIRECTIONAL_LIGHTS]{};
+			DirectionalLightShadowData	mDirectionalLightShadows[MAX_DIRECTIONAL_LIGHTS]{};
+			glm::mat4					mDirectionalShadowMatrix[MAX_DIRECTIONAL_LIGHTS]{};
+			glm::vec4					mAmbientLightColor{ 0.0f };
+		};
+
+		static_assert(sizeof(LightsBlock) == MAX_DIRECTIONAL_LIGHTS * (32 + 16 + 64) + 16, "LightsBlock must match std140 layout");
+
 		struct State {
 
 			/// һ֡
@@ -33,7 +57,11 @@ namespace ff {
 			uint32_t mDirectionalCount = 0;
 			uint32_t mNumDirectionalShadows = 0;
 
-			UniformHandleMap mLightUniformHandles{};
+			/// ӰͼsamplerܷŽUniformBufferӰpassд룬shaderеdirectionalShadowMap
+			std::vector<Texture::Ptr> mDirectionalShadowMaps{};
+
+			/// ÿ֡дһιUniformBuffer
+			LightsBlock mLightsBlock{};
 
 			/// ÿֻҪ֣ͬmVersionͻ+1
 			uint32_t mVersion{ 1 };
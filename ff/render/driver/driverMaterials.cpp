@@ -23,7 +23,7 @@ namespace ff
 		                                                    &DriverMaterials::onMaterialDispose);
 	}
 
-	auto DriverMaterials::get(const Material::Ptr& material) noexcept -> DriverMaterial::Ptr
+	auto DriverMaterials::get(const Material* material) noexcept -> const DriverMaterial::Ptr&
 	{
 		auto iter = mMaterials.find(material->getID());
 
@@ -35,6 +35,17 @@ namespace ff
 		return iter->second;
 	}
 
+	auto DriverMaterials::getPipelineState(const Material* material) noexcept -> const DriverState::PipelineState&
+	{
+		const auto& dMaterial = get(material);
+
+		/// 打包只是几次移位，每次绘制都重新进行，运行时直接修改mBlending、mDepthTest等属性也能立即生效，不需要改动version
+		/// 键与当前状态相同时，DriverState不会产生任何opengl调用
+		dMaterial->mPipelineState = DriverState::compilePipelineState(material);
+
+		return dMaterial->mPipelineState;
+	}
+
 	auto DriverMaterials::onMaterialDispose(const EventBase::Ptr& event) -> void
 	{
 		auto material = (Material*)event->mTarget;
@@ -63,32 +74,32 @@ namespace ff
 	}
 
 	auto DriverMaterials::refreshMaterialUniforms(UniformHandleMap& uniformHandleMap,
-	                                              const Material::Ptr& material) -> void
+	                                              const Material* material) -> void
 	{
 		uniformHandleMap["opacity"].mValue = material->mOpacity;
 		uniformHandleMap["opacity"].mNeedsUpdate = true;
 
 		if (material->mIsMeshBasicMaterial)
 		{
-			auto basicMaterial = std::static_pointer_cast<MeshBasicMaterial>(material);
+			const auto basicMaterial = static_cast<const MeshBasicMaterial*>(material);
 			refreshMaterialBasic(uniformHandleMap, basicMaterial);
 		}
 
 		if (material->mIsMeshPhongMaterial)
 		{
-			auto phongMaterial = std::static_pointer_cast<MeshPhongMaterial>(material);
+			const auto phongMaterial = static_cast<const MeshPhongMaterial*>(material);
 			refreshMaterialPhong(uniformHandleMap, phongMaterial);
 		}
 
 		if (material->mIsCubeMaterial)
 		{
-			const auto cubeMaterial = std::static_pointer_cast<CubeMaterial>(material);
+			const auto cubeMaterial = static_cast<const CubeMaterial*>(material);
 			refreshMaterialCube(uniformHandleMap, cubeMaterial);
 		}
 	}
 
 	auto DriverMaterials::refreshMaterialPhong(UniformHandleMap& uniformHandleMap,
-	                                           const MeshPhongMaterial::Ptr& material) -> void
+	                                           const MeshPhongMaterial* material) -> void
 	{
 		uniformHandleMap["shininess"].mValue = material->mShininess;
 		uniformHandleMap["shininess"].mNeedsUpdate = true;
@@ -113,7 +124,7 @@ namespace ff
 	}
 
 	auto DriverMaterials::refreshMaterialBasic(UniformHandleMap& uniformHandleMap,
-	                                           const MeshBasicMaterial::Ptr& material) -> void
+	                                           const MeshBasicMaterial* material) -> void
 	{
 		if ((material->mDiffuseMap && material->mDiffuseMap->mNeedsUpdate) || material->mNeedsUpdate)
 		{
@@ -123,7 +134,7 @@ namespace ff
 	}
 
 	auto DriverMaterials::refreshMaterialCube(UniformHandleMap& uniformHandleMap,
-	                                          const CubeMaterial::Ptr& material) -> void
+	                                          const CubeMaterial* material) -> void
 	{
 		if ((material->mEnvMap && material->mEnvMap->mNeedsUpdate) || material->mNeedsUpdate)
 		{
@@ -9,6 +9,7 @@
 #include "driverPrograms.h"
 #include "driverUniforms.h"
 #include "driverTextures.h"
+#include "driverState.h"
 #include "../shaders/uniformsLib.h"
 
 namespace ff {
@@ -27,8 +28,20 @@ namespace ff {
 	public:
 		uint32_t				mVersion{ 0 };
 		bool					mInstancing{ false };
+		bool					mInstancingColor{ false };
+		bool					mMultiDraw{ false };
 		DriverProgram::Ptr		mCurrentProgram{ nullptr };
 
+		/// 同一个material可能在普通绘制、实例化(代理合批)与multi-draw之间来回切换，按照变体缓存各自的program，
+		/// 切换时直接取出，不需要重新生成参数与哈希；其他影响shader的状态发生变化时全部作废
+		static constexpr uint32_t VARIANT_COUNT = 8;
+		DriverProgram::Ptr		mVariantPrograms[VARIANT_COUNT]{};
+
+		/// \brief 变体在mVariantPrograms中的下标
+		static auto getVariant(bool instancing, bool instancingColor, bool multiDraw) noexcept -> uint32_t {
+			return static_cast<uint32_t>(instancing) | static_cast<uint32_t>(instancingColor) << 1 | static_cast<uint32_t>(multiDraw) << 2;
+		}
+
 		Texture::Ptr			mDiffuseMap{ nullptr };
 		Texture::Ptr			mEnvMap{ nullptr };
 		Texture::Ptr			mNormalMap{ nullptr };
@@ -40,6 +53,9 @@ namespace ff {
 		bool					mSkinning{ false };
 		uint32_t				mMaxBones{ 0 };
 
+		/// 最近一次绘制时打包的管线状态
+		DriverState::PipelineState	mPipelineState{};
+
 		///  记录了前端对应的material所使用过的driverPrograms
 		///  如果我们不记录所有曾经使用过的DriverProgram，只记录当前正在使用的Program
 		///  当一个material奇数帧用DiffuseMap， 偶数帧用顶点Color，就会导致DriverProgram，析构，重建，析构，重建。。。
@@ -62,20 +78,25 @@ namespace ff {
 		/// \brief 传入前端的material， 返回后端对应的DriverMaterial
 		/// \param material 
 		/// \return 
-		auto get(const Material::Ptr& material) noexcept -> DriverMaterial::Ptr;
+		auto get(const Material* material) noexcept -> const DriverMaterial::Ptr&;
+
+		/// \brief 按照material当前的属性打包管线状态，每次绘制都会重新打包
+		/// \param material
+		/// \return
+		auto getPipelineState(const Material* material) noexcept -> const DriverState::PipelineState&;
 
 		auto onMaterialDispose(const EventBase::Ptr& event) -> void;
 
 		/// 用来更新uniform变量
-		static auto refreshMaterialUniforms(UniformHandleMap& uniformHandleMap, const Material::Ptr& material) -> void;
+		static auto refreshMaterialUniforms(UniformHandleMap& uniformHandleMap, const Material* material) -> void;
 
 		static auto refreshMaterialPhong(UniformHandleMap& uniformHandleMap,
-		                                 const MeshPhongMaterial::Ptr& material) -> void;
+		                                 const MeshPhongMaterial* material) -> void;
 
 		static auto refreshMaterialBasic(UniformHandleMap& uniformHandleMap,
-		                                 const MeshBasicMaterial::Ptr& material) -> void;
+		                                 const MeshBasicMaterial* material) -> void;
 
-		static auto refreshMaterialCube(UniformHandleMap& uniformHandleMap, const CubeMaterial::Ptr& material) -> void;
+		static auto refreshMaterialCube(UniformHandleMap& uniformHandleMap, const CubeMaterial* material) -> void;
 
 	private:
 		DriverPrograms::Ptr mPrograms{ nullptr };
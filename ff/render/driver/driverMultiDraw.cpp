@@ -0,0 +1,487 @@
+﻿#include "driverMultiDraw.h"
+#include "../renderer.h"
+#include "../../tools/profiler.h"
+#include "../../wrapper/glTrace.h"
+
+namespace ff {
+
+	DriverMultiDraw::DriverMultiDraw(Renderer* renderer, const DriverInfo::Ptr& info, const DriverBindingStates::Ptr& bindingStates) noexcept {
+		mRenderer = renderer;
+		mInfo = info;
+		mBindingStates = bindingStates;
+
+		GLint major = 0;
+		GLint minor = 0;
+		FF_GL(glGetIntegerv, GL_MAJOR_VERSION, &major);
+		FF_GL(glGetIntegerv, GL_MINOR_VERSION, &minor);
+		const auto version = major * 10 + minor;
+
+		bool drawParameters = false;
+		GLint extensionCount = 0;
+		FF_GL(glGetIntegerv, GL_NUM_EXTENSIONS, &extensionCount);
+		for (GLint i = 0; i < extensionCount; ++i) {
+			const auto name = reinterpret_cast<const char*>(FF_GL(glGetStringi, GL_EXTENSIONS, i));
+			if (name != nullptr && std::string(name) == "GL_ARB_shader_draw_parameters") {
+				drawParameters = true;
+				break;
+			}
+		}
+
+		/// glMultiDrawElementsIndirect与SSBO需要4.3，gl_DrawID在4.6成为核心功能
+		mDrawIDCore = version >= 46;
+		mSupported = version >= 43 && (mDrawIDCore || drawParameters);
+
+		if (mSupported) {
+			FF_GL(glGenBuffers, 1, &mCommandBuffer);
+			FF_GL(glGenBuffers, 1, &mDrawDataBuffer);
+		}
+
+		EventDispatcher::getInstance()->addEventListener("geometryDispose", this, &DriverMultiDraw::onGeometryDispose);
+	}
+
+	DriverMultiDraw::~DriverMultiDraw() noexcept {
+		EventDispatcher::getInstance()->removeEventListener("geometryDispose", this, &DriverMultiDraw::onGeometryDispose);
+
+		for (const auto& iter : mArenas) {
+			const auto& arena = iter.second;
+			for (const auto buffer : arena->mBuffers) {
+				if (buffer) FF_GL(glDeleteBuffers, 1, &buffer);
+			}
+
+			if (arena->mIndexBuffer) FF_GL(glDeleteBuffers, 1, &arena->mIndexBuffer);
+			if (arena->mVAO) FF_GL(glDeleteVertexArrays, 1, &arena->mVAO);
+		}
+
+		if (mCommandBuffer) FF_GL(glDeleteBuffers, 1, &mCommandBuffer);
+		if (mDrawDataBuffer) FF_GL(glDeleteBuffers, 1, &mDrawDataBuffer);
+	}
+
+	auto DriverMultiDraw::onGeometryDispose(const EventBase::Ptr& event) -> void
+	{
+		const auto geometry = static_cast<Geometry*>(event->mTarget);
+
+		auto iter = mEntries.find(geometry->getID());
+		if (iter == mEntries.end()) return;
+
+		release(iter->second);
+		mEntries.erase(iter);
+	}
+
+	auto DriverMultiDraw::canMultiDraw(const RenderItem& item, const Material* material) noexcept -> bool
+	{
+		const auto object = item.mObject;
+
+		return object->mIsMesh
+			&& !object->mIsSkinnedMesh
+			&& !object->mIsInstancedMesh
+			&& !object->mIsStaticBatchMesh
+			&& object->mOnBeforeRenderCallback == nullptr
+			&& !object->mOcclusionCulling
+			&& material->mDrawMode == DrawMode::Triangles;
+	}
+
+	/// 1 分组：找出每个可合并的renderItem所属的组(material + arena)
+	/// 2 绘制：按照队列顺序，组在其第一个物体的位置一次性绘制，其余物体逐个绘制
+	auto DriverMultiDraw::render(
+		const std::vector<RenderItem>& renderItems,
+		const std::vector<uint32_t>& queue,
+		const Scene::Ptr& scene,
+		const Camera::Ptr& camera
+	) noexcept -> void
+	{
+		FF_PROFILE_SCOPE("multiDraw");
+
+		const auto overrideMaterial = scene->mIsScene ? scene->mOverrideMaterial.get() : nullptr;
+
+		/// 上一帧没有用到的组释放掉，其余的清空复用
+		for (auto iter = mBatchMap.begin(); iter != mBatchMap.end();) {
+			if (iter->second.mPositions.empty()) {
+				iter = mBatchMap.erase(iter);
+			}
+			else {
+				iter->second.mPositions.clear();
+				++iter;
+			}
+		}
+
+		mItemBatches.assign(queue.size(), nullptr);
+		mItemEntries.assign(queue.size(), nullptr);
+
+		for (uint32_t i = 0; i < queue.size(); ++i) {
+			const auto& item = renderItems[queue[i]];
+			const auto material = overrideMaterial == nullptr ? item.mMaterial : overrideMaterial;
+
+			if (!canMultiDraw(item, material)) continue;
+
+			const auto entry = getEntry(item.mGeometry);
+			if (entry == nullptr) continue;
+
+			auto& batch = mBatchMap[BatchKey{ material, entry->mArena }];
+			batch.mArena = entry->mArena;
+			batch.mPositions.push_back(i);
+
+			mItemBatches[i] = &batch;
+			mItemEntries[i] = entry;
+		}
+
+		for (uint32_t i = 0; i < queue.size(); ++i) {
+			const auto& item = renderItems[queue[i]];
+			const auto material = overrideMaterial == nullptr ? item.mMaterial : overrideMaterial;
+
+			const auto batch = mItemBatches[i];
+			if (batch != nullptr && batch->mPositions.size() >= mMinDraws) {
+				if (batch->mPositions.front() == i) {
+					drawBatch(*batch, renderItems, queue, scene, camera, material);
+				}
+
+				continue;
+			}
+
+			mRenderer->renderObject(item.mObject, scene, camera, item.mGeometry, material);
+		}
+	}
+
+	auto DriverMultiDraw::drawBatch(
+		const Batch& batch,
+		const std::vector<RenderItem>& renderItems,
+		const std::vector<uint32_t>& queue,
+		const Scene::Ptr& scene,
+		const Camera::Ptr& camera,
+		Material* material
+	) noexcept -> void
+	{
+		mCommands.clear();
+		mDrawDatas.clear();
+
+		const auto viewMatrix = camera->getWorldMatrixInverse();
+
+		uint32_t indexCount = 0;
+		for (const auto position : batch.mPositions) {
+			const auto object = renderItems[queue[position]].mObject;
+			const auto entry = mItemEntries[position];
+
+			/// MVP，与renderObject一致，只是结果写入SSBO而不是uniform
+			object->updateModelViewMatrix(viewMatrix);
+			object->updateNormalMatrix();
+
+			DrawElementsIndirectCommand command;
+			command.mCount = entry->mIndexCount;
+			command.mInstanceCount = 1;
+			command.mFirstIndex = entry->mFirstIndex;
+			command.mBaseVertex = static_cast<int32_t>(entry->mBaseVertex);
+			mCommands.push_back(command);
+
+			DrawData data;
+			data.mModelMatrix = object->getWorldMatrix();
+			data.mModelViewMatrix = object->getModelViewMatrix();
+			data.mNormalMatrix = glm::mat4(object->getNormalMatrix());
+			mDrawDatas.push_back(data);
+
+			indexCount += entry->mIndexCount;
+		}
+
+		/// 组内物体共享同一个material与顶点格式，用第一个物体来选择program
+		const auto& first = renderItems[queue[batch.mPositions.front()]];
+		{
+			FF_PROFILE_SCOPE("setProgram");
+			mRenderer->setProgram(camera, scene, first.mGeometry, material, first.mObject, true);
+		}
+
+		mRenderer->mState->setPipelineState(mRenderer->mMaterials->getPipelineState(material));
+
+		/// 每一组都重新指定缓冲大小(orphan)，驱动可以分配新的存储，不需要等待上一次绘制读取完毕
+		FF_GL_BIND(glBindBuffer, GL_SHADER_STORAGE_BUFFER, mDrawDataBuffer);
+		FF_GL(glBufferData, GL_SHADER_STORAGE_BUFFER, mDrawDatas.size() * sizeof(DrawData), mDrawDatas.data(), GL_STREAM_DRAW);
+		FF_GL_BIND(glBindBufferBase, GL_SHADER_STORAGE_BUFFER, DRAW_DATA_BINDING, mDrawDataBuffer);
+
+		FF_GL_BIND(glBindBuffer, GL_DRAW_INDIRECT_BUFFER, mCommandBuffer);
+		FF_GL(glBufferData, GL_DRAW_INDIRECT_BUFFER, mCommands.size() * sizeof(DrawElementsIndirectCommand), mCommands.data(), GL_STREAM_DRAW);
+
+		/// 直接绑定了arena的VAO，DriverBindingStates的缓存失效
+		DriverBindingStates::bindVao(batch.mArena->mVAO);
+		mBindingStates->resetCurrentState();
+
+		FF_PROFILE_SCOPE("draw");
+		FF_GL(glMultiDrawElementsIndirect, GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, static_cast<GLsizei>(mCommands.size()), 0);
+		mInfo->update(indexCount, GL_TRIANGLES, 1);
+	}
+
+	/// geometry第一次参与multi-draw，或者任意attribute/index被修改、增删、替换时，重新拷贝进对应顶点格式的arena
+	auto DriverMultiDraw::getEntry(Geometry* geometry) noexcept -> const Entry*
+	{
+		if (geometry->getAttribute("position") == nullptr) return nullptr;
+
+		auto iter = mEntries.find(geometry->getID());
+		if (iter != mEntries.end() && isUpToDate(iter->second, geometry)) {
+			return &iter->second;
+		}
+
+		auto& entry = mEntries[geometry->getID()];
+
+		/// 旧的空间先归还，同一个arena中大小不变时会原地复用
+		release(entry);
+
+		/// 增删attribute会改变顶点格式，需要换到另一个arena
+		const auto arena = getArena(geometry);
+		append(*arena, geometry, entry);
+		collectVersions(geometry, entry.mVersions);
+
+		return &entry;
+	}
+
+	auto DriverMultiDraw::isUpToDate(const Entry& entry, const Geometry* geometry) noexcept -> bool
+	{
+		const auto& versions = entry.mVersions;
+
+		size_t i = 0;
+		for (const auto& iter : geometry->getAttributes()) {
+			if (i >= versions.size() || versions[i].first != iter.second->getID() || versions[i].second != iter.second->getVersion()) {
+				return false;
+			}
+
+			++i;
+		}
+
+		const auto& index = geometry->getIndex();
+		if (index != nullptr) {
+			if (i >= versions.size() || versions[i].first != index->getID() || versions[i].second != index->getVersion()) {
+				return false;
+			}
+
+			++i;
+		}
+
+		return i == versions.size();
+	}
+
+	auto DriverMultiDraw::collectVersions(const Geometry* geometry, std::vector<std::pair<ID, uint32_t>>& versions) noexcept -> void
+	{
+		versions.clear();
+		for (const auto& iter : geometry->getAttributes()) {
+			versions.emplace_back(iter.second->getID(), iter.second->getVersion());
+		}
+
+		const auto& index = geometry->getIndex();
+		if (index != nullptr) {
+			versions.emplace_back(index->getID(), index->getVersion());
+		}
+	}
+
+	/// 顶点格式：所有拥有location的attribute的名称与itemSize，按名称排序之后拼接
+	auto DriverMultiDraw::getArena(const Geometry* geometry) noexcept -> Arena*
+	{
+		std::vector<std::pair<std::string, uint32_t>> layout;
+		for (const auto& iter : geometry->getAttributes()) {
+			if (LOCATION_MAP.find(iter.first) == LOCATION_MAP.end()) continue;
+			layout.emplace_back(iter.first, iter.second->getItemSize());
+		}
+
+		std::sort(layout.begin(), layout.end());
+
+		std::string key;
+		for (const auto& item : layout) {
+			key.append(item.first).append(":").append(std::to_string(item.second)).append("|");
+		}
+
+		auto iter = mArenas.find(key);
+		if (iter != mArenas.end()) {
+			return iter->second.get();
+		}
+
+		auto arena = std::make_unique<Arena>();
+		for (const auto& item : layout) {
+			arena->mNames.push_back(item.first);
+			arena->mItemSizes.push_back(item.second);
+		}
+
+		arena->mBuffers.resize(layout.size(), 0);
+		FF_GL(glGenVertexArrays, 1, &arena->mVAO);
+
+		return mArenas.insert(std::make_pair(key, std::move(arena))).first->second.get();
+	}
+
+	auto DriverMultiDraw::append(Arena& arena, const Geometry* geometry, Entry& entry) noexcept -> void
+	{
+		const auto& attributes = geometry->getAttributes();
+		const auto vertexCount = attributes.at("position")->getCount();
+
+		const auto& index = geometry->getIndex();
+		const auto indexCount = index != nullptr ? index->getCount() : vertexCount;
+
+		/// 优先复用归还的空间，没有合适的空间才追加在末尾
+		uint32_t baseVertex = takeBlock(arena.mFreeVertexBlocks, vertexCount);
+		uint32_t firstIndex = takeBlock(arena.mFreeIndexBlocks, indexCount);
+
+		reserve(arena,
+			baseVertex == INVALID_OFFSET ? arena.mVertexCount + vertexCount : arena.mVertexCount,
+			firstIndex == INVALID_OFFSET ? arena.mIndexCount + indexCount : arena.mIndexCount);
+
+		if (baseVertex == INVALID_OFFSET) {
+			baseVertex = arena.mVertexCount;
+			arena.mVertexCount += vertexCount;
+		}
+
+		if (firstIndex == INVALID_OFFSET) {
+			firstIndex = arena.mIndexCount;
+			arena.mIndexCount += indexCount;
+		}
+
+		/// 使用GL_COPY_WRITE_BUFFER上传，不影响当前绑定的VAO
+		for (uint32_t i = 0; i < arena.mNames.size(); ++i) {
+			const auto itemSize = arena.mItemSizes[i];
+			const auto& data = attributes.at(arena.mNames[i])->getData();
+			const auto count = std::min<size_t>(data.size(), static_cast<size_t>(vertexCount) * itemSize);
+
+			FF_GL_BIND(glBindBuffer, GL_COPY_WRITE_BUFFER, arena.mBuffers[i]);
+			FF_GL(glBufferSubData, GL_COPY_WRITE_BUFFER, static_cast<size_t>(baseVertex) * itemSize * sizeof(float), count * sizeof(float), data.data());
+		}
+
+		/// 没有index的geometry，按照顶点顺序生成index
+		std::vector<uint32_t> sequence;
+		if (index == nullptr) {
+			sequence.resize(vertexCount);
+			for (uint32_t i = 0; i < vertexCount; ++i) sequence[i] = i;
+		}
+
+		const auto& indices = index != nullptr ? index->getData() : sequence;
+
+		FF_GL_BIND(glBindBuffer, GL_COPY_WRITE_BUFFER, arena.mIndexBuffer);
+		FF_GL(glBufferSubData, GL_COPY_WRITE_BUFFER, static_cast<size_t>(firstIndex) * sizeof(uint32_t), indexCount * sizeof(uint32_t), indices.data());
+		FF_GL_BIND(glBindBuffer, GL_COPY_WRITE_BUFFER, 0);
+
+		entry.mArena = &arena;
+		entry.mBaseVertex = baseVertex;
+		entry.mVertexCount = vertexCount;
+		entry.mFirstIndex = firstIndex;
+		entry.mIndexCount = indexCount;
+	}
+
+	auto DriverMultiDraw::release(Entry& entry) noexcept -> void
+	{
+		if (entry.mArena == nullptr) return;
+
+		auto& arena = *entry.mArena;
+		giveBlock(arena.mFreeVertexBlocks, arena.mVertexCount, entry.mBaseVertex, entry.mVertexCount);
+		giveBlock(arena.mFreeIndexBlocks, arena.mIndexCount, entry.mFirstIndex, entry.mIndexCount);
+
+		entry.mArena = nullptr;
+		entry.mVersions.clear();
+	}
+
+	auto DriverMultiDraw::takeBlock(std::vector<Block>& blocks, uint32_t count) noexcept -> uint32_t
+	{
+		for (auto iter = blocks.begin(); iter != blocks.end(); ++iter) {
+			if (iter->mCount < count) continue;
+
+			const auto offset = iter->mOffset;
+			iter->mOffset += count;
+			iter->mCount -= count;
+			if (iter->mCount == 0) blocks.erase(iter);
+
+			return offset;
+		}
+
+		return INVALID_OFFSET;
+	}
+
+	auto DriverMultiDraw::giveBlock(std::vector<Block>& blocks, uint32_t& used, uint32_t offset, uint32_t count) noexcept -> void
+	{
+		if (count == 0) return;
+
+		auto iter = std::lower_bound(blocks.begin(), blocks.end(), offset, [](const Block& block, uint32_t value) {
+			return block.mOffset < value;
+		});
+		iter = blocks.insert(iter, Block{ offset, count });
+
+		/// 与后一段相邻
+		const auto next = iter + 1;
+		if (next != blocks.end() && iter->mOffset + iter->mCount == next->mOffset) {
+			iter->mCount += next->mCount;
+			blocks.erase(next);
+		}
+
+		/// 与前一段相邻
+		if (iter != blocks.begin()) {
+			const auto prev = iter - 1;
+			if (prev->mOffset + prev->mCount == iter->mOffset) {
+				prev->mCount += iter->mCount;
+				iter = blocks.erase(iter) - 1;
+			}
+		}
+
+		/// 最后一段空闲空间位于末尾，直接缩短已使用的长度
+		if (iter->mOffset + iter->mCount == used) {
+			used = iter->mOffset;
+			blocks.erase(iter);
+		}
+	}
+
+	auto DriverMultiDraw::reserve(Arena& arena, uint32_t vertexCount, uint32_t indexCount) noexcept -> void
+	{
+		bool layoutChanged = false;
+
+		if (vertexCount > arena.mVertexCapacity) {
+			uint32_t capacity = std::max(arena.mVertexCapacity * 2, ARENA_MIN_CAPACITY);
+			while (capacity < vertexCount) capacity <<= 1;
+
+			for (uint32_t i = 0; i < arena.mBuffers.size(); ++i) {
+				const size_t stride = arena.mItemSizes[i] * sizeof(float);
+				arena.mBuffers[i] = growBuffer(arena.mBuffers[i], arena.mVertexCount * stride, capacity * stride);
+			}
+
+			arena.mVertexCapacity = capacity;
+			layoutChanged = true;
+		}
+
+		if (indexCount > arena.mIndexCapacity) {
+			uint32_t capacity = std::max(arena.mIndexCapacity * 2, ARENA_MIN_CAPACITY);
+			while (capacity < indexCount) capacity <<= 1;
+
+			arena.mIndexBuffer = growBuffer(arena.mIndexBuffer, arena.mIndexCount * sizeof(uint32_t), capacity * sizeof(uint32_t));
+
+			arena.mIndexCapacity = capacity;
+			layoutChanged = true;
+		}
+
+		if (!layoutChanged) return;
+
+		/// 缓冲重新创建之后，需要重新挂钩VAO
+		DriverBindingStates::bindVao(arena.mVAO);
+		for (uint32_t i = 0; i < arena.mBuffers.size(); ++i) {
+			const auto location = LOCATION_MAP.at(arena.mNames[i]);
+			const auto itemSize = arena.mItemSizes[i];
+
+			FF_GL_BIND(glBindBuffer, GL_ARRAY_BUFFER, arena.mBuffers[i]);
+			FF_GL(glEnableVertexAttribArray, location);
+			FF_GL(glVertexAttribPointer, location, itemSize, GL_FLOAT, GL_FALSE, itemSize * sizeof(float), (void*)0);
+		}
+
+		FF_GL_BIND(glBindBuffer, GL_ELEMENT_ARRAY_BUFFER, arena.mIndexBuffer);
+		DriverBindingStates::bindVao(0);
+
+		mBindingStates->resetCurrentState();
+	}
+
+	/// 新建一个更大的缓冲，把旧缓冲中已经使用的部分拷贝过去
+	auto DriverMultiDraw::growBuffer(GLuint buffer, size_t oldSize, size_t newSize) noexcept -> GLuint
+	{
+		GLuint newBuffer = 0;
+		FF_GL(glGenBuffers, 1, &newBuffer);
+		FF_GL_BIND(glBindBuffer, GL_COPY_WRITE_BUFFER, newBuffer);
+		FF_GL(glBufferData, GL_COPY_WRITE_BUFFER, newSize, nullptr, GL_STATIC_DRAW);
+
+		if (buffer) {
+			if (oldSize > 0) {
+				FF_GL_BIND(glBindBuffer, GL_COPY_READ_BUFFER, buffer);
+				FF_GL(glCopyBufferSubData, GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, oldSize);
+				FF_GL_BIND(glBindBuffer, GL_COPY_READ_BUFFER, 0);
+			}
+
+			FF_GL(glDeleteBuffers, 1, &buffer);
+		}
+
+		FF_GL_BIND(glBindBuffer, GL_COPY_WRITE_BUFFER, 0);
+
+		return newBuffer;
+	}
+}
@@ -0,0 +1,201 @@
+﻿#pragma once
+#include "../../global/base.h"
+#include "../../global/eventDispatcher.h"
+#include "../../core/geometry.h"
+#include "../../scene/scene.h"
+#include "../../camera/camera.h"
+#include "driverRenderList.h"
+#include "driverBindingState.h"
+#include "driverInfo.h"
+
+namespace ff {
+
+	class Renderer;
+
+	/// multi-draw indirect提交
+	/// 1 顶点格式(attribute名称与itemSize)相同的geometry，其顶点与index被拷贝进同一组大缓冲(arena)，共用一个VAO
+	/// 2 非透明队列中material与arena都相同的renderItem归为一组，每个物体生成一条DrawElementsIndirectCommand，
+	///   整组只需要一次glMultiDrawElementsIndirect
+	/// 3 每个物体的modelMatrix/modelViewMatrix/normalMatrix写入SSBO，shader中使用gl_DrawID取出
+	/// 4 需要4.3以上的上下文，gl_DrawID需要4.6或者ARB_shader_draw_parameters；不满足时isSupported返回false
+	/// 5 骨骼动画、InstancedMesh、StaticBatchMesh、带有onBeforeRender回调、开启遮挡剔除以及非三角形绘制的物体，仍然逐个绘制
+	/// 6 arena中的数据以所有attribute与index的(ID, 版本号)为准，任意一个被修改、增删或者替换都会重新拷贝；
+	///   旧的空间与析构的geometry所占的空间归还到arena的空闲链表，之后加入的geometry优先复用
+	class DriverMultiDraw {
+	public:
+		/// 与glMultiDrawElementsIndirect要求的格式完全一致
+		struct DrawElementsIndirectCommand {
+			uint32_t	mCount{ 0 };
+			uint32_t	mInstanceCount{ 0 };
+			uint32_t	mFirstIndex{ 0 };
+			int32_t		mBaseVertex{ 0 };
+			uint32_t	mBaseInstance{ 0 };
+		};
+
+		/// 与shader当中的DrawData(std430)一一对应，normalMatrix按照mat4存放以满足对齐
+		struct DrawData {
+			glm::mat4	mModelMatrix{ 1.0f };
+			glm::mat4	mModelViewMatrix{ 1.0f };
+			glm::mat4	mNormalMatrix{ 1.0f };
+		};
+
+		/// 与uniformMatricesVertex当中的binding一致
+		static constexpr GLuint DRAW_DATA_BINDING = 0;
+
+		using Ptr = std::shared_ptr<DriverMultiDraw>;
+		static Ptr create(Renderer* renderer, const DriverInfo::Ptr& info, const DriverBindingStates::Ptr& bindingStates) {
+			return std::make_shared<DriverMultiDraw>(renderer, info, bindingStates);
+		}
+
+		DriverMultiDraw(Renderer* renderer, const DriverInfo::Ptr& info, const DriverBindingStates::Ptr& bindingStates) noexcept;
+
+		~DriverMultiDraw() noexcept;
+
+		/// \brief 当前上下文是否支持multi-draw indirect
+		auto isSupported() const noexcept -> bool { return mSupported; }
+
+		/// \brief gl_DrawID是否为核心功能(4.6)
+		auto isDrawIDCore() const noexcept -> bool { return mDrawIDCore; }
+
+		/// \brief 绘制一个渲染队列，能够合并的renderItem使用glMultiDrawElementsIndirect，其余的逐个绘制
+		/// \param renderItems	本帧所有的renderItem
+		/// \param queue		需要渲染的队列，即renderItems中的下标
+		/// \param scene
+		/// \param camera
+		auto render(
+			const std::vector<RenderItem>& renderItems,
+			const std::vector<uint32_t>& queue,
+			const Scene::Ptr& scene,
+			const Camera::Ptr& camera) noexcept -> void;
+
+		auto onGeometryDispose(const EventBase::Ptr& event) -> void;
+
+	public:
+		/// 一组之内至少有多少个物体，才会使用multi-draw indirect
+		uint32_t mMinDraws{ 2 };
+
+	private:
+		/// arena第一次分配时的最小顶点/index数量，之后每次不够时容量翻倍
+		static constexpr uint32_t ARENA_MIN_CAPACITY = 4096;
+
+		static constexpr uint32_t INVALID_OFFSET = std::numeric_limits<uint32_t>::max();
+
+		/// arena当中一段连续的顶点或者index
+		struct Block {
+			uint32_t	mOffset{ 0 };
+			uint32_t	mCount{ 0 };
+		};
+
+		/// 一种顶点格式对应的一组大缓冲
+		struct Arena {
+			std::vector<std::string>	mNames{};
+			std::vector<uint32_t>		mItemSizes{};
+			std::vector<GLuint>			mBuffers{};
+
+			GLuint		mIndexBuffer{ 0 };
+			GLuint		mVAO{ 0 };
+
+			uint32_t	mVertexCount{ 0 };
+			uint32_t	mVertexCapacity{ 0 };
+			uint32_t	mIndexCount{ 0 };
+			uint32_t	mIndexCapacity{ 0 };
+
+			/// [0, mVertexCount)与[0, mIndexCount)当中被归还的空间，按照mOffset排序
+			std::vector<Block>	mFreeVertexBlocks{};
+			std::vector<Block>	mFreeIndexBlocks{};
+		};
+
+		/// 一个geometry在arena当中的位置
+		struct Entry {
+			Arena*		mArena{ nullptr };
+			uint32_t	mBaseVertex{ 0 };
+			uint32_t	mVertexCount{ 0 };
+			uint32_t	mFirstIndex{ 0 };
+			uint32_t	mIndexCount{ 0 };
+
+			/// 拷贝时所有attribute以及index的(ID, 版本号)，任意一个不同都需要重新拷贝
+			std::vector<std::pair<ID, uint32_t>>	mVersions{};
+		};
+
+		struct BatchKey {
+			const Material*	mMaterial{ nullptr };
+			const Arena*	mArena{ nullptr };
+
+			bool operator==(const BatchKey& other) const noexcept {
+				return mMaterial == other.mMaterial && mArena == other.mArena;
+			}
+		};
+
+		struct BatchKeyHash {
+			size_t operator()(const BatchKey& key) const noexcept {
+				size_t hash = std::hash<const void*>()(key.mMaterial);
+				return hash ^ (std::hash<const void*>()(key.mArena) + 0x9e3779b9 + (hash << 6) + (hash >> 2));
+			}
+		};
+
+		struct Batch {
+			/// 本帧属于这一组的物体在队列当中的位置
+			std::vector<uint32_t>	mPositions{};
+			Arena*					mArena{ nullptr };
+		};
+
+		static auto canMultiDraw(const RenderItem& item, const Material* material) noexcept -> bool;
+
+		auto getEntry(Geometry* geometry) noexcept -> const Entry*;
+
+		auto getArena(const Geometry* geometry) noexcept -> Arena*;
+
+		/// \brief geometry当前所有attribute与index的(ID, 版本号)是否与拷贝时一致
+		static auto isUpToDate(const Entry& entry, const Geometry* geometry) noexcept -> bool;
+
+		static auto collectVersions(const Geometry* geometry, std::vector<std::pair<ID, uint32_t>>& versions) noexcept -> void;
+
+		auto append(Arena& arena, const Geometry* geometry, Entry& entry) noexcept -> void;
+
+		/// \brief 把entry占用的空间归还给其arena
+		static auto release(Entry& entry) noexcept -> void;
+
+		/// \brief 从空闲链表中取出一段不小于count的空间(first-fit)
+		/// \return 起始位置，没有合适的空间时返回INVALID_OFFSET
+		static auto takeBlock(std::vector<Block>& blocks, uint32_t count) noexcept -> uint32_t;
+
+		/// \brief 归还一段空间，与相邻的空闲空间合并；位于末尾时直接缩短used
+		static auto giveBlock(std::vector<Block>& blocks, uint32_t& used, uint32_t offset, uint32_t count) noexcept -> void;
+
+		auto reserve(Arena& arena, uint32_t vertexCount, uint32_t indexCount) noexcept -> void;
+
+		auto drawBatch(
+			const Batch& batch,
+			const std::vector<RenderItem>& renderItems,
+			const std::vector<uint32_t>& queue,
+			const Scene::Ptr& scene,
+			const Camera::Ptr& camera,
+			Material* material) noexcept -> void;
+
+		static auto growBuffer(GLuint buffer, size_t oldSize, size_t newSize) noexcept -> GLuint;
+
+	private:
+		Renderer*					mRenderer{ nullptr };
+		DriverInfo::Ptr				mInfo{ nullptr };
+		DriverBindingStates::Ptr	mBindingStates{ nullptr };
+
+		bool	mSupported{ false };
+		bool	mDrawIDCore{ false };
+
+		GLuint	mCommandBuffer{ 0 };
+		GLuint	mDrawDataBuffer{ 0 };
+
+		/// key:顶点格式字符串
+		std::unordered_map<std::string, std::unique_ptr<Arena>> mArenas{};
+
+		/// key:geometry的ID号
+		std::unordered_map<ID, Entry> mEntries{};
+
+		/// 每一帧复用，避免反复申请内存
+		std::unordered_map<BatchKey, Batch, BatchKeyHash> mBatchMap{};
+		std::vector<Batch*>							mItemBatches{};
+		std::vector<const Entry*>					mItemEntries{};
+		std::vector<DrawElementsIndirectCommand>	mCommands{};
+		std::vector<DrawData>						mDrawDatas{};
+	};
+}
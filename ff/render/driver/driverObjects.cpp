@@ -1,5 +1,7 @@
 ﻿#include"driverObjects.h"
 #include "../../global/eventDispatcher.h"
+#include "../../tools/profiler.h"
+#include "../../objects/instancedMesh.h"
 
 namespace ff
 {
@@ -27,13 +29,16 @@ namespace ff
 	/// 调用object的geometry之update
 	/// 不同的object可能会共享同一个geometry
 	/// 得在这里，保证每个geometry每一帧，只update一次
-	auto DriverObjects::update(const RenderableObject::Ptr& object) noexcept -> Geometry::Ptr
+	auto DriverObjects::update(const RenderableObject* object) noexcept -> Geometry*
 	{
+		FF_PROFILE_SCOPE("updateObject");
+
 		/// 1 拿到当前到了第几帧
 		const auto frame = mInfo->mRender.mFrame;
 
 		/// 2 拿出geometry，并且在get里面做相关的数据记录
-		const auto geometry = mGeometries->get(object->getGeometry());
+		const auto& geometry = object->getGeometry();
+		mGeometries->get(geometry);
 
 		/// update once per frame,muti-objects-one geometry
 
@@ -53,6 +58,18 @@ namespace ff
 			mUpdateMap[geometry->getID()] = frame;
 		}
 
-		return geometry;
+		/// 实例attribute属于object本身，不会被共享，DriverAttributes内部会检查其是否需要重新上传
+		if (object->mIsInstancedMesh)
+		{
+			const auto instancedMesh = static_cast<const InstancedMesh*>(object);
+			mAttributes->update(instancedMesh->getInstanceMatrix(), BufferType::ArrayBuffer);
+
+			if (const auto& instanceColor = instancedMesh->getInstanceColor(); instanceColor != nullptr)
+			{
+				mAttributes->update(instanceColor, BufferType::ArrayBuffer);
+			}
+		}
+
+		return geometry.get();
 	}
 }
@@ -25,11 +25,13 @@ namespace ff
 
 		~DriverObjects() noexcept;
 
-		Geometry::Ptr update(const RenderableObject::Ptr& object) noexcept;
+		/// \brief 每帧对object的geometry至多更新一次，返回其geometry（不持有所有权）
+		/// 如果object是InstancedMesh，还会更新其实例attribute
+		/// \param object 
+		/// \return 
+		Geometry* update(const RenderableObject* object) noexcept;
 
 	private:
-		/// TODO  还差一个instance绘制的功能
-
 		/// key：geometry的ID
 		/// value：frameNumber
 		std::unordered_map<ID, uint32_t> mUpdateMap{};
@@ -0,0 +1,297 @@
+﻿#include "driverOcclusion.h"
+#include "../../wrapper/glTrace.h"
+
+namespace ff {
+
+	static const char* BOX_VERTEX =
+		"#version 330 core\n"
+		"layout(location = 0) in vec3 position;\n"
+		"uniform mat4 mvp;\n"
+		"void main() {\n"
+		"	gl_Position = mvp * vec4(position, 1.0);\n"
+		"}\n";
+
+	static const char* BOX_FRAGMENT =
+		"#version 330 core\n"
+		"out vec4 fragmentColor;\n"
+		"void main() {\n"
+		"	fragmentColor = vec4(1.0);\n"
+		"}\n";
+
+	static auto compileShader(GLenum type, const char* source) noexcept -> GLuint {
+		char infoLog[512];
+		int successFlag = 0;
+
+		const GLuint shader = FF_GL(glCreateShader, type);
+		FF_GL(glShaderSource, shader, 1, &source, NULL);
+		FF_GL(glCompileShader, shader);
+
+		FF_GL(glGetShaderiv, shader, GL_COMPILE_STATUS, &successFlag);
+		if (!successFlag) {
+			FF_GL(glGetShaderInfoLog, shader, 512, NULL, infoLog);
+			std::cout << infoLog << std::endl;
+		}
+
+		return shader;
+	}
+
+	DriverOcclusion::DriverOcclusion(const DriverState::Ptr& state, const DriverBindingStates::Ptr& bindingStates, const DriverInfo::Ptr& info) noexcept {
+		mState = state;
+		mBindingStates = bindingStates;
+		mInfo = info;
+
+		/// program
+		const GLuint vertexID = compileShader(GL_VERTEX_SHADER, BOX_VERTEX);
+		const GLuint fragID = compileShader(GL_FRAGMENT_SHADER, BOX_FRAGMENT);
+
+		mProgram = FF_GL(glCreateProgram);
+		FF_GL(glAttachShader, mProgram, vertexID);
+		FF_GL(glAttachShader, mProgram, fragID);
+		FF_GL(glLinkProgram, mProgram);
+
+		int successFlag = 0;
+		FF_GL(glGetProgramiv, mProgram, GL_LINK_STATUS, &successFlag);
+		if (!successFlag) {
+			char infoLog[512];
+			FF_GL(glGetProgramInfoLog, mProgram, 512, NULL, infoLog);
+			std::cout << infoLog << std::endl;
+		}
+		FF_GL(glDeleteShader, vertexID);
+		FF_GL(glDeleteShader, fragID);
+
+		mMVPLocation = FF_GL(glGetUniformLocation, mProgram, "mvp");
+
+		/// 单位立方体
+		const float positions[] = {
+			0.0f, 0.0f, 0.0f,
+			1.0f, 0.0f, 0.0f,
+			1.0f, 1.0f, 0.0f,
+			0.0f, 1.0f, 0.0f,
+			0.0f, 0.0f, 1.0f,
+			1.0f, 0.0f, 1.0f,
+			1.0f, 1.0f, 1.0f,
+			0.0f, 1.0f, 1.0f,
+		};
+
+		const uint8_t indices[] = {
+			0, 2, 1, 0, 3, 2,
+			4, 5, 6, 4, 6, 7,
+			0, 1, 5, 0, 5, 4,
+			3, 6, 2, 3, 7, 6,
+			0, 4, 7, 0, 7, 3,
+			1, 2, 6, 1, 6, 5,
+		};
+
+		mVAO = DriverBindingStates::createVao();
+		DriverBindingStates::bindVao(mVAO);
+
+		FF_GL(glGenBuffers, 1, &mVBO);
+		FF_GL_BIND(glBindBuffer, GL_ARRAY_BUFFER, mVBO);
+		FF_GL(glBufferData, GL_ARRAY_BUFFER, sizeof(positions), positions, GL_STATIC_DRAW);
+		FF_GL(glEnableVertexAttribArray, 0);
+		FF_GL(glVertexAttribPointer, 0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+
+		FF_GL(glGenBuffers, 1, &mEBO);
+		FF_GL_BIND(glBindBuffer, GL_ELEMENT_ARRAY_BUFFER, mEBO);
+		FF_GL(glBufferData, GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+
+		DriverBindingStates::bindVao(0);
+		mBindingStates->resetCurrentState();
+
+		/// 包围盒只参与深度检测，不能改动颜色与深度
+		mBoxMaterial = Material::create();
+		mBoxMaterial->mSide = Side::DoubleSide;
+		mBoxMaterial->mDepthWrite = false;
+		mBoxMaterial->mColorWrite = false;
+
+		mBoxPipelineState = DriverState::compilePipelineState(mBoxMaterial.get());
+	}
+
+	DriverOcclusion::~DriverOcclusion() noexcept {
+		for (const auto& [id, query] : mQueries) {
+			FF_GL(glDeleteQueries, 1, &query.mQuery);
+		}
+
+		FF_GL(glDeleteBuffers, 1, &mVBO);
+		FF_GL(glDeleteBuffers, 1, &mEBO);
+		FF_GL(glDeleteVertexArrays, 1, &mVAO);
+		FF_GL(glDeleteProgram, mProgram);
+	}
+
+	auto DriverOcclusion::beginFrame() noexcept -> void {
+		mFrame++;
+		mCandidates.clear();
+
+		/// 条件绘制不在CPU上回读结果
+		if (!mEnabled || mConditionalRender) {
+			return;
+		}
+
+		for (auto& [id, query] : mQueries) {
+			poll(query);
+		}
+	}
+
+	auto DriverOcclusion::getQuery(const RenderableObject* object) noexcept -> Query& {
+		auto& query = mQueries[object->getID()];
+		if (query.mQuery == 0) {
+			FF_GL(glGenQueries, 1, &query.mQuery);
+		}
+
+		return query;
+	}
+
+	auto DriverOcclusion::poll(Query& query) noexcept -> void {
+		if (!query.mPending) {
+			return;
+		}
+
+		GLuint available = 0;
+		FF_GL(glGetQueryObjectuiv, query.mQuery, GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available) {
+			return;
+		}
+
+		GLuint passed = 0;
+		FF_GL(glGetQueryObjectuiv, query.mQuery, GL_QUERY_RESULT, &passed);
+
+		query.mVisible = passed != 0;
+		query.mPending = false;
+		query.mHasResult = true;
+	}
+
+	auto DriverOcclusion::beginObject(const RenderableObject* object, bool depthPrePass) noexcept -> bool {
+		if (!mEnabled || !object->mOcclusionCulling) {
+			return true;
+		}
+
+		auto& query = getQuery(object);
+		if (query.mLastFrame != mFrame) {
+			query.mLastFrame = mFrame;
+			mCandidates.push_back(object);
+		}
+
+		if (mConditionalRender) {
+			/// 结果不可用时NO_WAIT会照常绘制，深度预渲染如果不等待，结果可能恰好在两次绘制之间回来，导致只写了深度或者只写了颜色
+			if (query.mHasResult) {
+				FF_GL(glBeginConditionalRender, query.mQuery, depthPrePass ? GL_QUERY_WAIT : GL_QUERY_NO_WAIT);
+				mConditionalActive = true;
+				if (!depthPrePass) mInfo->mRender.mOcclusionConditionalDraws++;
+			}
+
+			return true;
+		}
+
+		/// 可见性在beginFrame当中已经确定
+		if (!query.mVisible) {
+			if (!depthPrePass) mInfo->mRender.mOcclusionCulled++;
+			return false;
+		}
+
+		return true;
+	}
+
+	auto DriverOcclusion::endObject() noexcept -> void {
+		if (mConditionalActive) {
+			FF_GL(glEndConditionalRender);
+			mConditionalActive = false;
+		}
+	}
+
+	auto DriverOcclusion::computeWorldBox(const RenderableObject* object, glm::vec3& min, glm::vec3& max) noexcept -> bool {
+		/// 物体缓存的世界包围盒，InstancedMesh的包围盒包含了所有实例
+		const auto& box = object->getWorldBoundingBox();
+
+		/// 没有包围体的物体退化为一个点，无法可靠地查询
+		if (box.isEmpty() || box.mMin == box.mMax) return false;
+
+		min = box.mMin;
+		max = box.mMax;
+
+		return true;
+	}
+
+	auto DriverOcclusion::render(const Camera::Ptr& camera) noexcept -> void {
+		if (!mEnabled || mCandidates.empty()) {
+			release();
+			return;
+		}
+
+		const auto viewProjection = camera->getProjectionMatrix() * camera->getWorldMatrixInverse();
+		const auto cameraPosition = glm::vec3(camera->getWorldMatrix()[3]);
+
+		bool stateReady = false;
+
+		for (const auto object : mCandidates) {
+			auto& query = mQueries[object->getID()];
+
+			/// 上一次的结果还没有回来，沿用之前的结果；条件绘制不回读，每帧都重新查询
+			if (query.mPending && !mConditionalRender) {
+				continue;
+			}
+
+			glm::vec3 min;
+			glm::vec3 max;
+			if (!computeWorldBox(object, min, max)) {
+				query.mVisible = true;
+				query.mHasResult = false;
+				continue;
+			}
+
+			/// 相机在包围盒之内
+			if (glm::all(glm::greaterThanEqual(cameraPosition, min - mCameraMargin)) &&
+				glm::all(glm::lessThanEqual(cameraPosition, max + mCameraMargin))) {
+				query.mVisible = true;
+				query.mHasResult = false;
+				continue;
+			}
+
+			if (!stateReady) {
+				mState->useProgram(mProgram);
+				mState->setPipelineState(mBoxPipelineState);
+
+				/// 绕过了DriverBindingStates直接绑定VAO，下一次setup必须重新绑定
+				DriverBindingStates::bindVao(mVAO);
+				mBindingStates->resetCurrentState();
+
+				stateReady = true;
+			}
+
+			const auto mvp = viewProjection * glm::translate(glm::mat4(1.0f), min) * glm::scale(glm::mat4(1.0f), max - min);
+			FF_GL(glUniformMatrix4fv, mMVPLocation, 1, GL_FALSE, glm::value_ptr(mvp));
+
+			FF_GL(glBeginQuery, GL_ANY_SAMPLES_PASSED, query.mQuery);
+			FF_GL(glDrawElements, GL_TRIANGLES, 36, GL_UNSIGNED_BYTE, 0);
+			FF_GL(glEndQuery, GL_ANY_SAMPLES_PASSED);
+
+			if (mConditionalRender) {
+				query.mHasResult = true;
+			}
+			else {
+				query.mPending = true;
+			}
+
+			mInfo->mRender.mOcclusionQueries++;
+		}
+
+		mCandidates.clear();
+
+		if (stateReady) {
+			mState->restoreWriteMasks();
+		}
+
+		release();
+	}
+
+	auto DriverOcclusion::release() noexcept -> void {
+		for (auto iter = mQueries.begin(); iter != mQueries.end();) {
+			if (mFrame - iter->second.mLastFrame > RELEASE_FRAMES) {
+				FF_GL(glDeleteQueries, 1, &iter->second.mQuery);
+				iter = mQueries.erase(iter);
+			}
+			else {
+				++iter;
+			}
+		}
+	}
+}
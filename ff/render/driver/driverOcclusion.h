@@ -0,0 +1,105 @@
+﻿#pragma once
+#include "../../global/base.h"
+#include "../../objects/renderableObject.h"
+#include "../../camera/camera.h"
+#include "../../material/material.h"
+#include "driverState.h"
+#include "driverBindingState.h"
+#include "driverInfo.h"
+
+namespace ff {
+
+	/// 基于硬件遮挡查询(GL_ANY_SAMPLES_PASSED)的遮挡剔除，只对mOcclusionCulling为true的物体生效
+	/// 1 场景绘制结束之后，为本帧参与绘制的候选物体各画一个世界空间的包围盒(关闭颜色与深度写入)，每个包围盒包在一次查询当中
+	/// 2 之后的帧在beginFrame当中统一地、不等待地检查查询结果：结果已经可用则更新可见性，还不可用则沿用之前的结果，并且在结果回来之前不再发出新的查询；
+	///   一帧之内可见性不再变化，深度预渲染与正式绘制对同一个物体的决定总是一致的
+	/// 3 上一次结果为不可见的物体跳过绘制，但仍然作为候选物体继续查询，重新可见时恢复绘制(延迟一帧)
+	/// 4 开启mConditionalRender时，不在CPU上回读结果，物体的绘制包在glBeginConditionalRender(GL_QUERY_NO_WAIT)当中，由GPU决定是否绘制；
+	///   此时CPU无法知道剔除的数量，只统计条件绘制的次数；深度预渲染使用GL_QUERY_WAIT，保证GPU在两次绘制时使用同一个结果
+	/// 5 相机处在包围盒之内时，包围盒可能被近平面剪掉，直接视为可见
+	/// 注意：查询结果只对渲染场景所用的相机有效，同一帧用多个相机绘制同一个场景时结果会互相干扰；
+	/// 骨骼动画的包围盒来自绑定姿态，动作幅度大时可能被误剔除
+	class DriverOcclusion {
+	public:
+		/// 连续这么多帧没有成为候选物体，就删除其查询对象
+		static constexpr uint32_t RELEASE_FRAMES = 60;
+
+		using Ptr = std::shared_ptr<DriverOcclusion>;
+		static Ptr create(const DriverState::Ptr& state, const DriverBindingStates::Ptr& bindingStates, const DriverInfo::Ptr& info) {
+			return std::make_shared<DriverOcclusion>(state, bindingStates, info);
+		}
+
+		DriverOcclusion(const DriverState::Ptr& state, const DriverBindingStates::Ptr& bindingStates, const DriverInfo::Ptr& info) noexcept;
+
+		~DriverOcclusion() noexcept;
+
+		/// \brief 每帧绘制之前调用，回收所有已经可用的查询结果，本帧之内不再改变
+		auto beginFrame() noexcept -> void;
+
+		/// \brief 绘制物体之前调用，将其登记为本帧的候选物体
+		/// \param object
+		/// \param depthPrePass 深度预渲染中的绘制，不计入统计，条件绘制时等待结果
+		/// \return false代表物体被遮挡，应当跳过本次绘制
+		auto beginObject(const RenderableObject* object, bool depthPrePass = false) noexcept -> bool;
+
+		/// \brief 绘制物体之后调用，结束条件绘制
+		auto endObject() noexcept -> void;
+
+		/// \brief 为本帧的候选物体发出包围盒查询，需要在场景绘制结束、深度缓冲完整之后调用
+		/// \param camera
+		auto render(const Camera::Ptr& camera) noexcept -> void;
+
+	public:
+		bool mEnabled{ true };
+		bool mConditionalRender{ false };
+
+		/// 相机到包围盒的距离小于该值时，视为相机在包围盒之内，应当不小于相机的近平面距离
+		float mCameraMargin{ 0.5f };
+
+	private:
+		struct Query {
+			GLuint		mQuery{ 0 };
+
+			/// 最近一次可用的查询结果，没有结果之前视为可见
+			bool		mVisible{ true };
+			bool		mPending{ false };
+			bool		mHasResult{ false };
+
+			/// 最近一次成为候选物体的帧
+			uint32_t	mLastFrame{ 0 };
+		};
+
+		auto getQuery(const RenderableObject* object) noexcept -> Query&;
+
+		/// \brief 查询结果可用时更新可见性，不会等待GPU
+		auto poll(Query& query) noexcept -> void;
+
+		/// \brief 物体在世界空间的轴对齐包围盒
+		static auto computeWorldBox(const RenderableObject* object, glm::vec3& min, glm::vec3& max) noexcept -> bool;
+
+		auto release() noexcept -> void;
+
+	private:
+		DriverState::Ptr			mState{ nullptr };
+		DriverBindingStates::Ptr	mBindingStates{ nullptr };
+		DriverInfo::Ptr				mInfo{ nullptr };
+
+		std::unordered_map<ID, Query>			mQueries{};
+		std::vector<const RenderableObject*>	mCandidates{};
+		uint32_t	mFrame{ 0 };
+
+		/// 当前是否处在glBeginConditionalRender之内
+		bool		mConditionalActive{ false };
+
+		/// 单位立方体[0,1]^3，以及只输出位置的program
+		GLuint	mProgram{ 0 };
+		GLint	mMVPLocation{ -1 };
+		GLuint	mVAO{ 0 };
+		GLuint	mVBO{ 0 };
+		GLuint	mEBO{ 0 };
+
+		/// 双面、深度检测、不写深度也不写颜色
+		Material::Ptr				mBoxMaterial{ nullptr };
+		DriverState::PipelineState	mBoxPipelineState{};
+	};
+}
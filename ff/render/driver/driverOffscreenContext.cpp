@@ -0,0 +1,120 @@
+﻿#include "driverOffscreenContext.h"
+
+#ifdef FF_ENABLE_OFFSCREEN
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+namespace ff {
+
+#ifdef FF_ENABLE_OFFSCREEN
+
+	DriverOffscreenContext::DriverOffscreenContext(uint32_t majorVersion, uint32_t minorVersion) noexcept {
+		EGLDisplay display = EGL_NO_DISPLAY;
+
+		/// 1 优先尝试surfaceless平台，完全不需要显示服务器
+		const auto getPlatformDisplay =
+			reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+		if (getPlatformDisplay) {
+			display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+		}
+
+		/// 2 退而求其次，使用默认的display
+		if (display == EGL_NO_DISPLAY) {
+			display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+		}
+
+		EGLint major = 0;
+		EGLint minor = 0;
+		if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor)) {
+			std::cerr << "Error: failed to initialize EGL display" << std::endl;
+			exit(0);
+		}
+		mDisplay = display;
+
+		/// 使用桌面OpenGL，而非OpenGL ES
+		eglBindAPI(EGL_OPENGL_API);
+
+		const EGLint configAttributes[] = {
+			EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+			EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+			EGL_RED_SIZE, 8,
+			EGL_GREEN_SIZE, 8,
+			EGL_BLUE_SIZE, 8,
+			EGL_ALPHA_SIZE, 8,
+			EGL_DEPTH_SIZE, 24,
+			EGL_NONE
+		};
+
+		EGLConfig config = nullptr;
+		EGLint configCount = 0;
+		if (!eglChooseConfig(display, configAttributes, &config, 1, &configCount) || configCount == 0) {
+			std::cerr << "Error: failed to choose EGL config" << std::endl;
+			exit(0);
+		}
+
+		/// 与DriverWindow保持一致：核心模式，默认3.3
+		const EGLint contextAttributes[] = {
+			EGL_CONTEXT_MAJOR_VERSION, static_cast<EGLint>(majorVersion),
+			EGL_CONTEXT_MINOR_VERSION, static_cast<EGLint>(minorVersion),
+			EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+			EGL_NONE
+		};
+
+		EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttributes);
+		if (context == EGL_NO_CONTEXT) {
+			std::cerr << "Error: failed to create EGL context" << std::endl;
+			eglTerminate(display);
+			exit(0);
+		}
+		mContext = context;
+
+		/// 不绑定任何surface，所有的绘制都输出到FBO
+		if (!eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) {
+			/// 驱动不支持surfaceless context，则使用一个1x1的pbuffer占位
+			const EGLint pbufferAttributes[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+			EGLSurface surface = eglCreatePbufferSurface(display, config, pbufferAttributes);
+			if (surface == EGL_NO_SURFACE || !eglMakeCurrent(display, surface, surface, context)) {
+				std::cerr << "Error: failed to make EGL context current" << std::endl;
+				exit(0);
+			}
+			mSurface = surface;
+		}
+
+		/// 与glfw相同，需要通过EGL来装载glad的函数指针
+		if (!gladLoadGLLoader((GLADloadproc)eglGetProcAddress))
+		{
+			std::cout << "Failed to initialize GLAD" << std::endl;
+			exit(0);
+		}
+	}
+
+	DriverOffscreenContext::~DriverOffscreenContext() noexcept {
+		if (mDisplay == nullptr) {
+			return;
+		}
+
+		eglMakeCurrent(mDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+
+		if (mSurface != nullptr) {
+			eglDestroySurface(mDisplay, mSurface);
+		}
+
+		if (mContext != nullptr) {
+			eglDestroyContext(mDisplay, mContext);
+		}
+
+		eglTerminate(mDisplay);
+	}
+
+#else
+
+	DriverOffscreenContext::DriverOffscreenContext(uint32_t majorVersion, uint32_t minorVersion) noexcept {
+		std::cerr << "Error: offscreen rendering requires building with FF_ENABLE_OFFSCREEN" << std::endl;
+		exit(0);
+	}
+
+	DriverOffscreenContext::~DriverOffscreenContext() noexcept {}
+
+#endif
+}
@@ -0,0 +1,29 @@
+﻿#pragma once
+#include "../../global/base.h"
+
+namespace ff {
+
+	/// 无窗体的OpenGL上下文，用于离屏渲染（CI测试、缩略图生成、服务器端批量渲染、性能基准）
+	/// 使用EGL创建上下文：优先使用Mesa的surfaceless平台，不依赖任何显示服务器（X11/Wayland）
+	/// 由于没有窗体，也就没有默认的FrameBuffer，渲染结果由Renderer内部的默认RenderTarget承接
+	/// 需要在编译时开启FF_ENABLE_OFFSCREEN（CMake选项），否则创建时会报错退出
+	class DriverOffscreenContext {
+	public:
+		using Ptr = std::shared_ptr<DriverOffscreenContext>;
+		static Ptr create(uint32_t majorVersion = 3, uint32_t minorVersion = 3) {
+			return std::make_shared<DriverOffscreenContext>(majorVersion, minorVersion);
+		}
+
+		DriverOffscreenContext(uint32_t majorVersion = 3, uint32_t minorVersion = 3) noexcept;
+
+		~DriverOffscreenContext() noexcept;
+
+	private:
+		/// EGLDisplay/EGLContext/EGLSurface本质都是void*，这里不引入EGL头文件，避免污染外部
+		void* mDisplay{ nullptr };
+		void* mContext{ nullptr };
+
+		/// 只有当驱动不支持EGL_KHR_surfaceless_context时，才会创建一个1x1的pbuffer作为后备
+		void* mSurface{ nullptr };
+	};
+}
@@ -4,6 +4,9 @@
 #include "../../material/depthMaterial.h"
 #include "../../log/debugLog.h"
 #include "../../objects/skinnedMesh.h"
+#include "../../objects/instancedMesh.h"
+#include "../../tools/profiler.h"
+#include "../../wrapper/glTrace.h"
 
 namespace ff
 {
@@ -14,10 +17,15 @@ namespace ff
 		mID = Identity::generateID();
 
 		/// 1 shader版本字符串
+		/// multi-draw indirect需要SSBO(4.3)以及gl_DrawID(4.6或者ARB_shader_draw_parameters)
 		std::string versionString = "#version 330 core\n";
+		if (parameters->mMultiDraw)
+		{
+			versionString = parameters->mDrawIDCore ? "#version 460 core\n" : "#version 430 core\n";
+		}
 
 		/// 2 shader扩展字符串 
-		std::string extensionString = getExtensionString();
+		std::string extensionString = getExtensionString(parameters);
 
 		/// 3 prefix字符串，define的各类操作都会加入到prefix当中，从而决定后续代码当中哪些功能可以被打开
 		std::string prefixVertex;
@@ -34,6 +42,12 @@ namespace ff
 			                    : "");
 		prefixVertex.append(parameters->mUseNormalMap ? "#define USE_NORMALMAP\n" : "");
 		prefixVertex.append(parameters->mUseTangent ? "#define USE_TANGENT\n" : "");
+		prefixVertex.append(parameters->mInstancing ? "#define USE_INSTANCING\n" : "");
+		prefixVertex.append(parameters->mInstancingColor ? "#define USE_INSTANCING_COLOR\n" : "");
+		prefixVertex.append(parameters->mMultiDraw ? "#define USE_MULTI_DRAW\n" : "");
+		prefixVertex.append(parameters->mMultiDraw
+			                    ? std::string("#define DRAW_ID ") + (parameters->mDrawIDCore ? "gl_DrawID" : "gl_DrawIDARB") + "\n"
+			                    : "");
 
 		prefixFragment.append(parameters->mHasNormal ? "#define HAS_NORMAL\n" : "");
 		prefixFragment.append(parameters->mHasUV ? "#define HAS_UV\n" : "");
@@ -48,6 +62,7 @@ namespace ff
 			                      : "");
 		prefixFragment.append(parameters->mUseNormalMap ? "#define USE_NORMALMAP\n" : "");
 		prefixFragment.append(parameters->mUseTangent ? "#define USE_TANGENT\n" : "");
+		prefixFragment.append(parameters->mInstancingColor ? "#define USE_INSTANCING_COLOR\n" : "");
 
 		/// 4 从parameters里面取出来vs/fs基础功能代码
 		auto vertexString = parameters->mVertex;
@@ -83,52 +98,57 @@ namespace ff
 		char infoLog[512];
 		int successFlag = 0;
 
-		vertexID = glCreateShader(GL_VERTEX_SHADER);
-		glShaderSource(vertexID, 1, &vertex, NULL);
-		glCompileShader(vertexID);
+		vertexID = FF_GL(glCreateShader, GL_VERTEX_SHADER);
+		FF_GL(glShaderSource, vertexID, 1, &vertex, NULL);
+		FF_GL(glCompileShader, vertexID);
 
 		/// 获取错误信息
-		glGetShaderiv(vertexID, GL_COMPILE_STATUS, &successFlag);
+		FF_GL(glGetShaderiv, vertexID, GL_COMPILE_STATUS, &successFlag);
 		if (!successFlag)
 		{
-			glGetShaderInfoLog(vertexID, 512, NULL, infoLog);
+			FF_GL(glGetShaderInfoLog, vertexID, 512, NULL, infoLog);
 			std::cout << infoLog << std::endl;
 		}
 
-		fragID = glCreateShader(GL_FRAGMENT_SHADER);
-		glShaderSource(fragID, 1, &fragment, NULL);
-		glCompileShader(fragID);
+		fragID = FF_GL(glCreateShader, GL_FRAGMENT_SHADER);
+		FF_GL(glShaderSource, fragID, 1, &fragment, NULL);
+		FF_GL(glCompileShader, fragID);
 
-		glGetShaderiv(fragID, GL_COMPILE_STATUS, &successFlag);
+		FF_GL(glGetShaderiv, fragID, GL_COMPILE_STATUS, &successFlag);
 		if (!successFlag)
 		{
-			glGetShaderInfoLog(fragID, 512, NULL, infoLog);
+			FF_GL(glGetShaderInfoLog, fragID, 512, NULL, infoLog);
 			std::cout << infoLog << std::endl;
 		}
 
 		/// 链接
-		mProgram = glCreateProgram();
-		glAttachShader(mProgram, vertexID);
-		glAttachShader(mProgram, fragID);
-		glLinkProgram(mProgram);
+		mProgram = FF_GL(glCreateProgram);
+		FF_GL(glAttachShader, mProgram, vertexID);
+		FF_GL(glAttachShader, mProgram, fragID);
+		FF_GL(glLinkProgram, mProgram);
 
-		glGetProgramiv(mProgram, GL_LINK_STATUS, &successFlag);
+		FF_GL(glGetProgramiv, mProgram, GL_LINK_STATUS, &successFlag);
 		if (!successFlag)
 		{
-			glGetProgramInfoLog(mProgram, 512, NULL, infoLog);
+			FF_GL(glGetProgramInfoLog, mProgram, 512, NULL, infoLog);
 			std::cout << infoLog << std::endl;
 		}
-		glDeleteShader(vertexID);
-		glDeleteShader(fragID);
+		FF_GL(glDeleteShader, vertexID);
+		FF_GL(glDeleteShader, fragID);
+
+		/// CameraBlock与LightsBlock对应到固定的binding point
+		DriverUniformBuffers::bindBlocks(mProgram);
 
 		DebugLog::getInstance()->beginPrintUniformInfo(parameters->mShaderID);
 		mUniforms = DriverUniforms::create(mProgram);
 		DebugLog::getInstance()->end();
+
+		mUniformTable = DriverUniformTable::create(mProgram);
 	}
 
 	DriverProgram::~DriverProgram() noexcept
 	{
-		glDeleteProgram(mProgram);
+		FF_GL(glDeleteProgram, mProgram);
 	}
 
 	auto DriverProgram::replaceAttributeLocations(std::string& shader) const noexcept -> void
@@ -146,6 +166,8 @@ namespace ff
 			{"SKINNING_WEIGHTS_LOCATION", std::to_string(LOCATION_MAP.at("skinWeight"))},
 			{"TANGENT_LOCATION", std::to_string(LOCATION_MAP.at("tangent"))},
 			{"BITANGENT_B_LOCATION", std::to_string(LOCATION_MAP.at("bitangent"))},
+			{"INSTANCE_MATRIX_LOCATION", std::to_string(LOCATION_MAP.at("instanceMatrix"))},
+			{"INSTANCE_COLOR_LOCATION", std::to_string(LOCATION_MAP.at("instanceColor"))},
 		};
 
 		for (const auto& iter : replaceMap)
@@ -154,7 +176,8 @@ namespace ff
 			/// iter.second = location数字的字符串
 
 			/// 使用c++的正则表达式进行替换，直接使用占位符的字符串初始化了regex
-			std::regex pattern(iter.first);
+			/// 前后加上单词边界，防止COLOR_LOCATION匹配到INSTANCE_COLOR_LOCATION的一部分
+			std::regex pattern("\\b" + iter.first + "\\b");
 
 			/// 扫描整个shader字符串，只要发现符合pattern的字符串，就要替换为iter.second
 			shader = std::regex_replace(shader, pattern, iter.second);
@@ -168,6 +191,7 @@ namespace ff
 		std::unordered_map<std::string, std::string> replaceMap = {
 			{"NUM_DIR_LIGHTS", std::to_string(parameters->mDirectionalLightCount)},
 			{"NUM_DIR_LIGHT_SHADOWS", std::to_string(parameters->mNumDirectionalLightShadows)},
+			{"MAX_DIR_LIGHTS", std::to_string(DriverLights::MAX_DIRECTIONAL_LIGHTS)},
 		};
 
 		for (const auto& iter : replaceMap)
@@ -177,17 +201,30 @@ namespace ff
 		}
 	}
 
-	auto DriverProgram::getExtensionString() noexcept -> std::string
+	auto DriverProgram::getExtensionString(const Parameters::Ptr& parameters) noexcept -> std::string
 	{
 		std::string extensionString = "";
 		extensionString.append("#extension GL_ARB_separate_shader_objects : enable\n");
 
+		if (parameters->mMultiDraw && !parameters->mDrawIDCore)
+		{
+			extensionString.append("#extension GL_ARB_shader_draw_parameters : require\n");
+		}
+
 		return extensionString;
 	}
 
 	auto DriverProgram::uploadUniforms(UniformHandleMap& uniformMap, const DriverTextures::Ptr& textures) const -> void
 	{
+		FF_PROFILE_SCOPE("uploadUniforms");
 		mUniforms->upload(uniformMap, textures);
+		mUniformTable->invalidate();
+	}
+
+	auto DriverProgram::uploadUniforms(const DriverUniformTable::Sources& sources, const DriverTextures::Ptr& textures, const DriverInfo::Ptr& info) const -> void
+	{
+		FF_PROFILE_SCOPE("uploadUniforms");
+		mUniformTable->upload(sources, textures, info);
 	}
 
 	/// -----------------------------------driver programs---------------------------- ///
@@ -211,6 +248,7 @@ namespace ff
 			return iter->second;
 		}
 
+		FF_PROFILE_SCOPE("compileProgram");
 		auto program = DriverProgram::create(parameters);
 		program->mCacheKey = cacheKey;
 		mPrograms.insert(std::make_pair(cacheKey, program));
@@ -232,14 +270,15 @@ namespace ff
 	}
 
 	auto DriverPrograms::getParameters(
-		const Material::Ptr& material,
-		const Object3D::Ptr& object,
+		const Material* material,
+		const Object3D* object,
 		const DriverLights::Ptr& lights,
-		const DriverShadowMap::Ptr& shadowMap
+		const DriverShadowMap::Ptr& shadowMap,
+		bool multiDraw
 	) const noexcept -> DriverProgram::Parameters::Ptr
 	{
-		const auto renderObject = std::static_pointer_cast<RenderableObject>(object);
-		const auto geometry = renderObject->getGeometry();
+		const auto renderObject = static_cast<const RenderableObject*>(object);
+		const auto& geometry = renderObject->getGeometry();
 
 		/// 新建一个parameters
 		auto parameters = DriverProgram::Parameters::create();
@@ -297,29 +336,40 @@ namespace ff
 
 		if (object->mIsRenderableObject)
 		{
-			auto renderableObject = std::static_pointer_cast<RenderableObject>(object);
-			auto geometry = renderableObject->getGeometry();
 			parameters->mUseTangent = geometry->hasAttribute("tangent");
 		}
 
 		if (material->mIsDepthMaterial)
 		{
-			auto depthMaterial = std::static_pointer_cast<DepthMaterial>(material);
+			const auto depthMaterial = static_cast<const DepthMaterial*>(material);
 			parameters->mDepthPacking = depthMaterial->mPacking;
 		}
 
 		if (object->mIsSkinnedMesh)
 		{
-			const auto skinnedMesh = std::static_pointer_cast<SkinnedMesh>(object);
+			const auto skinnedMesh = static_cast<const SkinnedMesh*>(object);
 			parameters->mSkinning = true;
 			parameters->mMaxBones = skinnedMesh->mSkeleton->mBones.size();
 		}
 
+		if (object->mIsInstancedMesh)
+		{
+			const auto instancedMesh = static_cast<const InstancedMesh*>(object);
+			parameters->mInstancing = true;
+			parameters->mInstancingColor = instancedMesh->getInstanceColor() != nullptr;
+		}
+
+		if (multiDraw)
+		{
+			parameters->mMultiDraw = true;
+			parameters->mDrawIDCore = mDrawIDCore;
+		}
+
 		return parameters;
 	}
 
 
-	auto DriverPrograms::getUniforms(const Material::Ptr& material) noexcept -> UniformHandleMap
+	auto DriverPrograms::getUniforms(const Material* material) noexcept -> UniformHandleMap
 	{
 		UniformHandleMap uniforms{};
 
@@ -356,6 +406,10 @@ namespace ff
 		keyString.append(std::to_string(parameters->mUseNormalMap));
 		keyString.append(std::to_string(parameters->mUseTangent));
 		keyString.append(std::to_string(parameters->mDepthPacking));
+		keyString.append(std::to_string(parameters->mInstancing));
+		keyString.append(std::to_string(parameters->mInstancingColor));
+		keyString.append(std::to_string(parameters->mMultiDraw));
+		keyString.append(std::to_string(parameters->mDrawIDCore));
 
 		return hasher(keyString);
 	}
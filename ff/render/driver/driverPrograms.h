@@ -3,7 +3,9 @@
 #include "../../objects/renderableObject.h"
 #include "../../material/material.h"
 #include "driverUniforms.h"
+#include "driverUniformTable.h"
 #include "driverLights.h"
+#include "driverUniformBuffers.h"
 #include "driverShadowMap.h"
 #include "../shaders/uniformsLib.h"
 
@@ -22,7 +24,10 @@ namespace ff {
 			std::string		mVertex;							/// vs的代码
 			std::string		mFragment;							/// fs的代码
 
-			bool			mInstancing{ false };				/// 是否启用实例绘制,TODO
+			bool			mInstancing{ false };				/// 是否启用实例绘制
+			bool			mInstancingColor{ false };			/// 实例绘制时，是否有每个实例的颜色
+			bool			mMultiDraw{ false };				/// 是否使用multi-draw indirect绘制，矩阵从SSBO中按gl_DrawID读取
+			bool			mDrawIDCore{ false };				/// gl_DrawID是否为核心功能(4.6)，否则使用ARB_shader_draw_parameters
 			bool			mHasNormal{ false };				/// 本次绘制的模型是否有法线
 			bool			mHasUV{ false };					/// 本次绘制的模型是否有uv
 			bool			mHasColor{ false };					/// 本次绘制的模型是否有顶点颜色
@@ -60,17 +65,24 @@ namespace ff {
 
 		auto uploadUniforms(UniformHandleMap& uniformGroup, const DriverTextures::Ptr& textures) const -> void;
 
+		/// \brief 使用链接时编译好的uniform表上传，不经过UniformHandleMap
+		/// \param sources
+		/// \param textures
+		/// \param info
+		auto uploadUniforms(const DriverUniformTable::Sources& sources, const DriverTextures::Ptr& textures, const DriverInfo::Ptr& info) const -> void;
+
 	private:
 		auto replaceAttributeLocations(std::string& shader) const noexcept -> void;
 		auto replaceLightNumbers(std::string& shader, const Parameters::Ptr& parameters) const noexcept -> void;
 
-		auto getExtensionString() noexcept -> std::string;
+		auto getExtensionString(const Parameters::Ptr& parameters) noexcept -> std::string;
 
 	private:
 		uint32_t	mID{ 0 };			/// driverProgram 自己的id号
 		HashType	mCacheKey{ 0 };		/// 由parameters参数合集计算出来的hash值
 		uint32_t	mRefCount{ 0 };		/// 控制外界有多少引用本Program的renderItem
 		DriverUniforms::Ptr mUniforms = nullptr;
+		DriverUniformTable::Ptr mUniformTable = nullptr;
 	};
 
 	/// 1 对于DriverProgram的管理,存储成了一个map，key是program的哈希值，value就是DriverProgram的智能指针
@@ -92,7 +104,7 @@ namespace ff {
 		/// \brief				根据传入Material类型的不同，返回其必须的UniformHandleMap
 		/// \param material 
 		/// \return 
-		auto getUniforms(const Material::Ptr& material) noexcept -> UniformHandleMap;
+		auto getUniforms(const Material* material) noexcept -> UniformHandleMap;
 
 		
 		/// \brief				提取创建shader所必要的信息，组成一个parameters返回
@@ -100,12 +112,14 @@ namespace ff {
 		/// \param object		当前渲染物体的object3D
 		/// \param lights		当前渲染物体的光源信息
 		/// \param shadowMap	当前渲染物体的阴影信息
+		/// \param multiDraw	是否使用multi-draw indirect绘制
 		/// \return 
 		auto getParameters(
-			const Material::Ptr& material,
-			const Object3D::Ptr& object,
+			const Material* material,
+			const Object3D* object,
 			const DriverLights::Ptr& lights,
-			const DriverShadowMap::Ptr& shadowMap) const noexcept -> DriverProgram::Parameters::Ptr;
+			const DriverShadowMap::Ptr& shadowMap,
+			bool multiDraw = false) const noexcept -> DriverProgram::Parameters::Ptr;
 
 		/// \brief				将parameters做成字符串，然后进行哈希运算，得到最终的哈希结果
 		/// \param parameters 
@@ -116,6 +130,10 @@ namespace ff {
 		/// \param program 
 		auto release(const DriverProgram::Ptr& program) noexcept -> void;
 
+	public:
+		/// 当前上下文中gl_DrawID是否为核心功能，由Renderer在查询上下文能力之后设置
+		bool mDrawIDCore{ false };
+
 	private:
 		/// key-paramters做成的哈希值，value-用本parameters生成的driverProgram
 		std::unordered_map<HashType, DriverProgram::Ptr> mPrograms{};
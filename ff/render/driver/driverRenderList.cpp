@@ -2,31 +2,59 @@
 
 namespace ff
 {
-	RenderItem::Ptr RenderItem::create()
-	{
-		return std::make_shared<RenderItem>();
-	}
+	/// 排序键中各个字段所占的位数，从高位到低位：groupOrder | depth | program | material | geometry
+	/// program/material/geometry只取id的低位，只用于让相同状态的物体尽量相邻，碰撞不影响正确性
+	static constexpr uint32_t GROUP_ORDER_BITS = 8;
+	static constexpr uint32_t DEPTH_BITS = 24;
+	static constexpr uint32_t PROGRAM_BITS = 10;
+	static constexpr uint32_t MATERIAL_BITS = 12;
+	static constexpr uint32_t GEOMETRY_BITS = 10;
+
+	static constexpr uint32_t GEOMETRY_SHIFT = 0;
+	static constexpr uint32_t MATERIAL_SHIFT = GEOMETRY_SHIFT + GEOMETRY_BITS;
+	static constexpr uint32_t PROGRAM_SHIFT = MATERIAL_SHIFT + MATERIAL_BITS;
+	static constexpr uint32_t DEPTH_SHIFT = PROGRAM_SHIFT + PROGRAM_BITS;
+	static constexpr uint32_t GROUP_ORDER_SHIFT = DEPTH_SHIFT + DEPTH_BITS;
+
+	static_assert(GROUP_ORDER_SHIFT + GROUP_ORDER_BITS == 64, "render sort key must be 64 bits");
+	static_assert(DriverRenderList::MAX_GROUP_ORDER == (1u << GROUP_ORDER_BITS) - 1, "MAX_GROUP_ORDER must match GROUP_ORDER_BITS");
+
+	/// StateFirst布局，从高位到低位：groupOrder | program | material | geometry | 深度桶
+	/// 状态字段放在深度之前，相同状态的物体一定相邻；深度只保留粗粒度的桶，在相同状态内部仍然由近到远
+	static constexpr uint32_t STATE_PROGRAM_BITS = 12;
+	static constexpr uint32_t STATE_MATERIAL_BITS = 14;
+	static constexpr uint32_t STATE_GEOMETRY_BITS = 14;
+	static constexpr uint32_t DEPTH_BUCKET_BITS = 16;
+
+	static constexpr uint32_t DEPTH_BUCKET_SHIFT = 0;
+	static constexpr uint32_t STATE_GEOMETRY_SHIFT = DEPTH_BUCKET_SHIFT + DEPTH_BUCKET_BITS;
+	static constexpr uint32_t STATE_MATERIAL_SHIFT = STATE_GEOMETRY_SHIFT + STATE_GEOMETRY_BITS;
+	static constexpr uint32_t STATE_PROGRAM_SHIFT = STATE_MATERIAL_SHIFT + STATE_MATERIAL_BITS;
+
+	static_assert(STATE_PROGRAM_SHIFT + STATE_PROGRAM_BITS == GROUP_ORDER_SHIFT, "state sort key must be 64 bits");
 
+	static constexpr uint64_t bitMask(uint32_t bits) { return (uint64_t(1) << bits) - 1; }
 
 	DriverRenderList::Ptr DriverRenderList::create()
 	{
 		return std::make_shared<DriverRenderList>();
 	}
 
-	auto DriverRenderList::getOpaques() const noexcept -> const std::vector<RenderItem::Ptr>&
+	auto DriverRenderList::getRenderItems() const noexcept -> const std::vector<RenderItem>&
+	{
+		return mRenderItems;
+	}
+
+	auto DriverRenderList::getOpaques() const noexcept -> const std::vector<uint32_t>&
 	{
 		return mOpaques;
 	}
 
-	auto DriverRenderList::getTransparents() const noexcept -> const std::vector<RenderItem::Ptr>&
+	auto DriverRenderList::getTransparents() const noexcept -> const std::vector<uint32_t>&
 	{
 		return mTransparents;
 	}
 
-	RenderItem::RenderItem() noexcept = default;
-
-	RenderItem::~RenderItem() noexcept = default;
-
 	DriverRenderList::DriverRenderList() = default;
 
 	DriverRenderList::~DriverRenderList() = default;
@@ -34,108 +62,295 @@ namespace ff
 	/// 每一帧开始的时候，渲染列表都会被清空
 	auto DriverRenderList::init() noexcept -> void
 	{
-		mRenderItemIndex = 0;
+		mRenderItems.clear();
 		mOpaques.clear();
 		mTransparents.clear();
+
+		mMinZ = 0.0f;
+		mMaxZ = 0.0f;
+
+		mOpaqueStateChanges = {};
+		mDepthOrderStateChanges = {};
 	}
 
 	/// 在这里我们push进去一个可渲染物体的相关参数，解包的方式
 	/// 为什么需要解包传送,有可能会有替代,举例：本来object拥有一个material，但是scene也拥有一个overrideMaterial
 	/// 那么就不能使用object原来的material
 	auto DriverRenderList::push(
-		const RenderableObject::Ptr& object,
-		const Geometry::Ptr& geometry,
-		const Material::Ptr& material,
+		RenderableObject* object,
+		Geometry* geometry,
+		Material* material,
 		const uint32_t& groupOrder,
-		float z
+		float z,
+		uint32_t programID
 	) noexcept -> void
 	{
-		/// 每一帧都会重新构建renderList，所以比如有5个物体，如果不做renderItem的缓存，那么
-		/// 每一帧都要重新new 5个renderItem
-		/// 所以上一帧假设我们已经生成了10个renderItem，那么会将其缓存在renderItemCache里面，在需要的时候，就
-		/// 从中取出一个给到renderList使用
-		const auto renderItem = getNextRenderItem(object, geometry, material, groupOrder, z);
+		/// 记录深度范围，排序的时候用来量化深度
+		if (mRenderItems.empty())
+		{
+			mMinZ = z;
+			mMaxZ = z;
+		}
+		else
+		{
+			mMinZ = std::min(mMinZ, z);
+			mMaxZ = std::max(mMaxZ, z);
+		}
+
+		/// 每一帧都会重新构建renderList，mRenderItems在init中只是clear，容量会保留下来
+		/// 所以稳定之后，push只是向连续内存中写入一个值，既没有内存分配，也没有引用计数
+		const auto index = static_cast<uint32_t>(mRenderItems.size());
+
+		auto& renderItem = mRenderItems.emplace_back();
+		renderItem.mID = object->getID();
+		renderItem.mObject = object;
+		renderItem.mGeometry = geometry;
+		renderItem.mMaterial = material;
+		renderItem.mGroupOrder = groupOrder;
+
+		/// 超出范围的groupOrder在排序键中被截断，与MAX_GROUP_ORDER的物体无法区分先后
+		if (groupOrder > MAX_GROUP_ORDER && !mGroupOrderWarned)
+		{
+			std::cout << "Warning: groupOrder " << groupOrder << " exceeds " << MAX_GROUP_ORDER
+				<< " and is clamped in the render sort key" << std::endl;
+			mGroupOrderWarned = true;
+		}
+		renderItem.mZ = z;
+		renderItem.mProgramID = programID;
 
 		/// 检测是否开启透明
 		if (material->mTransparent)
 		{
-			mTransparents.push_back(renderItem);
+			mTransparents.push_back(index);
 		}
 		else
 		{
-			mOpaques.push_back(renderItem);
+			mOpaques.push_back(index);
 		}
 	}
 
-	auto DriverRenderList::getNextRenderItem(
-		const RenderableObject::Ptr& object,
-		const Geometry::Ptr& geometry,
-		const Material::Ptr& material,
-		const uint32_t& groupOrder,
-		float z
-	) noexcept -> RenderItem::Ptr
+	auto DriverRenderList::sort(
+		RenderSortLayout opaqueLayout,
+		RenderSortLayout transparentLayout,
+		bool depthOrderStatistics) noexcept -> void
 	{
-		RenderItem::Ptr renderItem = nullptr;
-
-		/// 如果当前renderItem的总数已经大于了缓存数量，那么就重新生成
-		/// 否则直接从缓存当中抽取第mRenderItemIndex个item
-		if (mRenderItemIndex >= mRenderItemCache.size())
+		if (mOpaques.size() > 1)
 		{
-			renderItem = RenderItem::create();
-			mRenderItemCache.push_back(renderItem);
+			/// 不是按照深度排序的时候，额外按照深度排序一次，用来统计两种顺序各自需要多少次状态切换
+			/// 完整的第二次排序只为了统计，所以只在调用者要求时进行
+			if (depthOrderStatistics && opaqueLayout != RenderSortLayout::SmallerZFirst)
+			{
+				mDepthOrder = mOpaques;
+				radixSort(mDepthOrder, RenderSortLayout::SmallerZFirst);
+				mDepthOrderStateChanges = countStateChanges(mDepthOrder);
+			}
+
+			radixSort(mOpaques, opaqueLayout);
 		}
-		else
+
+		mOpaqueStateChanges = countStateChanges(mOpaques);
+		if (opaqueLayout == RenderSortLayout::SmallerZFirst || mOpaques.size() <= 1)
 		{
-			renderItem = mRenderItemCache[mRenderItemIndex];
+			mDepthOrderStateChanges = mOpaqueStateChanges;
 		}
 
-		renderItem->mID = object->getID();
-		renderItem->mObject = object;
-		renderItem->mGeometry = geometry;
-		renderItem->mMaterial = material;
-		renderItem->mGroupOrder = groupOrder;
-		renderItem->mZ = z;
-
-		mRenderItemIndex++;
-
-		return renderItem;
+		if (mTransparents.size() > 1) radixSort(mTransparents, transparentLayout);
 	}
 
 	auto DriverRenderList::sort(
 		const RenderListSortFunction& opaqueSort,
 		const RenderListSortFunction& transparentSort) noexcept -> void
 	{
-		if (!mOpaques.empty()) std::sort(mOpaques.begin(), mOpaques.end(), opaqueSort);
+		const auto& items = mRenderItems;
+
+		if (!mOpaques.empty())
+		{
+			std::sort(mOpaques.begin(), mOpaques.end(), [&](uint32_t index0, uint32_t index1)
+			{
+				return opaqueSort(items[index0], items[index1]);
+			});
+		}
 
-		if (!mTransparents.empty()) std::sort(mTransparents.begin(), mTransparents.end(), transparentSort);
+		if (!mTransparents.empty())
+		{
+			std::sort(mTransparents.begin(), mTransparents.end(), [&](uint32_t index0, uint32_t index1)
+			{
+				return transparentSort(items[index0], items[index1]);
+			});
+		}
 	}
 
-	/// 如果缓存当中存在10个item，本帧只有5个物体需要渲染，那么就会使用到10个item里面的五个
-	/// 但是！剩下的没有使用到的五个，item里面，却存有object、materil、geometry的智能指针,则其内存无法被释放
-	/// 所以finish需要检测剩下的没有使用到的item，然后依次将其智能指针的引用置空
-	auto DriverRenderList::finish() noexcept -> void
+	auto DriverRenderList::makeSortKey(const RenderItem& item, RenderSortLayout layout) const noexcept -> uint64_t
+	{
+		/// groupOrder大的先绘制，所以取反
+		const uint64_t groupOrderMask = bitMask(GROUP_ORDER_BITS);
+		const uint64_t groupOrder = groupOrderMask - std::min<uint64_t>(item.mGroupOrder, groupOrderMask);
+
+		/// 将深度量化到[0, 2^DEPTH_BITS - 1]
+		const uint64_t depthMask = bitMask(DEPTH_BITS);
+		uint64_t depth = 0;
+
+		const float range = mMaxZ - mMinZ;
+		if (range > 0.0f)
+		{
+			const float normalized = std::clamp((item.mZ - mMinZ) / range, 0.0f, 1.0f);
+			depth = static_cast<uint64_t>(normalized * static_cast<float>(depthMask));
+		}
+
+		/// 由远到近，深度取反
+		if (layout == RenderSortLayout::BiggerZFirst)
+		{
+			depth = depthMask - depth;
+		}
+
+		if (layout == RenderSortLayout::StateFirst)
+		{
+			const uint64_t program = item.mProgramID & bitMask(STATE_PROGRAM_BITS);
+			const uint64_t material = item.mMaterial->getID() & bitMask(STATE_MATERIAL_BITS);
+			const uint64_t geometry = item.mGeometry->getID() & bitMask(STATE_GEOMETRY_BITS);
+			const uint64_t depthBucket = depth >> (DEPTH_BITS - DEPTH_BUCKET_BITS);
+
+			return (groupOrder << GROUP_ORDER_SHIFT)
+				| (program << STATE_PROGRAM_SHIFT)
+				| (material << STATE_MATERIAL_SHIFT)
+				| (geometry << STATE_GEOMETRY_SHIFT)
+				| (depthBucket << DEPTH_BUCKET_SHIFT);
+		}
+
+		const uint64_t program = item.mProgramID & bitMask(PROGRAM_BITS);
+		const uint64_t material = item.mMaterial->getID() & bitMask(MATERIAL_BITS);
+		const uint64_t geometry = item.mGeometry->getID() & bitMask(GEOMETRY_BITS);
+
+		return (groupOrder << GROUP_ORDER_SHIFT)
+			| (depth << DEPTH_SHIFT)
+			| (program << PROGRAM_SHIFT)
+			| (material << MATERIAL_SHIFT)
+			| (geometry << GEOMETRY_SHIFT);
+	}
+
+	auto DriverRenderList::radixSort(std::vector<uint32_t>& queue, RenderSortLayout layout) noexcept -> void
 	{
-		const auto listSize = mRenderItemCache.size();
+		const auto count = static_cast<uint32_t>(queue.size());
+
+		mKeys.resize(count);
+		mKeysTemp.resize(count);
+		mIndices.resize(count);
+		mIndicesTemp.resize(count);
+
+		/// 1 生成排序键，并且在同一次遍历当中统计8个字节各自的直方图
+		uint32_t histograms[8][256] = {};
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			const auto key = makeSortKey(mRenderItems[queue[i]], layout);
+			mKeys[i] = key;
+			mIndices[i] = queue[i];
+
+			for (uint32_t b = 0; b < 8; ++b)
+			{
+				histograms[b][(key >> (b * 8)) & 0xff]++;
+			}
+		}
+
+		/// 2 从最低字节到最高字节，依次进行稳定的计数排序
+		auto keys = mKeys.data();
+		auto keysTemp = mKeysTemp.data();
+		auto indices = mIndices.data();
+		auto indicesTemp = mIndicesTemp.data();
 
-		/// 0 1 2 ..... 9 cache里面的
-		/// 0 1 2 3 4 使用到的
-		/// mRenderItemIndex = 5，则这个循环会检测：
-		/// 5 6 7 8 9
-		for (uint32_t i = mRenderItemIndex; i < listSize; ++i)
+		for (uint32_t b = 0; b < 8; ++b)
 		{
-			auto renderItem = mRenderItemCache[i];
-			if (renderItem == nullptr)
+			const uint32_t shift = b * 8;
+			const auto& histogram = histograms[b];
+
+			/// 所有的键在这个字节上都相同，本轮不会改变顺序，直接跳过
+			/// 比如groupOrder通常全部相同，id的高位也通常相同
+			if (histogram[(keys[0] >> shift) & 0xff] == count) continue;
+
+			uint32_t offsets[256];
+			uint32_t sum = 0;
+			for (uint32_t v = 0; v < 256; ++v)
+			{
+				offsets[v] = sum;
+				sum += histogram[v];
+			}
+
+			for (uint32_t i = 0; i < count; ++i)
 			{
-				break;
+				const auto dst = offsets[(keys[i] >> shift) & 0xff]++;
+				keysTemp[dst] = keys[i];
+				indicesTemp[dst] = indices[i];
 			}
 
-			/// 清空所有的智能指针引用以及数据
-			renderItem->mID = 0;
-			renderItem->mObject = nullptr;
-			renderItem->mGeometry = nullptr;
-			renderItem->mGroupOrder = 0;
-			renderItem->mMaterial = nullptr;
-			renderItem->mZ = 0;
+			std::swap(keys, keysTemp);
+			std::swap(indices, indicesTemp);
 		}
+
+		/// 3 排好序的下标就是新的队列，renderItem本身不需要移动
+		if (indices != mIndices.data())
+		{
+			mIndices.swap(mIndicesTemp);
+		}
+
+		queue.swap(mIndices);
+	}
+
+	/// 某张纹理与上一次DrawCall所使用的不同，就需要重新绑定一次
+	static auto textureBinds(const Material* material, const Material* last) noexcept -> uint32_t
+	{
+		if (material == last) return 0;
+
+		uint32_t binds = 0;
+		if (material->mDiffuseMap && (last == nullptr || last->mDiffuseMap != material->mDiffuseMap)) binds++;
+		if (material->mEnvMap && (last == nullptr || last->mEnvMap != material->mEnvMap)) binds++;
+		if (material->mNormalMap && (last == nullptr || last->mNormalMap != material->mNormalMap)) binds++;
+		if (material->mSpecularMap && (last == nullptr || last->mSpecularMap != material->mSpecularMap)) binds++;
+
+		return binds;
+	}
+
+	/// 按照队列顺序模拟一遍绘制：program按照上一次绘制使用的program计算，一个geometry对应一个VAO
+	auto DriverRenderList::countStateChanges(const std::vector<uint32_t>& queue) const noexcept -> DriverInfo::StateChanges
+	{
+		DriverInfo::StateChanges changes{};
+		const RenderItem* last = nullptr;
+
+		for (const auto index : queue)
+		{
+			const auto& item = mRenderItems[index];
+
+			if (last == nullptr || last->mProgramID != item.mProgramID) changes.mPrograms++;
+			if (last == nullptr || last->mGeometry != item.mGeometry) changes.mVAOs++;
+			changes.mTextures += textureBinds(item.mMaterial, last != nullptr ? last->mMaterial : nullptr);
+
+			last = &item;
+		}
+
+		return changes;
+	}
+
+	/// renderItem只保存裸指针，并不持有object、material、geometry，不会延长它们的生命周期
+	/// 所以构建完毕之后不再需要像以前缓存智能指针时那样，逐个清空未使用到的item
+	auto DriverRenderList::finish() noexcept -> void
+	{
+	}
+
+	auto DriverRenderList::swapOpaques(std::vector<uint32_t>& opaques) noexcept -> void
+	{
+		mOpaques.swap(opaques);
+	}
+
+	auto DriverRenderList::retain() noexcept -> void
+	{
+		mRetainedItems = static_cast<uint32_t>(mRenderItems.size());
+		mRetainedOpaques = static_cast<uint32_t>(mOpaques.size());
+		mRetainedTransparents = static_cast<uint32_t>(mTransparents.size());
+	}
+
+	/// 临时加入的renderItem一定位于各个数组的末尾，直接截断即可，排序结果保持不变
+	auto DriverRenderList::restore() noexcept -> void
+	{
+		mRenderItems.resize(mRetainedItems);
+		mOpaques.resize(mRetainedOpaques);
+		mTransparents.resize(mRetainedTransparents);
 	}
-}
+}
\ No newline at end of file
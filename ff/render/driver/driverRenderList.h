@@ -3,75 +3,75 @@
 #include "../../objects/renderableObject.h"
 #include "../../core/geometry.h"
 #include "../../material/material.h"
+#include "../../global/constant.h"
+#include "driverInfo.h"
 
 namespace ff
 {
 	/// mesh line skinnedMesh 都会被解析为RenderItem
-	class RenderItem
+	/// RenderItem是值类型，只保存不拥有所有权的裸指针，由场景图保证其在本帧之内有效
+	/// 构建与遍历渲染列表的过程中，不会产生任何智能指针引用计数的原子操作
+	struct RenderItem
 	{
-	public:
-		using Ptr = std::shared_ptr<RenderItem>;
-		static Ptr create();
-
-		RenderItem() noexcept;
-
-		~RenderItem() noexcept;
-
-	public:
 		ID mID{0};
 		float mZ = 0; /// 用来排序-渲染透明物体的时候，是从远到近进行渲染
-		RenderableObject::Ptr mObject{nullptr};
-		Material::Ptr mMaterial{nullptr};
-		Geometry::Ptr mGeometry{nullptr};
+		RenderableObject* mObject{nullptr};
+		Material* mMaterial{nullptr};
+		Geometry* mGeometry{nullptr};
 		uint32_t mGroupOrder{0}; /// 影响渲染顺序
+		uint32_t mProgramID{0}; /// 上一次绘制所使用的DriverProgram的id，用于排序时将相同program的物体排在一起
 	};
 
-	using RenderListSortFunction = std::function<bool(const RenderItem::Ptr&, const RenderItem::Ptr&)>;
+	using RenderListSortFunction = std::function<bool(const RenderItem&, const RenderItem&)>;
 
 	/// 排序的原因:
 	/// 1 opaque物体需要排序，
 	/// >表示大的在前面
-	static auto smallerZFirstSort(const RenderItem::Ptr& item0, const RenderItem::Ptr& item1) -> bool
+	static auto smallerZFirstSort(const RenderItem& item0, const RenderItem& item1) -> bool
 	{
 		/// 首先保证groupOrder大的物体先绘制
-		if (item0->mGroupOrder != item1->mGroupOrder)
+		if (item0.mGroupOrder != item1.mGroupOrder)
 		{
-			return item0->mGroupOrder > item1->mGroupOrder;
+			return item0.mGroupOrder > item1.mGroupOrder;
 		}
 		/// 小的z，排在前面
-		else if (item0->mZ != item1->mZ)
+		else if (item0.mZ != item1.mZ)
 		{
-			return item0->mZ < item1->mZ;
+			return item0.mZ < item1.mZ;
 		}
 		else
 		{
 			/// 如果groupOrder与z分别相等,但是sort函数，必须要给到其一个true or false
 			/// id越大，说明创建的越晚，则创建越晚的物体，越先绘制
-			return item0->mID > item1->mID;
+			return item0.mID > item1.mID;
 		}
 	}
 
-	static auto biggerZFirstSort(const RenderItem::Ptr& item0, const RenderItem::Ptr& item1) -> bool
+	static auto biggerZFirstSort(const RenderItem& item0, const RenderItem& item1) -> bool
 	{
-		if (item0->mGroupOrder != item1->mGroupOrder)
+		if (item0.mGroupOrder != item1.mGroupOrder)
 		{
-			return item0->mGroupOrder > item1->mGroupOrder;
+			return item0.mGroupOrder > item1.mGroupOrder;
 		}
-		else if (item0->mZ != item1->mZ)
+		else if (item0.mZ != item1.mZ)
 		{
 			/// z越大，排序越靠前
-			return item0->mZ > item1->mZ;
+			return item0.mZ > item1.mZ;
 		}
 		else
 		{
-			return item0->mID > item1->mID;
+			return item0.mID > item1.mID;
 		}
 	}
 
 	/// driverRenderList用来存储，基础的渲染单元
+	/// 所有renderItem按值连续存放在mRenderItems当中，非透明/透明队列只是指向其中的下标数组
 	class DriverRenderList
 	{
 	public:
+		/// 基数排序的键中groupOrder只占8位，更大的值会被当作该值处理，并输出一次警告
+		static constexpr uint32_t MAX_GROUP_ORDER = 255;
+
 		using Ptr = std::shared_ptr<DriverRenderList>;
 		static Ptr create();
 
@@ -89,60 +89,116 @@ namespace ff
 		/// \param material 
 		/// \param groupOrder 
 		/// \param z 
+		/// \param programID 上一次绘制所使用的DriverProgram的id，还没有绘制过则为0
 		auto push(
-			const RenderableObject::Ptr& object,
-			const Geometry::Ptr& geometry,
-			const Material::Ptr& material,
+			RenderableObject* object,
+			Geometry* geometry,
+			Material* material,
 			const uint32_t& groupOrder,
-			float z) noexcept -> void;
+			float z,
+			uint32_t programID = 0) noexcept -> void;
 
 
-		/// \brief 排序操作,允许给出对于非透明物体以及透明物体的排序规则函数
+		/// \brief 排序操作，使用64位排序键进行基数排序，允许分别给出非透明物体以及透明物体的排序键布局
+		/// 同时统计非透明队列按照本次排序结果以及按照深度排序，分别需要多少次状态切换
+		/// \param opaqueLayout		为了earlyz(SmallerZFirst)，或者为了减少状态切换(StateFirst)
+		/// \param transparentLayout	为了颜色混合正确
+		/// \param depthOrderStatistics	非透明队列不是按照深度排序时，是否额外排序一次来统计按照深度排序的状态切换次数
+		auto sort(
+			RenderSortLayout opaqueLayout = RenderSortLayout::SmallerZFirst,
+			RenderSortLayout transparentLayout = RenderSortLayout::BiggerZFirst,
+			bool depthOrderStatistics = false) noexcept -> void;
+
+		/// \brief 排序操作,允许给出对于非透明物体以及透明物体的自定义排序规则函数
 		/// \param opaqueSort		为了earlyz
 		/// \param transparentSort	为了颜色混合正确
 		auto sort(
-			const RenderListSortFunction& opaqueSort = smallerZFirstSort,
-			const RenderListSortFunction& transparentSort = biggerZFirstSort) noexcept -> void;
+			const RenderListSortFunction& opaqueSort,
+			const RenderListSortFunction& transparentSort) noexcept -> void;
+
+		/// \brief 用新的下标数组替换非透明队列，比如自动实例化将多个renderItem合并为一个之后
+		/// \param opaques 交换之后为旧的非透明队列
+		auto swapOpaques(std::vector<uint32_t>& opaques) noexcept -> void;
 
 		/// \brief 在每一次构建完毕渲染列表的时候，调用finish
 		auto finish() noexcept -> void;
 
-		/// \brief 获得非透明的OBJ队列
+		/// \brief 记录当前(已经排好序的)列表长度
+		auto retain() noexcept -> void;
+
+		/// \brief 将列表恢复到retain时的状态，去掉之后临时加入的renderItem(比如天空盒)，用于跨帧沿用渲染列表
+		auto restore() noexcept -> void;
+
+		/// \brief 获得本帧所有的renderItem，opaque/transparent队列中的下标指向这里
 		/// \return 
-		auto getOpaques() const noexcept -> const std::vector<RenderItem::Ptr>&;
+		auto getRenderItems() const noexcept -> const std::vector<RenderItem>&;
 
-		/// \brief 获得透明的OBJ队列
+		/// \brief 获得非透明的OBJ队列（renderItem下标）
 		/// \return 
-		auto getTransparents() const noexcept -> const std::vector<RenderItem::Ptr>&;
+		auto getOpaques() const noexcept -> const std::vector<uint32_t>&;
 
-	private:
-		/// \brief
-		/// 每一次push一个可渲染物体，都会调用本函数，不管是重新生成renderItem还是
-		/// 从cache里面获取一个可用的，都会返回一个可用的renderItem
-		/// \param object 
-		/// \param geometry 
-		/// \param material 
-		/// \param groupOrder 
-		/// \param z 
+		/// \brief 获得透明的OBJ队列（renderItem下标）
 		/// \return 
-		auto getNextRenderItem(
-			const RenderableObject::Ptr& object,
-			const Geometry::Ptr& geometry,
-			const Material::Ptr& material,
-			const uint32_t& groupOrder,
-			float z) noexcept -> RenderItem::Ptr;
+		auto getTransparents() const noexcept -> const std::vector<uint32_t>&;
+
+		/// \brief 非透明队列按照本帧排序结果绘制，需要的program/VAO/纹理绑定次数
+		/// \return 
+		auto getOpaqueStateChanges() const noexcept -> const DriverInfo::StateChanges& { return mOpaqueStateChanges; }
+
+		/// \brief 非透明队列如果按照深度(SmallerZFirst)排序绘制，需要的program/VAO/纹理绑定次数
+		/// 本帧不是按照深度排序时，需要额外排序一次，只在sort时开启depthOrderStatistics才会统计，否则为0
+		/// \return 
+		auto getDepthOrderStateChanges() const noexcept -> const DriverInfo::StateChanges& { return mDepthOrderStateChanges; }
 
 	private:
-		/// 用来计数当前渲染列表的item数量，每一帧开始时候在init里面都会被置为0
-		uint32_t mRenderItemIndex{0};
+		/// \brief 按照布局，将renderItem打包为64位排序键
+		/// \param item
+		/// \param layout
+		/// \return
+		auto makeSortKey(const RenderItem& item, RenderSortLayout layout) const noexcept -> uint64_t;
+
+		/// \brief 对键/下标数组进行LSD基数排序（每次8位），然后按照结果重排队列中的下标
+		/// \param queue
+		/// \param layout
+		auto radixSort(std::vector<uint32_t>& queue, RenderSortLayout layout) noexcept -> void;
+
+		/// \brief 统计按照队列顺序依次绘制时，相邻DrawCall之间的状态切换次数
+		/// \param queue
+		/// \return
+		auto countStateChanges(const std::vector<uint32_t>& queue) const noexcept -> DriverInfo::StateChanges;
+
+	private:
+		/// \brief 本帧所有的renderItem，按值连续存储，clear不会释放内存，稳定之后不会再有内存分配
+		std::vector<RenderItem> mRenderItems{};
+
+		/// \brief 非透明物体在mRenderItems中的下标
+		std::vector<uint32_t> mOpaques{};
+
+		/// \brief 透明物体在mRenderItems中的下标
+		std::vector<uint32_t> mTransparents{};
+
+		/// retain时记录的列表长度
+		uint32_t mRetainedItems{0};
+		uint32_t mRetainedOpaques{0};
+		uint32_t mRetainedTransparents{0};
+
+		/// 是否已经对超出MAX_GROUP_ORDER的groupOrder发出过警告，只警告一次，避免每帧刷屏
+		bool mGroupOrderWarned{false};
+
+		/// 本帧所有renderItem的深度范围，用于将深度量化为整数
+		float mMinZ{0.0f};
+		float mMaxZ{0.0f};
 
-		/// \brief 存储非透明物体的智能指针
-		std::vector<RenderItem::Ptr> mOpaques{};
+		/// 基数排序使用的键/下标数组，以及交换用的临时数组，跨帧复用，避免重复分配
+		std::vector<uint64_t> mKeys{};
+		std::vector<uint64_t> mKeysTemp{};
+		std::vector<uint32_t> mIndices{};
+		std::vector<uint32_t> mIndicesTemp{};
 
-		/// \brief 存储透明物体的智能指针
-		std::vector<RenderItem::Ptr> mTransparents{};
+		/// 非透明队列按照深度排序的结果，只用来统计状态切换次数
+		std::vector<uint32_t> mDepthOrder{};
 
-		/// \brief 缓存renderItem
-		std::vector<RenderItem::Ptr> mRenderItemCache{};
+		DriverInfo::StateChanges mOpaqueStateChanges{};
+		DriverInfo::StateChanges mDepthOrderStateChanges{};
 	};
 }
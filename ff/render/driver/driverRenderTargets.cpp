@@ -1,5 +1,6 @@
 #include "driverRenderTargets.h"
 #include "../../global/eventDispatcher.h"
+#include "../../wrapper/glTrace.h"
 
 namespace ff
 {
@@ -20,18 +21,18 @@ namespace ff
 	{
 		if (mFrameBuffer)
 		{
-			glDeleteFramebuffers(1, &mFrameBuffer);
+			FF_GL(glDeleteFramebuffers, 1, &mFrameBuffer);
 		}
 
 		if (mDepthRenderBuffer)
 		{
-			glDeleteRenderbuffers(1, &mDepthRenderBuffer);
+			FF_GL(glDeleteRenderbuffers, 1, &mDepthRenderBuffer);
 		}
 	}
 
 	void DriverRenderTarget::generateFrameBuffer() noexcept
 	{
-		glGenFramebuffers(1, &mFrameBuffer);
+		FF_GL(glGenFramebuffers, 1, &mFrameBuffer);
 	}
 
 	DriverRenderTargets::DriverRenderTargets() noexcept
@@ -3,6 +3,9 @@
 #include "driverRenderState.h"
 #include "driverState.h"
 #include "../renderer.h"
+#include "../../tools/profiler.h"
+#include "../../objects/staticBatchMesh.h"
+#include "../../objects/instancedMesh.h"
 
 namespace ff
 {
@@ -21,7 +24,7 @@ namespace ff
 	/// 任务
 	/// 1 填充Uniforms（shadowMapUniform， shadowMatrixUniform）
 	/// 2 生成每个光源的RenderTarget
-	/// 3 为每个光源渲染自己的ShadowMap
+	/// 3 为每个光源渲染自己的ShadowMap；开启缓存的光源，阴影矩阵与投射阴影的物体都没有变化时沿用上一帧的ShadowMap
 	///
 	void DriverShadowMap::render(const std::shared_ptr<DriverRenderState>& renderState, const Scene::Ptr& scene,
 	                             const Camera::Ptr& camera) noexcept
@@ -48,15 +51,12 @@ namespace ff
 		/// 将会产生阴影的光源数组取出
 		auto lights = renderState->mShadowsArray;
 
-		/// 取出来光照系统的outMap
-		auto& uniforms = renderState->mLights->mState.mLightUniformHandles;
+		/// 取出来光照系统的阴影贴图数组，阴影矩阵则写入光照UniformBuffer的数据
+		auto& shadowMaps = renderState->mLights->mState.mDirectionalShadowMaps;
+		auto& lightsBlock = renderState->mLights->mState.mLightsBlock;
 
-		/// clear shadow matrix array
-		auto& shadowMapArray = uniforms["directionalShadowMap"];
-		clearPureArrayUniform(std::any_cast<std::vector<Texture::Ptr>>(&shadowMapArray.mValue));
-
-		auto& shadowMatrixArray = uniforms["directionalShadowMatrix"];
-		clearPureArrayUniform(std::any_cast<std::vector<glm::mat4>>(&shadowMatrixArray.mValue));
+		/// clear shadow map array
+		shadowMaps.clear();
 
 		for (uint32_t i = 0; i < lights.size(); ++i)
 		{
@@ -73,6 +73,15 @@ namespace ff
 			shadowFrameExtents = shadow->mFrameExtent; //todo
 			viewportSize = shadow->mMapSize;
 
+			/// 缓存的ShadowMap需要跨帧保留，不能使用FrameGraph的临时RenderTarget
+			ShadowCache* cache = nullptr;
+			if (shadow->mCacheEnabled)
+			{
+				shadow->mRenderTarget = getCachedRenderTarget(shadow);
+				cache = &mCaches[shadow.get()];
+			}
+
+			/// 通常由Renderer的FrameGraph分配好，单独调用时才在这里创建
 			if (shadow->mRenderTarget == nullptr)
 			{
 				RenderTarget::Options options;
@@ -83,8 +92,76 @@ namespace ff
 				shadow->mRenderTarget = RenderTarget::create(shadowMapSize.x, shadowMapSize.y, options);
 			}
 			/// give map to uniform handle
-			pushPureArrayUniform(shadow->mRenderTarget->getTexture(),
-			                     std::any_cast<std::vector<Texture::Ptr>>(&shadowMapArray.mValue));
+			shadowMaps.push_back(shadow->mRenderTarget->getTexture());
+
+			shadow->updateMatrices(light);
+
+			/// update uniform shadowmap matrix
+			if (i < DriverLights::MAX_DIRECTIONAL_LIGHTS)
+			{
+				lightsBlock.mDirectionalShadowMatrix[i] = shadow->mMatrix;
+			}
+
+			frustum = shadow->getFrustum();
+
+			FF_PROFILE_SCOPE("renderShadowCasters");
+
+			/// 场景开启了BVH，只访问与光源视景体相交的子树；BVH已经在本帧的project阶段更新过
+			mCasterObjects.clear();
+			if (scene->mBVHCulling)
+			{
+				scene->getBVH()->intersectFrustum(frustum, mCasters);
+				for (const auto entry : mCasters)
+				{
+					const auto object = entry->mObject;
+
+					/// 阴影使用LOD更粗糙的层级
+					if (entry->mLOD != nullptr && entry->mLOD->getShadowLevel(camera.get()) != entry->mLODLevel) continue;
+
+					if (object->mCastShadow && (!object->mIsStaticBatchMesh || static_cast<StaticBatchMesh*>(object)->cull(frustum) > 0))
+					{
+						mCasterObjects.push_back(object);
+					}
+				}
+			}
+			else
+			{
+				collectCasters(scene, camera, frustum);
+			}
+
+			/// 阴影矩阵包含了光源的变换与阴影相机的投影参数；骨骼动画每帧都在变化，总是重新绘制
+			if (cache != nullptr)
+			{
+				bool dirty = !cache->mValid || shadow->mNeedsUpdate || cache->mMatrix != shadow->mMatrix;
+
+				mCasterStates.clear();
+				for (const auto object : mCasterObjects)
+				{
+					if (object->mIsSkinnedMesh) dirty = true;
+
+					CasterState state;
+					state.mObject = object;
+					state.mWorldMatrixVersion = object->getWorldMatrixVersion();
+					state.mGeometry = object->getGeometry().get();
+					state.mGeometryVersion = getGeometryVersion(object);
+					mCasterStates.push_back(state);
+				}
+
+				dirty = dirty || mCasterStates != cache->mCasters;
+
+				if (!dirty)
+				{
+					++mRenderer->mInfos->mRender.mShadowMapsReused;
+					continue;
+				}
+
+				std::swap(cache->mCasters, mCasterStates);
+				cache->mMatrix = shadow->mMatrix;
+				cache->mValid = true;
+				shadow->mNeedsUpdate = false;
+			}
+
+			++mRenderer->mInfos->mRender.mShadowMapsRendered;
 
 			/// 开始向当前的shadowMap上面绘制，输出深度信息
 			mRenderer->setRenderTarget(shadow->mRenderTarget);
@@ -95,54 +172,136 @@ namespace ff
 
 			mState->viewport(viewport);
 
-			shadow->updateMatrices(light);
-
-			/// update uniform shadowmap matrix
-			pushPureArrayUniform(shadow->mMatrix, std::any_cast<std::vector<glm::mat4>>(&shadowMatrixArray.mValue));
-
-			frustum = shadow->getFrustum();
+			/// 阴影相机作为当前视图，更新相机UniformBuffer
+			mRenderer->mUniformBuffers->updateCamera(shadow->mCamera);
 
-			renderObject(scene, camera, shadow->mCamera, light, frustum);
+			for (const auto object : mCasterObjects)
+			{
+				renderCaster(object, shadow->mCamera);
+			}
 		}
 
 		mRenderer->setRenderTarget(currentRenderTarget);
 		mRenderer->setClearColor(currentClearColor.x, currentClearColor.y, currentClearColor.z, currentClearColor.w);
 	}
 
-	void DriverShadowMap::renderObject(
+	/// 关闭了ShadowMap或者没有光源投射阴影时，render不会被调用，所以释放工作不能放在render当中
+	void DriverShadowMap::endFrame() noexcept
+	{
+		/// 本帧没有投射阴影，或者关闭了缓存的光源，释放其常驻的RenderTarget
+		for (auto iter = mCaches.begin(); iter != mCaches.end();)
+		{
+			if (!iter->second.mUsed)
+			{
+				iter = mCaches.erase(iter);
+				continue;
+			}
+
+			iter->second.mUsed = false;
+			++iter;
+		}
+	}
+
+	void DriverShadowMap::collectCasters(
 		const Object3D::Ptr& object,
 		const Camera::Ptr& camera,
-		const Camera::Ptr& shadowCamera,
-		const Light::Ptr& light,
 		const Frustum::Ptr& frustum) noexcept
 	{
 		if (!object->mVisible) return;
 
+		/// 整棵子树都在光源的视景体之外
+		if (!object->getChildren().empty() && !frustum->intersectSubtree(object.get())) return;
+
 		if (object->mIsRenderableObject)
 		{
-			auto renderableObject = std::static_pointer_cast<RenderableObject>(object);
-
-			if (renderableObject->mCastShadow && frustum->intersectObject(renderableObject))
-			{
-				renderableObject->updateModelViewMatrix(shadowCamera->getWorldMatrixInverse());
+			const auto renderableObject = static_cast<RenderableObject*>(object.get());
 
-				auto geometry = mObjects->update(renderableObject);
+			/// 已经被静态合批的物体由StaticBatchMesh代为绘制；StaticBatchMesh则需要按照光源的视景体重新剪裁子区间
+			const bool castShadow = renderableObject->mCastShadow
+				&& !renderableObject->mStaticBatched
+				&& frustum->intersectObject(renderableObject)
+				&& (!renderableObject->mIsStaticBatchMesh || static_cast<StaticBatchMesh*>(renderableObject)->cull(frustum) > 0);
 
-				/// 所有物体统一使用默认的深度材质
-				auto material = mDefaultDepthMaterial;
-
-				mRenderer->renderBufferDirect(renderableObject, nullptr, shadowCamera, geometry, material);
+			if (castShadow)
+			{
+				mCasterObjects.push_back(renderableObject);
 			}
-			else
+		}
+
+		/// 阴影使用LOD更粗糙的层级，层级由主相机在project阶段选出
+		if (object->mIsLOD)
+		{
+			const auto lod = static_cast<LOD*>(object.get());
+			if (!lod->getLevels().empty())
 			{
-				std::cout << std::endl;
+				collectCasters(lod->getLevels()[lod->getShadowLevel(camera.get())].mObject, camera, frustum);
 			}
+			return;
 		}
 
-		auto children = object->getChildren();
+		const auto& children = object->getChildren();
 		for (const auto& child : children)
 		{
-			renderObject(child, camera, shadowCamera, light, frustum);
+			collectCasters(child, camera, frustum);
+		}
+	}
+
+	RenderTarget::Ptr DriverShadowMap::getCachedRenderTarget(const LightShadow::Ptr& shadow) noexcept
+	{
+		auto& cache = mCaches[shadow.get()];
+		cache.mUsed = true;
+
+		if (cache.mRenderTarget == nullptr || cache.mMapSize != shadow->mMapSize)
+		{
+			RenderTarget::Options options;
+			options.mMinFilter = TextureFilter::NearestFilter;
+			options.mMagFilter = TextureFilter::NearestFilter;
+			options.mFormat = TextureFormat::RGBA;
+
+			cache.mRenderTarget = RenderTarget::create(shadow->mMapSize.x, shadow->mMapSize.y, options);
+			cache.mMapSize = shadow->mMapSize;
+			cache.mValid = false;
+		}
+
+		return cache.mRenderTarget;
+	}
+
+	uint64_t DriverShadowMap::getGeometryVersion(const RenderableObject* object) noexcept
+	{
+		/// 替换attribute会改变其ID，修改数据会改变其版本号
+		uint64_t version = 0;
+		const auto& geometry = object->getGeometry();
+		for (const auto& [name, attribute] : geometry->getAttributes())
+		{
+			version = version * 31 + attribute->getID();
+			version = version * 31 + attribute->getVersion();
+		}
+
+		if (geometry->getIndex() != nullptr)
+		{
+			version = version * 31 + geometry->getIndex()->getID();
+			version = version * 31 + geometry->getIndex()->getVersion();
+		}
+
+		if (object->mIsInstancedMesh)
+		{
+			const auto instancedMesh = static_cast<const InstancedMesh*>(object);
+			version = version * 31 + instancedMesh->getInstanceMatrix()->getVersion();
+			version = version * 31 + instancedMesh->getCount();
 		}
+
+		return version;
+	}
+
+	void DriverShadowMap::renderCaster(RenderableObject* object, const Camera::Ptr& shadowCamera) noexcept
+	{
+		object->updateModelViewMatrix(shadowCamera->getWorldMatrixInverse());
+
+		const auto geometry = mObjects->update(object);
+
+		/// 所有物体统一使用默认的深度材质
+		const auto material = mDefaultDepthMaterial.get();
+
+		mRenderer->renderBufferDirect(object, nullptr, shadowCamera, geometry, material);
 	}
 }
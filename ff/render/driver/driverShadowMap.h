@@ -24,13 +24,28 @@ namespace ff {
 
 		void render(const std::shared_ptr<DriverRenderState>& renderState, const Scene::Ptr& scene, const Camera::Ptr& camera) noexcept;
 
-		void renderObject(
+		/// \brief 每帧结束时调用，无论本帧是否绘制了ShadowMap，释放本帧没有用到的常驻RenderTarget
+		void endFrame() noexcept;
+
+		/// \brief 收集光源视景体之内投射阴影的物体，放入mCasterObjects
+		/// \param object 
+		/// \param camera 主相机，决定LOD的层级
+		/// \param frustum 光源的视景体
+		void collectCasters(
 			const Object3D::Ptr& object,
 			const Camera::Ptr& camera,
-			const Camera::Ptr& shadowCamera,
-			const Light::Ptr& light,
 			const Frustum::Ptr& frustum) noexcept;
 
+		/// \brief 以阴影相机绘制一个投射阴影的物体，调用之前已经完成剪裁
+		/// \param object 
+		/// \param shadowCamera 
+		void renderCaster(RenderableObject* object, const Camera::Ptr& shadowCamera) noexcept;
+
+		/// \brief 开启缓存的光源所使用的常驻RenderTarget，尺寸变化时重新创建
+		/// \param shadow 
+		/// \return 
+		RenderTarget::Ptr getCachedRenderTarget(const LightShadow::Ptr& shadow) noexcept;
+
 	public:
 		/// 决定整个系统是否开启ShadowMap
 		bool mEnabled{ true };
@@ -41,5 +56,45 @@ namespace ff {
 		std::shared_ptr<DriverState>	mState{ nullptr };
 
 		DepthMaterial::Ptr	mDefaultDepthMaterial = DepthMaterial::create(DepthMaterial::RGBADepthPacking);
+
+		/// BVH模式下与光源视景体相交的物体，跨帧复用内存
+		std::vector<const SceneBVH::Entry*>	mCasters{};
+
+		/// 本光源需要绘制的物体，跨帧复用内存
+		std::vector<RenderableObject*>	mCasterObjects{};
+
+		/// 决定ShadowMap内容的一个物体的状态
+		struct CasterState {
+			RenderableObject*	mObject{ nullptr };
+			uint32_t			mWorldMatrixVersion{ 0 };
+			const Geometry*		mGeometry{ nullptr };
+			uint64_t			mGeometryVersion{ 0 };
+
+			bool operator==(const CasterState& other) const noexcept {
+				return mObject == other.mObject
+					&& mWorldMatrixVersion == other.mWorldMatrixVersion
+					&& mGeometry == other.mGeometry
+					&& mGeometryVersion == other.mGeometryVersion;
+			}
+		};
+
+		/// 一个光源的ShadowMap缓存：常驻的RenderTarget，以及绘制它时的阴影矩阵与投射阴影的物体
+		struct ShadowCache {
+			RenderTarget::Ptr			mRenderTarget{ nullptr };
+			glm::vec2					mMapSize = glm::vec2(0.0f);
+			glm::mat4					mMatrix = glm::mat4(1.0f);
+			std::vector<CasterState>	mCasters{};
+			bool						mValid{ false };
+
+			/// 本帧是否使用过，没有使用的缓存在帧末释放
+			bool						mUsed{ false };
+		};
+
+		/// \brief 物体的顶点数据版本，包含geometry的所有attribute以及InstancedMesh的实例矩阵
+		static uint64_t getGeometryVersion(const RenderableObject* object) noexcept;
+
+		/// 只用作查找的key，不会通过它访问LightShadow
+		std::unordered_map<const LightShadow*, ShadowCache>	mCaches{};
+		std::vector<CasterState>	mCasterStates{};
 	};
 }
\ No newline at end of file
@@ -1,11 +1,14 @@
 ﻿#include "driverState.h"
 #include "../../wrapper/glWrapper.hpp"
+#include "../../wrapper/glTrace.h"
 
 namespace ff
 {
-	DriverState::DriverState() noexcept
+	DriverState::DriverState(const DriverInfo::Ptr& info) noexcept
 	{
-		glEnable(GL_MULTISAMPLE);
+		mInfo = info;
+
+		FF_GL(glEnable, GL_MULTISAMPLE);
 	}
 
 	DriverState::~DriverState() noexcept
@@ -16,7 +19,7 @@ namespace ff
 	{
 		if (mCurrentViewport != viewport)
 		{
-			glViewport(
+			FF_GL(glViewport,
 				static_cast<GLint>(viewport.x),
 				static_cast<GLint>(viewport.y),
 				static_cast<GLsizei>(viewport.z),
@@ -33,7 +36,7 @@ namespace ff
 		/// 只有不一样的时候，才会重新绑定
 		if (mCurrentProgram != program)
 		{
-			glUseProgram(program);
+			FF_GL_BIND(glUseProgram, program);
 			mCurrentProgram = program;
 
 			return true;
@@ -42,46 +45,85 @@ namespace ff
 		return false;
 	}
 
-	auto DriverState::setMaterial(const Material::Ptr& material) noexcept -> void
+	auto DriverState::setMaterial(const Material* material) noexcept -> void
 	{
-		/// 对于双面渲染，有两种方案
-		///  1 在绘制背面的时候，进行法线的反转
-		///  2 在绘制背面的时候，不进行反转法线(我方采用）
-		if (mCurrentRaster.mSide != material->mSide)
+		setPipelineState(compilePipelineState(material));
+	}
+
+	auto DriverState::compilePipelineState(const Material* material) noexcept -> PipelineState
+	{
+		PipelineState state;
+
+		state.mKey =
+			static_cast<uint64_t>(material->mSide) << SIDE_SHIFT |
+			static_cast<uint64_t>(material->mFrontFace) << FRONT_FACE_SHIFT |
+			packBlending(
+				material->mBlendingType,
+				material->mTransparent,
+				material->mBlendSrc,
+				material->mBlendDst,
+				material->mBlendEquation,
+				material->mBlendSrcAlpha,
+				material->mBlendDstAlpha,
+				material->mBlendEquationAlpha
+				) |
+			packDepth(material->mDepthTest, material->mDepthWrite, material->mDepthFunction) |
+			(material->mColorWrite ? 0 : COLOR_WRITE_OFF_MASK);
+
+		state.mDepthClearColor = material->mDepthClearColor;
+
+		return state;
+	}
+
+	auto DriverState::setPipelineState(const PipelineState& state) noexcept -> void
+	{
+		const uint64_t key = mDepthPrePassStage == DepthPrePassStage::None ? state.mKey : overrideKey(state.mKey);
+
+		/// 绝大多数相邻的DrawCall使用相同的状态，只需要这一次比较
+		if (key != mCurrentKey)
 		{
-			if (material->mSide == Side::DoubleSide)
-			{
-				gl::disable(GL_CULL_FACE);
-			}
-			else
-			{
-				gl::enable(GL_CULL_FACE);
-				glCullFace(toGL(material->mSide));
-			}
-			mCurrentRaster.mSide = material->mSide;
+			applyKey(key);
 		}
 
-		if (mCurrentRaster.mFrontFace != material->mFrontFace)
+		setDepthClearColor(state.mDepthClearColor);
+	}
+
+	auto DriverState::setDepthPrePassStage(DepthPrePassStage stage) noexcept -> void
+	{
+		mDepthPrePassStage = stage;
+
+		if (stage == DepthPrePassStage::None)
 		{
-			mCurrentRaster.mFrontFace = material->mFrontFace;
-			glFrontFace(toGL(material->mFrontFace));
+			restoreWriteMasks();
 		}
+	}
 
-		setBlending(
-			material->mBlendingType,
-			material->mTransparent,
-			material->mBlendSrc,
-			material->mBlendDst,
-			material->mBlendEquation,
-			material->mBlendSrcAlpha,
-			material->mBlendDstAlpha,
-			material->mBlendEquationAlpha
-			);
+	auto DriverState::restoreWriteMasks() noexcept -> void
+	{
+		if (mCurrentKey != INVALID_KEY)
+		{
+			applyKey((mCurrentKey & ~COLOR_WRITE_OFF_MASK) | DEPTH_WRITE_MASK);
+		}
+	}
 
-		setDepth(material->mDepthTest, material->mDepthWrite, material->mDepthFunction, material->mDepthClearColor);
+	auto DriverState::overrideKey(uint64_t key) const noexcept -> uint64_t
+	{
+		switch (mDepthPrePassStage)
+		{
+		case DepthPrePassStage::PrePass:
+			return key | COLOR_WRITE_OFF_MASK;
+		case DepthPrePassStage::MainPass:
+			if ((key & DEPTH_TEST_MASK) && (key & DEPTH_WRITE_MASK))
+			{
+				return (key & ~DEPTH_MASK) | packDepth(true, false, CompareFunction::Equal);
+			}
+			return key;
+		default:
+			return key;
+		}
 	}
 
-	auto DriverState::setBlending(
+	auto DriverState::packBlending(
 		BlendingType blendingType,
 		bool transparent,
 		BlendingFactor blendSrc,
@@ -90,168 +132,222 @@ namespace ff
 		BlendingFactor blendSrcAlpha,
 		BlendingFactor blendDstAlpha,
 		BlendingEquation blendEquationAlpha
-		) noexcept -> void
+		) noexcept -> uint64_t
 	{
-		/// 当前状态与material要求状态不一致，且不是用户自定义的blendingType
-		if (mCurrentBlending.mBlendingType != blendingType && mCurrentBlending.mBlendingType !=
-			BlendingType::CustomBlending)
+		/// DefaultBlending使用固定的混合方式，CustomBlending只有在transparent时才开启
+		if (blendingType == BlendingType::DefaultBlending)
 		{
-			mCurrentBlending.mBlendingType = blendingType;
-
-			if (blendingType == BlendingType::NoBlending)
-			{
-				glDisable(GL_BLEND);
-				return;
-			}
-
-			if (mCurrentBlending.mBlendingType == BlendingType::DefaultBlending)
-			{
-				/// 根据传入的参数，设置blending的所有状态
-				setBlendingInternal(
-					true,
-					BlendingFactor::SrcAlpha,
-					BlendingFactor::OneMinusSrcAlpha,
-					BlendingEquation::AddEquation,
-					BlendingFactor::SrcAlpha,
-					BlendingFactor::OneMinusSrcAlpha,
-					BlendingEquation::AddEquation
-					);
-				return;
-			}
+			blendSrc = BlendingFactor::SrcAlpha;
+			blendDst = BlendingFactor::OneMinusSrcAlpha;
+			blendEquation = BlendingEquation::AddEquation;
+			blendSrcAlpha = BlendingFactor::SrcAlpha;
+			blendDstAlpha = BlendingFactor::OneMinusSrcAlpha;
+			blendEquationAlpha = BlendingEquation::AddEquation;
 		}
-		else if (mCurrentBlending.mBlendingType == BlendingType::CustomBlending)
+		else if (blendingType != BlendingType::CustomBlending || !transparent)
 		{
-			setBlendingInternal(
-				transparent,
-				blendSrc,
-				blendDst,
-				blendEquation,
-				blendSrcAlpha,
-				blendDstAlpha,
-				blendEquationAlpha
-				);
+			return 0;
 		}
+
+		return BLEND_MASK |
+			static_cast<uint64_t>(blendSrc) << BLEND_SRC_SHIFT |
+			static_cast<uint64_t>(blendDst) << BLEND_DST_SHIFT |
+			static_cast<uint64_t>(blendEquation) << BLEND_EQUATION_SHIFT |
+			static_cast<uint64_t>(blendSrcAlpha) << BLEND_SRC_ALPHA_SHIFT |
+			static_cast<uint64_t>(blendDstAlpha) << BLEND_DST_ALPHA_SHIFT |
+			static_cast<uint64_t>(blendEquationAlpha) << BLEND_EQUATION_ALPHA_SHIFT;
 	}
 
-	auto DriverState::setBlendingInternal(
-		bool transparent,
-		BlendingFactor blendSrc,
-		BlendingFactor blendDst,
-		BlendingEquation blendEquation,
-		BlendingFactor blendSrcAlpha,
-		BlendingFactor blendDstAlpha,
-		BlendingEquation blendEquationAlpha
-		) noexcept -> void
+	auto DriverState::packDepth(bool depthTest, bool depthWrite, CompareFunction depthFunction) noexcept -> uint64_t
 	{
-		if (mCurrentBlending.mTransparent == false && transparent == false)
+		return static_cast<uint64_t>(depthTest) << DEPTH_TEST_SHIFT |
+			static_cast<uint64_t>(depthWrite) << DEPTH_WRITE_SHIFT |
+			static_cast<uint64_t>(depthFunction) << DEPTH_FUNCTION_SHIFT;
+	}
+
+	auto DriverState::applyKey(uint64_t key) noexcept -> void
+	{
+		/// 不混合时混合因子与方程不起作用，清零之后与编译好的不混合的key一致，setPipelineState的一次比较就能命中；
+		/// opengl当前的因子与方程记录在mCurrentBlendFunction当中，之后重新开启同样的混合时不需要再次设置
+		if (!(key & BLEND_MASK))
+		{
+			key &= ~(BLEND_FUNC_MASK | BLEND_EQUATION_MASK);
+		}
+
+		const uint64_t diff = mCurrentKey ^ key;
+		if (!diff)
 		{
 			return;
 		}
 
-		if (mCurrentBlending.mTransparent != transparent)
+		const bool first = mCurrentKey == INVALID_KEY;
+		uint32_t calls = 0;
+
+		/// 对于双面渲染，有两种方案
+		///  1 在绘制背面的时候，进行法线的反转
+		///  2 在绘制背面的时候，不进行反转法线(我方采用）
+		if (diff & SIDE_MASK)
 		{
-			mCurrentBlending.mTransparent = transparent;
-			if (transparent)
+			const auto side = static_cast<Side>((key & SIDE_MASK) >> SIDE_SHIFT);
+			const auto currentSide = static_cast<Side>((mCurrentKey & SIDE_MASK) >> SIDE_SHIFT);
+
+			if (side == Side::DoubleSide)
 			{
-				gl::enable(GL_BLEND);
+				gl::disable(GL_CULL_FACE);
+				calls++;
+			}
+			else
+			{
+				if (first || currentSide == Side::DoubleSide)
+				{
+					gl::enable(GL_CULL_FACE);
+					calls++;
+				}
+				FF_GL(glCullFace, toGL(side));
+				calls++;
 			}
 		}
 
-		if (!transparent)
+		if (diff & FRONT_FACE_MASK)
 		{
-			gl::disable(GL_BLEND);
-			return;
+			FF_GL(glFrontFace, toGL(static_cast<FrontFace>((key & FRONT_FACE_MASK) >> FRONT_FACE_SHIFT)));
+			calls++;
 		}
 
-		/// 但凡发现有一个不相等的变量，就重新记录，并且调用api进行状态更改
-		if (
-			mCurrentBlending.mBlendSrc != blendSrc ||
-			mCurrentBlending.mBlendDst != blendDst ||
-			mCurrentBlending.mBlendSrcAlpha != blendSrcAlpha ||
-			mCurrentBlending.mBlendDstAlpha != blendDstAlpha
-			)
+		if (diff & BLEND_MASK)
 		{
-			mCurrentBlending.mBlendSrc = blendSrc;
-			mCurrentBlending.mBlendSrc = blendSrc;
-			mCurrentBlending.mBlendDst = blendDst;
-			mCurrentBlending.mBlendSrcAlpha = blendSrcAlpha;
-			mCurrentBlending.mBlendDstAlpha = blendDstAlpha;
-
-			gl::blendFuncSeparate(toGL(blendSrc), toGL(blendDst), toGL(blendSrcAlpha), toGL(blendDstAlpha));
+			if (key & BLEND_MASK)
+			{
+				gl::enable(GL_BLEND);
+			}
+			else
+			{
+				gl::disable(GL_BLEND);
+			}
+			calls++;
 		}
 
-		if (
-			mCurrentBlending.mBlendEquation != blendEquation ||
-			mCurrentBlending.mBlendEquationAlpha != blendEquationAlpha
-			)
+		const uint64_t blendDiff = (key & BLEND_MASK) ? mCurrentBlendFunction ^ key : 0;
+
+		if (blendDiff & BLEND_FUNC_MASK)
 		{
-			mCurrentBlending.mBlendEquationAlpha = blendEquationAlpha;
-			mCurrentBlending.mBlendEquation = blendEquation;
+			gl::blendFuncSeparate(
+				toGL(static_cast<BlendingFactor>((key >> BLEND_SRC_SHIFT) & 0x7)),
+				toGL(static_cast<BlendingFactor>((key >> BLEND_DST_SHIFT) & 0x7)),
+				toGL(static_cast<BlendingFactor>((key >> BLEND_SRC_ALPHA_SHIFT) & 0x7)),
+				toGL(static_cast<BlendingFactor>((key >> BLEND_DST_ALPHA_SHIFT) & 0x7)));
+			calls++;
+		}
 
-			gl::blendEquationSeparate(toGL(blendEquation), toGL(blendEquationAlpha));
+		if (blendDiff & BLEND_EQUATION_MASK)
+		{
+			gl::blendEquationSeparate(
+				toGL(static_cast<BlendingEquation>((key >> BLEND_EQUATION_SHIFT) & 0x3)),
+				toGL(static_cast<BlendingEquation>((key >> BLEND_EQUATION_ALPHA_SHIFT) & 0x3)));
+			calls++;
 		}
-	}
 
-	auto DriverState::setDepth(
-		bool depthTest,
-		bool depthWrite,
-		CompareFunction depthFunction,
-		double depthClearColor
-		) noexcept -> void
-	{
-		if (mCurrentDepth.mDepthTest == false && depthTest == false)
+		if (key & BLEND_MASK)
 		{
-			return;
+			mCurrentBlendFunction = key & (BLEND_FUNC_MASK | BLEND_EQUATION_MASK);
 		}
 
 		/// depthTest决定了当前物体的绘制，是否参与深度检测
-		if (mCurrentDepth.mDepthTest != depthTest)
+		if (diff & DEPTH_TEST_MASK)
 		{
-			mCurrentDepth.mDepthTest = depthTest;
-			if (!mCurrentDepth.mDepthTest)
+			if (key & DEPTH_TEST_MASK)
 			{
-				gl::disable(GL_DEPTH_TEST);
+				gl::enable(GL_DEPTH_TEST);
 			}
 			else
 			{
-				gl::enable(GL_DEPTH_TEST);
+				gl::disable(GL_DEPTH_TEST);
 			}
+			calls++;
 		}
 
 		/// depthWrite决定了当前物体如果通过了深度检测，是否用当前物体的fragment的深度更新depthBuffer
-		if (mCurrentDepth.mDepthWrite != depthWrite)
+		if (diff & DEPTH_WRITE_MASK)
 		{
-			mCurrentDepth.mDepthWrite = depthWrite;
+			gl::depthMask((key & DEPTH_WRITE_MASK) ? GL_TRUE : GL_FALSE);
+			calls++;
+		}
 
-			if (mCurrentDepth.mDepthWrite)
-			{
-				gl::depthMask(GL_TRUE);
-			}
-			else
-			{
-				gl::depthMask(GL_FALSE);
-			}
+		if (diff & DEPTH_FUNCTION_MASK)
+		{
+			gl::depthFunc(toGL(static_cast<CompareFunction>((key & DEPTH_FUNCTION_MASK) >> DEPTH_FUNCTION_SHIFT)));
+			calls++;
 		}
 
-		if (mCurrentDepth.mDepthFunction != depthFunction)
+		if (diff & COLOR_WRITE_OFF_MASK)
 		{
-			mCurrentDepth.mDepthFunction = depthFunction;
-			gl::depthFunc(toGL(depthFunction));
+			const GLboolean colorWrite = (key & COLOR_WRITE_OFF_MASK) ? GL_FALSE : GL_TRUE;
+			FF_GL(glColorMask, colorWrite, colorWrite, colorWrite, colorWrite);
+			calls++;
 		}
 
-		if (mCurrentDepth.mDepthClearColor != depthClearColor)
+		mCurrentKey = key;
+
+		mInfo->mRender.mPipelineChanges++;
+		mInfo->mRender.mPipelineStateCalls += calls;
+	}
+
+	auto DriverState::setDepthClearColor(double depthClearColor) noexcept -> void
+	{
+		if (mCurrentDepthClearColor != depthClearColor)
 		{
-			mCurrentDepth.mDepthClearColor = depthClearColor;
+			mCurrentDepthClearColor = depthClearColor;
 			gl::clearDepth(depthClearColor);
 		}
 	}
 
+	auto DriverState::setBlending(
+		BlendingType blendingType,
+		bool transparent,
+		BlendingFactor blendSrc,
+		BlendingFactor blendDst,
+		BlendingEquation blendEquation,
+		BlendingFactor blendSrcAlpha,
+		BlendingFactor blendDstAlpha,
+		BlendingEquation blendEquationAlpha
+		) noexcept -> void
+	{
+		/// 只替换当前状态当中的混合部分
+		const uint64_t current = mCurrentKey == INVALID_KEY ? 0 : mCurrentKey;
+		const uint64_t blending = packBlending(
+			blendingType,
+			transparent,
+			blendSrc,
+			blendDst,
+			blendEquation,
+			blendSrcAlpha,
+			blendDstAlpha,
+			blendEquationAlpha
+			);
+
+		applyKey((current & ~BLENDING_MASK) | blending);
+	}
+
+	auto DriverState::setDepth(
+		bool depthTest,
+		bool depthWrite,
+		CompareFunction depthFunction,
+		double depthClearColor
+		) noexcept -> void
+	{
+		/// 只替换当前状态当中的深度部分
+		const uint64_t current = mCurrentKey == INVALID_KEY ? 0 : mCurrentKey;
+
+		applyKey((current & ~DEPTH_MASK) | packDepth(depthTest, depthWrite, depthFunction));
+		setDepthClearColor(depthClearColor);
+	}
+
 	auto DriverState::bindFrameBuffer(const GLuint& frameBuffer) noexcept -> void
 	{
 		if (mCurrentFrameBuffer != frameBuffer)
 		{
 			mCurrentFrameBuffer = frameBuffer;
-			glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer);
+			FF_GL_BIND(glBindFramebuffer, GL_FRAMEBUFFER, frameBuffer);
 		}
 	}
 
@@ -3,6 +3,7 @@
 #include "../../material/material.h"
 #include "../renderTarget.h"
 #include "driverRenderTargets.h"
+#include "driverInfo.h"
 
 namespace ff {
 
@@ -13,37 +14,38 @@ namespace ff {
 	/// 4 其他相关配置
 	class DriverState {
 	public:
-		struct RasterState {
-			Side		mSide{ Side::None };
-			FrontFace	mFrontFace{ FrontFace::None };
-		};
-
 		struct ColorState {
 			glm::vec4 mClearColor = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
 		};
 
-		struct BlendingState {
-			BlendingType		mBlendingType{ BlendingType::None };
-			bool				mTransparent{ false };
-			BlendingFactor		mBlendSrc{ BlendingFactor::None };
-			BlendingFactor		mBlendDst{ BlendingFactor::None };
-			BlendingEquation	mBlendEquation{ BlendingEquation::None };
-			BlendingFactor		mBlendSrcAlpha{ BlendingFactor::None };
-			BlendingFactor		mBlendDstAlpha{ BlendingFactor::None };
-			BlendingEquation	mBlendEquationAlpha{ BlendingEquation::None };
+		/// 一个material所需的光栅化、混合与深度状态，编译之后不再改变
+		/// 1 除去清除深度值之外，所有状态打包进64位的mKey，mKey本身即为其哈希值
+		/// 2 没有开启blending时，混合因子与方程置0，使所有不混合的material得到相同的mKey
+		/// 3 应用时与当前的mKey做一次比较，不同时只对变化了的字段调用opengl
+		struct PipelineState {
+			uint64_t	mKey{ 0 };
+			double		mDepthClearColor{ 1.0 };
+
+			auto getHash() const noexcept -> HashType { return static_cast<HashType>(mKey); }
+
+			bool operator==(const PipelineState& other) const noexcept {
+				return mKey == other.mKey && mDepthClearColor == other.mDepthClearColor;
+			}
 		};
 
-		struct DepthState {
-			bool			mDepthTest{ false };
-			bool			mDepthWrite{ false };
-			CompareFunction mDepthFunction{ CompareFunction::None };
-			double			mDepthClearColor{ -1.0f };
+		/// 深度预渲染所处的阶段，对之后应用的PipelineState进行改写
+		enum class DepthPrePassStage {
+			None,
+			/// 只写入深度，关闭颜色写入
+			PrePass,
+			/// 开启了深度检测与深度写入的物体，深度已经由PrePass写好，改为Equal比较并且关闭深度写入
+			MainPass
 		};
 
 		using Ptr = std::shared_ptr<DriverState>;
-		static Ptr create() { return std::make_shared<DriverState>(); }
+		static Ptr create(const DriverInfo::Ptr& info) { return std::make_shared<DriverState>(info); }
 
-		DriverState() noexcept;
+		DriverState(const DriverInfo::Ptr& info) noexcept;
 
 		~DriverState() noexcept;
 
@@ -54,9 +56,25 @@ namespace ff {
 		/// \return 
 		auto useProgram(GLuint program) noexcept -> bool;
 
-		/// \brief 设置材质
+		/// \brief 设置材质，即编译并应用其管线状态；经常绘制的material应当缓存编译结果(见DriverMaterials)
 		/// \param material 
-		auto setMaterial(const Material::Ptr& material) noexcept -> void;
+		auto setMaterial(const Material* material) noexcept -> void;
+
+		/// \brief 将material的光栅化、混合与深度状态编译为PipelineState
+		/// \param material
+		/// \return
+		static auto compilePipelineState(const Material* material) noexcept -> PipelineState;
+
+		/// \brief 应用一个编译好的管线状态，与当前状态相同时只需要一次比较
+		/// \param state
+		auto setPipelineState(const PipelineState& state) noexcept -> void;
+
+		/// \brief 切换深度预渲染的阶段，回到None时恢复颜色写入与深度写入
+		/// \param stage
+		auto setDepthPrePassStage(DepthPrePassStage stage) noexcept -> void;
+
+		/// \brief 恢复颜色写入与深度写入，关闭过它们的绘制结束之后调用，保证之后的clear正常工作
+		auto restoreWriteMasks() noexcept -> void;
 
 		auto bindFrameBuffer(const GLuint& frameBuffer) noexcept -> void;
 
@@ -83,7 +101,41 @@ namespace ff {
 		auto getClearColor() const noexcept -> glm::vec4;
 
 	private:
-		auto setBlendingInternal(
+		/// mKey当中各个字段的位置与宽度
+		static constexpr uint32_t SIDE_SHIFT = 0;
+		static constexpr uint32_t FRONT_FACE_SHIFT = 2;
+		static constexpr uint32_t BLEND_SHIFT = 4;
+		static constexpr uint32_t BLEND_SRC_SHIFT = 5;
+		static constexpr uint32_t BLEND_DST_SHIFT = 8;
+		static constexpr uint32_t BLEND_EQUATION_SHIFT = 11;
+		static constexpr uint32_t BLEND_SRC_ALPHA_SHIFT = 13;
+		static constexpr uint32_t BLEND_DST_ALPHA_SHIFT = 16;
+		static constexpr uint32_t BLEND_EQUATION_ALPHA_SHIFT = 19;
+		static constexpr uint32_t DEPTH_TEST_SHIFT = 21;
+		static constexpr uint32_t DEPTH_WRITE_SHIFT = 22;
+		static constexpr uint32_t DEPTH_FUNCTION_SHIFT = 23;
+		static constexpr uint32_t COLOR_WRITE_OFF_SHIFT = 26;
+
+		static constexpr uint64_t SIDE_MASK = 0x3ull << SIDE_SHIFT;
+		static constexpr uint64_t FRONT_FACE_MASK = 0x3ull << FRONT_FACE_SHIFT;
+		static constexpr uint64_t BLEND_MASK = 0x1ull << BLEND_SHIFT;
+		static constexpr uint64_t BLEND_FUNC_MASK =
+			(0x7ull << BLEND_SRC_SHIFT) | (0x7ull << BLEND_DST_SHIFT) |
+			(0x7ull << BLEND_SRC_ALPHA_SHIFT) | (0x7ull << BLEND_DST_ALPHA_SHIFT);
+		static constexpr uint64_t BLEND_EQUATION_MASK = (0x3ull << BLEND_EQUATION_SHIFT) | (0x3ull << BLEND_EQUATION_ALPHA_SHIFT);
+		static constexpr uint64_t BLENDING_MASK = BLEND_MASK | BLEND_FUNC_MASK | BLEND_EQUATION_MASK;
+		static constexpr uint64_t DEPTH_TEST_MASK = 0x1ull << DEPTH_TEST_SHIFT;
+		static constexpr uint64_t DEPTH_WRITE_MASK = 0x1ull << DEPTH_WRITE_SHIFT;
+		static constexpr uint64_t DEPTH_FUNCTION_MASK = 0x7ull << DEPTH_FUNCTION_SHIFT;
+		static constexpr uint64_t DEPTH_MASK = DEPTH_TEST_MASK | DEPTH_WRITE_MASK | DEPTH_FUNCTION_MASK;
+		/// 置位时关闭颜色写入，对应Material::mColorWrite为false
+		static constexpr uint64_t COLOR_WRITE_OFF_MASK = 0x1ull << COLOR_WRITE_OFF_SHIFT;
+
+		/// 还没有应用过任何状态，任何合法的mKey都不会等于它
+		static constexpr uint64_t INVALID_KEY = ~0ull;
+
+		static auto packBlending(
+			BlendingType blendingType,
 			bool transparent,
 			BlendingFactor blendSrc,
 			BlendingFactor blendDst,
@@ -91,12 +143,30 @@ namespace ff {
 			BlendingFactor blendSrcAlpha,
 			BlendingFactor blendDstAlpha,
 			BlendingEquation blendEquationAlpha
-			) noexcept -> void;
+			) noexcept -> uint64_t;
+
+		static auto packDepth(bool depthTest, bool depthWrite, CompareFunction depthFunction) noexcept -> uint64_t;
+
+		/// \brief 只对与当前mKey不同的字段调用opengl
+		/// \param key
+		auto applyKey(uint64_t key) noexcept -> void;
+
+		/// \brief 按照当前的深度预渲染阶段改写mKey
+		/// \param key
+		/// \return
+		auto overrideKey(uint64_t key) const noexcept -> uint64_t;
+
+		auto setDepthClearColor(double depthClearColor) noexcept -> void;
 
 	private:
-		RasterState		mCurrentRaster;
-		BlendingState	mCurrentBlending;
-		DepthState		mCurrentDepth;
+		DriverInfo::Ptr	mInfo{ nullptr };
+
+		uint64_t		mCurrentKey{ INVALID_KEY };
+
+		/// opengl当前的混合因子与方程，关闭混合之后仍然保留
+		uint64_t		mCurrentBlendFunction{ INVALID_KEY };
+		double			mCurrentDepthClearColor{ -1.0 };
+		DepthPrePassStage	mDepthPrePassStage{ DepthPrePassStage::None };
 		ColorState		mCurrentColor;
 
 		GLuint	mCurrentProgram{ 0 };
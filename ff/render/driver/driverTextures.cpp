@@ -1,5 +1,6 @@
 #include "driverTextures.h"
 #include "../MultipleRenderTarget.h"
+#include "../../wrapper/glTrace.h"
 
 namespace ff
 {
@@ -16,7 +17,7 @@ namespace ff
 	{
 		if (mHandle)
 		{
-			glDeleteTextures(GL_TEXTURE_2D, &mHandle);
+			FF_GL(glDeleteTextures, GL_TEXTURE_2D, &mHandle);
 			mHandle = 0;
 		}
 	}
@@ -32,21 +33,14 @@ namespace ff
 	DriverTextures::~DriverTextures() noexcept
 	{
 		EventDispatcher::getInstance()->removeEventListener("textureDispose", this, &DriverTextures::onTextureDestroy);
-	}
-
-	auto DriverTextures::update(const Texture::Ptr& texture) noexcept -> void
-	{
-		auto dTexture = get(texture);
 
-		/// mNeedsUpdate在texture初次创建的时候，会是true
-		/// 在使用者更改了texture相关的东西之后，可以手动将其置为true，就会触发更改
-		if (texture->mNeedsUpdate)
+		for (const auto& iter : mSamplers)
 		{
-			texture->mNeedsUpdate = false;
-			setupDriverTexture(texture);
+			FF_GL(glDeleteSamplers, 1, &iter.second);
 		}
 	}
 
+
 	auto DriverTextures::setupDriverTexture(const Texture::Ptr& texture) noexcept -> DriverTexture::Ptr
 	{
 		DriverTexture::Ptr textural = get(texture);
@@ -54,16 +48,12 @@ namespace ff
 
 		if (!textural->mHandle)
 		{
-			glGenTextures(1, &textural->mHandle);
+			FF_GL(glGenTextures, 1, &textural->mHandle);
 		}
-		glBindTexture(toGL(texture->mTextureType), textural->mHandle);
+		FF_GL_BIND(glBindTexture, toGL(texture->mTextureType), textural->mHandle);
 
-		/// 设置纹理参数
-		glTexParameteri(toGL(texture->mTextureType), GL_TEXTURE_MIN_FILTER, toGL(texture->mMinFilter));
-		glTexParameteri(toGL(texture->mTextureType), GL_TEXTURE_MAG_FILTER, toGL(texture->mMagFilter));
-		glTexParameteri(toGL(texture->mTextureType), GL_TEXTURE_WRAP_S, toGL(texture->mWrapS));
-		glTexParameteri(toGL(texture->mTextureType), GL_TEXTURE_WRAP_T, toGL(texture->mWrapT));
-		glTexParameteri(toGL(texture->mTextureType), GL_TEXTURE_WRAP_R, toGL(texture->mWrapR));
+		/// 过滤与包裹方式不再写入纹理对象，而是由绑定时的sampler对象决定，参数相同的纹理共享同一个sampler
+		textural->mSampler = getSampler(texture);
 
 		if (texture->mTextureType == TextureType::Texture2D)
 		{
@@ -74,9 +64,9 @@ namespace ff
 
 			/// 1 开辟内存空间 显存
 			/// 2 传输图片数据
-			glTexImage2D(GL_TEXTURE_2D, 0, toGL(texture->mInternalFormat), texture->mWidth, texture->mHeight, 0,
+			FF_GL(glTexImage2D, GL_TEXTURE_2D, 0, toGL(texture->mInternalFormat), texture->mWidth, texture->mHeight, 0,
 			             toGL(texture->mFormat), toGL(texture->mDataType), data);
-			glGenerateMipmap(GL_TEXTURE_2D);
+			FF_GL(glGenerateMipmap, GL_TEXTURE_2D);
 		}
 		else
 		{
@@ -90,12 +80,13 @@ namespace ff
 
 				/// 开辟内存及更新数据的顺序：右左上下前后
 				/// 要给哪一个面开辟内存更新数据，就输入哪一个面的target
-				glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, toGL(texture->mInternalFormat), texture->mWidth,
+				FF_GL(glTexImage2D, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, toGL(texture->mInternalFormat), texture->mWidth,
 				             texture->mHeight, 0, toGL(texture->mFormat), toGL(texture->mDataType), data);
 			}
 		}
 
-		glBindTexture(toGL(texture->mTextureType), 0);
+		FF_GL_BIND(glBindTexture, toGL(texture->mTextureType), 0);
+		resetActiveUnit();
 		mInfo->mMemory.mTextures++;
 
 		return textural;
@@ -106,9 +97,9 @@ namespace ff
 	{
 		const auto dTexture = get(texture);
 
-		glBindFramebuffer(GL_FRAMEBUFFER, fbo);
-		glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, toGL(texture->mTextureType), dTexture->mHandle, 0);
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		FF_GL_BIND(glBindFramebuffer, GL_FRAMEBUFFER, fbo);
+		FF_GL(glFramebufferTexture2D, GL_FRAMEBUFFER, attachment, toGL(texture->mTextureType), dTexture->mHandle, 0);
+		FF_GL_BIND(glBindFramebuffer, GL_FRAMEBUFFER, 0);
 	}
 
 	void DriverTextures::setupFBODepthStencilAttachment(const RenderTarget::Ptr& renderTarget) noexcept
@@ -144,10 +135,10 @@ namespace ff
 		const auto dDepthTexture = get(depthTexture);
 		setupDriverTexture(depthTexture);
 
-		glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer);
-		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, toGL(depthTexture->mTextureType),
+		FF_GL_BIND(glBindFramebuffer, GL_FRAMEBUFFER, frameBuffer);
+		FF_GL(glFramebufferTexture2D, GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, toGL(depthTexture->mTextureType),
 		                       dDepthTexture->mHandle, 0);
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		FF_GL_BIND(glBindFramebuffer, GL_FRAMEBUFFER, 0);
 	}
 
 	void DriverTextures::setupDepthRenderBuffer(const GLuint& frameBuffer, const RenderTarget::Ptr& renderTarget)
@@ -155,23 +146,23 @@ namespace ff
 		const auto dRenderTarget = mRenderTargets->get(renderTarget);
 
 		/// 创建RenderBuffer
-		glGenRenderbuffers(1, &dRenderTarget->mDepthRenderBuffer);
-		glBindRenderbuffer(GL_RENDERBUFFER, dRenderTarget->mDepthRenderBuffer);
+		FF_GL(glGenRenderbuffers, 1, &dRenderTarget->mDepthRenderBuffer);
+		FF_GL_BIND(glBindRenderbuffer, GL_RENDERBUFFER, dRenderTarget->mDepthRenderBuffer);
 
 		/// 为renderBuffer对象开辟空间
-		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT16, renderTarget->mWidth, renderTarget->mHeight);
-		glBindRenderbuffer(GL_RENDERBUFFER, 0);
+		FF_GL(glRenderbufferStorage, GL_RENDERBUFFER, GL_DEPTH_COMPONENT16, renderTarget->mWidth, renderTarget->mHeight);
+		FF_GL_BIND(glBindRenderbuffer, GL_RENDERBUFFER, 0);
 
 		/// 向frameBuffer进行绑定
-		glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer);
-		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER,
+		FF_GL_BIND(glBindFramebuffer, GL_FRAMEBUFFER, frameBuffer);
+		FF_GL(glFramebufferRenderbuffer, GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER,
 		                          dRenderTarget->mDepthRenderBuffer);
 
-		GLint error = glCheckFramebufferStatus(GL_FRAMEBUFFER);
-		if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		GLint error = FF_GL(glCheckFramebufferStatus, GL_FRAMEBUFFER);
+		if (FF_GL(glCheckFramebufferStatus, GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
 			std::cout << "ERROR::FRAMEBUFFER:: Framebuffer is not complete!" << std::endl;
 
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		FF_GL_BIND(glBindFramebuffer, GL_FRAMEBUFFER, 0);
 	}
 
 	auto DriverTextures::get(const Texture::Ptr& texture) noexcept -> DriverTexture::Ptr
@@ -187,14 +178,78 @@ namespace ff
 
 	auto DriverTextures::bindTexture(const Texture::Ptr& texture, GLenum textureUnit) -> void
 	{
+		/// 更新或者创建textureID，只查找一次DriverTexture
+		const auto dTexture = texture->mNeedsUpdate ? setupDriverTexture(texture) : get(texture);
+
 		/// GL_TEXTURE0  GL_TEXTURE1 GL_TEXTURE2....
 		/// GL_TEXTURE1 = GL_TEXTURE0+1
 		/// GL_TEXTURE2 = GL_TEXTURE0+2
-		glActiveTexture(textureUnit);
-		/// 更新或者创建textureID
-		update(texture);
-		const auto dTexture = get(texture);
-		glBindTexture(toGL(texture->mTextureType), dTexture->mHandle);
+		const uint32_t unit = textureUnit - GL_TEXTURE0;
+
+		/// 超出记录范围的textureUnit不做缓存
+		if (unit >= TEXTURE_UNIT_COUNT)
+		{
+			FF_GL_BIND(glActiveTexture, textureUnit);
+			mActiveUnit = textureUnit;
+			FF_GL_BIND(glBindTexture, toGL(texture->mTextureType), dTexture->mHandle);
+			FF_GL_BIND(glBindSampler, unit, dTexture->mSampler);
+			return;
+		}
+
+		if (mBoundTextures[unit] != dTexture->mHandle)
+		{
+			if (mActiveUnit != textureUnit)
+			{
+				FF_GL_BIND(glActiveTexture, textureUnit);
+				mActiveUnit = textureUnit;
+			}
+
+			FF_GL_BIND(glBindTexture, toGL(texture->mTextureType), dTexture->mHandle);
+			mBoundTextures[unit] = dTexture->mHandle;
+		}
+
+		/// sampler直接按照unit编号绑定，不需要glActiveTexture
+		if (mBoundSamplers[unit] != dTexture->mSampler)
+		{
+			FF_GL_BIND(glBindSampler, unit, dTexture->mSampler);
+			mBoundSamplers[unit] = dTexture->mSampler;
+		}
+	}
+
+	auto DriverTextures::getSampler(const Texture::Ptr& texture) noexcept -> GLuint
+	{
+		/// 每个枚举值都小于16，各占4位
+		const uint32_t key = static_cast<uint32_t>(texture->mMinFilter)
+			| static_cast<uint32_t>(texture->mMagFilter) << 4
+			| static_cast<uint32_t>(texture->mWrapS) << 8
+			| static_cast<uint32_t>(texture->mWrapT) << 12
+			| static_cast<uint32_t>(texture->mWrapR) << 16;
+
+		if (const auto iter = mSamplers.find(key); iter != mSamplers.end())
+		{
+			return iter->second;
+		}
+
+		GLuint sampler = 0;
+		FF_GL(glGenSamplers, 1, &sampler);
+		FF_GL(glSamplerParameteri, sampler, GL_TEXTURE_MIN_FILTER, toGL(texture->mMinFilter));
+		FF_GL(glSamplerParameteri, sampler, GL_TEXTURE_MAG_FILTER, toGL(texture->mMagFilter));
+		FF_GL(glSamplerParameteri, sampler, GL_TEXTURE_WRAP_S, toGL(texture->mWrapS));
+		FF_GL(glSamplerParameteri, sampler, GL_TEXTURE_WRAP_T, toGL(texture->mWrapT));
+		FF_GL(glSamplerParameteri, sampler, GL_TEXTURE_WRAP_R, toGL(texture->mWrapR));
+
+		mSamplers.insert(std::make_pair(key, sampler));
+
+		return sampler;
+	}
+
+	auto DriverTextures::resetActiveUnit() noexcept -> void
+	{
+		const uint32_t unit = mActiveUnit - GL_TEXTURE0;
+		if (unit < TEXTURE_UNIT_COUNT)
+		{
+			mBoundTextures[unit] = 0;
+		}
 	}
 
 	auto DriverTextures::setupRenderTarget(const RenderTarget::Ptr& renderTarget) noexcept -> void
@@ -241,6 +296,15 @@ namespace ff
 
 		if (const auto iter = mTextures.find(texture->getID()); iter != mTextures.end())
 		{
+			/// 纹理被删除之后，其编号可能被新的纹理复用，不能再认为它还绑定着
+			for (auto& handle : mBoundTextures)
+			{
+				if (handle == iter->second->mHandle)
+				{
+					handle = 0;
+				}
+			}
+
 			mTextures.erase(iter);
 			mInfo->mMemory.mTextures--;
 		}
@@ -27,6 +27,9 @@ namespace ff {
 		/// \brief ͨglGenTexturesõtextureı
 		GLuint	mHandle{ 0 };
 
+		/// \brief ʽӦsamplerDriverTexturesͳһ빲
+		GLuint	mSampler{ 0 };
+
 	};
 	
 	/*
@@ -61,9 +64,16 @@ namespace ff {
 		auto onTextureDestroy(const EventBase::Ptr& e) noexcept -> void;
 
 	private:
-		/// \brief Ҫô½һtexture  Ҫôԭtextureݻ
-		/// \param texture 
-		auto update(const Texture::Ptr& texture) noexcept -> void;
+		/// DriverUniformsDriverUniformTableܹtextureUnitһ
+		static constexpr uint32_t TEXTURE_UNIT_COUNT = MAX_TEXTURE - GL_TEXTURE0;
+
+		/// \brief (min, mag, wrapS, wrapT, wrapR)ȡsamplerû򴴽
+		/// \param texture
+		/// \return
+		auto getSampler(const Texture::Ptr& texture) noexcept -> GLuint;
+
+		/// \brief ǰtextureUnitϰ˱(紴ʱ)¼
+		auto resetActiveUnit() noexcept -> void;
 
 		/// \brief װһDriverTexture (openglײ㴴)
 		/// \param texture 
@@ -83,5 +93,13 @@ namespace ff {
 		DriverInfo::Ptr								mInfo{ nullptr };
 		DriverRenderTargets::Ptr					mRenderTargets{ nullptr };
 		std::unordered_map<ID, DriverTexture::Ptr>	mTextures{};
+
+		/// key:ʽ֮
+		std::unordered_map<uint32_t, GLuint>		mSamplers{};
+
+		/// ÿtextureUnitǰ󶨵samplerͬ
+		GLenum										mActiveUnit{ GL_TEXTURE0 };
+		std::array<GLuint, TEXTURE_UNIT_COUNT>		mBoundTextures{};
+		std::array<GLuint, TEXTURE_UNIT_COUNT>		mBoundSamplers{};
 	};
 }
\ No newline at end of file
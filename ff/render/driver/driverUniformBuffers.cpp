@@ -0,0 +1,71 @@
+﻿#include "driverUniformBuffers.h"
+#include <cstring>
+#include "../../wrapper/glTrace.h"
+
+namespace ff {
+
+	DriverUniformBuffers::DriverUniformBuffers() noexcept {
+		FF_GL(glGenBuffers, 1, &mCameraBuffer);
+		FF_GL_BIND(glBindBuffer, GL_UNIFORM_BUFFER, mCameraBuffer);
+		FF_GL(glBufferData, GL_UNIFORM_BUFFER, sizeof(CameraBlock), &mCameraBlock, GL_DYNAMIC_DRAW);
+
+		FF_GL(glGenBuffers, 1, &mLightsBuffer);
+		FF_GL_BIND(glBindBuffer, GL_UNIFORM_BUFFER, mLightsBuffer);
+		FF_GL(glBufferData, GL_UNIFORM_BUFFER, sizeof(DriverLights::LightsBlock), &mLightsBlock, GL_DYNAMIC_DRAW);
+
+		FF_GL_BIND(glBindBuffer, GL_UNIFORM_BUFFER, 0);
+
+		/// binding point是全局状态，绑定一次即可
+		FF_GL_BIND(glBindBufferBase, GL_UNIFORM_BUFFER, CAMERA_BLOCK_BINDING, mCameraBuffer);
+		FF_GL_BIND(glBindBufferBase, GL_UNIFORM_BUFFER, LIGHTS_BLOCK_BINDING, mLightsBuffer);
+	}
+
+	DriverUniformBuffers::~DriverUniformBuffers() noexcept {
+		FF_GL(glDeleteBuffers, 1, &mCameraBuffer);
+		FF_GL(glDeleteBuffers, 1, &mLightsBuffer);
+	}
+
+	auto DriverUniformBuffers::updateCamera(const Camera::Ptr& camera) noexcept -> void
+	{
+		CameraBlock block;
+		block.mViewMatrix = camera->getWorldMatrixInverse();
+		block.mProjectionMatrix = camera->getProjectionMatrix();
+		block.mCameraPosition = glm::vec4(camera->getWorldPosition(), 1.0f);
+
+		if (std::memcmp(&block, &mCameraBlock, sizeof(CameraBlock)) == 0) return;
+
+		mCameraBlock = block;
+		upload(mCameraBuffer, &mCameraBlock, sizeof(CameraBlock));
+	}
+
+	auto DriverUniformBuffers::updateLights(const DriverLights::Ptr& lights) noexcept -> void
+	{
+		const auto& block = lights->mState.mLightsBlock;
+
+		if (std::memcmp(&block, &mLightsBlock, sizeof(DriverLights::LightsBlock)) == 0) return;
+
+		mLightsBlock = block;
+		upload(mLightsBuffer, &mLightsBlock, sizeof(DriverLights::LightsBlock));
+	}
+
+	auto DriverUniformBuffers::bindBlocks(GLuint program) noexcept -> void
+	{
+		/// 没有用到的block会被编译器优化掉，此时得到GL_INVALID_INDEX
+		const auto cameraIndex = FF_GL(glGetUniformBlockIndex, program, CAMERA_BLOCK_NAME);
+		if (cameraIndex != GL_INVALID_INDEX) {
+			FF_GL(glUniformBlockBinding, program, cameraIndex, CAMERA_BLOCK_BINDING);
+		}
+
+		const auto lightsIndex = FF_GL(glGetUniformBlockIndex, program, LIGHTS_BLOCK_NAME);
+		if (lightsIndex != GL_INVALID_INDEX) {
+			FF_GL(glUniformBlockBinding, program, lightsIndex, LIGHTS_BLOCK_BINDING);
+		}
+	}
+
+	auto DriverUniformBuffers::upload(GLuint buffer, const void* data, size_t size) noexcept -> void
+	{
+		FF_GL_BIND(glBindBuffer, GL_UNIFORM_BUFFER, buffer);
+		FF_GL(glBufferSubData, GL_UNIFORM_BUFFER, 0, size, data);
+		FF_GL_BIND(glBindBuffer, GL_UNIFORM_BUFFER, 0);
+	}
+}
@@ -0,0 +1,62 @@
+﻿#pragma once
+#include "../../global/base.h"
+#include "../../camera/camera.h"
+#include "driverLights.h"
+
+namespace ff {
+
+	/// 每帧/每个视图只更新一次的UniformBuffer(std140)
+	/// 1 CameraBlock：viewMatrix、projectionMatrix、cameraPosition，每个视图(主相机、各个阴影相机)更新一次
+	/// 2 LightsBlock：平行光、阴影参数、阴影矩阵以及环境光，每帧更新一次
+	/// 3 两个buffer绑定在固定的binding point上，program链接之后使用glUniformBlockBinding将block与之对应
+	/// 这样每一次DrawCall都不需要再上传投影矩阵以及全部的光照uniform
+	class DriverUniformBuffers {
+	public:
+		static constexpr GLuint CAMERA_BLOCK_BINDING = 0;
+		static constexpr GLuint LIGHTS_BLOCK_BINDING = 1;
+
+		static constexpr const char* CAMERA_BLOCK_NAME = "CameraBlock";
+		static constexpr const char* LIGHTS_BLOCK_NAME = "LightsBlock";
+
+		/// 与shader当中的CameraBlock按照std140布局一一对应
+		struct CameraBlock {
+			glm::mat4 mViewMatrix{ 1.0f };
+			glm::mat4 mProjectionMatrix{ 1.0f };
+			glm::vec4 mCameraPosition{ 0.0f };
+		};
+
+		static_assert(sizeof(CameraBlock) == 64 + 64 + 16, "CameraBlock must match std140 layout");
+
+		using Ptr = std::shared_ptr<DriverUniformBuffers>;
+		static Ptr create() {
+			return std::make_shared<DriverUniformBuffers>();
+		}
+
+		DriverUniformBuffers() noexcept;
+
+		~DriverUniformBuffers() noexcept;
+
+		/// \brief 以camera作为当前视图，更新CameraBlock，数据没有变化则不上传
+		/// \param camera
+		auto updateCamera(const Camera::Ptr& camera) noexcept -> void;
+
+		/// \brief 更新LightsBlock，数据没有变化则不上传
+		/// \param lights
+		auto updateLights(const DriverLights::Ptr& lights) noexcept -> void;
+
+		/// \brief 将program当中的CameraBlock与LightsBlock对应到固定的binding point，program链接之后调用
+		/// \param program
+		static auto bindBlocks(GLuint program) noexcept -> void;
+
+	private:
+		static auto upload(GLuint buffer, const void* data, size_t size) noexcept -> void;
+
+	private:
+		GLuint	mCameraBuffer{ 0 };
+		GLuint	mLightsBuffer{ 0 };
+
+		/// 上一次上传的数据，用于跳过没有变化的上传
+		CameraBlock					mCameraBlock{};
+		DriverLights::LightsBlock	mLightsBlock{};
+	};
+}
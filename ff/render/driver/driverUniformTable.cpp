@@ -0,0 +1,243 @@
+﻿#include "driverUniformTable.h"
+#include "../../material/meshPhongMaterial.h"
+#include "../../wrapper/glWrapper.hpp"
+#include <cstring>
+#include "../../wrapper/glTrace.h"
+
+namespace ff {
+
+	/// 非sampler的uniform一个元素所占的字节数
+	static auto getShadowSize(GLenum type) noexcept -> size_t {
+		switch (type) {
+		case GL_FLOAT:
+			return sizeof(float);
+		case GL_FLOAT_MAT3:
+			return sizeof(glm::mat3);
+		case GL_FLOAT_MAT4:
+			return sizeof(glm::mat4);
+		default:
+			return 0;
+		}
+	}
+
+	const std::array<const char*, DriverUniformTable::SlotCount> DriverUniformTable::SLOT_NAMES = {
+		"modelViewMatrix",
+		"normalMatrix",
+		"modelMatrix",
+		"opacity",
+		"shininess",
+		"diffuseMap",
+		"normalMap",
+		"specularMap",
+		"envMap",
+		"directionalShadowMap",
+		"boneMatrices",
+	};
+
+	DriverUniformTable::DriverUniformTable(GLuint program) noexcept {
+		GLint count = 0;
+		FF_GL(glGetProgramiv, program, GL_ACTIVE_UNIFORMS, &count);
+
+		GLsizei length;
+		GLint size;
+		GLenum type;
+		GLchar name[256];
+
+		for (GLint i = 0; i < count; ++i) {
+			FF_GL(glGetActiveUniform, program, i, 256, &length, &size, &type, name);
+
+			/// 数组形式的uniform，opengl返回的名字为xxx[0]
+			std::string id = name;
+			if (const auto pos = id.find('['); pos != std::string::npos) {
+				id = id.substr(0, pos);
+			}
+
+			const auto iter = std::find_if(SLOT_NAMES.begin(), SLOT_NAMES.end(),
+				[&id](const char* slotName) { return id == slotName; });
+
+			/// block成员以及表中没有的uniform，不在这里处理
+			if (iter == SLOT_NAMES.end()) {
+				continue;
+			}
+
+			const GLint location = FF_GL(glGetUniformLocation, program, name);
+			if (location < 0) {
+				continue;
+			}
+
+			const auto slot = static_cast<Slot>(iter - SLOT_NAMES.begin());
+			auto& entry = mEntries[slot];
+			entry.mLocation = location;
+			entry.mSize = size;
+			entry.mType = type;
+
+			mActiveSlots.push_back(slot);
+		}
+
+		/// 按照槽位顺序为sampler分配固定的textureUnit
+		std::sort(mActiveSlots.begin(), mActiveSlots.end());
+
+		GLint textureUnit = 0;
+		for (const auto slot : mActiveSlots) {
+			auto& entry = mEntries[slot];
+			if (entry.mType != GL_SAMPLER_2D && entry.mType != GL_SAMPLER_CUBE) {
+				continue;
+			}
+
+			if (GL_TEXTURE0 + textureUnit + entry.mSize > MAX_TEXTURE) {
+				std::cerr << "DriverUniformTable: too much textures, " << SLOT_NAMES[slot] << " is ignored" << std::endl;
+				entry.mLocation = -1;
+				continue;
+			}
+
+			entry.mTextureUnit = textureUnit;
+			textureUnit += entry.mSize;
+		}
+
+		mActiveSlots.erase(std::remove_if(mActiveSlots.begin(), mActiveSlots.end(),
+			[this](Slot slot) { return mEntries[slot].mLocation < 0; }), mActiveSlots.end());
+
+		/// 为每个非sampler槽位在mShadow当中留出位置
+		size_t shadowSize = 0;
+		for (const auto slot : mActiveSlots) {
+			auto& entry = mEntries[slot];
+			entry.mShadowOffset = shadowSize;
+			shadowSize += getShadowSize(entry.mType) * entry.mSize;
+		}
+
+		mShadow.resize(shadowSize);
+	}
+
+	DriverUniformTable::~DriverUniformTable() noexcept {}
+
+	auto DriverUniformTable::invalidate() noexcept -> void {
+		mTextureUnitsBound = false;
+
+		for (auto& entry : mEntries) {
+			entry.mShadowValid = false;
+		}
+	}
+
+	auto DriverUniformTable::changed(Entry& entry, const void* data, size_t size, const DriverInfo::Ptr& info) noexcept -> bool {
+		auto shadow = mShadow.data() + entry.mShadowOffset;
+
+		if (entry.mShadowValid && std::memcmp(shadow, data, size) == 0) {
+			info->mRender.mUniformSkips++;
+			return false;
+		}
+
+		std::memcpy(shadow, data, size);
+		entry.mShadowValid = true;
+		info->mRender.mUniformUploads++;
+
+		return true;
+	}
+
+	auto DriverUniformTable::upload(const Sources& sources, const DriverTextures::Ptr& textures, const DriverInfo::Ptr& info) noexcept -> void {
+		/// sampler与textureUnit的对应关系是program自己的状态，只需要设置一次
+		if (!mTextureUnitsBound) {
+			for (const auto slot : mActiveSlots) {
+				const auto& entry = mEntries[slot];
+				if (entry.mTextureUnit < 0) {
+					continue;
+				}
+
+				std::vector<GLint> units(entry.mSize);
+				for (GLint i = 0; i < entry.mSize; ++i) {
+					units[i] = entry.mTextureUnit + i;
+				}
+
+				gl::uniform1iv(entry.mLocation, entry.mSize, units.data());
+			}
+
+			mTextureUnitsBound = true;
+		}
+
+		const auto material = sources.mMaterial;
+
+		for (const auto slot : mActiveSlots) {
+			auto& entry = mEntries[slot];
+
+			switch (slot) {
+			case ModelViewMatrix:
+				if (sources.mModelViewMatrix && changed(entry, sources.mModelViewMatrix, sizeof(glm::mat4), info)) {
+					FF_GL(glUniformMatrix4fv, entry.mLocation, 1, GL_FALSE, glm::value_ptr(*sources.mModelViewMatrix));
+				}
+				break;
+			case NormalMatrix:
+				if (sources.mNormalMatrix && changed(entry, sources.mNormalMatrix, sizeof(glm::mat3), info)) {
+					FF_GL(glUniformMatrix3fv, entry.mLocation, 1, GL_FALSE, glm::value_ptr(*sources.mNormalMatrix));
+				}
+				break;
+			case ModelMatrix:
+				if (sources.mModelMatrix && changed(entry, sources.mModelMatrix, sizeof(glm::mat4), info)) {
+					FF_GL(glUniformMatrix4fv, entry.mLocation, 1, GL_FALSE, glm::value_ptr(*sources.mModelMatrix));
+				}
+				break;
+			case Opacity:
+				if (material && changed(entry, &material->mOpacity, sizeof(float), info)) {
+					FF_GL(glUniform1f, entry.mLocation, material->mOpacity);
+				}
+				break;
+			case Shininess:
+				if (material && material->mIsMeshPhongMaterial) {
+					const auto& shininess = static_cast<const MeshPhongMaterial*>(material)->mShininess;
+					if (changed(entry, &shininess, sizeof(float), info)) {
+						FF_GL(glUniform1f, entry.mLocation, shininess);
+					}
+				}
+				break;
+			case DiffuseMap:
+				if (material) {
+					uploadTexture(entry, material->mDiffuseMap, textures);
+				}
+				break;
+			case NormalMap:
+				if (material) {
+					uploadTexture(entry, material->mNormalMap, textures);
+				}
+				break;
+			case SpecularMap:
+				if (material) {
+					uploadTexture(entry, material->mSpecularMap, textures);
+				}
+				break;
+			case EnvMap:
+				if (material) {
+					uploadTexture(entry, material->mEnvMap, textures);
+				}
+				break;
+			case DirectionalShadowMap:
+				if (sources.mDirectionalShadowMaps) {
+					const auto& shadowMaps = *sources.mDirectionalShadowMaps;
+					const auto count = std::min<size_t>(shadowMaps.size(), entry.mSize);
+					for (size_t i = 0; i < count; ++i) {
+						if (shadowMaps[i]) {
+							textures->bindTexture(shadowMaps[i], GL_TEXTURE0 + entry.mTextureUnit + i);
+						}
+					}
+				}
+				break;
+			case BoneMatrices:
+				if (sources.mBoneMatrices && !sources.mBoneMatrices->empty()) {
+					const auto& boneMatrices = *sources.mBoneMatrices;
+					const auto count = std::min<size_t>(boneMatrices.size(), entry.mSize);
+					if (changed(entry, boneMatrices.data(), count * sizeof(glm::mat4), info)) {
+						FF_GL(glUniformMatrix4fv, entry.mLocation, static_cast<GLsizei>(count), GL_FALSE, glm::value_ptr(boneMatrices[0]));
+					}
+				}
+				break;
+			default:
+				break;
+			}
+		}
+	}
+
+	auto DriverUniformTable::uploadTexture(const Entry& entry, const Texture::Ptr& texture, const DriverTextures::Ptr& textures) noexcept -> void {
+		if (texture == nullptr) {
+			return;
+		}
+
+		textures->bindTexture(texture, GL_TEXTURE0 + entry.mTextureUnit);
+	}
+}
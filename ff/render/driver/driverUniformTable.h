@@ -0,0 +1,98 @@
+﻿#pragma once
+#include "../../global/base.h"
+#include "../../material/material.h"
+#include "../../textures/texture.h"
+#include "driverTextures.h"
+#include "driverInfo.h"
+#include <array>
+
+namespace ff {
+
+	/// 每个program在链接之后编译出来的uniform表，替代绘制热路径上的UniformHandleMap
+	/// 1 shader当中所有非block的uniform都是固定的一组，链接时按照名字查出location，记录为整数槽位(Slot)
+	/// 2 每次DrawCall只遍历本program真正激活的槽位，数据通过Sources中的指针直接读取物体/材质/骨骼/光照的数据，
+	///   不再拷贝map、不再按照字符串查找，也不再经过std::any
+	/// 3 sampler在链接时就分配好固定的textureUnit，sampler与unit的对应关系只需要在第一次上传时设置一次
+	/// 4 每个槽位保存上一次上传的值(一小段字节)，memcmp相同则跳过glUniform调用
+	/// 注意：shader当中新增了uniform，需要同时在Slot以及SLOT_NAMES当中加入
+	class DriverUniformTable {
+	public:
+		enum Slot : uint32_t {
+			ModelViewMatrix = 0,
+			NormalMatrix,
+			ModelMatrix,
+			Opacity,
+			Shininess,
+			DiffuseMap,
+			NormalMap,
+			SpecularMap,
+			EnvMap,
+			DirectionalShadowMap,
+			BoneMatrices,
+			SlotCount
+		};
+
+		/// 与Slot一一对应，数组形式的uniform不带[0]
+		static const std::array<const char*, SlotCount> SLOT_NAMES;
+
+		/// 一次DrawCall所需数据的来源，全部为指针，由Renderer在setProgram当中填写
+		struct Sources {
+			const glm::mat4*					mModelViewMatrix{ nullptr };
+			const glm::mat3*					mNormalMatrix{ nullptr };
+			const glm::mat4*					mModelMatrix{ nullptr };
+			const Material*						mMaterial{ nullptr };
+			const std::vector<Texture::Ptr>*	mDirectionalShadowMaps{ nullptr };
+			const std::vector<glm::mat4>*		mBoneMatrices{ nullptr };
+		};
+
+		using Ptr = std::shared_ptr<DriverUniformTable>;
+		static Ptr create(GLuint program) {
+			return std::make_shared<DriverUniformTable>(program);
+		}
+
+		DriverUniformTable(GLuint program) noexcept;
+
+		~DriverUniformTable() noexcept;
+
+		/// \brief 按照槽位上传本次DrawCall的uniform，调用之前本program必须已经绑定
+		/// \param sources
+		/// \param textures
+		/// \param info 统计上传与跳过的glUniform次数
+		auto upload(const Sources& sources, const DriverTextures::Ptr& textures, const DriverInfo::Ptr& info) noexcept -> void;
+
+		/// \brief 旧的DriverUniforms绕过本表修改了program的uniform，之后需要重新设置sampler并且不能再信任保存的值
+		auto invalidate() noexcept -> void;
+
+	private:
+		struct Entry {
+			GLint		mLocation{ -1 };
+			GLint		mSize{ 0 };
+			GLenum		mType{ 0 };
+
+			/// sampler所使用的第一个textureUnit编号(0代表GL_TEXTURE0)
+			GLint		mTextureUnit{ -1 };
+
+			/// 上一次上传的值在mShadow当中的位置，以及是否已经上传过
+			size_t		mShadowOffset{ 0 };
+			bool		mShadowValid{ false };
+		};
+
+		auto uploadTexture(const Entry& entry, const Texture::Ptr& texture, const DriverTextures::Ptr& textures) noexcept -> void;
+
+		/// \brief 与上一次上传的值比较，不同则记录下新的值
+		/// \return 需要调用glUniform时返回true
+		auto changed(Entry& entry, const void* data, size_t size, const DriverInfo::Ptr& info) noexcept -> bool;
+
+	private:
+		std::array<Entry, SlotCount>	mEntries{};
+
+		/// 本program激活了的槽位，上传时只遍历它们
+		std::vector<Slot>				mActiveSlots{};
+
+		/// 所有非sampler槽位上一次上传的值
+		std::vector<uint8_t>			mShadow{};
+
+		/// sampler与textureUnit的对应关系是否已经设置
+		bool	mTextureUnitsBound{ false };
+	};
+}
@@ -1,6 +1,7 @@
 ﻿#include "driverUniforms.h"
 #include "../../log/debugLog.h"
 #include "../../wrapper/glWrapper.hpp"
+#include "../../wrapper/glTrace.h"
 
 namespace ff
 {
@@ -308,7 +309,7 @@ namespace ff
 	{
 		/// 获得当前program中已经激活的uniforms的数量
 		GLint count = 0;
-		glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+		FF_GL(glGetProgramiv, program, GL_ACTIVE_UNIFORMS, &count);
 
 		UniformContainer* container = this;
 
@@ -322,8 +323,14 @@ namespace ff
 
 		for (uint32_t i = 0; i < count; ++i)
 		{
-			glGetActiveUniform(program, i, bufferSize, &length, &size, &type, name);
-			location = glGetUniformLocation(program, name);
+			FF_GL(glGetActiveUniform, program, i, bufferSize, &length, &size, &type, name);
+			location = FF_GL(glGetUniformLocation, program, name);
+
+			/// uniform block当中的成员没有location，由DriverUniformBuffers统一上传
+			if (location < 0)
+			{
+				continue;
+			}
 
 			/// 正则表达式解析
 			/// (\\w+) 匹配1-多个字符(字母数字下划线）
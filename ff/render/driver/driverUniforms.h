@@ -3,6 +3,7 @@
 #include "../../global/constant.h"
 #include "driverTextures.h"
 #include "../shaders/uniformsLib.h"
+#include "../../wrapper/glTrace.h"
 
 namespace ff
 {
@@ -295,7 +296,7 @@ namespace ff
 	template <>
 	inline auto SingleUniform::upload<float>(const float& value) -> void
 	{
-		glUniform1f(mLocation, value);
+		FF_GL(glUniform1f, mLocation, value);
 	}
 
 	template <>
@@ -304,155 +305,155 @@ namespace ff
 		/// 如果要从glm：：vec2这个类型的变量，拿出来其数据指针，就得使用glm::value_ptr
 		/// 这是为了展示多种多样的做法
 		///	glUniform2f(mLocation, value.x, value.y);
-		glUniform2fv(mLocation, 1, glm::value_ptr(value));
+		FF_GL(glUniform2fv, mLocation, 1, glm::value_ptr(value));
 	}
 
 	template <>
 	inline auto SingleUniform::upload<glm::vec3>(const glm::vec3& value) -> void
 	{
-		glUniform3fv(mLocation, 1, glm::value_ptr(value));
+		FF_GL(glUniform3fv, mLocation, 1, glm::value_ptr(value));
 	}
 
 	template <>
 	inline auto SingleUniform::upload<glm::vec4>(const glm::vec4& value) -> void
 	{
-		glUniform4fv(mLocation, 1, glm::value_ptr(value));
+		FF_GL(glUniform4fv, mLocation, 1, glm::value_ptr(value));
 	}
 
 	template <>
 	inline void SingleUniform::upload<int>(const int& value)
 	{
-		glUniform1i(mLocation, value);
+		FF_GL(glUniform1i, mLocation, value);
 	}
 
 	template <>
 	inline auto SingleUniform::upload<glm::ivec2>(const glm::ivec2& value) -> void
 	{
-		glUniform2i(mLocation, value.x, value.y);
+		FF_GL(glUniform2i, mLocation, value.x, value.y);
 	}
 
 	template <>
 	inline auto SingleUniform::upload<glm::ivec3>(const glm::ivec3& value) -> void
 	{
-		glUniform3i(mLocation, value.x, value.y, value.z);
+		FF_GL(glUniform3i, mLocation, value.x, value.y, value.z);
 	}
 
 	template <>
 	inline auto SingleUniform::upload<glm::ivec4>(const glm::ivec4& value) -> void
 	{
-		glUniform4i(mLocation, value.x, value.y, value.z, value.w);
+		FF_GL(glUniform4i, mLocation, value.x, value.y, value.z, value.w);
 	}
 
 	template <>
 	inline auto SingleUniform::upload<bool>(const bool& value) -> void
 	{
 		int v = value;
-		glUniform1i(mLocation, v);
+		FF_GL(glUniform1i, mLocation, v);
 	}
 
 	template <>
 	inline auto SingleUniform::upload<glm::bvec2>(const glm::bvec2& value) -> void
 	{
 		glm::ivec2 v = value;
-		glUniform2i(mLocation, v.x, v.y);
+		FF_GL(glUniform2i, mLocation, v.x, v.y);
 	}
 
 	template <>
 	inline auto SingleUniform::upload<glm::bvec3>(const glm::bvec3& value) -> void
 	{
 		glm::ivec3 v = value;
-		glUniform3i(mLocation, v.x, v.y, v.z);
+		FF_GL(glUniform3i, mLocation, v.x, v.y, v.z);
 	}
 
 	template <>
 	inline auto SingleUniform::upload<glm::bvec4>(const glm::bvec4& value) -> void
 	{
 		glm::ivec4 v = value;
-		glUniform4i(mLocation, v.x, v.y, v.z, v.w);
+		FF_GL(glUniform4i, mLocation, v.x, v.y, v.z, v.w);
 	}
 
 	template <>
 	inline auto SingleUniform::upload<glm::mat2>(const glm::mat2& value) -> void
 	{
-		glUniformMatrix2fv(mLocation, 1, GL_FALSE, glm::value_ptr(value));
+		FF_GL(glUniformMatrix2fv, mLocation, 1, GL_FALSE, glm::value_ptr(value));
 	}
 
 	template <>
 	inline auto SingleUniform::upload<glm::mat3>(const glm::mat3& value) -> void
 	{
-		glUniformMatrix3fv(mLocation, 1, GL_FALSE, glm::value_ptr(value));
+		FF_GL(glUniformMatrix3fv, mLocation, 1, GL_FALSE, glm::value_ptr(value));
 	}
 
 	template <>
 	inline auto SingleUniform::upload<glm::mat4>(const glm::mat4& value) -> void
 	{
-		glUniformMatrix4fv(mLocation, 1, GL_FALSE, glm::value_ptr(value));
+		FF_GL(glUniformMatrix4fv, mLocation, 1, GL_FALSE, glm::value_ptr(value));
 	}
 
 	template <>
 	inline auto PureArrayUniform::upload<float>(const float* value) -> void
 	{
-		glUniform1fv(mLocation, mSize, value);
+		FF_GL(glUniform1fv, mLocation, mSize, value);
 	}
 
 	template <>
 	inline auto PureArrayUniform::upload<glm::vec2>(const glm::vec2* value) -> void
 	{
 		/// 需要拿到数组开头的指针，拿到数组的第一个元素 value【0】，然后取其数据地址
-		glUniform2fv(mLocation, mSize, glm::value_ptr(value[0]));
+		FF_GL(glUniform2fv, mLocation, mSize, glm::value_ptr(value[0]));
 	}
 
 	template <>
 	inline auto PureArrayUniform::upload<glm::vec3>(const glm::vec3* value) -> void
 	{
-		glUniform3fv(mLocation, mSize, glm::value_ptr(value[0]));
+		FF_GL(glUniform3fv, mLocation, mSize, glm::value_ptr(value[0]));
 	}
 
 	template <>
 	inline auto PureArrayUniform::upload<glm::vec4>(const glm::vec4* value) -> void
 	{
-		glUniform4fv(mLocation, mSize, glm::value_ptr(value[0]));
+		FF_GL(glUniform4fv, mLocation, mSize, glm::value_ptr(value[0]));
 	}
 
 	template <>
 	inline auto PureArrayUniform::upload<int>(const int* value) -> void
 	{
-		glUniform1iv(mLocation, mSize, value);
+		FF_GL(glUniform1iv, mLocation, mSize, value);
 	}
 
 	template <>
 	inline auto PureArrayUniform::upload<glm::ivec2>(const glm::ivec2* value) -> void
 	{
-		glUniform2iv(mLocation, mSize, glm::value_ptr(value[0]));
+		FF_GL(glUniform2iv, mLocation, mSize, glm::value_ptr(value[0]));
 	}
 
 	template <>
 	inline auto PureArrayUniform::upload<glm::ivec3>(const glm::ivec3* value) -> void
 	{
-		glUniform3iv(mLocation, mSize, glm::value_ptr(value[0]));
+		FF_GL(glUniform3iv, mLocation, mSize, glm::value_ptr(value[0]));
 	}
 
 	template <>
 	inline auto PureArrayUniform::upload<glm::ivec4>(const glm::ivec4* value) -> void
 	{
-		glUniform4iv(mLocation, mSize, glm::value_ptr(value[0]));
+		FF_GL(glUniform4iv, mLocation, mSize, glm::value_ptr(value[0]));
 	}
 
 	template <>
 	inline auto PureArrayUniform::upload<glm::mat2>(const glm::mat2* value) -> void
 	{
-		glUniformMatrix2fv(mLocation, mSize, GL_FALSE, glm::value_ptr(value[0]));
+		FF_GL(glUniformMatrix2fv, mLocation, mSize, GL_FALSE, glm::value_ptr(value[0]));
 	}
 
 	template <>
 	inline auto PureArrayUniform::upload<glm::mat3>(const glm::mat3* value) -> void
 	{
-		glUniformMatrix3fv(mLocation, mSize, GL_FALSE, glm::value_ptr(value[0]));
+		FF_GL(glUniformMatrix3fv, mLocation, mSize, GL_FALSE, glm::value_ptr(value[0]));
 	}
 
 	template <>
 	inline auto PureArrayUniform::upload<glm::mat4>(const glm::mat4* value) -> void
 	{
-		glUniformMatrix4fv(mLocation, mSize, GL_FALSE, glm::value_ptr(value[0]));
+		FF_GL(glUniformMatrix4fv, mLocation, mSize, GL_FALSE, glm::value_ptr(value[0]));
 	}
 }
@@ -3,7 +3,7 @@
 
 namespace ff {
 
-	DriverWindow::DriverWindow(Renderer* renderer, const int& width, const int& height) noexcept {
+	DriverWindow::DriverWindow(Renderer* renderer, const int& width, const int& height, uint32_t majorVersion, uint32_t minorVersion) noexcept {
 		mWidth = width;
 		mHeight = height;
 		mRenderer = renderer;
@@ -11,8 +11,8 @@ namespace ff {
 		glfwInit();
 
 		/// 初始化上下文信息 /// 渲染 核心模式
-		glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-		glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, static_cast<int>(majorVersion));
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, static_cast<int>(minorVersion));
 		glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 #ifdef __APPLE__
 		glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
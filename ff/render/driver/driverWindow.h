@@ -29,11 +29,11 @@ namespace ff {
 
 		/// ָ
 		using Ptr = std::shared_ptr<DriverWindow>;
-		static Ptr create(Renderer* renderer, const int& width, const int& height) { 
-			return std::make_shared<DriverWindow>(renderer, width, height);
+		static Ptr create(Renderer* renderer, const int& width, const int& height, uint32_t majorVersion = 3, uint32_t minorVersion = 3) { 
+			return std::make_shared<DriverWindow>(renderer, width, height, majorVersion, minorVersion);
 		}
 
-		DriverWindow(Renderer* renderer, const int &width, const int &height) noexcept;
+		DriverWindow(Renderer* renderer, const int &width, const int &height, uint32_t majorVersion = 3, uint32_t minorVersion = 3) noexcept;
 
 		~DriverWindow() noexcept;
 
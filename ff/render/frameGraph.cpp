@@ -0,0 +1,377 @@
+﻿#include "frameGraph.h"
+
+namespace ff
+{
+	FrameGraph::PassBuilder::PassBuilder(FrameGraph* graph, uint32_t pass) noexcept
+	{
+		mGraph = graph;
+		mPass = pass;
+	}
+
+	auto FrameGraph::PassBuilder::read(Handle handle) noexcept -> Handle
+	{
+		if (handle >= mGraph->mResources.size())
+		{
+			std::cerr << "FrameGraph: pass " << mGraph->mPasses[mPass].mName << " reads an invalid target" << std::endl;
+			return INVALID_HANDLE;
+		}
+
+		mGraph->mPasses[mPass].mReads.push_back(handle);
+
+		return handle;
+	}
+
+	auto FrameGraph::PassBuilder::write(Handle handle) noexcept -> Handle
+	{
+		if (handle >= mGraph->mResources.size())
+		{
+			std::cerr << "FrameGraph: pass " << mGraph->mPasses[mPass].mName << " writes an invalid target" << std::endl;
+			return INVALID_HANDLE;
+		}
+
+		auto& pass = mGraph->mPasses[mPass];
+		auto& resource = mGraph->mResources[handle];
+
+		pass.mWrites.push_back(handle);
+		resource.mWriters.push_back(mPass);
+
+		if (resource.mImported)
+		{
+			pass.mSideEffect = true;
+		}
+
+		return handle;
+	}
+
+	FrameGraph::FrameGraph(const DriverInfo::Ptr& info) noexcept
+	{
+		mInfo = info;
+	}
+
+	FrameGraph::~FrameGraph() noexcept
+	{
+	}
+
+	auto FrameGraph::reset() noexcept -> void
+	{
+		mResources.clear();
+		mPasses.clear();
+		mOrder.clear();
+	}
+
+	auto FrameGraph::importTarget(const std::string& name, const RenderTarget::Ptr& target) noexcept -> Handle
+	{
+		Resource resource;
+		resource.mName = name;
+		resource.mImported = true;
+		resource.mTarget = target;
+
+		mResources.push_back(resource);
+
+		return static_cast<Handle>(mResources.size() - 1);
+	}
+
+	auto FrameGraph::createTarget(const std::string& name, const TargetDesc& desc) noexcept -> Handle
+	{
+		Resource resource;
+		resource.mName = name;
+		resource.mDesc = desc;
+
+		mResources.push_back(resource);
+
+		return static_cast<Handle>(mResources.size() - 1);
+	}
+
+	auto FrameGraph::addPass(const std::string& name, const SetupFunction& setup, const ExecuteFunction& execute) noexcept -> void
+	{
+		Pass pass;
+		pass.mName = name;
+		pass.mExecute = execute;
+
+		mPasses.push_back(pass);
+
+		PassBuilder builder(this, static_cast<uint32_t>(mPasses.size() - 1));
+		setup(builder);
+	}
+
+	auto FrameGraph::compile() noexcept -> void
+	{
+		cull();
+		sort();
+		allocate();
+
+		mInfo->mRender.mGraphPasses = static_cast<uint32_t>(mOrder.size());
+		mInfo->mRender.mGraphCulledPasses = static_cast<uint32_t>(mPasses.size() - mOrder.size());
+		mInfo->mRender.mGraphPooledTargets = getPoolSize();
+	}
+
+	/// 引用计数剔除
+	/// 1 资源的引用计数为读取它的Pass数量，Pass的引用计数为它写入的资源数量
+	/// 2 没有人读取的临时资源，其写入者的引用计数减一，减到0且没有写入导入目标的Pass被剔除
+	/// 3 被剔除的Pass不再读取任何资源，它所读取的资源引用计数减一，如此传递下去
+	auto FrameGraph::cull() noexcept -> void
+	{
+		for (auto& pass : mPasses)
+		{
+			pass.mRefCount = static_cast<uint32_t>(pass.mWrites.size());
+			pass.mCulled = false;
+
+			for (const auto handle : pass.mReads)
+			{
+				mResources[handle].mRefCount++;
+			}
+		}
+
+		std::vector<Handle> unreferenced;
+		for (Handle handle = 0; handle < mResources.size(); ++handle)
+		{
+			if (mResources[handle].mRefCount == 0 && !mResources[handle].mImported)
+			{
+				unreferenced.push_back(handle);
+			}
+		}
+
+		auto cullPass = [&](Pass& pass)
+		{
+			pass.mCulled = true;
+
+			for (const auto handle : pass.mReads)
+			{
+				auto& resource = mResources[handle];
+				if (--resource.mRefCount == 0 && !resource.mImported)
+				{
+					unreferenced.push_back(handle);
+				}
+			}
+		};
+
+		/// 什么都不写入的Pass，直接剔除
+		for (auto& pass : mPasses)
+		{
+			if (pass.mRefCount == 0 && !pass.mSideEffect)
+			{
+				cullPass(pass);
+			}
+		}
+
+		while (!unreferenced.empty())
+		{
+			const auto handle = unreferenced.back();
+			unreferenced.pop_back();
+
+			for (const auto writer : mResources[handle].mWriters)
+			{
+				auto& pass = mPasses[writer];
+				if (pass.mCulled || pass.mSideEffect)
+				{
+					continue;
+				}
+
+				if (--pass.mRefCount == 0)
+				{
+					cullPass(pass);
+				}
+			}
+		}
+	}
+
+	/// 一个Pass必须排在它所读取资源的所有写入者之后，以及它所写入资源的之前写入者之后
+	/// 每次在可以执行的Pass当中选择加入最早的一个，没有依赖关系的Pass保持原来的顺序
+	auto FrameGraph::sort() noexcept -> void
+	{
+		const auto count = static_cast<uint32_t>(mPasses.size());
+
+		std::vector<std::vector<uint32_t>> dependencies(count);
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			const auto& pass = mPasses[i];
+			if (pass.mCulled)
+			{
+				continue;
+			}
+
+			for (const auto handle : pass.mReads)
+			{
+				for (const auto writer : mResources[handle].mWriters)
+				{
+					if (writer != i && !mPasses[writer].mCulled)
+					{
+						dependencies[i].push_back(writer);
+					}
+				}
+			}
+
+			for (const auto handle : pass.mWrites)
+			{
+				for (const auto writer : mResources[handle].mWriters)
+				{
+					if (writer < i && !mPasses[writer].mCulled)
+					{
+						dependencies[i].push_back(writer);
+					}
+				}
+			}
+		}
+
+		std::vector<bool> scheduled(count, false);
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			scheduled[i] = mPasses[i].mCulled;
+		}
+
+		mOrder.clear();
+		bool progress = true;
+		while (progress)
+		{
+			progress = false;
+
+			for (uint32_t i = 0; i < count; ++i)
+			{
+				if (scheduled[i])
+				{
+					continue;
+				}
+
+				const auto& deps = dependencies[i];
+				const bool ready = std::all_of(deps.begin(), deps.end(), [&scheduled](uint32_t dep) { return scheduled[dep]; });
+				if (!ready)
+				{
+					continue;
+				}
+
+				scheduled[i] = true;
+				mOrder.push_back(i);
+				progress = true;
+				break;
+			}
+		}
+
+		/// 存在循环依赖的Pass无法排序，不执行
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			if (!scheduled[i])
+			{
+				std::cerr << "FrameGraph: pass " << mPasses[i].mName << " has a cyclic dependency and is skipped" << std::endl;
+				mPasses[i].mCulled = true;
+			}
+		}
+	}
+
+	auto FrameGraph::allocate() noexcept -> void
+	{
+		/// 按照执行顺序计算每个资源的生命周期
+		for (int32_t position = 0; position < static_cast<int32_t>(mOrder.size()); ++position)
+		{
+			const auto& pass = mPasses[mOrder[position]];
+
+			auto use = [&](Handle handle)
+			{
+				auto& resource = mResources[handle];
+				if (resource.mFirstUse < 0)
+				{
+					resource.mFirstUse = position;
+				}
+				resource.mLastUse = position;
+			};
+
+			std::for_each(pass.mReads.begin(), pass.mReads.end(), use);
+			std::for_each(pass.mWrites.begin(), pass.mWrites.end(), use);
+		}
+
+		for (auto& pooled : mPool)
+		{
+			pooled.mBusyUntil = -1;
+		}
+
+		/// 按照第一次使用的先后分配，池子中描述相同并且上一个使用者已经结束的RenderTarget可以直接复用
+		std::vector<Handle> transients;
+		for (Handle handle = 0; handle < mResources.size(); ++handle)
+		{
+			const auto& resource = mResources[handle];
+			if (!resource.mImported && resource.mFirstUse >= 0)
+			{
+				transients.push_back(handle);
+			}
+		}
+
+		std::sort(transients.begin(), transients.end(), [this](Handle a, Handle b)
+		{
+			return mResources[a].mFirstUse < mResources[b].mFirstUse;
+		});
+
+		mInfo->mRender.mGraphTransientTargets = static_cast<uint32_t>(transients.size());
+
+		std::vector<bool> used(mPool.size(), false);
+		for (const auto handle : transients)
+		{
+			auto& resource = mResources[handle];
+
+			auto iter = std::find_if(mPool.begin(), mPool.end(), [&resource](const PooledTarget& pooled)
+			{
+				return pooled.mBusyUntil < resource.mFirstUse && isCompatible(pooled.mDesc, resource.mDesc);
+			});
+
+			if (iter == mPool.end())
+			{
+				PooledTarget pooled;
+				pooled.mDesc = resource.mDesc;
+				pooled.mTarget = RenderTarget::create(resource.mDesc.mWidth, resource.mDesc.mHeight, resource.mDesc.mOptions);
+
+				mPool.push_back(pooled);
+				used.push_back(false);
+				iter = mPool.end() - 1;
+			}
+
+			iter->mBusyUntil = resource.mLastUse;
+			used[iter - mPool.begin()] = true;
+
+			resource.mTarget = iter->mTarget;
+		}
+
+		/// 长时间没有被使用的显存释放掉，避免某一帧的峰值一直占用下去
+		for (size_t i = 0; i < mPool.size(); ++i)
+		{
+			mPool[i].mUnusedFrames = used[i] ? 0 : mPool[i].mUnusedFrames + 1;
+		}
+
+		mPool.erase(std::remove_if(mPool.begin(), mPool.end(), [](const PooledTarget& pooled)
+		{
+			return pooled.mUnusedFrames > POOL_RETAIN_FRAMES;
+		}), mPool.end());
+	}
+
+	auto FrameGraph::execute() noexcept -> void
+	{
+		for (const auto index : mOrder)
+		{
+			const auto& pass = mPasses[index];
+			if (pass.mExecute)
+			{
+				pass.mExecute(*this);
+			}
+		}
+	}
+
+	auto FrameGraph::getTarget(Handle handle) const noexcept -> RenderTarget::Ptr
+	{
+		if (handle >= mResources.size())
+		{
+			return nullptr;
+		}
+
+		return mResources[handle].mTarget;
+	}
+
+	auto FrameGraph::isCompatible(const TargetDesc& a, const TargetDesc& b) noexcept -> bool
+	{
+		const auto& oa = a.mOptions;
+		const auto& ob = b.mOptions;
+
+		return a.mWidth == b.mWidth && a.mHeight == b.mHeight &&
+			oa.mWrapS == ob.mWrapS && oa.mWrapT == ob.mWrapT && oa.mWrapR == ob.mWrapR &&
+			oa.mMagFilter == ob.mMagFilter && oa.mMinFilter == ob.mMinFilter &&
+			oa.mFormat == ob.mFormat && oa.mDataType == ob.mDataType && oa.mInternalFormat == ob.mInternalFormat &&
+			oa.mNeedsDepthBuffer == ob.mNeedsDepthBuffer && oa.mNeedsStencilBuffer == ob.mNeedsStencilBuffer &&
+			oa.mDepthTexture == ob.mDepthTexture;
+	}
+}
@@ -0,0 +1,165 @@
+﻿#pragma once
+#include "../global/base.h"
+#include "renderTarget.h"
+#include "driver/driverInfo.h"
+
+namespace ff
+{
+	/// 一帧之内的渲染阶段(Pass)调度
+	/// 1 每帧重新搭建：reset之后，导入外部的RenderTarget(importTarget)或者声明临时的RenderTarget(createTarget)，
+	///   再通过addPass加入各个阶段，每个阶段在setup当中声明自己读取与写入的RenderTarget
+	/// 2 compile：写入的结果没有被任何阶段读取的Pass会被剔除，写入导入目标(比如屏幕)的Pass永远保留；
+	///   剩下的Pass按照读写依赖排序，依赖相同的情况下保持加入的顺序
+	/// 3 临时RenderTarget只在第一次写入到最后一次读取之间存活，生命周期不重叠且尺寸格式相同的临时目标共用同一块显存，
+	///   显存来自跨帧保留的池子，连续POOL_RETAIN_FRAMES帧没有使用的显存会被释放
+	/// 4 execute：按照顺序执行Pass，临时目标只有在execute期间才能通过getTarget取到
+	class FrameGraph
+	{
+	public:
+		using Handle = uint32_t;
+
+		static constexpr Handle INVALID_HANDLE = UINT32_MAX;
+
+		/// 池子中的RenderTarget连续这么多帧没有被使用，就释放掉
+		static constexpr uint32_t POOL_RETAIN_FRAMES = 60;
+
+		/// 临时RenderTarget的描述，尺寸与Options完全相同的临时目标才能共用显存
+		struct TargetDesc
+		{
+			uint32_t mWidth{0};
+			uint32_t mHeight{0};
+			RenderTarget::Options mOptions{};
+		};
+
+		/// Pass在setup当中声明读写关系
+		class PassBuilder
+		{
+		public:
+			PassBuilder(FrameGraph* graph, uint32_t pass) noexcept;
+
+			/// \brief 声明本Pass读取handle
+			/// \param handle
+			/// \return handle本身
+			auto read(Handle handle) noexcept -> Handle;
+
+			/// \brief 声明本Pass写入handle，写入导入的目标视为对外可见的结果，本Pass不会被剔除
+			/// \param handle
+			/// \return handle本身
+			auto write(Handle handle) noexcept -> Handle;
+
+		private:
+			FrameGraph* mGraph{nullptr};
+			uint32_t mPass{0};
+		};
+
+		using SetupFunction = std::function<void(PassBuilder& builder)>;
+		using ExecuteFunction = std::function<void(FrameGraph& graph)>;
+
+		using Ptr = std::shared_ptr<FrameGraph>;
+		static Ptr create(const DriverInfo::Ptr& info)
+		{
+			return std::make_shared<FrameGraph>(info);
+		}
+
+		FrameGraph(const DriverInfo::Ptr& info) noexcept;
+
+		~FrameGraph() noexcept;
+
+		/// \brief 清空上一帧的Pass与资源声明，池子中的显存保留
+		auto reset() noexcept -> void;
+
+		/// \brief 导入外部的RenderTarget，导入的目标不会被剔除，也不参与显存共用
+		/// \param name
+		/// \param target 为nullptr代表默认的FrameBuffer
+		/// \return
+		auto importTarget(const std::string& name, const RenderTarget::Ptr& target) noexcept -> Handle;
+
+		/// \brief 声明一个临时的RenderTarget，真正的显存在compile时分配
+		/// \param name
+		/// \param desc
+		/// \return
+		auto createTarget(const std::string& name, const TargetDesc& desc) noexcept -> Handle;
+
+		/// \brief 加入一个Pass，setup立即被调用
+		/// \param name
+		/// \param setup 声明读写关系
+		/// \param execute 真正的渲染工作，在execute阶段调用
+		auto addPass(const std::string& name, const SetupFunction& setup, const ExecuteFunction& execute) noexcept -> void;
+
+		/// \brief 剔除、排序并且为临时目标分配显存
+		auto compile() noexcept -> void;
+
+		/// \brief 按照compile得到的顺序执行所有Pass
+		auto execute() noexcept -> void;
+
+		/// \brief 取得handle对应的RenderTarget，临时目标只有在compile之后才有效
+		/// \param handle
+		/// \return
+		auto getTarget(Handle handle) const noexcept -> RenderTarget::Ptr;
+
+		/// \brief 池子中实际存在的RenderTarget数量
+		/// \return
+		auto getPoolSize() const noexcept -> uint32_t { return static_cast<uint32_t>(mPool.size()); }
+
+	private:
+		struct Resource
+		{
+			std::string mName{};
+			TargetDesc mDesc{};
+			bool mImported{false};
+			RenderTarget::Ptr mTarget{nullptr};
+
+			/// 写入本资源的Pass，以及读取本资源的(未被剔除的)Pass数量
+			std::vector<uint32_t> mWriters{};
+			uint32_t mRefCount{0};
+
+			/// 生命周期，为执行顺序当中的下标
+			int32_t mFirstUse{-1};
+			int32_t mLastUse{-1};
+		};
+
+		struct Pass
+		{
+			std::string mName{};
+			ExecuteFunction mExecute{nullptr};
+			std::vector<Handle> mReads{};
+			std::vector<Handle> mWrites{};
+
+			/// 写入了导入的目标
+			bool mSideEffect{false};
+
+			/// 写入的资源当中，仍然被读取的数量
+			uint32_t mRefCount{0};
+			bool mCulled{false};
+		};
+
+		struct PooledTarget
+		{
+			TargetDesc mDesc{};
+			RenderTarget::Ptr mTarget{nullptr};
+
+			/// 本帧已经被分配到的最后一个使用位置，-1代表本帧还没有被占用
+			int32_t mBusyUntil{-1};
+			uint32_t mUnusedFrames{0};
+		};
+
+		auto cull() noexcept -> void;
+
+		auto sort() noexcept -> void;
+
+		auto allocate() noexcept -> void;
+
+		static auto isCompatible(const TargetDesc& a, const TargetDesc& b) noexcept -> bool;
+
+	private:
+		DriverInfo::Ptr mInfo{nullptr};
+
+		std::vector<Resource> mResources{};
+		std::vector<Pass> mPasses{};
+
+		/// compile之后的执行顺序，为mPasses的下标
+		std::vector<uint32_t> mOrder{};
+
+		std::vector<PooledTarget> mPool{};
+	};
+}
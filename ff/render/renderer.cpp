@@ -1,8 +1,11 @@
 ﻿#include "renderer.h"
 #include "../objects/group.h"
 #include "../objects/skinnedMesh.h"
+#include "../objects/instancedMesh.h"
+#include "../objects/staticBatchMesh.h"
 #include "../tools/timer.h"
 #include "../log/debugLog.h"
+#include "../wrapper/glTrace.h"
 
 namespace ff
 {
@@ -26,13 +29,22 @@ namespace ff
 
 		mViewport = {0.0f, 0.0f, mWidth, mHeight};
 
-		mWindow = DriverWindow::create(this, mWidth, mHeight);
-		mWindow->setFrameSizeCallBack(onFrameSizeCallback);
+		/// 上下文必须先于其他Driver创建，否则glad的函数指针还没有装载
+		if (descriptor.mOffscreen)
+		{
+			mOffscreenContext = DriverOffscreenContext::create(descriptor.mContextMajorVersion, descriptor.mContextMinorVersion);
+		}
+		else
+		{
+			mWindow = DriverWindow::create(this, mWidth, mHeight, descriptor.mContextMajorVersion, descriptor.mContextMinorVersion);
+			mWindow->setFrameSizeCallBack(onFrameSizeCallback);
+		}
 
 		mInfos = DriverInfo::create();
+		mGPUTimer = DriverGPUTimer::create(mInfos);
 		mRenderList = DriverRenderList::create();
 		mAttributes = DriverAttributes::create();
-		mState = DriverState::create();
+		mState = DriverState::create(mInfos);
 		mBindingStates = DriverBindingStates::create(mAttributes);
 		mGeometries = DriverGeometries::create(mAttributes, mInfos, mBindingStates);
 		mObjects = DriverObjects::create(mGeometries, mAttributes, mInfos);
@@ -44,25 +56,52 @@ namespace ff
 		/// 纹理
 		mTextures = DriverTextures::create(mInfos, mRenderTargets);
 		mShadowMap = DriverShadowMap::create(this, mObjects, mState);
+		mInstancing = DriverInstancing::create(mObjects);
+		mMultiDraw = DriverMultiDraw::create(this, mInfos, mBindingStates);
+		mPrograms->mDrawIDCore = mMultiDraw->isDrawIDCore();
+		mUniformBuffers = DriverUniformBuffers::create();
+		mOcclusion = DriverOcclusion::create(mState, mBindingStates, mInfos);
+		mSoftwareOcclusion = SoftwareOcclusion::create();
+
+		mFrameGraph = FrameGraph::create(mInfos);
 
 		mFrustum = Frustum::create();
+
+		/// 离屏模式下没有窗体提供的默认FrameBuffer，由mDefaultRenderTarget来代替
+		if (mOffscreenContext != nullptr)
+		{
+			const RenderTarget::Options options;
+			mDefaultRenderTarget = RenderTarget::create(mWidth, mHeight, options);
+			setRenderTarget(nullptr);
+		}
 	}
 
 	Renderer::~Renderer() noexcept = default;
 
 	auto Renderer::render(Scene::Ptr scene, Camera::Ptr camera) -> bool
 	{
-		/// 处理窗体消息，并且判断是否继续render
-		if (!mWindow->processEvent())
+		/// 处理窗体消息，并且判断是否继续render，离屏模式下没有窗体消息需要处理
+		if (mWindow != nullptr && !mWindow->processEvent())
 		{
 			return false;
 		}
 
+		/// 本次render作为分析器当中的一帧，各个阶段分别计时
+		FF_PROFILE_FRAME();
+
+		/// 本次render同时作为opengl调用统计当中的一帧
+		FF_GL_TRACE_FRAME();
+
 		if (scene == nullptr) { scene = mDummyScene; }
 
+		mCurrentCamera = camera.get();
+
 		/// 1 更新场景数据
-		scene->updateWorldMatrix(true, true);
-		camera->updateWorldMatrix(true, true);
+		{
+			FF_PROFILE_SCOPE("updateWorldMatrix");
+			scene->updateWorldMatrix(true, true);
+			camera->updateWorldMatrix(true, true);
+		}
 
 		const auto projectionMatrix = camera->getProjectionMatrix();
 		const auto cameraInverseMatrix = camera->getWorldMatrixInverse();
@@ -70,46 +109,198 @@ namespace ff
 		mCurrentViewMatrix = projectionMatrix * cameraInverseMatrix;
 		mFrustum->setFromProjectionMatrix(mCurrentViewMatrix);
 
+		/// 软件遮挡剔除的深度缓冲需要在project之前准备好
+		if (mSoftwareOcclusionCulling)
+		{
+			FF_PROFILE_SCOPE("softwareOcclusion");
+			mSoftwareOcclusion->begin(mCurrentViewMatrix);
+			rasterizeOccluders(scene);
+			mSoftwareOcclusion->finish();
+		}
+
 		/// 2 提取渲染数据，构成渲染列表与状态
-		mRenderState->init(); /// 光与影
-		mRenderList->init(); /// 渲染数据
+		bool listRebuilt = true;
+		{
+			FF_PROFILE_SCOPE("projectObject");
+			mRenderState->init(); /// 光与影
 
-		/// scene当中的数据都是层级架构的树状数据，从这个结构，解析为一个线性列表
-		projectObject(scene, 0, mSortObject);
+			if (scene->mBVHCulling)
+			{
+				mRetainedCollection.invalidate();
+				mRenderList->init();
 
-		/// 调用完毕projectObject之后，所有可渲染物体&在视景体范围内的，都已经被压入到了RenderList当中
-		mRenderList->finish();
+				projectBVH(scene);
+			}
+			else if (mRetainedRenderList)
+			{
+				listRebuilt = projectRetained(scene);
+			}
+			else
+			{
+				mRetainedCollection.invalidate();
+				mRenderList->init(); /// 渲染数据
+
+				/// scene当中的数据都是层级架构的树状数据，从这个结构，解析为一个线性列表
+				projectObject(scene, 0, mSortObject);
+			}
+
+			/// 调用完毕projectObject之后，所有可渲染物体&在视景体范围内的，都已经被压入到了RenderList当中
+			mRenderList->finish();
+		}
+
+		/// 自动实例化会改写非透明队列，常驻模式下列表没有变化，则沿用上一帧的合并结果
+		if (mAutoInstancing && listRebuilt)
+		{
+			mInstancing->batch(mRenderList);
+		}
 
 		/// 经过上述projectObject的流程，任何一个我们使用到的Attribute都已经成功的被解析成为了一个VBO
 		/// 在上述流程中，每个Mesh的IndexAttribute并没有被解析为EBO
 
-		if (mSortObject)
+		/// 常驻模式下列表没有变化，则沿用上一帧的排序结果
+		if (mSortObject && listRebuilt)
 		{
-			mRenderList->sort();
+			FF_PROFILE_SCOPE("sort");
+			mRenderList->sort(scene->mOpaqueSortLayout, RenderSortLayout::BiggerZFirst, mSortStatistics);
 		}
 
+		/// 记录当前列表的长度，之后background等临时加入的renderItem，会在下一帧restore时被去掉
+		mRenderList->retain();
+
 		/// make frame data
 		mInfos->reset();
+		mInfos->mRender.mOpaqueStateChanges = mRenderList->getOpaqueStateChanges();
+		mInfos->mRender.mDepthOrderStateChanges = mRenderList->getDepthOrderStateChanges();
+		if (mAutoInstancing)
+		{
+			mInfos->mRender.mAutoInstancedBatches = mInstancing->getBatches();
+			mInfos->mRender.mAutoInstancedObjects = mInstancing->getBatchedObjects();
+		}
+		if (mSoftwareOcclusionCulling)
+		{
+			mInfos->mRender.mSoftwareOccluders = mSoftwareOcclusion->getStats().mOccluders;
+			mInfos->mRender.mSoftwareOcclusionCulled = mSoftwareOcclusion->getStats().mCulled;
+		}
+		if (scene->mBVHCulling)
+		{
+			mInfos->mRender.mBVHRefitted = scene->getBVH()->getStats().mRefitted;
+			mInfos->mRender.mBVHVisitedNodes = scene->getBVH()->getStats().mVisitedNodes;
+		}
+		mGPUTimer->beginFrame();
+
+		mOcclusion->mEnabled = mOcclusionCulling;
+		mOcclusion->mConditionalRender = mOcclusionConditionalRender;
+		mOcclusion->beginFrame();
 
 		/// renderScene
 		/// 更新建设了一些与坐标系选择没有关系的uniform内容
-		mRenderState->setupLights();
+		{
+			FF_PROFILE_SCOPE("setupLights");
+			mRenderState->setupLights();
+		}
 
+		/// 3 渲染场景，各个阶段作为FrameGraph当中的Pass，由FrameGraph负责剔除、排序以及临时RenderTarget的分配
+		mFrameGraph->reset();
+
+		/// 当前的RenderTarget(nullptr代表默认的FrameBuffer)是本帧最终输出的位置
+		const auto output = mFrameGraph->importTarget("output", mCurrentRenderTarget);
 
-		/// 3 渲染场景
 		/// shadow
-		mShadowMap->render(mRenderState, scene, camera);
+		/// 每个投射阴影的光源一张临时的ShadowMap，只存活到场景绘制结束；开启了缓存的光源导入DriverShadowMap持有的常驻ShadowMap
+		std::vector<std::pair<LightShadow::Ptr, FrameGraph::Handle>> shadowMaps;
+		if (mShadowMap->mEnabled)
+		{
+			for (const auto& light : mRenderState->mShadowsArray)
+			{
+				if (light->mShadow == nullptr) continue;
+
+				if (light->mShadow->mCacheEnabled)
+				{
+					shadowMaps.emplace_back(light->mShadow, mFrameGraph->importTarget("shadowMap", mShadowMap->getCachedRenderTarget(light->mShadow)));
+					continue;
+				}
+
+				FrameGraph::TargetDesc desc;
+				desc.mWidth = static_cast<uint32_t>(light->mShadow->mMapSize.x);
+				desc.mHeight = static_cast<uint32_t>(light->mShadow->mMapSize.y);
+				desc.mOptions.mMinFilter = TextureFilter::NearestFilter;
+				desc.mOptions.mMagFilter = TextureFilter::NearestFilter;
+				desc.mOptions.mFormat = TextureFormat::RGBA;
+
+				shadowMaps.emplace_back(light->mShadow, mFrameGraph->createTarget("shadowMap", desc));
+			}
+		}
+
+		mFrameGraph->addPass("shadowMap",
+			[&](FrameGraph::PassBuilder& builder)
+			{
+				for (const auto& shadowMap : shadowMaps)
+				{
+					builder.write(shadowMap.second);
+				}
+			},
+			[&](FrameGraph& graph)
+			{
+				for (const auto& shadowMap : shadowMaps)
+				{
+					shadowMap.first->mRenderTarget = graph.getTarget(shadowMap.second);
+				}
+
+				FF_PROFILE_SCOPE("shadowMap");
+				mGPUTimer->begin(DriverInfo::ShadowPass);
+				mShadowMap->render(mRenderState, scene, camera);
+				mGPUTimer->end();
+			});
+
+		mFrameGraph->addPass("scene",
+			[&](FrameGraph::PassBuilder& builder)
+			{
+				for (const auto& shadowMap : shadowMaps)
+				{
+					builder.read(shadowMap.second);
+				}
+
+				builder.write(output);
+			},
+			[&](FrameGraph& graph)
+			{
+				setRenderTarget(graph.getTarget(output));
 
-		/// drawBackground and clear 
-		mBackground->render(mRenderList, scene);
+				/// drawBackground and clear 
+				{
+					FF_PROFILE_SCOPE("background");
+					mGPUTimer->begin(DriverInfo::BackgroundPass);
+					mBackground->render(mRenderList, scene);
+					mGPUTimer->end();
+				}
 
-		renderScene(mRenderList, scene, camera);
+				{
+					FF_PROFILE_SCOPE("renderScene");
+					renderScene(mRenderList, scene, camera);
+				}
+			});
+
+		{
+			FF_PROFILE_SCOPE("frameGraph");
+			mFrameGraph->compile();
+		}
+
+		mFrameGraph->execute();
+
+		mShadowMap->endFrame();
 
 		return true;
 	}
 
 	auto Renderer::swap() const noexcept -> void
 	{
+		/// 离屏模式下没有双缓冲，只需要保证命令被提交
+		if (mWindow == nullptr)
+		{
+			FF_GL(glFlush);
+			return;
+		}
+
 		mWindow->swap();
 	}
 
@@ -118,6 +309,9 @@ namespace ff
 		/// 当前需要被解析的物体，如果是不可见物体，那么连同其子节点一起都变为不可见状态
 		if (!object->mVisible) return;
 
+		/// 整棵子树都在视景体之外，并且其中没有灯光与骨骼动画，用缓存的子树包围盒一次剪裁掉
+		if (!object->getChildren().empty() && object->isSubtreeCullable() && !mFrustum->intersectSubtree(object.get())) return;
+
 		glm::vec4 toolVec(1.0f);
 
 		/// 对object进行了类型判断，并且分别做不同的处理 
@@ -141,7 +335,7 @@ namespace ff
 			/// 骨骼
 			if (object->mIsSkinnedMesh)
 			{
-				const auto skinnedMesh = std::dynamic_pointer_cast<SkinnedMesh>(object);
+				const auto skinnedMesh = dynamic_cast<SkinnedMesh*>(object.get());
 				skinnedMesh->mSkeleton->update();
 			}
 
@@ -152,121 +346,547 @@ namespace ff
 				toolVec = mCurrentViewMatrix * toolVec;
 			}
 
-			const auto renderableObject = std::static_pointer_cast<RenderableObject>(object);
+			/// 渲染列表只记录裸指针，这里不产生智能指针的拷贝
+			const auto renderableObject = static_cast<RenderableObject*>(object.get());
 
-			/// 首先对object进行一次视景体剪裁测试
-			if (mFrustum->intersectObject(renderableObject))
+			/// 首先对object进行一次视景体剪裁测试，已经被静态合批的物体由StaticBatchMesh代为绘制
+			if (!renderableObject->mStaticBatched && mFrustum->intersectObject(renderableObject)
+				&& (!mSoftwareOcclusionCulling || !mSoftwareOcclusion->isOccluded(renderableObject)))
 			{
 				/// 1 对object geometry attribute进行解析与更新
-				auto geometry = mObjects->update(renderableObject);
+				const auto geometry = mObjects->update(renderableObject);
 
 				/// 2 拿出material
-				auto material = renderableObject->getMaterial();
+				const auto material = renderableObject->getMaterial().get();
+
+				/// 3 上一次绘制本material所使用的program，排序时让相同program的物体尽量相邻
+				const auto& dMaterial = mMaterials->get(material);
+				const auto programID = dMaterial->mCurrentProgram != nullptr ? dMaterial->mCurrentProgram->getID() : 0;
 
 				mRenderList->push(
 					renderableObject,
 					geometry,
 					material,
 					groupOrder,
-					toolVec.z);
+					toolVec.z,
+					programID);
 			}
 		}
 
-		auto children = object->getChildren();
-		for (auto& child : children)
+		/// LOD只展开本相机所选择的一个层级
+		if (object->mIsLOD)
+		{
+			const auto lod = static_cast<LOD*>(object.get());
+			if (!lod->getLevels().empty())
+			{
+				projectObject(lod->getLevels()[lod->select(mCurrentCamera)].mObject, groupOrder, sortObjects);
+			}
+			return;
+		}
+
+		const auto& children = object->getChildren();
+		for (const auto& child : children)
 		{
 			projectObject(child, groupOrder, sortObjects);
 		}
 	}
 
+	auto Renderer::projectRetained(const Scene::Ptr& scene) noexcept -> bool
+	{
+		/// 1 层级结构或者任意一个已展开节点的可见性发生变化，重新收集整个场景
+		const bool rebuild = mRetainedCollection.isStale(scene);
+		if (rebuild)
+		{
+			mRetainedCollection.collect(scene);
+
+			mRetainedEntries.clear();
+			for (const auto& renderable : mRetainedCollection.getRenderables())
+			{
+				auto& entry = mRetainedEntries.emplace_back();
+				entry.mObject = renderable.mObject;
+				entry.mGroupOrder = renderable.mGroupOrder;
+				entry.mLOD = renderable.mLOD;
+				entry.mLODLevel = renderable.mLODLevel;
+			}
+
+			/// LOD的所有层级都已收集并记录所属的层级，每一帧只压入被选中的层级
+			mRetainedLODs.clear();
+			for (const auto lod : mRetainedCollection.getLODs())
+			{
+				mRetainedLODs.emplace_back(lod, lod->getCurrentLevel(mCurrentCamera));
+			}
+		}
+
+		/// 灯光与骨骼每一帧都需要处理
+		for (const auto& light : mRetainedCollection.getLights())
+		{
+			mRenderState->pushLight(light);
+			if (light->mCastShadow)
+			{
+				mRenderState->pushShadow(light);
+			}
+		}
+
+		for (const auto skinnedMesh : mRetainedCollection.getSkinnedMeshes())
+		{
+			skinnedMesh->mSkeleton->update();
+		}
+
+		/// 2 摄像机发生了变化，所有物体都需要重新剪裁，并且重新计算深度
+		const bool cameraChanged = rebuild || mRetainedViewMatrix != mCurrentViewMatrix;
+		mRetainedViewMatrix = mCurrentViewMatrix;
+
+		/// 3 只有变换、材质、几何发生变化的物体才需要重新处理
+		bool listChanged = rebuild || cameraChanged
+			|| mRetainedSortLayout != scene->mOpaqueSortLayout
+			|| mRetainedAutoInstancing != mAutoInstancing;
+		mRetainedSortLayout = scene->mOpaqueSortLayout;
+		mRetainedAutoInstancing = mAutoInstancing;
+
+		/// LOD的选择取决于相机与LOD自身的位置，每一帧都要重新选择
+		for (auto& [lod, level] : mRetainedLODs)
+		{
+			const auto selected = lod->select(mCurrentCamera);
+			if (selected != level)
+			{
+				level = selected;
+				listChanged = true;
+			}
+		}
+
+		for (auto& entry : mRetainedEntries)
+		{
+			const auto object = entry.mObject;
+			const auto& geometry = object->getGeometry();
+			const auto& material = object->getMaterial();
+
+			/// 原地重新计算了包围体的geometry，剪裁结果同样需要更新
+			bool changed = cameraChanged
+				|| object->getWorldMatrixVersion() != entry.mWorldMatrixVersion
+				|| geometry->getID() != entry.mGeometryID
+				|| geometry->getBoundsVersion() != entry.mGeometryBoundsVersion
+				|| material->getID() != entry.mMaterialID
+				|| material->mTransparent != entry.mTransparent;
+
+			/// 实例矩阵的变化不体现在worldMatrix上，InstancedMesh每帧都要重新剪裁
+			if (!changed && object->mIsInstancedMesh)
+			{
+				changed = mFrustum->intersectObject(object) != entry.mInFrustum;
+			}
+
+			/// 材质第一次绘制或者更换了program，会影响排序键；DriverMaterial可能随着材质的dispose被删除，每帧重新获取
+			if (!changed)
+			{
+				const auto& program = mMaterials->get(material.get())->mCurrentProgram;
+				changed = (program != nullptr ? program->getID() : 0) != entry.mProgramID;
+			}
+
+			if (changed)
+			{
+				updateRetainedEntry(entry);
+				listChanged = true;
+			}
+
+			/// 软件遮挡的结果取决于本帧所有遮挡物的位置，每一帧都要重新测试
+			const bool occluded = mSoftwareOcclusionCulling && entry.mInFrustum && mSoftwareOcclusion->isOccluded(object);
+			if (occluded != entry.mOccluded)
+			{
+				entry.mOccluded = occluded;
+				listChanged = true;
+			}
+		}
+
+		/// 4 没有任何变化，沿用上一帧的渲染列表，只需要保证geometry的数据是最新的
+		if (!listChanged)
+		{
+			mRenderList->restore();
+
+			for (const auto& entry : mRetainedEntries)
+			{
+				if (entry.mInFrustum && !entry.mOccluded && isLODLevelSelected(entry.mLOD, entry.mLODLevel))
+				{
+					mObjects->update(entry.mObject);
+				}
+			}
+
+			return false;
+		}
+
+		mRenderList->init();
+		for (const auto& entry : mRetainedEntries)
+		{
+			if (!entry.mInFrustum || entry.mOccluded || !isLODLevelSelected(entry.mLOD, entry.mLODLevel)) continue;
+
+			const auto geometry = mObjects->update(entry.mObject);
+			mRenderList->push(entry.mObject, geometry, entry.mMaterial, entry.mGroupOrder, entry.mZ, entry.mProgramID);
+		}
+
+		return true;
+	}
+
+	auto Renderer::projectBVH(const Scene::Ptr& scene) noexcept -> void
+	{
+		const auto& bvh = scene->getBVH();
+		bvh->update(scene);
+
+		/// 灯光与骨骼在BVH收集物体时一并记录
+		for (const auto& light : bvh->getLights())
+		{
+			mRenderState->pushLight(light);
+			if (light->mCastShadow)
+			{
+				mRenderState->pushShadow(light);
+			}
+		}
+
+		for (const auto skinnedMesh : bvh->getSkinnedMeshes())
+		{
+			skinnedMesh->mSkeleton->update();
+		}
+
+		for (const auto lod : bvh->getLODs())
+		{
+			lod->select(mCurrentCamera);
+		}
+
+		bvh->intersectFrustum(mFrustum, mBVHVisible);
+
+		for (const auto entry : mBVHVisible)
+		{
+			const auto object = entry->mObject;
+			if (!isLODLevelSelected(entry->mLOD, entry->mLODLevel)) continue;
+			if (mSoftwareOcclusionCulling && mSoftwareOcclusion->isOccluded(object)) continue;
+
+			float z = 0.0f;
+			if (mSortObject)
+			{
+				z = (mCurrentViewMatrix * glm::vec4(object->getWorldPosition(), 1.0)).z;
+			}
+
+			const auto geometry = mObjects->update(object);
+			const auto material = object->getMaterial().get();
+
+			const auto& dMaterial = mMaterials->get(material);
+			const auto programID = dMaterial->mCurrentProgram != nullptr ? dMaterial->mCurrentProgram->getID() : 0;
+
+			mRenderList->push(object, geometry, material, entry->mGroupOrder, z, programID);
+		}
+	}
+
+	auto Renderer::isLODLevelSelected(const LOD* lod, uint32_t level) const noexcept -> bool
+	{
+		return lod == nullptr || lod->getCurrentLevel(mCurrentCamera) == level;
+	}
+
+	auto Renderer::updateRetainedEntry(RetainedEntry& entry) noexcept -> void
+	{
+		const auto object = entry.mObject;
+
+		entry.mGeometry = object->getGeometry().get();
+		entry.mMaterial = object->getMaterial().get();
+		entry.mGeometryID = entry.mGeometry->getID();
+		entry.mMaterialID = entry.mMaterial->getID();
+		entry.mGeometryBoundsVersion = entry.mGeometry->getBoundsVersion();
+		entry.mTransparent = entry.mMaterial->mTransparent;
+		entry.mWorldMatrixVersion = object->getWorldMatrixVersion();
+
+		const auto& dMaterial = mMaterials->get(entry.mMaterial);
+		entry.mProgramID = dMaterial->mCurrentProgram != nullptr ? dMaterial->mCurrentProgram->getID() : 0;
+
+		entry.mInFrustum = mFrustum->intersectObject(object);
+
+		if (mSortObject)
+		{
+			const auto toolVec = mCurrentViewMatrix * glm::vec4(object->getWorldPosition(), 1.0);
+			entry.mZ = toolVec.z;
+		}
+	}
+
+	auto Renderer::rasterizeOccluders(const Object3D::Ptr& object) noexcept -> void
+	{
+		if (!object->mVisible) return;
+
+		if (object->mIsRenderableObject)
+		{
+			const auto renderableObject = static_cast<RenderableObject*>(object.get());
+			if (renderableObject->mOccluder && mFrustum->intersectObject(renderableObject))
+			{
+				mSoftwareOcclusion->rasterizeOccluder(renderableObject);
+			}
+		}
+
+		if (object->mIsLOD)
+		{
+			const auto lod = static_cast<LOD*>(object.get());
+			if (!lod->getLevels().empty())
+			{
+				rasterizeOccluders(lod->getLevels()[lod->select(mCurrentCamera)].mObject);
+			}
+			return;
+		}
+
+		const auto& children = object->getChildren();
+		for (const auto& child : children)
+		{
+			rasterizeOccluders(child);
+		}
+	}
+
 	auto Renderer::renderScene(
 		const DriverRenderList::Ptr& currentRenderList,
 		const Scene::Ptr& scene,
 		const Camera::Ptr& camera
 	) noexcept -> void
 	{
-		auto opaqueObjects = currentRenderList->getOpaques();
-		auto transparentObjects = currentRenderList->getTransparents();
+		const auto& renderItems = currentRenderList->getRenderItems();
+		const auto& opaqueObjects = currentRenderList->getOpaques();
+		const auto& transparentObjects = currentRenderList->getTransparents();
 
 		/// TODO 设置场景相关的状态，可以在这里继续扩展很多场景相关设置
 		mRenderState->setupLightsView(camera);
+
+		/// 相机与光照的UniformBuffer，每个视图只更新一次
+		mUniformBuffers->updateCamera(camera);
+		mUniformBuffers->updateLights(mRenderState->mLights);
 		/// scene viewport 
 		mState->viewport(mViewport);
 
-		if (!opaqueObjects.empty()) renderObjects(opaqueObjects, scene, camera);
+		/// 深度预渲染之后，非透明物体的深度已经写好，正式绘制时只有最前面的片元能够通过Equal比较
+		const bool depthPrePass = scene->mDepthPrePass && !opaqueObjects.empty();
+		if (depthPrePass)
+		{
+			FF_PROFILE_SCOPE("depthPrePass");
+			mGPUTimer->begin(DriverInfo::DepthPrePass);
+			mState->setDepthPrePassStage(DriverState::DepthPrePassStage::PrePass);
+			renderDepthPrePass(renderItems, opaqueObjects, scene, camera);
+			mState->setDepthPrePassStage(DriverState::DepthPrePassStage::MainPass);
+			mGPUTimer->end();
+		}
+
+		if (!opaqueObjects.empty())
+		{
+			FF_PROFILE_SCOPE("opaque");
+			mGPUTimer->begin(DriverInfo::OpaquePass);
+			if (mMultiDrawIndirect && mMultiDraw->isSupported())
+			{
+				mMultiDraw->render(renderItems, opaqueObjects, scene, camera);
+			}
+			else
+			{
+				renderObjects(renderItems, opaqueObjects, scene, camera);
+			}
+			mGPUTimer->end();
+		}
+
+		if (depthPrePass)
+		{
+			mState->setDepthPrePassStage(DriverState::DepthPrePassStage::None);
+		}
 
-		if (!transparentObjects.empty()) renderObjects(transparentObjects, scene, camera);
+		if (!transparentObjects.empty())
+		{
+			FF_PROFILE_SCOPE("transparent");
+			mGPUTimer->begin(DriverInfo::TransparentPass);
+			renderObjects(renderItems, transparentObjects, scene, camera);
+			mGPUTimer->end();
+		}
+
+		/// 为本帧绘制过的遮挡剔除候选物体发出包围盒查询，结果在之后的帧使用
+		{
+			FF_PROFILE_SCOPE("occlusionQueries");
+			mOcclusion->render(camera);
+		}
 	}
 
 	auto Renderer::renderObjects(
-		const std::vector<RenderItem::Ptr>& renderItems,
+		const std::vector<RenderItem>& renderItems,
+		const std::vector<uint32_t>& queue,
 		const Scene::Ptr& scene,
 		const Camera::Ptr& camera
 	) noexcept -> void
 	{
 		/// 对当前某一个渲染队列的渲染任务，进行一些必要的状态设置
-		const auto overrideMaterial = scene->mIsScene ? scene->mOverrideMaterial : nullptr;
+		const auto overrideMaterial = scene->mIsScene ? scene->mOverrideMaterial.get() : nullptr;
 
-		for (const auto& renderItem : renderItems)
+		for (const auto index : queue)
 		{
-			const auto object = renderItem->mObject;
-			const auto geometry = renderItem->mGeometry;
-			const auto material = overrideMaterial == nullptr ? renderItem->mMaterial : overrideMaterial;
+			const auto& renderItem = renderItems[index];
+
+			const auto object = renderItem.mObject;
+			const auto geometry = renderItem.mGeometry;
+			const auto material = overrideMaterial == nullptr ? renderItem.mMaterial : overrideMaterial;
 
 			renderObject(object, scene, camera, geometry, material);
 		}
 	}
 
+	auto Renderer::renderDepthPrePass(
+		const std::vector<RenderItem>& renderItems,
+		const std::vector<uint32_t>& queue,
+		const Scene::Ptr& scene,
+		const Camera::Ptr& camera
+	) noexcept -> void
+	{
+		const auto overrideMaterial = scene->mIsScene ? scene->mOverrideMaterial.get() : nullptr;
+
+		for (const auto index : queue)
+		{
+			const auto& renderItem = renderItems[index];
+
+			const auto object = renderItem.mObject;
+			const auto material = overrideMaterial == nullptr ? renderItem.mMaterial : overrideMaterial;
+
+			/// 与DriverState::DepthPrePassStage::MainPass的改写条件保持一致，不写深度的物体正式绘制时照常比较
+			if (!material->mDepthTest || !material->mDepthWrite) continue;
+
+			/// 回调可能修改物体的变换(比如天空盒跟随相机)，预渲染写入的深度必须与正式绘制时的位置一致，否则Equal比较会失败
+			object->onBeforeRender(this, scene.get(), camera.get());
+
+			if (object->mIsStaticBatchMesh && static_cast<StaticBatchMesh*>(object)->cull(mFrustum, mInfos->mRender.mFrame) == 0)
+			{
+				continue;
+			}
+
+			/// 与正式绘制使用同一个遮挡结果：被剔除的物体两次都跳过，条件绘制则两次都包在同一个查询当中
+			if (!mOcclusion->beginObject(object, true)) continue;
+
+			object->updateModelViewMatrix(camera->getWorldMatrixInverse());
+
+			/// 与DriverShadowMap一样，深度材质不需要场景的光照信息
+			renderBufferDirect(object, nullptr, camera, renderItem.mGeometry, getDepthPrePassMaterial(material));
+
+			mOcclusion->endObject();
+		}
+	}
+
+	auto Renderer::getDepthPrePassMaterial(const Material* material) noexcept -> Material*
+	{
+		const uint32_t key =
+			static_cast<uint32_t>(material->mSide) |
+			static_cast<uint32_t>(material->mFrontFace) << 2 |
+			static_cast<uint32_t>(material->mDrawMode) << 4;
+
+		auto& depthMaterial = mDepthPrePassMaterials[key];
+		if (depthMaterial == nullptr)
+		{
+			depthMaterial = DepthMaterial::create();
+			depthMaterial->mSide = material->mSide;
+			depthMaterial->mFrontFace = material->mFrontFace;
+			depthMaterial->mDrawMode = material->mDrawMode;
+		}
+
+		return depthMaterial.get();
+	}
+
 	auto Renderer::renderObject(
-		const RenderableObject::Ptr& object,
+		RenderableObject* object,
 		const Scene::Ptr& scene,
 		const Camera::Ptr& camera,
-		const Geometry::Ptr& geometry,
-		const Material::Ptr& material
+		Geometry* geometry,
+		Material* material
 	) noexcept -> void
 	{
 		object->onBeforeRender(this, scene.get(), camera.get());
 
+		/// 静态合批的物体，逐个源物体剪裁，全部不可见则不需要绘制
+		if (object->mIsStaticBatchMesh && static_cast<StaticBatchMesh*>(object)->cull(mFrustum, mInfos->mRender.mFrame) == 0)
+		{
+			return;
+		}
+
+		/// 遮挡剔除：上一次包围盒查询的结果为被遮挡，跳过本次绘制
+		if (!mOcclusion->beginObject(object))
+		{
+			return;
+		}
+
 		/// MVP uniform
 		object->updateModelViewMatrix(camera->getWorldMatrixInverse());
 		object->updateNormalMatrix();
 
 		/// deal with double side
 		renderBufferDirect(object, scene, camera, geometry, material);
+
+		mOcclusion->endObject();
 	}
 
 	auto Renderer::renderBufferDirect(
-		const RenderableObject::Ptr& object,
+		RenderableObject* object,
 		const Scene::Ptr& scene,
 		const Camera::Ptr& camera,
-		const Geometry::Ptr& geometry,
-		const Material::Ptr& material
+		Geometry* geometry,
+		Material* material
 	) noexcept -> void
 	{
-		auto _scene = scene;
-		if (_scene == nullptr) _scene = mDummyScene;
+		const auto& _scene = scene != nullptr ? scene : mDummyScene;
 
-		auto index = geometry->getIndex();
-		auto position = geometry->getAttribute("position");
+		const auto& index = geometry->getIndex();
 
 		/// 真正的设置shader的函数
-		auto program = setProgram(camera, _scene, geometry, material, object);
+		{
+			FF_PROFILE_SCOPE("setProgram");
+			setProgram(camera, _scene, geometry, material, object);
+		}
 
-		mState->setMaterial(material);
+		mState->setPipelineState(mMaterials->getPipelineState(material));
 
 		/// 1 生成并管理VAO
 		/// 2 设置绑定状态
 		/// 3 负责了VAO绑定状态的缓存
-		mBindingStates->setup(geometry, index);
+		mBindingStates->setup(geometry, index, object);
 
 		/// draw
+		FF_PROFILE_SCOPE("draw");
+		const auto drawMode = toGL(material->mDrawMode);
+
+		/// 静态合批的物体只绘制cull之后可见的子区间，一次DrawCall绘制多段index
+		if (object->mIsStaticBatchMesh)
+		{
+			const auto staticBatchMesh = static_cast<const StaticBatchMesh*>(object);
+			const auto& counts = staticBatchMesh->getDrawCounts();
+			const auto& offsets = staticBatchMesh->getDrawOffsets();
+			if (counts.empty()) return;
+
+			FF_GL(glMultiDrawElements, drawMode, counts.data(), toGL(index->getDataType()), offsets.data(), static_cast<GLsizei>(counts.size()));
+
+			uint32_t count = 0;
+			for (const auto value : counts) count += value;
+			mInfos->update(count, drawMode, 1);
+
+			return;
+		}
+
+		/// InstancedMesh一次DrawCall绘制全部实例
+		if (object->mIsInstancedMesh)
+		{
+			const auto instanceCount = static_cast<const InstancedMesh*>(object)->getCount();
+			if (instanceCount == 0) return;
+
+			if (index)
+			{
+				FF_GL(glDrawElementsInstanced, drawMode, index->getCount(), toGL(index->getDataType()), 0, instanceCount);
+				mInfos->update(index->getCount(), drawMode, instanceCount);
+			}
+			else
+			{
+				const auto position = geometry->getAttribute("position");
+				FF_GL(glDrawArraysInstanced, drawMode, 0, position->getCount(), instanceCount);
+				mInfos->update(position->getCount(), drawMode, instanceCount);
+			}
+
+			return;
+		}
+
 		if (index)
 		{
-			glDrawElements(toGL(material->mDrawMode), index->getCount(), toGL(index->getDataType()), 0);
+			FF_GL(glDrawElements, drawMode, index->getCount(), toGL(index->getDataType()), 0);
+			mInfos->update(index->getCount(), drawMode, 1);
 		}
 		else
 		{
-			glDrawArrays(toGL(material->mDrawMode), 0, position->getCount());
+			const auto position = geometry->getAttribute("position");
+			FF_GL(glDrawArrays, drawMode, 0, position->getCount());
+			mInfos->update(position->getCount(), drawMode, 1);
 		}
 	}
 
@@ -282,18 +902,25 @@ namespace ff
 	auto Renderer::setProgram(
 		const Camera::Ptr& camera,
 		const Scene::Ptr& scene,
-		const Geometry::Ptr& geometry,
-		const Material::Ptr& material,
-		const RenderableObject::Ptr& object
-	) noexcept -> DriverProgram::Ptr
+		const Geometry* geometry,
+		const Material* material,
+		const RenderableObject* object,
+		bool multiDraw
+	) noexcept -> const DriverProgram::Ptr&
 	{
-		const auto lights = mRenderState->mLights;
+		const auto& lights = mRenderState->mLights;
 
 		/// 标志着是否需要更换一个绑定的Program
 		bool needsProgramChange = false;
 
+		/// 只是实例化、multi-draw的变体不同，可以直接使用缓存的program
+		const bool instancing = object->mIsInstancedMesh;
+		const bool instancingColor = instancing && static_cast<const InstancedMesh*>(object)->getInstanceColor() != nullptr;
+		const auto variant = DriverMaterial::getVariant(instancing, instancingColor, multiDraw);
+		bool variantChanged = false;
+
 		/// 从backeng里面，获取到当前Material的DriverMaterial
-		const auto dMaterial = mMaterials->get(material);
+		const auto& dMaterial = mMaterials->get(material);
 
 		/// 如果本物体第一次送入管线进行绘制，比如第一帧的第一个三角形，就必须为其生成一个DriverProgram
 		/// material的Version初始化为1， DriverMaterial的Version初始化为0
@@ -357,13 +984,22 @@ namespace ff
 
 			if (object->mIsSkinnedMesh)
 			{
-				const auto skinnedMesh = std::dynamic_pointer_cast<SkinnedMesh>(object);
+				const auto skinnedMesh = static_cast<const SkinnedMesh*>(object);
 				if (skinnedMesh->mSkeleton->mBones.size() != dMaterial->mMaxBones)
 				{
 					needsProgramChange = true;
 					dMaterial->mMaxBones = skinnedMesh->mSkeleton->mBones.size();
 				}
 			}
+
+			/// 同一个material可能同时被普通Mesh与InstancedMesh使用，两者需要不同的shader；
+			/// multi-draw indirect的矩阵来自SSBO，与逐个绘制的shader也不同
+			if (instancing != dMaterial->mInstancing
+				|| instancingColor != dMaterial->mInstancingColor
+				|| multiDraw != dMaterial->mMultiDraw)
+			{
+				variantChanged = true;
+			}
 		}
 		else
 		{
@@ -372,13 +1008,34 @@ namespace ff
 		}
 
 		/// 如果第一次解析material，则mCurrentProgram一定是nullptr
-		auto dprogram = dMaterial->mCurrentProgram;
 		if (needsProgramChange)
 		{
-			/// 生成，或者复用原来的Program，并且给出使用的Program
-			dprogram = getProgram(material, scene, object);
+			/// 影响所有变体的状态发生了变化，之前缓存的变体全部作废
+			std::fill(std::begin(dMaterial->mVariantPrograms), std::end(dMaterial->mVariantPrograms), nullptr);
+
+			/// 生成，或者复用原来的Program，并且记录为dMaterial的mCurrentProgram
+			getProgram(material, scene, object, multiDraw);
+			dMaterial->mVariantPrograms[variant] = dMaterial->mCurrentProgram;
+		}
+		else if (variantChanged)
+		{
+			auto& cached = dMaterial->mVariantPrograms[variant];
+			if (cached != nullptr)
+			{
+				dMaterial->mCurrentProgram = cached;
+				dMaterial->mInstancing = instancing;
+				dMaterial->mInstancingColor = instancingColor;
+				dMaterial->mMultiDraw = multiDraw;
+			}
+			else
+			{
+				getProgram(material, scene, object, multiDraw);
+				cached = dMaterial->mCurrentProgram;
+			}
 		}
 
+		const auto& dprogram = dMaterial->mCurrentProgram;
+
 		bool refreshProgram = false;
 		/// useProgram当中，如果更换了绑定的Program，就得更新Uniform
 		if (mState->useProgram(dprogram->mProgram))
@@ -390,30 +1047,54 @@ namespace ff
 
 		/// ----------------------------------展开对于Uniforms更新的工作-----------------------------------------
 
+		const bool needsLights = materialNeedsLights(material);
+
+		const std::vector<glm::mat4>* boneMatrices = nullptr;
+		if (object->mIsSkinnedMesh)
+		{
+			boneMatrices = &static_cast<const SkinnedMesh*>(object)->mSkeleton->mBoneMatrices;
+		}
+
+		/// 编译好的uniform表：直接引用物体、材质、骨骼以及光照的数据，按照槽位上传
+		if (mCompiledUniforms)
+		{
+			DriverUniformTable::Sources sources;
+			sources.mModelViewMatrix = &object->getModelViewMatrix();
+			sources.mNormalMatrix = &object->getNormalMatrix();
+			sources.mModelMatrix = &object->getWorldMatrix();
+			sources.mMaterial = material;
+			sources.mDirectionalShadowMaps = needsLights ? &lights->mState.mDirectionalShadowMaps : nullptr;
+			sources.mBoneMatrices = boneMatrices;
+
+			DebugLog::getInstance()->beginUpLoad(material->getType());
+
+			dprogram->uploadUniforms(sources, mTextures, mInfos);
+
+			DebugLog::getInstance()->end();
+
+			return dprogram;
+		}
+
 		/// attention, 拷贝map,本uniforms也就是我们说的outMap，类型是UniformHandleMap
 		auto uniforms = dMaterial->mUniforms;
 
 		///  DriverMaterial根据我们绘制需要的material，对uniforms进行了更新处理
 		DriverMaterials::refreshMaterialUniforms(uniforms, material);
 
-		const bool needsLights = materialNeedsLights(material);
-
-		auto& lightUniforms = mRenderState->mLights->mState.mLightUniformHandles;
-
-		/// TODO 相当于光照更新
-		/// 如果本material需要光照，就得把光照相关的Uniforms合并进来
+		/// 光照数据都在LightsBlock当中，只有阴影贴图这种sampler仍然需要逐个program绑定
 		if (needsLights)
 		{
-			makeLightsNeedUpdate(lightUniforms);
-			uniforms.insert(lightUniforms.begin(), lightUniforms.end());
+			auto& uniform = uniforms["directionalShadowMap"];
+			uniform.mValue = lights->mState.mDirectionalShadowMaps;
+			uniform.mNeedsUpdate = true;
 		}
 
 		/// bones
-		if (object->mIsSkinnedMesh)
+		if (boneMatrices)
 		{
-			const auto skinnedMesh = std::dynamic_pointer_cast<SkinnedMesh>(object);
-			const auto skeleton = skinnedMesh->mSkeleton;
-			uniforms.insert(skeleton->mUniforms.begin(), skeleton->mUniforms.end());
+			auto& uniform = uniforms["boneMatrices"];
+			uniform.mValue = *boneMatrices;
+			uniform.mNeedsUpdate = true;
 		}
 
 		/// 通用第一次会自动加入
@@ -425,8 +1106,6 @@ namespace ff
 		uniforms["normalMatrix"].mValue = object->getNormalMatrix();
 		uniforms["normalMatrix"].mNeedsUpdate = true;
 
-		uniforms["projectionMatrix"].mValue = camera->getProjectionMatrix();
-		uniforms["projectionMatrix"].mNeedsUpdate = true;
 
 		uniforms["modelMatrix"].mValue = object->getWorldMatrix();
 		uniforms["modelMatrix"].mNeedsUpdate = true;
@@ -441,21 +1120,22 @@ namespace ff
 	}
 
 	auto Renderer::getProgram(
-		const Material::Ptr& material,
+		const Material* material,
 		const Scene::Ptr& scene,
-		const RenderableObject::Ptr& object
+		const RenderableObject* object,
+		bool multiDraw
 	) noexcept -> DriverProgram::Ptr
 	{
 		DriverProgram::Ptr program = nullptr;
 
-		const auto dMaterial = mMaterials->get(material);
-		const auto lights = mRenderState->mLights;
+		const auto& dMaterial = mMaterials->get(material);
+		const auto& lights = mRenderState->mLights;
 
 		/// 将以前用过的DriverPrograms取出来，是一个map的引用
 		auto& programs = dMaterial->mPrograms;
 
 		/// mPrograms是DriverPrograms，通过下方的接口，生成本个RenderItem的Parameters
-		const auto parameters = mPrograms->getParameters(material, object, lights, mShadowMap);
+		const auto parameters = mPrograms->getParameters(material, object, lights, mShadowMap, multiDraw);
 
 		/// 通过Parameters计算一个哈希值
 		auto cacheKey = mPrograms->getProgramCacheKey(parameters);
@@ -493,19 +1173,21 @@ namespace ff
 
 	/// 统一了本Material跟其对应的DriverMaterial的关键变量，从而在下一帧的时候，不会needsProgramChange
 	auto Renderer::updateCommonMaterialProperties(
-		const Material::Ptr& material,
+		const Material* material,
 		const DriverProgram::Parameters::Ptr& parameters) noexcept -> void
 	{
-		auto dMaterial = mMaterials->get(material);
+		const auto& dMaterial = mMaterials->get(material);
 
 		dMaterial->mInstancing = parameters->mInstancing;
+		dMaterial->mInstancingColor = parameters->mInstancingColor;
+		dMaterial->mMultiDraw = parameters->mMultiDraw;
 		dMaterial->mDiffuseMap = material->mDiffuseMap;
 		dMaterial->mEnvMap = material->mEnvMap;
 		dMaterial->mNormalMap = material->mNormalMap;
 		dMaterial->mSpecularMap = material->mSpecularMap;
 	}
 
-	auto Renderer::materialNeedsLights(const Material::Ptr& material) noexcept -> bool
+	auto Renderer::materialNeedsLights(const Material* material) noexcept -> bool
 	{
 		if (material->mIsMeshPhongMaterial)
 		{
@@ -515,14 +1197,6 @@ namespace ff
 		return false;
 	}
 
-	void Renderer::makeLightsNeedUpdate(UniformHandleMap& lightsUniformMap) noexcept
-	{
-		for (auto& iter : lightsUniformMap)
-		{
-			iter.second.mNeedsUpdate = true;
-		}
-	}
-
 	auto Renderer::setSize(int width, int height) noexcept -> void
 	{
 		mWidth = width;
@@ -533,6 +1207,16 @@ namespace ff
 
 		mState->viewport(mViewport);
 
+		/// 离屏模式下，默认的RenderTarget需要跟随尺寸变化，变化后其FrameBuffer会被销毁，需要重新绑定
+		if (mDefaultRenderTarget != nullptr)
+		{
+			mDefaultRenderTarget->setSize(width, height);
+			if (mCurrentRenderTarget == nullptr)
+			{
+				setRenderTarget(nullptr);
+			}
+		}
+
 		/// pay attention: we should deal with custom-renderTarget resizing in application
 		if (mOnSizeCallback)
 		{
@@ -546,19 +1230,21 @@ namespace ff
 		mCurrentRenderTarget = renderTarget;
 
 		/// 如果RenderTarget是空，说明使用默认的RenderTarget
-		if (renderTarget == nullptr)
+		/// 离屏模式下，默认的RenderTarget就是mDefaultRenderTarget
+		const auto target = renderTarget != nullptr ? renderTarget : mDefaultRenderTarget;
+		if (target == nullptr)
 		{
 			mState->bindFrameBuffer(0);
 			return;
 		}
 
 		/// 拿出来DriverRenderTarget
-		const auto dRenderTarget = mRenderTargets->get(renderTarget);
+		const auto dRenderTarget = mRenderTargets->get(target);
 
 		/// 如果当前的RenderTarget还没有被创建，则将创建任务丢给DriverTextures
 		if (!dRenderTarget->mFrameBuffer)
 		{
-			mTextures->setupRenderTarget(renderTarget);
+			mTextures->setupRenderTarget(target);
 		}
 
 		mState->bindFrameBuffer(dRenderTarget->mFrameBuffer);
@@ -569,11 +1255,24 @@ namespace ff
 		return mCurrentRenderTarget;
 	}
 
+	auto Renderer::readPixels(std::vector<byte>& pixels) const noexcept -> void
+	{
+		pixels.resize(static_cast<size_t>(mWidth) * mHeight * 4);
+
+		FF_GL(glPixelStorei, GL_PACK_ALIGNMENT, 1);
+		FF_GL(glReadPixels, 0, 0, mWidth, mHeight, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+	}
+
 	auto Renderer::setClearColor(float r, float g, float b, float a) noexcept -> void
 	{
 		mState->setClearColor(r, g, b, a);
 	}
 
+	auto Renderer::getGLTrace() const noexcept -> const GLTrace::Frame&
+	{
+		return GLTrace::getInstance()->getLastFrame();
+	}
+
 	auto Renderer::getClearColor() const noexcept -> glm::vec4
 	{
 		return mState->getClearColor();
@@ -587,7 +1286,17 @@ namespace ff
 		if (depth) bits |= GL_DEPTH_BUFFER_BIT;
 		if (stencil) bits |= GL_STENCIL_BUFFER_BIT;
 
-		glClear(bits);
+		FF_GL(glClear, bits);
+	}
+
+	auto Renderer::getFrameProfile() const noexcept -> const Profiler::Frame&
+	{
+		return Profiler::getInstance()->getLastFrame();
+	}
+
+	auto Renderer::getProfileStatistics() const noexcept -> std::vector<Profiler::Statistic>
+	{
+		return Profiler::getInstance()->getStatistics();
 	}
 
 	void Renderer::enableShadow(bool enable) noexcept
@@ -595,6 +1304,11 @@ namespace ff
 		mShadowMap->mEnabled = enable;
 	}
 
+	void Renderer::enableGPUTimer(bool enable) noexcept
+	{
+		mGPUTimer->mEnabled = enable;
+	}
+
 	/// 为何不直接使用driverWindow的set函数进行回调设置呢？
 	/// 窗体大小的变化会影响咱们renderer的状态,比如视口viewport需要跟随设置变化
 	auto Renderer::setFrameSizeCallBack(const OnSizeCallback& callback) noexcept -> void
@@ -602,18 +1316,25 @@ namespace ff
 		mOnSizeCallback = callback;
 	}
 
+	/// 离屏模式下没有窗体，输入事件的回调直接忽略
 	auto Renderer::setMouseMoveCallBack(const DriverWindow::MouseMoveCallback& callback) noexcept -> void
 	{
+		if (mWindow == nullptr) return;
+
 		mWindow->setMouseMoveCallBack(callback);
 	}
 
 	auto Renderer::setMouseActionCallback(const DriverWindow::MouseActionCallback& callback) noexcept -> void
 	{
+		if (mWindow == nullptr) return;
+
 		mWindow->setMouseActionCallback(callback);
 	}
 
 	auto Renderer::setKeyboardActionCallBack(const DriverWindow::KeyboardActionCallback& callback) noexcept -> void
 	{
+		if (mWindow == nullptr) return;
+
 		mWindow->setKeyboardActionCallBack(callback);
 	}
 }
@@ -3,12 +3,17 @@
 #include "../camera/camera.h"
 #include "../core/object3D.h"
 #include "../objects/mesh.h"
+#include "../objects/skinnedMesh.h"
+#include "../objects/lod.h"
 #include "../scene/scene.h"
+#include "../scene/sceneCollection.h"
 #include "renderTarget.h"
+#include "frameGraph.h"
 #include "driver/driverAttributes.h"
 #include "driver/driverBindingState.h"
 #include "driver/driverPrograms.h"
 #include "driver/driverWindow.h"
+#include "driver/driverOffscreenContext.h"
 #include "driver/driverRenderList.h"
 #include "driver/driverTextures.h"
 #include "driver/driverObjects.h"
@@ -19,7 +24,15 @@
 #include "driver/driverRenderState.h"
 #include "driver/driverRenderTargets.h"
 #include "driver/driverShadowMap.h"
+#include "driver/driverGPUTimer.h"
+#include "driver/driverInstancing.h"
+#include "driver/driverMultiDraw.h"
+#include "driver/driverUniformBuffers.h"
+#include "driver/driverOcclusion.h"
 #include "../math/frustum.h"
+#include "../tools/softwareOcclusion.h"
+#include "../tools/profiler.h"
+#include "../wrapper/glTrace.h"
 
 namespace ff
 {
@@ -27,12 +40,21 @@ namespace ff
 	{
 	public:
 		friend class DriverShadowMap;
+		friend class DriverMultiDraw;
 
 		struct Descriptor
 		{
 			uint32_t mWidth{800};
 			uint32_t mHeight{600};
 
+			/// 离屏模式：不创建窗体，也不处理窗体事件与垂直同步，渲染结果输出到内部的默认RenderTarget
+			/// 适用于CI测试、缩略图生成、服务器端批量渲染以及性能基准测试
+			bool mOffscreen{false};
+
+			/// OpenGL上下文版本，默认3.3核心模式；multi-draw indirect需要4.3以上(gl_DrawID需要4.6或者ARB_shader_draw_parameters)
+			uint32_t mContextMajorVersion{3};
+			uint32_t mContextMinorVersion{3};
+
 			/// TODO 是否抗锯齿........
 		};
 
@@ -68,6 +90,14 @@ namespace ff
 
 		RenderTarget::Ptr getRenderTarget() const noexcept;
 
+		/// \brief 离屏模式下，替代窗体默认FrameBuffer的RenderTarget，窗体模式下为nullptr
+		/// \return
+		auto getDefaultRenderTarget() const noexcept -> RenderTarget::Ptr { return mDefaultRenderTarget; }
+
+		/// \brief 将当前绑定的FrameBuffer中的颜色数据回读到内存（RGBA，每个通道一个byte，自下而上）
+		/// \param pixels 输出的像素数据，大小会被调整为 width * height * 4
+		auto readPixels(std::vector<byte>& pixels) const noexcept -> void;
+
 		/// \brief 设置刷新背景色
 		/// \param r 
 		/// \param g 
@@ -81,6 +111,28 @@ namespace ff
 
 		void enableShadow(bool enable) noexcept;
 
+		/// \brief 是否使用GPU计时查询统计每个渲染阶段的GPU耗时
+		/// \param enable
+		void enableGPUTimer(bool enable) noexcept;
+
+		/// \brief 渲染统计：DrawCall数量、三角形数量，以及每个渲染阶段的GPU耗时（若干帧之前的结果）
+		/// \return
+		auto getRenderInfo() const noexcept -> const DriverInfo::Render& { return mInfos->mRender; }
+
+		/// \brief 最近一帧的CPU分析数据，包含各个阶段以及Driver内部嵌套阶段的耗时
+		/// 需要在编译时开启FF_ENABLE_PROFILER，否则没有任何数据
+		/// \return
+		auto getFrameProfile() const noexcept -> const Profiler::Frame&;
+
+		/// \brief 最近Profiler::FRAME_HISTORY帧当中，整帧以及每个阶段耗时的p50/p95/p99（毫秒）
+		/// \return
+		auto getProfileStatistics() const noexcept -> std::vector<Profiler::Statistic>;
+
+		/// \brief 最近一帧每个opengl入口的调用次数以及冗余绑定次数，入口名称见GLTrace::getEntryName
+		/// 需要在编译时开启FF_ENABLE_GL_TRACE，否则没有任何数据
+		/// \return
+		auto getGLTrace() const noexcept -> const GLTrace::Frame&;
+
 		/// \brief 清除 colorbuffer
 		/// \param color 
 		/// \param depth 
@@ -91,6 +143,34 @@ namespace ff
 		/// 每一次绘制，是否需要自动擦除ColorBuffer
 		bool mAutoClear{true};
 
+		/// 常驻渲染列表模式：渲染列表跨帧保留，只有物体的变换、可见性、材质或者几何发生变化时才会更新列表及其排序
+		/// 层级结构变化(addChild/removeChild)或者可见性变化时，重新收集整个场景；适合大部分物体静止的场景
+		bool mRetainedRenderList{false};
+
+		/// 统计非透明队列按照深度排序时需要的状态切换次数(DriverInfo::Render::mDepthOrderStateChanges)，
+		/// 用于与当前的排序布局对比；不是按照深度排序时每帧需要额外排序一次，默认关闭
+		bool mSortStatistics{false};
+
+		/// 自动实例化：geometry与material都相同的非透明Mesh，合并为一次实例化DrawCall
+		/// 骨骼动画、透明物体、带有onBeforeRender回调以及开启遮挡剔除的物体不参与合并
+		bool mAutoInstancing{false};
+
+		/// multi-draw indirect：非透明队列中material与顶点格式相同的Mesh，合并为一次glMultiDrawElementsIndirect
+		/// 需要创建4.3以上的上下文(见Descriptor)，当前上下文不支持时自动使用逐个绘制
+		bool mMultiDrawIndirect{false};
+
+		/// 使用program链接时编译好的uniform表上传每次DrawCall的uniform；关闭则使用旧的UniformHandleMap(拷贝map+字符串查找)
+		bool mCompiledUniforms{true};
+
+		/// 硬件遮挡剔除总开关，只对RenderableObject::mOcclusionCulling为true的物体生效，结果统计在DriverInfo当中
+		bool mOcclusionCulling{true};
+
+		/// 遮挡剔除不在CPU上回读查询结果，改为glBeginConditionalRender由GPU决定是否绘制，节省回读但是无法节省CPU端的绘制开销
+		bool mOcclusionConditionalRender{false};
+
+		/// CPU软件遮挡剔除：每帧将mOccluder为true的物体光栅化进低分辨率深度缓冲，在project阶段剔除被挡住的物体，没有GPU回读的延迟
+		bool mSoftwareOcclusionCulling{false};
+
 	private:
 		/// ///////////////////////////// 层级渲染 /////////////////////////////////////// /// 
 
@@ -100,6 +180,53 @@ namespace ff
 		/// \param sortObjects	sortObjects 是否在渲染列表中，对item进行排序
 		auto projectObject(const Object3D::Ptr& object, uint32_t groupOrder, bool sortObjects) noexcept -> void;
 
+		/// 常驻渲染列表当中的一个可渲染物体，以及上一次检查时它的状态
+		struct RetainedEntry
+		{
+			RenderableObject* mObject{nullptr};
+			Geometry* mGeometry{nullptr};
+			Material* mMaterial{nullptr};
+
+			/// 使用ID而不是地址判断geometry/material是否被更换，释放之后新分配的对象可能恰好位于同一个地址
+			ID mGeometryID{0};
+			ID mMaterialID{0};
+			uint32_t mGeometryBoundsVersion{0};
+			uint32_t mGroupOrder{0};
+			uint32_t mWorldMatrixVersion{0};
+			uint32_t mProgramID{0};
+			float mZ{0.0f};
+			bool mTransparent{false};
+			bool mInFrustum{false};
+			bool mOccluded{false};
+
+			/// 所属的LOD以及层级，不属于任何LOD时为空
+			LOD* mLOD{nullptr};
+			uint32_t mLODLevel{0};
+		};
+
+		/// \brief				常驻渲染列表模式下的project，只处理发生了变化的物体
+		/// \param scene 
+		/// \return				渲染列表是否被重新构建，如果没有，则沿用上一帧排好序的列表
+		auto projectRetained(const Scene::Ptr& scene) noexcept -> bool;
+
+
+		/// \brief				物体所属的LOD层级是否被当前相机选中，不属于任何LOD的物体总是选中
+		/// \param lod 
+		/// \param level 
+		auto isLODLevelSelected(const LOD* lod, uint32_t level) const noexcept -> bool;
+
+		/// \brief				重新计算一个常驻物体的剪裁结果、深度以及材质相关的信息
+		/// \param entry 
+		auto updateRetainedEntry(RetainedEntry& entry) noexcept -> void;
+
+		/// \brief				BVH模式下的project，只访问与视景体相交的子树
+		/// \param scene 
+		auto projectBVH(const Scene::Ptr& scene) noexcept -> void;
+
+		/// \brief				将视景体之内的遮挡物光栅化进软件遮挡剔除的深度缓冲
+		/// \param object 
+		auto rasterizeOccluders(const Object3D::Ptr& object) noexcept -> void;
+
 
 		/// \brief
 		/// 第一层级，在场景级别，进行一些状态的处理与设置，并且根据
@@ -113,14 +240,32 @@ namespace ff
 		/// \brief
 		///	第二层级，在队列级别，进行一些状态的处理与设置
 		/// 依次调用每个渲染单元，进入到renderObject
-		/// \param renderItems 
+		/// \param renderItems	本帧所有的renderItem
+		/// \param queue		需要渲染的队列，即renderItems中的下标
 		/// \param scene 
 		/// \param camera 
 		auto renderObjects(
-			const std::vector<RenderItem::Ptr>& renderItems,
+			const std::vector<RenderItem>& renderItems,
+			const std::vector<uint32_t>& queue,
+			const Scene::Ptr& scene,
+			const Camera::Ptr& camera) noexcept -> void;
+
+		/// \brief 深度预渲染，用深度材质只写入队列中开启了深度检测与深度写入的物体的深度
+		/// \param renderItems	本帧所有的renderItem
+		/// \param queue		非透明队列，即renderItems中的下标
+		/// \param scene 
+		/// \param camera 
+		auto renderDepthPrePass(
+			const std::vector<RenderItem>& renderItems,
+			const std::vector<uint32_t>& queue,
 			const Scene::Ptr& scene,
 			const Camera::Ptr& camera) noexcept -> void;
 
+		/// \brief 深度预渲染所用的深度材质，剔除面、正面朝向以及绘制方式与原material一致，保证覆盖的像素完全相同
+		/// \param material 
+		/// \return 
+		auto getDepthPrePassMaterial(const Material* material) noexcept -> Material*;
+
 
 		/// \brief
 		///	第三层级，在单个渲染单元层面上，进行一些状态的处理与设置
@@ -131,11 +276,11 @@ namespace ff
 		/// \param geometry 
 		/// \param material 
 		auto renderObject(
-			const RenderableObject::Ptr& object,
+			RenderableObject* object,
 			const Scene::Ptr& scene,
 			const Camera::Ptr& camera,
-			const Geometry::Ptr& geometry,
-			const Material::Ptr& material) noexcept -> void;
+			Geometry* geometry,
+			Material* material) noexcept -> void;
 
 		/// \brief 在单个渲染单元层面上
 		///	第四层级，最底层的所有的跟OpenGL的状态机最密集的一层
@@ -145,11 +290,11 @@ namespace ff
 		/// \param geometry 
 		/// \param material 
 		auto renderBufferDirect(
-			const RenderableObject::Ptr& object,
+			RenderableObject* object,
 			const Scene::Ptr& scene,
 			const Camera::Ptr& camera,
-			const Geometry::Ptr& geometry,
-			const Material::Ptr& material) noexcept -> void;
+			Geometry* geometry,
+			Material* material) noexcept -> void;
 
 		/// \brief 设置本Material的Program
 		/// \param camera 
@@ -157,37 +302,39 @@ namespace ff
 		/// \param geometry 
 		/// \param material 
 		/// \param object 
+		/// \param multiDraw	是否为multi-draw indirect绘制，矩阵从SSBO读取
 		/// \return 
 		auto setProgram(
 			const Camera::Ptr& camera,
 			const Scene::Ptr& scene,
-			const Geometry::Ptr& geometry,
-			const Material::Ptr& material,
-			const RenderableObject::Ptr& object) noexcept -> DriverProgram::Ptr;
+			const Geometry* geometry,
+			const Material* material,
+			const RenderableObject* object,
+			bool multiDraw = false) noexcept -> const DriverProgram::Ptr&;
 
 		/// \brief 得到与本Material对应的Program
 		/// \param material 
 		/// \param scene 
 		/// \param object 
+		/// \param multiDraw 
 		/// \return 
 		auto getProgram(
-			const Material::Ptr& material,
+			const Material* material,
 			const Scene::Ptr& scene,
-			const RenderableObject::Ptr& object) noexcept -> DriverProgram::Ptr;
+			const RenderableObject* object,
+			bool multiDraw = false) noexcept -> DriverProgram::Ptr;
 
 		/// \brief	更新了本Material跟其对应的DriverMaterial的关键变量
 		/// \param material 
 		/// \param parameters 
 		auto updateCommonMaterialProperties(
-			const Material::Ptr& material,
+			const Material* material,
 			const DriverProgram::Parameters::Ptr& parameters) noexcept -> void;
 
 		/// \brief 当前Material是否需要光照
 		/// \param material 
 		/// \return 
-		auto materialNeedsLights(const Material::Ptr& material) noexcept -> bool;
-
-		void makeLightsNeedUpdate(UniformHandleMap& lightsUniformMap) noexcept;
+		auto materialNeedsLights(const Material* material) noexcept -> bool;
 
 	private:
 		int mWidth{800};
@@ -199,16 +346,23 @@ namespace ff
 
 		glm::mat4 mCurrentViewMatrix = glm::mat4(1.0f);
 
+		/// 本次render的相机，LOD按相机记录所选的层级
+		Camera* mCurrentCamera{nullptr};
+
 		glm::vec4 mViewport{};
 
 		RenderTarget::Ptr mCurrentRenderTarget{nullptr};
 
 		DriverWindow::Ptr mWindow{nullptr};
+		/// 离屏模式下，使用无窗体的上下文，以及替代默认FrameBuffer的RenderTarget
+		DriverOffscreenContext::Ptr mOffscreenContext{nullptr};
+		RenderTarget::Ptr mDefaultRenderTarget{nullptr};
 		DriverRenderList::Ptr mRenderList{nullptr};
 		/// \brief 纹理
 		DriverTextures::Ptr mTextures{nullptr};
 		DriverAttributes::Ptr mAttributes{nullptr};
 		DriverInfo::Ptr mInfos{nullptr};
+		DriverGPUTimer::Ptr mGPUTimer{nullptr};
 		DriverState::Ptr mState{nullptr};
 		DriverObjects::Ptr mObjects{nullptr};
 		DriverGeometries::Ptr mGeometries{nullptr};
@@ -219,9 +373,35 @@ namespace ff
 		DriverRenderState::Ptr mRenderState{nullptr};
 		DriverRenderTargets::Ptr mRenderTargets{nullptr};
 		DriverShadowMap::Ptr mShadowMap{nullptr};
+		DriverInstancing::Ptr mInstancing{nullptr};
+		DriverMultiDraw::Ptr mMultiDraw{nullptr};
+		DriverUniformBuffers::Ptr mUniformBuffers{nullptr};
+		DriverOcclusion::Ptr mOcclusion{nullptr};
+		SoftwareOcclusion::Ptr mSoftwareOcclusion{nullptr};
+
+		/// 每帧重新搭建的Pass调度，临时RenderTarget的池子跨帧保留
+		FrameGraph::Ptr mFrameGraph{nullptr};
 
 		Frustum::Ptr mFrustum{nullptr};
 
+		/// BVH模式下本帧与视景体相交的物体，跨帧复用内存
+		std::vector<const SceneBVH::Entry*> mBVHVisible{};
+
+		/// 常驻渲染列表：上一次的投影*视图矩阵、排序方式以及是否自动实例化
+		glm::mat4 mRetainedViewMatrix = glm::mat4(1.0f);
+		RenderSortLayout mRetainedSortLayout{RenderSortLayout::SmallerZFirst};
+		bool mRetainedAutoInstancing{false};
+
+		/// 场景树的展开结果(灯光、骨骼动画物体以及所有已展开节点的可见性)，以及由其中的可渲染物体生成的常驻物体
+		SceneCollection mRetainedCollection{};
+		std::vector<RetainedEntry> mRetainedEntries{};
+
+		/// 常驻的LOD，以及上一帧所选的层级
+		std::vector<std::pair<LOD*, uint32_t>> mRetainedLODs{};
+
+		/// 深度预渲染的深度材质，以side、frontFace与drawMode打包为key
+		std::unordered_map<uint32_t, DepthMaterial::Ptr> mDepthPrePassMaterials{};
+
 		/// dummy objects
 		Scene::Ptr mDummyScene = Scene::create();
 	};
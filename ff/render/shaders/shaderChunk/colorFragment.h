@@ -3,7 +3,7 @@
 
 namespace ff {
 	static const std::string colorFragment =
-		"#ifdef HAS_COLOR\n"\
+		"#if defined(HAS_COLOR) || defined(USE_INSTANCING_COLOR)\n"\
 		"	diffuseColor.rgb *= fragColor;\n"\
 		"#endif\n"\
 		"\n";
@@ -3,7 +3,7 @@
 
 namespace ff {
 	static const std::string colorParseFragment =
-		"#ifdef HAS_COLOR\n"\
+		"#if defined(HAS_COLOR) || defined(USE_INSTANCING_COLOR)\n"\
 		"	in vec3 fragColor;\n"\
 		"#endif\n"\
 		"\n";
@@ -5,6 +5,9 @@ namespace ff {
 	static const std::string colorParseVertex =
 		"#ifdef HAS_COLOR\n"\
 		"	layout(location = COLOR_LOCATION) in vec3 color;\n"\
+		"#endif\n"\
+		"\n"\
+		"#if defined(HAS_COLOR) || defined(USE_INSTANCING_COLOR)\n"\
 		"	out vec3 fragColor;\n"\
 		"#endif\n"\
 		"\n";
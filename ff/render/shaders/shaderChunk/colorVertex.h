@@ -3,8 +3,16 @@
 
 namespace ff {
 	static const std::string colorVertex =
+		"#if defined(HAS_COLOR) || defined(USE_INSTANCING_COLOR)\n"\
+		"	fragColor = vec3(1.0);\n"\
+		"#endif\n"\
+		"\n"\
 		"#ifdef HAS_COLOR\n"\
-		"	fragColor = color;\n"\
+		"	fragColor *= color;\n"\
+		"#endif\n"\
+		"\n"\
+		"#ifdef USE_INSTANCING_COLOR\n"\
+		"	fragColor *= instanceColor;\n"\
 		"#endif\n"\
 		"\n";
 }
\ No newline at end of file
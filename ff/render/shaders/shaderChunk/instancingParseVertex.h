@@ -0,0 +1,16 @@
+﻿#pragma once
+#include "../../../global/base.h"
+
+namespace ff {
+
+	/// 实例矩阵是mat4，会占用INSTANCE_MATRIX_LOCATION开始的连续4个location
+	static const std::string instancingParseVertex =
+		"#ifdef USE_INSTANCING\n"\
+		"	layout(location = INSTANCE_MATRIX_LOCATION) in mat4 instanceMatrix;\n"\
+		"#endif\n"\
+		"\n"\
+		"#ifdef USE_INSTANCING_COLOR\n"\
+		"	layout(location = INSTANCE_COLOR_LOCATION) in vec3 instanceColor;\n"\
+		"#endif\n"\
+		"\n";
+}
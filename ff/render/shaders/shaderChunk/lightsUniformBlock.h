@@ -0,0 +1,30 @@
+﻿#pragma once
+#include "../../../global/base.h"
+
+namespace ff {
+
+	/// 光照UniformBuffer，与DriverLights::LightsBlock按照std140布局一一对应
+	/// 顶点与片元shader都可能用到，使用LIGHTS_BLOCK保证同一个shader当中只声明一次
+	static const std::string lightsUniformBlock =
+		"#ifndef LIGHTS_BLOCK\n"\
+		"#define LIGHTS_BLOCK\n"\
+		"	struct DirectionalLight {\n"\
+		"		vec3 direction;\n"\
+		"		vec3 color;\n"\
+		"	};\n"\
+		"\n"\
+		"	struct DirectionalLightShadow {\n"\
+		"		float shadowRadius;\n"\
+		"		float shadowBias;\n"\
+		"		vec2  shadowMapSize;\n"\
+		"	};\n"\
+		"\n"\
+		"	layout(std140) uniform LightsBlock {\n"\
+		"		DirectionalLight directionalLights[MAX_DIR_LIGHTS];\n"\
+		"		DirectionalLightShadow directionalLightShadows[MAX_DIR_LIGHTS];\n"\
+		"		mat4 directionalShadowMatrix[MAX_DIR_LIGHTS];\n"\
+		"		vec3 ambientLightColor;\n"\
+		"	};\n"\
+		"#endif\n"\
+		"\n";
+}
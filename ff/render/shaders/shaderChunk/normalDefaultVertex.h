@@ -5,12 +5,26 @@ namespace ff {
 
 	static const std::string normalDefaultVertex =
 		"#ifdef HAS_NORMAL\n"\
-		"	vec3 transformedNormal = normalMatrix * objectNormal;\n"\
+		"	vec3 transformedNormal = objectNormal;\n"\
+		"\n"\
+		/// 实例矩阵可能带有非均匀缩放，法线需要乘以其逆转置，这里先除以各轴缩放的平方，再乘以实例矩阵
+		"	#ifdef USE_INSTANCING\n"\
+		"		mat3 instanceMatrix3 = mat3(instanceMatrix);\n"\
+		"		transformedNormal /= vec3(dot(instanceMatrix3[0], instanceMatrix3[0]), dot(instanceMatrix3[1], instanceMatrix3[1]), dot(instanceMatrix3[2], instanceMatrix3[2]));\n"\
+		"		transformedNormal = instanceMatrix3 * transformedNormal;\n"\
+		"	#endif\n"\
+		"\n"\
+		"	transformedNormal = normalMatrix * transformedNormal;\n"\
 		"\n"\
 		"	#ifdef USE_TANGENT\n"\
 		/// because tangent is the base vector 
-		"		vec3 transformedTangent = (modelViewMatrix * vec4(objectTangent, 0.0)).xyz;\n"\
-		"		vec3 transformedBitangent = (modelViewMatrix * vec4(objectBitangent, 0.0)).xyz;\n"\
+		"		#ifdef USE_INSTANCING\n"\
+		"			vec3 transformedTangent = (modelViewMatrix * instanceMatrix * vec4(objectTangent, 0.0)).xyz;\n"\
+		"			vec3 transformedBitangent = (modelViewMatrix * instanceMatrix * vec4(objectBitangent, 0.0)).xyz;\n"\
+		"		#else\n"\
+		"			vec3 transformedTangent = (modelViewMatrix * vec4(objectTangent, 0.0)).xyz;\n"\
+		"			vec3 transformedBitangent = (modelViewMatrix * vec4(objectBitangent, 0.0)).xyz;\n"\
+		"		#endif\n"\
 		"	#endif\n"\
 		"#endif\n"\
 		"\n";
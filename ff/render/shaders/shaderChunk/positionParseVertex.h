@@ -3,7 +3,9 @@
 
 namespace ff {
 
+	/// gl_Position声明为invariant：深度预渲染与正式绘制使用不同的shader，必须得到完全相同的深度，Equal比较才能通过
 	static const std::string positionParseVertex =
 		"layout(location = POSITION_LOCATION) in vec3 position;\n"\
+		"invariant gl_Position;\n"\
 		"\n";
 }
\ No newline at end of file
@@ -5,6 +5,9 @@ namespace ff
 {
 	static const std::string projectVertex =
 		"	vec4 mvPosition = vec4(transformed, 1.0);\n"\
+		"#ifdef USE_INSTANCING\n"\
+		"	mvPosition = instanceMatrix * mvPosition;\n"\
+		"#endif\n"\
 		"	mvPosition = modelViewMatrix * mvPosition;\n"\
 		"	gl_Position = projectionMatrix * mvPosition;\n";
 }
@@ -8,6 +8,8 @@
 #include "positionParseVertex.h"
 #include "worldPositionVertex.h"
 
+#include "instancingParseVertex.h"
+
 #include "skinningParseVertex.h"
 #include "skinBaseVertex.h"
 #include "skinningVertex.h"
@@ -40,6 +42,7 @@
 #include "diffuseMapFragment.h"
 #include "colorFragment.h"
 
+#include "lightsUniformBlock.h"
 #include "lightsParseBegin.h"
 #include "lightsPhongParseFragment.h"
 #include "lightsPhongMaterial.h"
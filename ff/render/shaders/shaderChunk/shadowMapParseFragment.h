@@ -1,21 +1,15 @@
 #pragma once
 #include "../../../global/base.h"
+#include "lightsUniformBlock.h"
 
 namespace ff {
 
 	static const std::string shadowMapParseFragment =
 		"#ifdef USE_SHADOWMAP\n"\
-		"	#if NUM_DIR_LIGHT_SHADOWS > 0\n"\
+		"	#if NUM_DIR_LIGHT_SHADOWS > 0\n" +
+		lightsUniformBlock +
 		"		uniform sampler2D directionalShadowMap[NUM_DIR_LIGHT_SHADOWS];\n"\
 		"		in vec4 directionalShadowCoords[NUM_DIR_LIGHT_SHADOWS];\n"\
-		"\n"\
-		"		struct DirectionalLightShadow {\n"\
-		"			float shadowRadius;\n"\
-		"			float shadowBias;\n"\
-		"			vec2 shadowMapSize;\n"\
-		"		};\n"\
-		"\n"\
-		"		uniform DirectionalLightShadow directionalLightShadows[NUM_DIR_LIGHT_SHADOWS];\n"\
 		"	#endif\n"\
 		/// return 1 if texture value is bigger than compare
 		"	float texture2DCompare(sampler2D depths, vec2 uv, float compare) {\n"\
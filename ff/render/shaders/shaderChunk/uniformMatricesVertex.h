@@ -3,10 +3,32 @@
 
 namespace ff {
 
+	/// 1 相机相关的矩阵来自CameraBlock，与DriverUniformBuffers::CameraBlock按照std140布局一一对应，每个视图只上传一次
+	/// 2 multi-draw indirect时，每个物体的矩阵存放在SSBO当中，使用DRAW_ID(gl_DrawID)取出，
+	/// 以宏替换的方式保持其他代码块不变
 	static const std::string uniformMatricesVertex =
-		"uniform mat4 modelViewMatrix;\n"\
-		"uniform mat3 normalMatrix;\n"\
-		"uniform mat4 projectionMatrix;\n"\
-		"uniform mat4 modelMatrix;\n"\
+		"layout(std140) uniform CameraBlock {\n"\
+		"	mat4 viewMatrix;\n"\
+		"	mat4 projectionMatrix;\n"\
+		"	vec3 cameraPosition;\n"\
+		"};\n"\
+		"\n"\
+		"#ifdef USE_MULTI_DRAW\n"\
+		"	struct DrawData {\n"\
+		"		mat4 modelMatrix;\n"\
+		"		mat4 modelViewMatrix;\n"\
+		"		mat4 normalMatrix;\n"\
+		"	};\n"\
+		"	layout(std430, binding = 0) readonly buffer DrawDataBuffer {\n"\
+		"		DrawData drawDatas[];\n"\
+		"	};\n"\
+		"	#define modelMatrix drawDatas[DRAW_ID].modelMatrix\n"\
+		"	#define modelViewMatrix drawDatas[DRAW_ID].modelViewMatrix\n"\
+		"	#define normalMatrix mat3(drawDatas[DRAW_ID].normalMatrix)\n"\
+		"#else\n"\
+		"	uniform mat4 modelViewMatrix;\n"\
+		"	uniform mat3 normalMatrix;\n"\
+		"	uniform mat4 modelMatrix;\n"\
+		"#endif\n"\
 		"\n";
 }
\ No newline at end of file
@@ -5,6 +5,9 @@ namespace ff {
 	static const std::string worldPositionVertex =
 		"#if defined(USE_SHADOWMAP) || defined(USE_ENVMAP)\n"\
 		"	vec4 worldPosition = vec4(transformed, 1.0);\n"\
+		"	#ifdef USE_INSTANCING\n"\
+		"		worldPosition = instanceMatrix * worldPosition;\n"\
+		"	#endif\n"\
 		"	worldPosition = modelMatrix * worldPosition;\n"\
 		"#endif\n"\
 		"\n";
@@ -10,6 +10,7 @@ namespace ff {
 			positionParseVertex +
 			uniformMatricesVertex +
 			skinningParseVertex +
+			instancingParseVertex +
 			"out vec2 zw;\n"\
 
 			"void main() {\n" +
@@ -12,6 +12,7 @@ namespace ff {
 			colorParseVertex +
 			uvParseVertex +
 			uniformMatricesVertex +
+			instancingParseVertex +
 
 			"void main() {\n" +
 				beginNormal +
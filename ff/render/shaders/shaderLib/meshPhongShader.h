@@ -31,6 +31,7 @@ namespace ff {
 			/// Ӱ
 			shadowMapParseVertex + 
 			skinningParseVertex + 
+			instancingParseVertex +
 
 			"void main() {\n" +
 			beginNormal + 
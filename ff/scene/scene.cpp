@@ -13,4 +13,14 @@ namespace ff
 	}
 
 	Scene::~Scene() noexcept = default;
+
+	auto Scene::getBVH() noexcept -> const SceneBVH::Ptr&
+	{
+		if (mBVH == nullptr)
+		{
+			mBVH = SceneBVH::create();
+		}
+
+		return mBVH;
+	}
 }
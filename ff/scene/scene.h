@@ -1,8 +1,10 @@
 ﻿#pragma once
 #include "../global/base.h"
+#include "../global/constant.h"
 #include "../core/object3D.h"
 #include "../material/material.h"
 #include "../textures/cubeTexture.h"
+#include "sceneBVH.h"
 
 namespace ff
 {
@@ -22,5 +24,27 @@ namespace ff
 
 		/// 天空盒
 		CubeTexture::Ptr mBackground = nullptr;
+
+		/// 非透明物体的排序方式
+		/// SmallerZFirst：由近到远，利于earlyZ，适合overdraw严重、片元着色开销大的场景
+		/// StateFirst：按照program/material/geometry聚合，适合物体多、DrawCall开销大的场景
+		/// 可以参考DriverInfo当中统计的状态切换次数进行选择
+		RenderSortLayout mOpaqueSortLayout{ RenderSortLayout::SmallerZFirst };
+
+		/// 深度预渲染：先用深度材质只写入非透明物体的深度，正式绘制时以Equal比较并且不再写入深度，
+		/// 每个像素只执行一次光照计算；适合片元着色开销大(多光源、阴影采样)的场景，代价是非透明物体的顶点处理与DrawCall翻倍
+		/// 物体的onBeforeRender回调在两次绘制之前都会被调用
+		bool mDepthPrePass{ false };
+
+		/// 使用BVH进行视景体剪裁：主相机与阴影相机只访问与视景体相交的子树，不再逐个物体变换包围球；
+		/// 适合物体数量很多(数万以上)、每帧只有少量物体移动的场景；关闭排序时绘制顺序为BVH的遍历顺序
+		bool mBVHCulling{ false };
+
+		/// \brief 场景的BVH，第一次调用时创建；也可以不开启mBVHCulling，在update之后单独用于射线拾取
+		/// \return 
+		auto getBVH() noexcept -> const SceneBVH::Ptr&;
+
+	private:
+		SceneBVH::Ptr mBVH{ nullptr };
 	};
 }
@@ -0,0 +1,476 @@
+﻿#include "sceneBVH.h"
+
+namespace ff
+{
+	SceneBVH::SceneBVH() noexcept
+	{
+	}
+
+	SceneBVH::~SceneBVH() noexcept
+	{
+	}
+
+	auto SceneBVH::update(const Object3D::Ptr& root) noexcept -> void
+	{
+		mStats.mRefitted = 0;
+		mStats.mVisitedNodes = 0;
+
+		/// 1 层级结构或者任意一个节点的可见性发生变化，重新收集，同步构建
+		if (mCollection.isStale(root))
+		{
+			mCollection.collect(root);
+
+			mEntries.clear();
+			for (const auto& renderable : mCollection.getRenderables())
+			{
+				auto& entry = mEntries.emplace_back();
+				entry.mObject = renderable.mObject;
+				entry.mGroupOrder = renderable.mGroupOrder;
+				entry.mLOD = renderable.mLOD;
+				entry.mLODLevel = renderable.mLODLevel;
+
+				computeBounds(entry);
+			}
+
+			mTree = build(snapshot());
+			mRefitCount = 0;
+			mGeneration++;
+
+			mStats.mBuilds++;
+			mStats.mEntries = static_cast<uint32_t>(mEntries.size());
+			mStats.mNodes = static_cast<uint32_t>(mTree.mNodes.size());
+
+			return;
+		}
+
+		/// 2 后台构建已经完成，替换掉refit之后的旧树
+		bool replaced = false;
+		if (mPendingTree.valid() && mPendingTree.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+		{
+			auto tree = mPendingTree.get();
+			if (mPendingGeneration == mGeneration)
+			{
+				mTree = std::move(tree);
+				replaced = true;
+
+				mStats.mBackgroundBuilds++;
+				mStats.mNodes = static_cast<uint32_t>(mTree.mNodes.size());
+			}
+		}
+
+		/// 3 只有worldMatrix或者geometry发生变化的物体需要重新计算包围盒；实例矩阵的变化不体现在worldMatrix上，InstancedMesh每帧都要检查
+		for (uint32_t i = 0; i < mEntries.size(); ++i)
+		{
+			auto& entry = mEntries[i];
+			const auto object = entry.mObject;
+
+			const bool changed = object->mIsInstancedMesh
+				|| object->getWorldMatrixVersion() != entry.mWorldMatrixVersion
+				|| object->getGeometry()->getBoundsVersion() != entry.mGeometryBoundsVersion;
+
+			if (!changed || !computeBounds(entry))
+			{
+				continue;
+			}
+
+			if (!replaced)
+			{
+				refitEntry(i);
+			}
+
+			mRefitCount++;
+			mStats.mRefitted++;
+		}
+
+		/// 新树构建于若干帧之前的包围盒，整体refit一次
+		if (replaced)
+		{
+			refitAll();
+		}
+
+		/// 4 refit累计得足够多，在后台重新构建
+		if (!mPendingTree.valid() && mRefitCount > static_cast<float>(mEntries.size()) * REBUILD_RATIO)
+		{
+			mPendingGeneration = mGeneration;
+			mPendingTree = std::async(std::launch::async, [bounds = snapshot()]()
+			{
+				return build(bounds);
+			});
+
+			mRefitCount = 0;
+		}
+	}
+
+	auto SceneBVH::computeBounds(Entry& entry) noexcept -> bool
+	{
+		const auto object = entry.mObject;
+
+		entry.mWorldMatrixVersion = object->getWorldMatrixVersion();
+		entry.mGeometryBoundsVersion = object->getGeometry()->getBoundsVersion();
+
+		/// 物体缓存的世界包围盒，InstancedMesh的包围盒包含了所有实例
+		const auto& box = object->getWorldBoundingBox();
+
+		const bool changed = box.mMin != entry.mMin || box.mMax != entry.mMax;
+
+		entry.mMin = box.mMin;
+		entry.mMax = box.mMax;
+
+		return changed;
+	}
+
+	auto SceneBVH::snapshot() const noexcept -> std::vector<Bounds>
+	{
+		std::vector<Bounds> bounds(mEntries.size());
+		for (size_t i = 0; i < mEntries.size(); ++i)
+		{
+			bounds[i].mMin = mEntries[i].mMin;
+			bounds[i].mMax = mEntries[i].mMax;
+		}
+
+		return bounds;
+	}
+
+	auto SceneBVH::build(const std::vector<Bounds>& bounds) noexcept -> Tree
+	{
+		Tree tree;
+
+		const auto count = static_cast<uint32_t>(bounds.size());
+		if (count == 0)
+		{
+			return tree;
+		}
+
+		tree.mIndices.resize(count);
+		tree.mLeafOf.resize(count, INVALID_NODE);
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			tree.mIndices[i] = i;
+		}
+
+		/// 二叉树的节点数量不会超过2n - 1
+		tree.mNodes.reserve(static_cast<size_t>(count) * 2);
+
+		buildNode(tree, bounds, INVALID_NODE, 0, count);
+
+		return tree;
+	}
+
+	auto SceneBVH::buildNode(Tree& tree, const std::vector<Bounds>& bounds, uint32_t parent, uint32_t first, uint32_t count) noexcept -> uint32_t
+	{
+		auto centroid = [&bounds](uint32_t index)
+		{
+			return (bounds[index].mMin + bounds[index].mMax) * 0.5f;
+		};
+
+		Node node;
+		node.mParent = parent;
+		node.mMin = glm::vec3(std::numeric_limits<float>::infinity());
+		node.mMax = glm::vec3(-std::numeric_limits<float>::infinity());
+
+		glm::vec3 centroidMin = glm::vec3(std::numeric_limits<float>::infinity());
+		glm::vec3 centroidMax = glm::vec3(-std::numeric_limits<float>::infinity());
+
+		for (uint32_t i = first; i < first + count; ++i)
+		{
+			const auto index = tree.mIndices[i];
+			node.mMin = glm::min(node.mMin, bounds[index].mMin);
+			node.mMax = glm::max(node.mMax, bounds[index].mMax);
+
+			const auto center = centroid(index);
+			centroidMin = glm::min(centroidMin, center);
+			centroidMax = glm::max(centroidMax, center);
+		}
+
+		const auto nodeIndex = static_cast<uint32_t>(tree.mNodes.size());
+		tree.mNodes.push_back(node);
+
+		if (count <= MAX_LEAF_SIZE)
+		{
+			tree.mNodes[nodeIndex].mFirst = first;
+			tree.mNodes[nodeIndex].mCount = count;
+
+			for (uint32_t i = first; i < first + count; ++i)
+			{
+				tree.mLeafOf[tree.mIndices[i]] = nodeIndex;
+			}
+
+			return nodeIndex;
+		}
+
+		/// 分桶SAH：按照包围盒中心落入的桶统计，在桶的边界上选择 左侧数量*左侧面积 + 右侧数量*右侧面积 最小的划分
+		struct Bin
+		{
+			glm::vec3	mMin{ std::numeric_limits<float>::infinity() };
+			glm::vec3	mMax{ -std::numeric_limits<float>::infinity() };
+			uint32_t	mCount{ 0 };
+		};
+
+		const glm::vec3 extent = centroidMax - centroidMin;
+
+		auto binOf = [&](uint32_t index, int axis)
+		{
+			const float offset = (centroid(index)[axis] - centroidMin[axis]) * (static_cast<float>(SAH_BINS) / extent[axis]);
+			return std::min(SAH_BINS - 1, static_cast<uint32_t>(std::max(0.0f, offset)));
+		};
+
+		int bestAxis = -1;
+		uint32_t bestSplit = 0;
+		float bestCost = std::numeric_limits<float>::max();
+
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			if (extent[axis] <= 0.0f)
+			{
+				continue;
+			}
+
+			Bin bins[SAH_BINS];
+			for (uint32_t i = first; i < first + count; ++i)
+			{
+				const auto index = tree.mIndices[i];
+				auto& bin = bins[binOf(index, axis)];
+
+				bin.mMin = glm::min(bin.mMin, bounds[index].mMin);
+				bin.mMax = glm::max(bin.mMax, bounds[index].mMax);
+				bin.mCount++;
+			}
+
+			/// 从右向左累计，rightArea[i]与rightCount[i]为桶(i, SAH_BINS)的合并结果
+			float rightArea[SAH_BINS]{};
+			uint32_t rightCount[SAH_BINS]{};
+
+			Bin accumulated;
+			for (uint32_t i = SAH_BINS - 1; i > 0; --i)
+			{
+				accumulated.mMin = glm::min(accumulated.mMin, bins[i].mMin);
+				accumulated.mMax = glm::max(accumulated.mMax, bins[i].mMax);
+				accumulated.mCount += bins[i].mCount;
+
+				rightArea[i - 1] = accumulated.mCount > 0 ? surfaceArea(accumulated.mMin, accumulated.mMax) : 0.0f;
+				rightCount[i - 1] = accumulated.mCount;
+			}
+
+			accumulated = Bin();
+			for (uint32_t i = 0; i + 1 < SAH_BINS; ++i)
+			{
+				accumulated.mMin = glm::min(accumulated.mMin, bins[i].mMin);
+				accumulated.mMax = glm::max(accumulated.mMax, bins[i].mMax);
+				accumulated.mCount += bins[i].mCount;
+
+				if (accumulated.mCount == 0 || rightCount[i] == 0)
+				{
+					continue;
+				}
+
+				const float cost = accumulated.mCount * surfaceArea(accumulated.mMin, accumulated.mMax) + rightCount[i] * rightArea[i];
+				if (cost < bestCost)
+				{
+					bestCost = cost;
+					bestAxis = axis;
+					bestSplit = i;
+				}
+			}
+		}
+
+		auto begin = tree.mIndices.begin() + first;
+		auto end = begin + count;
+		auto middle = begin + count / 2;
+
+		/// 所有中心重合时无法划分，直接从中间分开
+		if (bestAxis >= 0)
+		{
+			middle = std::partition(begin, end, [&](uint32_t index) { return binOf(index, bestAxis) <= bestSplit; });
+			if (middle == begin || middle == end)
+			{
+				middle = begin + count / 2;
+			}
+		}
+
+		const auto leftCount = static_cast<uint32_t>(middle - begin);
+
+		const auto left = buildNode(tree, bounds, nodeIndex, first, leftCount);
+		const auto right = buildNode(tree, bounds, nodeIndex, first + leftCount, count - leftCount);
+
+		tree.mNodes[nodeIndex].mLeft = left;
+		tree.mNodes[nodeIndex].mRight = right;
+
+		return nodeIndex;
+	}
+
+	auto SceneBVH::surfaceArea(const glm::vec3& min, const glm::vec3& max) noexcept -> float
+	{
+		const auto size = max - min;
+		return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+	}
+
+	auto SceneBVH::refitNode(uint32_t nodeIndex) noexcept -> bool
+	{
+		auto& node = mTree.mNodes[nodeIndex];
+
+		glm::vec3 min = glm::vec3(std::numeric_limits<float>::infinity());
+		glm::vec3 max = glm::vec3(-std::numeric_limits<float>::infinity());
+
+		if (node.mCount > 0)
+		{
+			for (uint32_t i = node.mFirst; i < node.mFirst + node.mCount; ++i)
+			{
+				const auto& entry = mEntries[mTree.mIndices[i]];
+				min = glm::min(min, entry.mMin);
+				max = glm::max(max, entry.mMax);
+			}
+		}
+		else
+		{
+			const auto& left = mTree.mNodes[node.mLeft];
+			const auto& right = mTree.mNodes[node.mRight];
+
+			min = glm::min(left.mMin, right.mMin);
+			max = glm::max(left.mMax, right.mMax);
+		}
+
+		if (min == node.mMin && max == node.mMax)
+		{
+			return false;
+		}
+
+		node.mMin = min;
+		node.mMax = max;
+
+		return true;
+	}
+
+	auto SceneBVH::refitEntry(uint32_t entry) noexcept -> void
+	{
+		auto nodeIndex = mTree.mLeafOf[entry];
+		while (nodeIndex != INVALID_NODE && refitNode(nodeIndex))
+		{
+			nodeIndex = mTree.mNodes[nodeIndex].mParent;
+		}
+	}
+
+	auto SceneBVH::refitAll() noexcept -> void
+	{
+		/// 先序排列，倒序遍历时子节点总是先于父节点
+		for (auto i = static_cast<int64_t>(mTree.mNodes.size()) - 1; i >= 0; --i)
+		{
+			refitNode(static_cast<uint32_t>(i));
+		}
+	}
+
+	auto SceneBVH::intersectFrustum(const Frustum::Ptr& frustum, std::vector<const Entry*>& result) noexcept -> void
+	{
+		result.clear();
+		if (mTree.mNodes.empty())
+		{
+			return;
+		}
+
+		mStack.clear();
+		mStack.push_back(0);
+
+		while (!mStack.empty())
+		{
+			const auto nodeIndex = mStack.back();
+			mStack.pop_back();
+
+			const auto& node = mTree.mNodes[nodeIndex];
+			mStats.mVisitedNodes++;
+
+			if (!frustum->intersectBox(node.mMin, node.mMax))
+			{
+				continue;
+			}
+
+			/// 完全在视景体之内，整棵子树都可见
+			if (frustum->containsBox(node.mMin, node.mMax))
+			{
+				addSubtree(nodeIndex, result);
+				continue;
+			}
+
+			if (node.mCount > 0)
+			{
+				for (uint32_t i = node.mFirst; i < node.mFirst + node.mCount; ++i)
+				{
+					const auto& entry = mEntries[mTree.mIndices[i]];
+					if (frustum->intersectBox(entry.mMin, entry.mMax))
+					{
+						result.push_back(&entry);
+					}
+				}
+			}
+			else
+			{
+				mStack.push_back(node.mRight);
+				mStack.push_back(node.mLeft);
+			}
+		}
+	}
+
+	auto SceneBVH::addSubtree(uint32_t nodeIndex, std::vector<const Entry*>& result) noexcept -> void
+	{
+		const auto& node = mTree.mNodes[nodeIndex];
+		if (node.mCount > 0)
+		{
+			for (uint32_t i = node.mFirst; i < node.mFirst + node.mCount; ++i)
+			{
+				result.push_back(&mEntries[mTree.mIndices[i]]);
+			}
+
+			return;
+		}
+
+		addSubtree(node.mLeft, result);
+		addSubtree(node.mRight, result);
+	}
+
+	auto SceneBVH::intersectRay(const Ray& ray, std::vector<RaycastHit>& result, float maxDistance) noexcept -> void
+	{
+		result.clear();
+		if (mTree.mNodes.empty())
+		{
+			return;
+		}
+
+		mStack.clear();
+		mStack.push_back(0);
+
+		float distance = 0.0f;
+		while (!mStack.empty())
+		{
+			const auto nodeIndex = mStack.back();
+			mStack.pop_back();
+
+			const auto& node = mTree.mNodes[nodeIndex];
+			mStats.mVisitedNodes++;
+
+			if (!ray.intersectBox(node.mMin, node.mMax, distance) || distance > maxDistance)
+			{
+				continue;
+			}
+
+			if (node.mCount > 0)
+			{
+				for (uint32_t i = node.mFirst; i < node.mFirst + node.mCount; ++i)
+				{
+					const auto& entry = mEntries[mTree.mIndices[i]];
+					if (ray.intersectBox(entry.mMin, entry.mMax, distance) && distance <= maxDistance)
+					{
+						result.push_back({ &entry, distance });
+					}
+				}
+			}
+			else
+			{
+				mStack.push_back(node.mRight);
+				mStack.push_back(node.mLeft);
+			}
+		}
+
+		std::sort(result.begin(), result.end(), [](const RaycastHit& a, const RaycastHit& b)
+		{
+			return a.mDistance < b.mDistance;
+		});
+	}
+}
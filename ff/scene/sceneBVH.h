@@ -0,0 +1,188 @@
+﻿#pragma once
+#include "../global/base.h"
+#include "../core/object3D.h"
+#include "../objects/renderableObject.h"
+#include "../objects/lod.h"
+#include "../lights/light.h"
+#include "sceneCollection.h"
+#include "../math/frustum.h"
+#include "../math/ray.h"
+#include <future>
+
+namespace ff
+{
+	class SkinnedMesh;
+
+	/// 场景中所有可渲染物体的动态BVH(层次包围盒)，视景体剪裁与射线查询的开销为O(log n + 结果数量)
+	/// 1 update：层级结构或者节点的可见性发生变化时，重新收集物体，同步地以SAH构建整棵树；
+	///   否则只重新计算worldMatrix或geometry包围体发生变化的物体的世界包围盒，沿着父节点向上refit，包围盒不再变化时提前停止
+	/// 2 refit不改变树的拓扑，物体移动得多了之后树的质量会下降：累计refit的物体超过一定比例时，在后台线程以SAH重新构建，
+	///   构建期间继续使用refit之后的旧树，构建完成后替换，并整体refit一次以追上构建期间的变化
+	/// 3 收集(见SceneCollection)时一并记录灯光、骨骼动画与LOD，使用BVH的Renderer不需要每帧遍历场景树；LOD的所有层级都在树中，由使用者按所选层级过滤
+	/// 注意：发现变化仍然需要线性地比较每个物体的版本号与每个节点的可见性，省掉的是包围球变换与平面测试；
+	/// 已经被静态合批的物体由StaticBatchMesh代为绘制，不在BVH当中
+	class SceneBVH
+	{
+	public:
+		/// 叶子节点最多容纳的物体数量
+		static constexpr uint32_t MAX_LEAF_SIZE = 4;
+
+		/// SAH沿每个轴的分桶数量
+		static constexpr uint32_t SAH_BINS = 12;
+
+		/// 累计refit的物体数量超过物体总数的这个比例，就在后台重新构建
+		static constexpr float REBUILD_RATIO = 0.5f;
+
+		static constexpr uint32_t INVALID_NODE = std::numeric_limits<uint32_t>::max();
+
+		struct Entry
+		{
+			RenderableObject*	mObject{ nullptr };
+			uint32_t			mGroupOrder{ 0 };
+
+			/// 世界空间的轴对齐包围盒
+			glm::vec3			mMin{ 0.0f };
+			glm::vec3			mMax{ 0.0f };
+
+			/// 计算包围盒时的worldMatrix版本号以及geometry包围体的版本号
+			uint32_t			mWorldMatrixVersion{ 0 };
+			uint32_t			mGeometryBoundsVersion{ 0 };
+
+			/// 所属的LOD以及层级，不属于任何LOD时为空
+			LOD*				mLOD{ nullptr };
+			uint32_t			mLODLevel{ 0 };
+		};
+
+		struct RaycastHit
+		{
+			const Entry*	mEntry{ nullptr };
+
+			/// 射线进入物体包围盒的距离
+			float			mDistance{ 0.0f };
+		};
+
+		struct Stats
+		{
+			uint32_t	mEntries{ 0 };
+			uint32_t	mNodes{ 0 };
+
+			/// 本次update当中包围盒发生变化的物体数量
+			uint32_t	mRefitted{ 0 };
+
+			/// 累计的同步构建与后台构建次数
+			uint32_t	mBuilds{ 0 };
+			uint32_t	mBackgroundBuilds{ 0 };
+
+			/// 本次update以来，各次查询访问过的节点数量
+			uint32_t	mVisitedNodes{ 0 };
+		};
+
+		using Ptr = std::shared_ptr<SceneBVH>;
+		static Ptr create()
+		{
+			return std::make_shared<SceneBVH>();
+		}
+
+		SceneBVH() noexcept;
+
+		~SceneBVH() noexcept;
+
+		/// \brief 使BVH与场景保持一致，调用之前场景的worldMatrix需要是最新的
+		/// \param root
+		auto update(const Object3D::Ptr& root) noexcept -> void;
+
+		/// \brief 与视景体相交的物体，完全在视景体之内的子树不再逐个测试
+		/// \param frustum
+		/// \param result 会先被清空
+		auto intersectFrustum(const Frustum::Ptr& frustum, std::vector<const Entry*>& result) noexcept -> void;
+
+		/// \brief 包围盒与射线相交的物体，按照距离由近到远排列
+		/// \param ray
+		/// \param result 会先被清空
+		/// \param maxDistance
+		auto intersectRay(const Ray& ray, std::vector<RaycastHit>& result, float maxDistance = std::numeric_limits<float>::max()) noexcept -> void;
+
+		auto getEntries() const noexcept -> const std::vector<Entry>& { return mEntries; }
+
+		auto getLights() const noexcept -> const std::vector<Light::Ptr>& { return mCollection.getLights(); }
+
+		auto getSkinnedMeshes() const noexcept -> const std::vector<SkinnedMesh*>& { return mCollection.getSkinnedMeshes(); }
+
+		auto getLODs() const noexcept -> const std::vector<LOD*>& { return mCollection.getLODs(); }
+
+		auto getStats() const noexcept -> const Stats& { return mStats; }
+
+	private:
+		/// mCount大于0为叶子节点，物体为mIndices[mFirst, mFirst + mCount)；否则为内部节点，子节点为mLeft与mRight
+		/// 先序排列，子节点的下标总是大于父节点
+		struct Node
+		{
+			glm::vec3	mMin{ 0.0f };
+			glm::vec3	mMax{ 0.0f };
+			uint32_t	mParent{ INVALID_NODE };
+			uint32_t	mLeft{ INVALID_NODE };
+			uint32_t	mRight{ INVALID_NODE };
+			uint32_t	mFirst{ 0 };
+			uint32_t	mCount{ 0 };
+		};
+
+		struct Bounds
+		{
+			glm::vec3	mMin{ 0.0f };
+			glm::vec3	mMax{ 0.0f };
+		};
+
+		/// 构建的结果，只依赖于构建时的包围盒，可以在后台线程生成
+		struct Tree
+		{
+			std::vector<Node>		mNodes{};
+			std::vector<uint32_t>	mIndices{};
+
+			/// 每个物体所在的叶子节点
+			std::vector<uint32_t>	mLeafOf{};
+		};
+
+
+		/// \brief 重新计算物体的世界包围盒
+		/// \return 包围盒是否发生了变化
+		static auto computeBounds(Entry& entry) noexcept -> bool;
+
+		auto snapshot() const noexcept -> std::vector<Bounds>;
+
+		static auto build(const std::vector<Bounds>& bounds) noexcept -> Tree;
+
+		static auto buildNode(Tree& tree, const std::vector<Bounds>& bounds, uint32_t parent, uint32_t first, uint32_t count) noexcept -> uint32_t;
+
+		static auto surfaceArea(const glm::vec3& min, const glm::vec3& max) noexcept -> float;
+
+		/// \brief 由子节点或者叶子中的物体重新计算节点的包围盒
+		/// \return 包围盒是否发生了变化
+		auto refitNode(uint32_t node) noexcept -> bool;
+
+		/// \brief 从物体所在的叶子向上refit，直到包围盒不再变化
+		auto refitEntry(uint32_t entry) noexcept -> void;
+
+		auto refitAll() noexcept -> void;
+
+		auto addSubtree(uint32_t node, std::vector<const Entry*>& result) noexcept -> void;
+
+	private:
+		/// 场景树的展开结果，以及由其中的可渲染物体生成的BVH物体
+		SceneCollection				mCollection{};
+		std::vector<Entry>			mEntries{};
+
+		Tree		mTree{};
+
+		/// 上一次构建以来refit过的物体数量
+		uint32_t	mRefitCount{ 0 };
+
+		/// 后台构建，以及发起构建时物体列表的代数；重新收集物体之后，旧的构建结果作废
+		std::future<Tree>	mPendingTree{};
+		uint32_t	mPendingGeneration{ 0 };
+		uint32_t	mGeneration{ 0 };
+
+		std::vector<uint32_t>	mStack{};
+
+		Stats		mStats{};
+	};
+}
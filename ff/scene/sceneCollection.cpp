@@ -0,0 +1,95 @@
+﻿#include "sceneCollection.h"
+#include "../objects/group.h"
+#include "../objects/skinnedMesh.h"
+
+namespace ff
+{
+	SceneCollection::SceneCollection() noexcept
+	{
+	}
+
+	SceneCollection::~SceneCollection() noexcept
+	{
+	}
+
+	auto SceneCollection::isStale(const Object3D::Ptr& root) const noexcept -> bool
+	{
+		if (!mValid || mRootID != root->getID() || mHierarchyVersion != root->getHierarchyVersion())
+		{
+			return true;
+		}
+
+		/// 任意一个已展开节点的可见性发生变化，其子树的展开结果就会不同；不可见节点也记录在内，其变为可见的时候才能发现
+		for (const auto& node : mNodeVisibility)
+		{
+			if (node.first->mVisible != node.second)
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	auto SceneCollection::collect(const Object3D::Ptr& root) noexcept -> void
+	{
+		mRenderables.clear();
+		mLights.clear();
+		mSkinnedMeshes.clear();
+		mLODs.clear();
+		mNodeVisibility.clear();
+
+		collectNode(root, 0, nullptr, 0);
+
+		mRootID = root->getID();
+		mHierarchyVersion = root->getHierarchyVersion();
+		mValid = true;
+	}
+
+	auto SceneCollection::collectNode(const Object3D::Ptr& object, uint32_t groupOrder, LOD* lod, uint32_t lodLevel) noexcept -> void
+	{
+		mNodeVisibility.emplace_back(object.get(), object->mVisible);
+		if (!object->mVisible) return;
+
+		if (object->mIsGroup)
+		{
+			groupOrder = static_cast<Group*>(object.get())->mGroupOrder;
+		}
+		else if (object->mIsLight)
+		{
+			mLights.push_back(std::static_pointer_cast<Light>(object));
+		}
+		else if (object->mIsRenderableObject)
+		{
+			if (object->mIsSkinnedMesh)
+			{
+				mSkinnedMeshes.push_back(dynamic_cast<SkinnedMesh*>(object.get()));
+			}
+
+			const auto renderableObject = static_cast<RenderableObject*>(object.get());
+			if (!renderableObject->mStaticBatched)
+			{
+				mRenderables.push_back({ renderableObject, groupOrder, lod, lodLevel });
+			}
+		}
+
+		if (object->mIsLOD)
+		{
+			const auto lodObject = static_cast<LOD*>(object.get());
+			mLODs.push_back(lodObject);
+
+			const auto& levels = lodObject->getLevels();
+			for (uint32_t i = 0; i < levels.size(); ++i)
+			{
+				collectNode(levels[i].mObject, groupOrder, lodObject, i);
+			}
+			return;
+		}
+
+		const auto& children = object->getChildren();
+		for (const auto& child : children)
+		{
+			collectNode(child, groupOrder, lod, lodLevel);
+		}
+	}
+}
@@ -0,0 +1,69 @@
+﻿#pragma once
+#include "../global/base.h"
+#include "../core/object3D.h"
+#include "../objects/renderableObject.h"
+#include "../objects/lod.h"
+#include "../lights/light.h"
+
+namespace ff
+{
+	class SkinnedMesh;
+
+	/// 场景树的扁平展开结果，常驻渲染列表(Renderer::mRetainedRenderList)与SceneBVH共用同一套展开规则
+	/// 1 与Renderer::projectObject一致：不可见节点的子树整体跳过，Group决定其子树的groupOrder
+	/// 2 LOD的所有层级都会展开，每个可渲染物体记录所属的LOD以及层级，由使用者按照所选的层级过滤
+	/// 3 已经被静态合批的物体由StaticBatchMesh代为绘制，不会被收集
+	/// 4 记录根节点的层级版本号以及每个已展开节点的可见性，二者都没有变化时展开结果不变，不需要重新收集
+	class SceneCollection
+	{
+	public:
+		struct Renderable
+		{
+			RenderableObject*	mObject{ nullptr };
+			uint32_t			mGroupOrder{ 0 };
+
+			/// 所属的LOD以及层级，不属于任何LOD时为空
+			LOD*				mLOD{ nullptr };
+			uint32_t			mLODLevel{ 0 };
+		};
+
+		SceneCollection() noexcept;
+
+		~SceneCollection() noexcept;
+
+		/// \brief 上一次收集之后，root是否被更换，其层级结构或者任意一个已展开节点的可见性是否发生了变化
+		/// \param root
+		/// \return true则需要重新collect
+		auto isStale(const Object3D::Ptr& root) const noexcept -> bool;
+
+		/// \brief 清空之前的结果，重新展开root
+		/// \param root
+		auto collect(const Object3D::Ptr& root) noexcept -> void;
+
+		/// \brief 使收集结果失效，之后的isStale一定返回true
+		auto invalidate() noexcept -> void { mValid = false; }
+
+		auto getRenderables() const noexcept -> const std::vector<Renderable>& { return mRenderables; }
+
+		auto getLights() const noexcept -> const std::vector<Light::Ptr>& { return mLights; }
+
+		auto getSkinnedMeshes() const noexcept -> const std::vector<SkinnedMesh*>& { return mSkinnedMeshes; }
+
+		auto getLODs() const noexcept -> const std::vector<LOD*>& { return mLODs; }
+
+	private:
+		auto collectNode(const Object3D::Ptr& object, uint32_t groupOrder, LOD* lod, uint32_t lodLevel) noexcept -> void;
+
+	private:
+		/// 收集时的根节点、层级版本号，以及每个已展开节点的可见性
+		bool		mValid{ false };
+		ID			mRootID{ 0 };
+		uint32_t	mHierarchyVersion{ 0 };
+		std::vector<std::pair<Object3D*, bool>>	mNodeVisibility{};
+
+		std::vector<Renderable>		mRenderables{};
+		std::vector<Light::Ptr>		mLights{};
+		std::vector<SkinnedMesh*>	mSkinnedMeshes{};
+		std::vector<LOD*>			mLODs{};
+	};
+}
@@ -0,0 +1,176 @@
+﻿#include "profiler.h"
+
+namespace ff {
+
+	/// 最近邻排名法求百分位，samples需要已经排好序
+	static double percentile(const std::vector<double>& samples, double p) noexcept {
+		if (samples.empty()) return 0.0;
+
+		auto rank = static_cast<size_t>(std::ceil(p * samples.size()));
+		rank = std::clamp<size_t>(rank, 1, samples.size());
+
+		return samples[rank - 1];
+	}
+
+	Profiler* Profiler::mInstance = nullptr;
+	Profiler* Profiler::getInstance() {
+		if (mInstance == nullptr) {
+			mInstance = new Profiler();
+		}
+
+		return mInstance;
+	}
+
+	Profiler::Profiler() noexcept {
+		mFrames.resize(FRAME_HISTORY);
+	}
+
+	Profiler::~Profiler() noexcept {}
+
+	void Profiler::beginFrame() noexcept {
+		/// 环形缓冲，覆盖最老的一帧，vector的clear不会释放内存，稳定之后不会再有内存分配
+		mCurrent = static_cast<uint32_t>(mFrameCount % FRAME_HISTORY);
+
+		auto& frame = mFrames[mCurrent];
+		frame.mFrame = mFrameCount;
+		frame.mTime = 0.0;
+		frame.mScopes.clear();
+
+		mStackSize = 0;
+		mInFrame = true;
+		mFrameBegin = Clock::now();
+	}
+
+	void Profiler::endFrame() noexcept {
+		if (!mInFrame) return;
+
+		/// 正常情况下，此时所有的作用域都已经结束
+		while (mStackSize > 0) {
+			endScope();
+		}
+
+		auto& frame = mFrames[mCurrent];
+		frame.mTime = std::chrono::duration<double, std::milli>(Clock::now() - mFrameBegin).count();
+
+		mFrameCount++;
+		mInFrame = false;
+	}
+
+	void Profiler::beginScope(const char* name) noexcept {
+		if (mStackSize >= MAX_SCOPE_DEPTH) {
+			/// 仍然要入栈，保证与endScope配对
+			mStackSize++;
+			return;
+		}
+
+		auto& open = mStack[mStackSize];
+		open.mIndex = -1;
+
+		if (mInFrame) {
+			auto& scopes = mFrames[mCurrent].mScopes;
+			const int32_t parent = mStackSize > 0 ? mStack[mStackSize - 1].mIndex : -1;
+
+			/// 同一个父作用域下的同名作用域合并，每帧的作用域数量很少，线性查找即可
+			for (int32_t i = 0; i < static_cast<int32_t>(scopes.size()); ++i) {
+				if (scopes[i].mName == name && scopes[i].mParent == parent) {
+					open.mIndex = i;
+					break;
+				}
+			}
+
+			if (open.mIndex < 0) {
+				Scope scope;
+				scope.mName = name;
+				scope.mParent = parent;
+				scope.mDepth = mStackSize;
+
+				open.mIndex = static_cast<int32_t>(scopes.size());
+				scopes.push_back(scope);
+			}
+		}
+
+		mStackSize++;
+		open.mBegin = Clock::now();
+	}
+
+	void Profiler::endScope() noexcept {
+		if (mStackSize == 0) return;
+
+		mStackSize--;
+		if (mStackSize >= MAX_SCOPE_DEPTH) return;
+
+		const auto& open = mStack[mStackSize];
+		if (!mInFrame || open.mIndex < 0) return;
+
+		auto& scope = mFrames[mCurrent].mScopes[open.mIndex];
+		scope.mCalls++;
+		scope.mTime += std::chrono::duration<double, std::milli>(Clock::now() - open.mBegin).count();
+	}
+
+	auto Profiler::getLastFrame() const noexcept -> const Frame& {
+		static const Frame empty{};
+		if (mFrameCount == 0) return empty;
+
+		return mFrames[(mFrameCount - 1) % FRAME_HISTORY];
+	}
+
+	auto Profiler::getScopePath(const Frame& frame, int32_t index) const noexcept -> std::string {
+		const auto& scope = frame.mScopes[index];
+		if (scope.mParent < 0) return scope.mName;
+
+		return getScopePath(frame, scope.mParent) + "/" + scope.mName;
+	}
+
+	auto Profiler::getStatistics() const noexcept -> std::vector<Statistic> {
+		std::vector<Statistic> statistics;
+
+		const auto count = static_cast<uint32_t>(std::min<uint64_t>(mFrameCount, FRAME_HISTORY));
+		if (count == 0) return statistics;
+
+		/// 按照从新到旧的顺序遍历，统计的顺序与最近一帧的作用域顺序一致
+		std::vector<std::vector<double>> samples;
+		std::unordered_map<std::string, size_t> indices;
+
+		Statistic frameStatistic;
+		frameStatistic.mName = "frame";
+		statistics.push_back(frameStatistic);
+		samples.emplace_back();
+
+		for (uint32_t i = 0; i < count; ++i) {
+			const auto& frame = mFrames[(mFrameCount - 1 - i) % FRAME_HISTORY];
+
+			if (i == 0) statistics[0].mLast = frame.mTime;
+			samples[0].push_back(frame.mTime);
+
+			for (int32_t s = 0; s < static_cast<int32_t>(frame.mScopes.size()); ++s) {
+				const auto path = getScopePath(frame, s);
+
+				auto iter = indices.find(path);
+				if (iter == indices.end()) {
+					Statistic statistic;
+					statistic.mName = path;
+					statistic.mDepth = frame.mScopes[s].mDepth;
+					if (i == 0) statistic.mLast = frame.mScopes[s].mTime;
+
+					iter = indices.insert(std::make_pair(path, statistics.size())).first;
+					statistics.push_back(statistic);
+					samples.emplace_back();
+				}
+
+				samples[iter->second].push_back(frame.mScopes[s].mTime);
+			}
+		}
+
+		for (size_t i = 0; i < statistics.size(); ++i) {
+			auto& values = samples[i];
+			std::sort(values.begin(), values.end());
+
+			statistics[i].mSamples = static_cast<uint32_t>(values.size());
+			statistics[i].mP50 = percentile(values, 0.50);
+			statistics[i].mP95 = percentile(values, 0.95);
+			statistics[i].mP99 = percentile(values, 0.99);
+		}
+
+		return statistics;
+	}
+}
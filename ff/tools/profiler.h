@@ -0,0 +1,125 @@
+﻿#pragma once
+#include "../global/base.h"
+#include <array>
+
+namespace ff {
+
+	/// CPU端的帧分析器
+	/// 1 每一次Renderer::render作为一帧，帧内的各个阶段（以及Driver内部嵌套的阶段）以作用域为单位计时
+	/// 2 同一帧内，同一个父作用域下的同名作用域会被合并，只累加耗时与调用次数，保证每帧记录的数量很小
+	/// 3 最近FRAME_HISTORY帧的数据保存在环形缓冲当中，可以统计p50/p95/p99
+	/// 4 只有在编译时开启了FF_ENABLE_PROFILER，下方的宏才会展开，否则不产生任何代码
+	class Profiler {
+	public:
+		static constexpr uint32_t FRAME_HISTORY = 256;
+		static constexpr uint32_t MAX_SCOPE_DEPTH = 32;
+
+		/// 一帧之内的某一个作用域
+		struct Scope {
+			const char* mName{ nullptr };
+
+			/// 父作用域在Frame::mScopes当中的下标，-1表示处于帧的最外层
+			int32_t		mParent{ -1 };
+			uint32_t	mDepth{ 0 };
+
+			/// 本帧之内进入本作用域的次数
+			uint32_t	mCalls{ 0 };
+
+			/// 本帧之内累计的耗时，单位毫秒
+			double		mTime{ 0.0 };
+		};
+
+		struct Frame {
+			uint64_t			mFrame{ 0 };
+
+			/// 整帧耗时，单位毫秒
+			double				mTime{ 0.0 };
+			std::vector<Scope>	mScopes{};
+		};
+
+		/// 某个作用域在最近若干帧中的统计结果，单位毫秒
+		struct Statistic {
+			/// 作用域的完整路径，比如 render/renderScene/setProgram
+			std::string mName{};
+			uint32_t	mDepth{ 0 };
+			uint32_t	mSamples{ 0 };
+			double		mLast{ 0.0 };
+			double		mP50{ 0.0 };
+			double		mP95{ 0.0 };
+			double		mP99{ 0.0 };
+		};
+
+		static Profiler* getInstance();
+
+		~Profiler() noexcept;
+
+		void beginFrame() noexcept;
+
+		void endFrame() noexcept;
+
+		void beginScope(const char* name) noexcept;
+
+		void endScope() noexcept;
+
+		/// \brief 最近一个完整结束的帧
+		/// \return
+		auto getLastFrame() const noexcept -> const Frame&;
+
+		/// \brief 统计环形缓冲中所有帧，第一项为整帧耗时，其余为各个作用域
+		/// \return
+		auto getStatistics() const noexcept -> std::vector<Statistic>;
+
+	private:
+		Profiler() noexcept;
+
+		auto getScopePath(const Frame& frame, int32_t index) const noexcept -> std::string;
+
+	private:
+		static Profiler* mInstance;
+
+		using Clock = std::chrono::high_resolution_clock;
+
+		struct OpenScope {
+			int32_t				mIndex{ -1 };
+			Clock::time_point	mBegin{};
+		};
+
+		std::vector<Frame>	mFrames{};
+
+		/// 当前正在记录的帧在mFrames中的下标
+		uint32_t			mCurrent{ 0 };
+		uint64_t			mFrameCount{ 0 };
+		bool				mInFrame{ false };
+		Clock::time_point	mFrameBegin{};
+
+		std::array<OpenScope, MAX_SCOPE_DEPTH> mStack{};
+		uint32_t			mStackSize{ 0 };
+	};
+
+	/// 作用域计时，构造时开始，析构时结束
+	class ProfileScope {
+	public:
+		explicit ProfileScope(const char* name) noexcept { Profiler::getInstance()->beginScope(name); }
+
+		~ProfileScope() noexcept { Profiler::getInstance()->endScope(); }
+	};
+
+	/// 帧计时，构造时开始一帧，析构时结束一帧
+	class ProfileFrame {
+	public:
+		ProfileFrame() noexcept { Profiler::getInstance()->beginFrame(); }
+
+		~ProfileFrame() noexcept { Profiler::getInstance()->endFrame(); }
+	};
+}
+
+#define FF_PROFILE_CONCAT_IMPL(a, b) a##b
+#define FF_PROFILE_CONCAT(a, b) FF_PROFILE_CONCAT_IMPL(a, b)
+
+#ifdef FF_ENABLE_PROFILER
+#define FF_PROFILE_FRAME() ff::ProfileFrame FF_PROFILE_CONCAT(ffProfileFrame, __LINE__)
+#define FF_PROFILE_SCOPE(name) ff::ProfileScope FF_PROFILE_CONCAT(ffProfileScope, __LINE__)(name)
+#else
+#define FF_PROFILE_FRAME()
+#define FF_PROFILE_SCOPE(name)
+#endif
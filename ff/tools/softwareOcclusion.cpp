@@ -0,0 +1,387 @@
+﻿#include "softwareOcclusion.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define FF_SIMD_AVX2
+#define FF_SIMD_SSE2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FF_SIMD_SSE2
+#endif
+
+namespace ff {
+
+	/// 裁剪空间的w小于这个值，认为顶点跨过了相机所在的平面
+	static constexpr float NEAR_W = 1e-5f;
+
+#if defined(FF_SIMD_AVX2)
+	/// 一次处理8个像素
+	using Lane = __m256;
+	static constexpr uint32_t LANES = 8;
+
+	static inline Lane laneSet(float value) noexcept { return _mm256_set1_ps(value); }
+	static inline Lane laneRamp() noexcept { return _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f); }
+	static inline Lane laneAdd(Lane a, Lane b) noexcept { return _mm256_add_ps(a, b); }
+	static inline Lane laneMul(Lane a, Lane b) noexcept { return _mm256_mul_ps(a, b); }
+	static inline Lane laneMin(Lane a, Lane b) noexcept { return _mm256_min_ps(a, b); }
+	static inline Lane laneLoad(const float* data) noexcept { return _mm256_loadu_ps(data); }
+	static inline void laneStore(float* data, Lane value) noexcept { _mm256_storeu_ps(data, value); }
+	static inline Lane laneInside(Lane e0, Lane e1, Lane e2) noexcept {
+		const auto zero = _mm256_setzero_ps();
+		return _mm256_and_ps(_mm256_and_ps(_mm256_cmp_ps(e0, zero, _CMP_GE_OQ), _mm256_cmp_ps(e1, zero, _CMP_GE_OQ)), _mm256_cmp_ps(e2, zero, _CMP_GE_OQ));
+	}
+	static inline int laneAny(Lane mask) noexcept { return _mm256_movemask_ps(mask); }
+	static inline Lane laneSelect(Lane mask, Lane a, Lane b) noexcept { return _mm256_blendv_ps(b, a, mask); }
+#elif defined(FF_SIMD_SSE2)
+	/// 一次处理4个像素
+	using Lane = __m128;
+	static constexpr uint32_t LANES = 4;
+
+	static inline Lane laneSet(float value) noexcept { return _mm_set1_ps(value); }
+	static inline Lane laneRamp() noexcept { return _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f); }
+	static inline Lane laneAdd(Lane a, Lane b) noexcept { return _mm_add_ps(a, b); }
+	static inline Lane laneMul(Lane a, Lane b) noexcept { return _mm_mul_ps(a, b); }
+	static inline Lane laneMin(Lane a, Lane b) noexcept { return _mm_min_ps(a, b); }
+	static inline Lane laneLoad(const float* data) noexcept { return _mm_loadu_ps(data); }
+	static inline void laneStore(float* data, Lane value) noexcept { _mm_storeu_ps(data, value); }
+	static inline Lane laneInside(Lane e0, Lane e1, Lane e2) noexcept {
+		const auto zero = _mm_setzero_ps();
+		return _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)), _mm_cmpge_ps(e2, zero));
+	}
+	static inline int laneAny(Lane mask) noexcept { return _mm_movemask_ps(mask); }
+	/// SSE2没有blendv，使用与或代替
+	static inline Lane laneSelect(Lane mask, Lane a, Lane b) noexcept { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+#endif
+
+	/// 三角形一条边的边函数E(x, y) = A * x + B * y + C，三角形逆时针时内部为正
+	struct Edge {
+		float mA{ 0.0f };
+		float mB{ 0.0f };
+		float mC{ 0.0f };
+
+		Edge(const glm::vec4& from, const glm::vec4& to) noexcept {
+			mA = from.y - to.y;
+			mB = to.x - from.x;
+			mC = -mA * from.x - mB * from.y;
+		}
+
+		auto at(float x, float y) const noexcept -> float { return mA * x + mB * y + mC; }
+	};
+
+	SoftwareOcclusion::SoftwareOcclusion(uint32_t width, uint32_t height) noexcept {
+		/// 每一行按照8个像素一组处理
+		mWidth = std::max(8u, (width + 7u) & ~7u);
+		mHeight = std::max(1u, height);
+
+		uint32_t levelWidth = mWidth;
+		uint32_t levelHeight = mHeight;
+		while (true) {
+			Level level;
+			level.mWidth = levelWidth;
+			level.mHeight = levelHeight;
+			level.mDepths.resize(static_cast<size_t>(levelWidth) * levelHeight, 1.0f);
+			mLevels.push_back(std::move(level));
+
+			if (levelWidth == 1 && levelHeight == 1) break;
+
+			levelWidth = (levelWidth + 1) / 2;
+			levelHeight = (levelHeight + 1) / 2;
+		}
+	}
+
+	SoftwareOcclusion::~SoftwareOcclusion() noexcept {}
+
+	auto SoftwareOcclusion::begin(const glm::mat4& viewProjectionMatrix) noexcept -> void {
+		mViewProjectionMatrix = viewProjectionMatrix;
+		mStats = {};
+
+		std::fill(mLevels[0].mDepths.begin(), mLevels[0].mDepths.end(), 1.0f);
+	}
+
+	auto SoftwareOcclusion::rasterizeOccluder(const RenderableObject* object) noexcept -> void {
+		if (object->getMaterial() && object->getMaterial()->mDrawMode != DrawMode::Triangles) {
+			return;
+		}
+
+		const auto& geometry = object->mOccluderGeometry != nullptr ? object->mOccluderGeometry : object->getGeometry();
+		if (geometry == nullptr) {
+			return;
+		}
+
+		const auto position = geometry->getAttribute("position");
+		if (position == nullptr || position->getItemSize() != 3) {
+			return;
+		}
+
+		mStats.mOccluders++;
+
+		const auto& index = geometry->getIndex();
+		if (index != nullptr) {
+			rasterizeTriangles(object->getWorldMatrix(), position->getData(), index->getData().data(), index->getCount());
+		}
+		else {
+			rasterizeTriangles(object->getWorldMatrix(), position->getData(), nullptr, position->getCount());
+		}
+	}
+
+	auto SoftwareOcclusion::transformVertices(const glm::mat4& mvp, const std::vector<float>& positions) noexcept -> void {
+		const size_t count = positions.size() / 3;
+		mScreenVertices.resize(count);
+
+		const float width = static_cast<float>(mWidth);
+		const float height = static_cast<float>(mHeight);
+
+#if defined(FF_SIMD_SSE2)
+		/// 矩阵按列存放，一个顶点的变换为四列的线性组合
+		const __m128 c0 = _mm_loadu_ps(glm::value_ptr(mvp[0]));
+		const __m128 c1 = _mm_loadu_ps(glm::value_ptr(mvp[1]));
+		const __m128 c2 = _mm_loadu_ps(glm::value_ptr(mvp[2]));
+		const __m128 c3 = _mm_loadu_ps(glm::value_ptr(mvp[3]));
+#endif
+
+		for (size_t i = 0; i < count; ++i) {
+			const float* p = positions.data() + i * 3;
+
+#if defined(FF_SIMD_SSE2)
+			const __m128 clip = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(c0, _mm_set1_ps(p[0])), _mm_mul_ps(c1, _mm_set1_ps(p[1]))),
+				_mm_add_ps(_mm_mul_ps(c2, _mm_set1_ps(p[2])), c3));
+
+			glm::vec4 result;
+			_mm_storeu_ps(glm::value_ptr(result), clip);
+#else
+			const glm::vec4 result = mvp * glm::vec4(p[0], p[1], p[2], 1.0f);
+#endif
+
+			auto& vertex = mScreenVertices[i];
+			vertex.w = result.w;
+			if (result.w <= NEAR_W) {
+				continue;
+			}
+
+			const float inverseW = 1.0f / result.w;
+			vertex.x = (result.x * inverseW * 0.5f + 0.5f) * width;
+			vertex.y = (result.y * inverseW * 0.5f + 0.5f) * height;
+			vertex.z = result.z * inverseW * 0.5f + 0.5f;
+		}
+	}
+
+	auto SoftwareOcclusion::rasterizeTriangles(const glm::mat4& modelMatrix, const std::vector<float>& positions, const uint32_t* indices, uint32_t count) noexcept -> void {
+		transformVertices(mViewProjectionMatrix * modelMatrix, positions);
+
+		const auto vertexCount = static_cast<uint32_t>(mScreenVertices.size());
+
+		for (uint32_t i = 0; i + 2 < count; i += 3) {
+			const uint32_t i0 = indices ? indices[i] : i;
+			const uint32_t i1 = indices ? indices[i + 1] : i + 1;
+			const uint32_t i2 = indices ? indices[i + 2] : i + 2;
+			if (i0 >= vertexCount || i1 >= vertexCount || i2 >= vertexCount) continue;
+
+			const auto& v0 = mScreenVertices[i0];
+			const auto& v1 = mScreenVertices[i1];
+			const auto& v2 = mScreenVertices[i2];
+
+			/// 跨过相机所在平面或者在近平面之前的三角形，GPU上只会画出一部分，直接丢弃
+			if (v0.w <= NEAR_W || v1.w <= NEAR_W || v2.w <= NEAR_W) continue;
+			if (v0.z < 0.0f || v1.z < 0.0f || v2.z < 0.0f) continue;
+
+			rasterizeTriangle(v0, v1, v2);
+			mStats.mTriangles++;
+		}
+	}
+
+	auto SoftwareOcclusion::rasterizeTriangle(const glm::vec4& v0, const glm::vec4& v1, const glm::vec4& v2) noexcept -> void {
+		float area = (v1.x - v0.x) * (v2.y - v0.y) - (v1.y - v0.y) * (v2.x - v0.x);
+		if (std::abs(area) < 1e-8f) {
+			return;
+		}
+
+		/// 遮挡物的正反面都参与光栅化，统一成逆时针
+		const glm::vec4* a = &v0;
+		const glm::vec4* b = &v1;
+		const glm::vec4* c = &v2;
+		if (area < 0.0f) {
+			std::swap(b, c);
+			area = -area;
+		}
+
+		const int32_t x0 = std::max(0, static_cast<int32_t>(std::floor(std::min({ a->x, b->x, c->x }))));
+		const int32_t x1 = std::min(static_cast<int32_t>(mWidth) - 1, static_cast<int32_t>(std::ceil(std::max({ a->x, b->x, c->x }))));
+		const int32_t y0 = std::max(0, static_cast<int32_t>(std::floor(std::min({ a->y, b->y, c->y }))));
+		const int32_t y1 = std::min(static_cast<int32_t>(mHeight) - 1, static_cast<int32_t>(std::ceil(std::max({ a->y, b->y, c->y }))));
+		if (x0 > x1 || y0 > y1) {
+			return;
+		}
+
+		/// 三条边的边函数除以面积，就是对面顶点的重心坐标
+		const Edge eBC(*b, *c);
+		const Edge eCA(*c, *a);
+		const Edge eAB(*a, *b);
+
+		/// 屏幕空间中ndc深度是线性的：z(x, y) = zA * x + zB * y + zC
+		const float inverseArea = 1.0f / area;
+		const float zA = (eBC.mA * a->z + eCA.mA * b->z + eAB.mA * c->z) * inverseArea;
+		const float zB = (eBC.mB * a->z + eCA.mB * b->z + eAB.mB * c->z) * inverseArea;
+		const float zC = (eBC.mC * a->z + eCA.mC * b->z + eAB.mC * c->z) * inverseArea;
+
+		auto& depths = mLevels[0].mDepths;
+
+#if defined(FF_SIMD_SSE2)
+		/// 按照LANES对齐起点，宽度是8的倍数，每一组都不会越过行尾；组内三角形之外的像素由边函数排除
+		const int32_t xStart = x0 & ~static_cast<int32_t>(LANES - 1);
+		const float step = static_cast<float>(LANES);
+
+		const Lane ramp = laneRamp();
+		const Lane stepE0 = laneSet(eBC.mA * step);
+		const Lane stepE1 = laneSet(eCA.mA * step);
+		const Lane stepE2 = laneSet(eAB.mA * step);
+		const Lane stepZ = laneSet(zA * step);
+
+		for (int32_t y = y0; y <= y1; ++y) {
+			const float py = static_cast<float>(y) + 0.5f;
+			const Lane px = laneAdd(laneSet(static_cast<float>(xStart) + 0.5f), ramp);
+
+			Lane e0 = laneAdd(laneMul(laneSet(eBC.mA), px), laneSet(eBC.mB * py + eBC.mC));
+			Lane e1 = laneAdd(laneMul(laneSet(eCA.mA), px), laneSet(eCA.mB * py + eCA.mC));
+			Lane e2 = laneAdd(laneMul(laneSet(eAB.mA), px), laneSet(eAB.mB * py + eAB.mC));
+			Lane z = laneAdd(laneMul(laneSet(zA), px), laneSet(zB * py + zC));
+
+			float* row = depths.data() + static_cast<size_t>(y) * mWidth;
+
+			for (int32_t x = xStart; x <= x1; x += LANES) {
+				const Lane inside = laneInside(e0, e1, e2);
+				if (laneAny(inside)) {
+					const Lane old = laneLoad(row + x);
+					laneStore(row + x, laneSelect(inside, laneMin(old, z), old));
+				}
+
+				e0 = laneAdd(e0, stepE0);
+				e1 = laneAdd(e1, stepE1);
+				e2 = laneAdd(e2, stepE2);
+				z = laneAdd(z, stepZ);
+			}
+		}
+#else
+		for (int32_t y = y0; y <= y1; ++y) {
+			const float py = static_cast<float>(y) + 0.5f;
+			float* row = depths.data() + static_cast<size_t>(y) * mWidth;
+
+			for (int32_t x = x0; x <= x1; ++x) {
+				const float px = static_cast<float>(x) + 0.5f;
+				if (eBC.at(px, py) < 0.0f || eCA.at(px, py) < 0.0f || eAB.at(px, py) < 0.0f) continue;
+
+				row[x] = std::min(row[x], zA * px + zB * py + zC);
+			}
+		}
+#endif
+	}
+
+	auto SoftwareOcclusion::finish() noexcept -> void {
+		/// 上一层2x2当中最远的深度，奇数尺寸时边缘只有1x2或者2x1
+		for (size_t i = 1; i < mLevels.size(); ++i) {
+			const auto& source = mLevels[i - 1];
+			auto& target = mLevels[i];
+
+			for (uint32_t y = 0; y < target.mHeight; ++y) {
+				const uint32_t sy0 = y * 2;
+				const uint32_t sy1 = std::min(sy0 + 1, source.mHeight - 1);
+
+				for (uint32_t x = 0; x < target.mWidth; ++x) {
+					const uint32_t sx0 = x * 2;
+					const uint32_t sx1 = std::min(sx0 + 1, source.mWidth - 1);
+
+					target.mDepths[static_cast<size_t>(y) * target.mWidth + x] = std::max(
+						std::max(source.mDepths[static_cast<size_t>(sy0) * source.mWidth + sx0], source.mDepths[static_cast<size_t>(sy0) * source.mWidth + sx1]),
+						std::max(source.mDepths[static_cast<size_t>(sy1) * source.mWidth + sx0], source.mDepths[static_cast<size_t>(sy1) * source.mWidth + sx1]));
+				}
+			}
+		}
+	}
+
+	auto SoftwareOcclusion::isOccluded(const RenderableObject* object) noexcept -> bool {
+		/// 遮挡物的表面与自己的包围盒重合时，插值误差会让它挡住自己
+		if (object->mOccluder || object->mIsInstancedMesh || object->mIsStaticBatchMesh || object->mIsSkinnedMesh) {
+			return false;
+		}
+
+		const auto& geometry = object->getGeometry();
+		if (geometry->getBoundingBox() == nullptr) {
+			geometry->computeBoundingBox();
+		}
+
+		const auto box = geometry->getBoundingBox();
+		if (box == nullptr || box->isEmpty()) {
+			return false;
+		}
+
+		return isOccluded(object->getWorldMatrix(), box->mMin, box->mMax);
+	}
+
+	auto SoftwareOcclusion::isOccluded(const glm::mat4& modelMatrix, const glm::vec3& min, const glm::vec3& max) noexcept -> bool {
+		mStats.mTested++;
+
+		const auto mvp = mViewProjectionMatrix * modelMatrix;
+
+		glm::vec3 screenMin(std::numeric_limits<float>::infinity());
+		glm::vec3 screenMax(-std::numeric_limits<float>::infinity());
+
+		for (uint32_t i = 0; i < 8; ++i) {
+			const glm::vec4 corner(
+				(i & 1) ? max.x : min.x,
+				(i & 2) ? max.y : min.y,
+				(i & 4) ? max.z : min.z,
+				1.0f);
+
+			const auto clip = mvp * corner;
+
+			/// 包围盒跨过了相机所在的平面
+			if (clip.w <= NEAR_W) {
+				return false;
+			}
+
+			const glm::vec3 screen(
+				(clip.x / clip.w * 0.5f + 0.5f) * static_cast<float>(mWidth),
+				(clip.y / clip.w * 0.5f + 0.5f) * static_cast<float>(mHeight),
+				clip.z / clip.w * 0.5f + 0.5f);
+
+			screenMin = glm::min(screenMin, screen);
+			screenMax = glm::max(screenMax, screen);
+		}
+
+		/// 包围盒跨过了近平面
+		if (screenMin.z < 0.0f) {
+			return false;
+		}
+
+		int32_t x0 = std::max(0, static_cast<int32_t>(std::floor(screenMin.x)));
+		int32_t x1 = std::min(static_cast<int32_t>(mWidth) - 1, static_cast<int32_t>(std::floor(screenMax.x)));
+		int32_t y0 = std::max(0, static_cast<int32_t>(std::floor(screenMin.y)));
+		int32_t y1 = std::min(static_cast<int32_t>(mHeight) - 1, static_cast<int32_t>(std::floor(screenMax.y)));
+
+		/// 完全在屏幕之外，交给视景体剪裁处理
+		if (x0 > x1 || y0 > y1) {
+			return false;
+		}
+
+		/// 选择屏幕矩形不超过MAX_TEST_TEXELS个texel的那一层
+		size_t level = 0;
+		while (level + 1 < mLevels.size() &&
+			((x1 >> level) - (x0 >> level) >= static_cast<int32_t>(MAX_TEST_TEXELS) ||
+			 (y1 >> level) - (y0 >> level) >= static_cast<int32_t>(MAX_TEST_TEXELS))) {
+			++level;
+		}
+
+		const auto& hiz = mLevels[level];
+		for (int32_t y = y0 >> level; y <= (y1 >> level); ++y) {
+			for (int32_t x = x0 >> level; x <= (x1 >> level); ++x) {
+				if (hiz.mDepths[static_cast<size_t>(y) * hiz.mWidth + x] >= screenMin.z) {
+					return false;
+				}
+			}
+		}
+
+		mStats.mCulled++;
+
+		return true;
+	}
+}
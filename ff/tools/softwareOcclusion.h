@@ -0,0 +1,105 @@
+﻿#pragma once
+#include "../global/base.h"
+#include "../objects/renderableObject.h"
+
+namespace ff {
+
+	/// CPU软件遮挡剔除，不依赖opengl，没有GPU回读的延迟，也可以脱离Renderer单独测试
+	/// 1 begin：设置本帧的投影*视图矩阵，清空低分辨率的深度缓冲
+	/// 2 rasterizeOccluder：将标记为mOccluder的物体(有mOccluderGeometry时使用这个简化的geometry)光栅化进深度缓冲，
+	///   顶点变换与逐像素的边函数、深度插值都使用SIMD(AVX2一次8个像素，SSE2一次4个像素，都没有时逐像素)
+	/// 3 finish：由深度缓冲生成Hi-Z金字塔，每一层的texel保存下一层2x2当中最远的深度
+	/// 4 isOccluded：物体geometry包围盒的八个顶点投影到屏幕，得到屏幕矩形与最近的深度，
+	///   在矩形足够小的那一层上，所有覆盖到的texel都比它近，则物体被遮挡
+	/// 注意：跨过相机所在平面的遮挡三角形会被直接丢弃，跨过相机所在平面的包围盒总是视为可见，二者都是保守的处理；
+	/// 遮挡物自身，以及包围盒不可靠的InstancedMesh、StaticBatchMesh与骨骼动画，不参与测试
+	class SoftwareOcclusion {
+	public:
+		/// 宽度需要是8的倍数
+		static constexpr uint32_t DEFAULT_WIDTH = 256;
+		static constexpr uint32_t DEFAULT_HEIGHT = 128;
+
+		/// 测试时，屏幕矩形在所选层级上不超过这么多个texel
+		static constexpr uint32_t MAX_TEST_TEXELS = 4;
+
+		struct Stats {
+			uint32_t	mOccluders{ 0 };
+			uint32_t	mTriangles{ 0 };
+			uint32_t	mTested{ 0 };
+			uint32_t	mCulled{ 0 };
+		};
+
+		using Ptr = std::shared_ptr<SoftwareOcclusion>;
+		static Ptr create(uint32_t width = DEFAULT_WIDTH, uint32_t height = DEFAULT_HEIGHT) {
+			return std::make_shared<SoftwareOcclusion>(width, height);
+		}
+
+		SoftwareOcclusion(uint32_t width, uint32_t height) noexcept;
+
+		~SoftwareOcclusion() noexcept;
+
+		/// \brief 开始新的一帧
+		/// \param viewProjectionMatrix 投影矩阵*视图矩阵
+		auto begin(const glm::mat4& viewProjectionMatrix) noexcept -> void;
+
+		/// \brief 光栅化一个遮挡物，调用之前其worldMatrix需要是最新的
+		/// \param object
+		auto rasterizeOccluder(const RenderableObject* object) noexcept -> void;
+
+		/// \brief 光栅化一组三角形
+		/// \param modelMatrix
+		/// \param positions	xyz依次存放的顶点
+		/// \param indices		为nullptr时每三个顶点构成一个三角形
+		/// \param count		index数量(或者顶点数量)
+		auto rasterizeTriangles(const glm::mat4& modelMatrix, const std::vector<float>& positions, const uint32_t* indices, uint32_t count) noexcept -> void;
+
+		/// \brief 所有遮挡物光栅化完毕之后调用，生成Hi-Z金字塔
+		auto finish() noexcept -> void;
+
+		/// \brief 物体是否被遮挡
+		/// \param object
+		/// \return
+		auto isOccluded(const RenderableObject* object) noexcept -> bool;
+
+		/// \brief 局部空间的包围盒是否被遮挡
+		/// \param modelMatrix
+		/// \param min
+		/// \param max
+		/// \return
+		auto isOccluded(const glm::mat4& modelMatrix, const glm::vec3& min, const glm::vec3& max) noexcept -> bool;
+
+		auto getStats() const noexcept -> const Stats& { return mStats; }
+
+		auto getWidth() const noexcept -> uint32_t { return mWidth; }
+
+		auto getHeight() const noexcept -> uint32_t { return mHeight; }
+
+		/// \brief 深度缓冲，[0,1]，1为最远，第一行对应ndc的y = -1
+		auto getDepthBuffer() const noexcept -> const std::vector<float>& { return mLevels[0].mDepths; }
+
+	private:
+		struct Level {
+			uint32_t			mWidth{ 0 };
+			uint32_t			mHeight{ 0 };
+			std::vector<float>	mDepths{};
+		};
+
+		/// 变换到屏幕空间之后的顶点：x、y为像素坐标，z为[0,1]的深度，w为裁剪空间的w
+		auto transformVertices(const glm::mat4& mvp, const std::vector<float>& positions) noexcept -> void;
+
+		auto rasterizeTriangle(const glm::vec4& v0, const glm::vec4& v1, const glm::vec4& v2) noexcept -> void;
+
+	private:
+		uint32_t	mWidth{ 0 };
+		uint32_t	mHeight{ 0 };
+
+		glm::mat4	mViewProjectionMatrix{ 1.0f };
+
+		/// 第0层即为深度缓冲
+		std::vector<Level>		mLevels{};
+
+		std::vector<glm::vec4>	mScreenVertices{};
+
+		Stats		mStats{};
+	};
+}
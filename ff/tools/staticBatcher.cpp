@@ -0,0 +1,208 @@
+﻿#include "staticBatcher.h"
+
+namespace ff {
+
+	auto StaticBatcher::batch(const Object3D::Ptr& root) noexcept -> std::vector<StaticBatchMesh::Ptr>
+	{
+		std::vector<StaticBatchMesh::Ptr> batches;
+
+		/// 保证世界矩阵是最新的
+		root->updateWorldMatrix(true, true);
+
+		std::vector<RenderableObject::Ptr> meshes;
+		collect(root, meshes);
+
+		/// 分组的key：materialID | castShadow | 每个attribute的名字与itemSize
+		/// 只有attribute组成完全相同的物体才能合并，否则shader的宏定义不同，且合并后的数据无法对齐
+		std::map<std::string, std::vector<RenderableObject::Ptr>> groups;
+		for (const auto& mesh : meshes) {
+			std::vector<std::string> attributeKeys;
+			for (const auto& iter : mesh->getGeometry()->getAttributes()) {
+				attributeKeys.push_back(iter.first + ":" + std::to_string(iter.second->getItemSize()));
+			}
+			std::sort(attributeKeys.begin(), attributeKeys.end());
+
+			std::string key = std::to_string(mesh->getMaterial()->getID()) + "|" + std::to_string(mesh->mCastShadow);
+			for (const auto& attributeKey : attributeKeys) {
+				key += "|" + attributeKey;
+			}
+
+			groups[key].push_back(mesh);
+		}
+
+		for (const auto& group : groups) {
+			batches.push_back(merge(group.second));
+		}
+
+		return batches;
+	}
+
+	auto StaticBatcher::unbatch(const std::vector<StaticBatchMesh::Ptr>& batches) noexcept -> void
+	{
+		for (const auto& batch : batches) {
+			for (const auto& range : batch->getRanges()) {
+				if (const auto source = range.mSource.lock(); source != nullptr) {
+					source->mStaticBatched = false;
+				}
+			}
+		}
+	}
+
+	auto StaticBatcher::collect(const Object3D::Ptr& object, std::vector<RenderableObject::Ptr>& meshes) noexcept -> void
+	{
+		/// 不可见的子树本来就不会被绘制，不能合并进去
+		if (!object->mVisible) return;
+
+		if (object->mIsMesh
+			&& !object->mIsSkinnedMesh
+			&& !object->mIsInstancedMesh
+			&& !object->mIsStaticBatchMesh)
+		{
+			const auto mesh = std::static_pointer_cast<RenderableObject>(object);
+			/// 透明物体需要逐个由远到近绘制，不能合并
+			if (mesh->mStatic
+				&& !mesh->mStaticBatched
+				&& !mesh->getMaterial()->mTransparent
+				&& mesh->mOnBeforeRenderCallback == nullptr
+				&& mesh->getGeometry()->hasAttribute("position"))
+			{
+				/// 缩放为0等退化的worldMatrix没有逆矩阵，normal会变成NaN，这样的物体保持单独绘制
+				if (std::abs(glm::determinant(glm::mat3(mesh->getWorldMatrix()))) < DEGENERATE_EPSILON) {
+					std::cout << "Warning: StaticBatcher skips mesh " << mesh->mName << " with a degenerate world matrix" << std::endl;
+				}
+				else {
+					meshes.push_back(mesh);
+				}
+			}
+		}
+
+		for (const auto& child : object->getChildren()) {
+			collect(child, meshes);
+		}
+	}
+
+	/// 1 position使用worldMatrix变换，normal使用其逆转置矩阵变换，tangent/bitangent使用worldMatrix的旋转缩放部分变换；
+	///   4分量的tangent只变换xyz，w为副切线的方向，镜像变换时取反，保证重建出的副切线与变换之后的一致
+	/// 2 没有index的geometry生成顺序index，所有index加上本物体在合并数组中的顶点偏移
+	/// 3 worldMatrix为镜像变换(行列式小于0)时，三角形的环绕方向会反过来，需要交换每个三角形的后两个顶点
+	auto StaticBatcher::merge(const std::vector<RenderableObject::Ptr>& meshes) noexcept -> StaticBatchMesh::Ptr
+	{
+		const auto& material = meshes.front()->getMaterial();
+
+		std::unordered_map<std::string, std::vector<float>> attributeDatas;
+		std::unordered_map<std::string, uint32_t> itemSizes;
+		for (const auto& iter : meshes.front()->getGeometry()->getAttributes()) {
+			attributeDatas[iter.first] = {};
+			itemSizes[iter.first] = iter.second->getItemSize();
+		}
+
+		std::vector<uint32_t> indices;
+		std::vector<std::tuple<RenderableObject::Ptr, uint32_t, uint32_t, Sphere::Ptr>> ranges;
+
+		uint32_t vertexBase = 0;
+		for (const auto& mesh : meshes) {
+			const auto& geometry = mesh->getGeometry();
+			const auto worldMatrix = mesh->getWorldMatrix();
+			const auto rotateMatrix = glm::mat3(worldMatrix);
+			const auto normalMatrix = glm::transpose(glm::inverse(rotateMatrix));
+			const bool mirrored = glm::determinant(rotateMatrix) < 0.0f;
+
+			const auto vertexCount = geometry->getAttribute("position")->getCount();
+
+			for (const auto& iter : geometry->getAttributes()) {
+				const auto& name = iter.first;
+				const auto& data = iter.second->getData();
+				auto& mergedData = attributeDatas[name];
+
+				const bool isVector = iter.second->getItemSize() == 3
+					&& (name == "position" || name == "normal" || name == "tangent" || name == "bitangent");
+
+				const bool isTangent4 = iter.second->getItemSize() == 4 && name == "tangent";
+
+				if (isVector) {
+					for (uint32_t i = 0; i < vertexCount; ++i) {
+						glm::vec3 value(data[i * 3], data[i * 3 + 1], data[i * 3 + 2]);
+
+						if (name == "position") {
+							value = glm::vec3(worldMatrix * glm::vec4(value, 1.0f));
+						}
+						else if (name == "normal") {
+							value = glm::normalize(normalMatrix * value);
+						}
+						else {
+							value = glm::normalize(rotateMatrix * value);
+						}
+
+						mergedData.push_back(value.x);
+						mergedData.push_back(value.y);
+						mergedData.push_back(value.z);
+					}
+				}
+				else if (isTangent4) {
+					for (uint32_t i = 0; i < vertexCount; ++i) {
+						const auto value = glm::normalize(rotateMatrix * glm::vec3(data[i * 4], data[i * 4 + 1], data[i * 4 + 2]));
+						const auto handedness = mirrored ? -data[i * 4 + 3] : data[i * 4 + 3];
+
+						mergedData.push_back(value.x);
+						mergedData.push_back(value.y);
+						mergedData.push_back(value.z);
+						mergedData.push_back(handedness);
+					}
+				}
+				else {
+					mergedData.insert(mergedData.end(), data.begin(), data.end());
+				}
+			}
+
+			const auto indexOffset = static_cast<uint32_t>(indices.size());
+			const auto& index = geometry->getIndex();
+			if (index != nullptr) {
+				for (const auto value : index->getData()) {
+					indices.push_back(vertexBase + value);
+				}
+			}
+			else {
+				for (uint32_t i = 0; i < vertexCount; ++i) {
+					indices.push_back(vertexBase + i);
+				}
+			}
+			const auto indexCount = static_cast<uint32_t>(indices.size()) - indexOffset;
+
+			if (material->mDrawMode == DrawMode::Triangles && mirrored) {
+				for (uint32_t i = indexOffset; i + 2 < indexOffset + indexCount; i += 3) {
+					std::swap(indices[i + 1], indices[i + 2]);
+				}
+			}
+
+			/// 源物体在世界坐标系下的包围球，用于逐个子区间的剪裁
+			if (geometry->getBoundingSphere() == nullptr) {
+				geometry->computeBoundingSphere();
+			}
+			auto boundingSphere = Sphere::create(glm::vec3(0.0f), 0.0f);
+			boundingSphere->copy(geometry->getBoundingSphere());
+			boundingSphere->applyMatrix4(worldMatrix);
+
+			ranges.emplace_back(mesh, indexOffset, indexCount, boundingSphere);
+
+			vertexBase += vertexCount;
+			mesh->mStaticBatched = true;
+		}
+
+		auto mergedGeometry = Geometry::create();
+		for (auto& iter : attributeDatas) {
+			mergedGeometry->setAttribute(iter.first, Attributef::create(iter.second, itemSizes[iter.first]));
+		}
+		mergedGeometry->setIndex(Attributei::create(indices, 1));
+		mergedGeometry->computeBoundingSphere();
+
+		auto batch = StaticBatchMesh::create(mergedGeometry, material);
+		batch->mCastShadow = meshes.front()->mCastShadow;
+		batch->mName = "staticBatch";
+
+		for (const auto& [source, indexOffset, indexCount, boundingSphere] : ranges) {
+			batch->addRange(source, indexOffset, indexCount, boundingSphere);
+		}
+
+		return batch;
+	}
+}
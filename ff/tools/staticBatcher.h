@@ -0,0 +1,32 @@
+﻿#pragma once
+#include "../global/base.h"
+#include "../core/object3D.h"
+#include "../objects/staticBatchMesh.h"
+
+namespace ff {
+
+	/// 静态合批
+	/// 1 把子树当中所有标记为mStatic的非透明Mesh，按照material(以及attribute的组成、是否产生阴影)分组
+	/// 2 每一组的顶点变换到世界坐标系之后，合并为一个Geometry，生成一个StaticBatchMesh
+	/// 3 源物体仍然保留在场景当中，用于拾取等用途，但是被标记为mStaticBatched，不再单独绘制
+	/// 4 生成的StaticBatchMesh需要由调用者加入到场景当中，并且不能挂在有变换的节点之下
+	class StaticBatcher {
+	public:
+		/// \brief 合并root子树当中的所有静态Mesh
+		/// \param root
+		/// \return 每一组生成一个StaticBatchMesh
+		static auto batch(const Object3D::Ptr& root) noexcept -> std::vector<StaticBatchMesh::Ptr>;
+
+		/// \brief 撤销合并，源物体恢复单独绘制，调用者需要自行将StaticBatchMesh从场景中移除
+		/// \param batches
+		static auto unbatch(const std::vector<StaticBatchMesh::Ptr>& batches) noexcept -> void;
+
+	private:
+		/// worldMatrix旋转缩放部分的行列式绝对值小于该值时，视为退化矩阵，不参与合并
+		static constexpr float DEGENERATE_EPSILON = 1e-12f;
+
+		static auto collect(const Object3D::Ptr& object, std::vector<RenderableObject::Ptr>& meshes) noexcept -> void;
+
+		static auto merge(const std::vector<RenderableObject::Ptr>& meshes) noexcept -> StaticBatchMesh::Ptr;
+	};
+}
@@ -0,0 +1,113 @@
+﻿#include "glTrace.h"
+
+namespace ff {
+
+	GLTrace* GLTrace::mInstance = nullptr;
+	GLTrace* GLTrace::getInstance() {
+		if (mInstance == nullptr) {
+			mInstance = new GLTrace();
+		}
+
+		return mInstance;
+	}
+
+	GLTrace::GLTrace() noexcept {
+		mFrames.resize(FRAME_HISTORY);
+	}
+
+	GLTrace::~GLTrace() noexcept {}
+
+	auto GLTrace::registerEntry(const char* name) noexcept -> uint32_t {
+		for (uint32_t i = 0; i < mEntries.size(); ++i) {
+			if (mEntries[i].mName == name) {
+				return i;
+			}
+		}
+
+		Entry entry;
+		entry.mName = name;
+		entry.mIsTextureBind = entry.mName == "glBindTexture";
+		entry.mIsActiveTexture = entry.mName == "glActiveTexture";
+
+		mEntries.push_back(entry);
+
+		return static_cast<uint32_t>(mEntries.size() - 1);
+	}
+
+	auto GLTrace::onCall(uint32_t entry) noexcept -> void {
+		if (!mInFrame) {
+			return;
+		}
+
+		auto& frame = mFrames[mCurrent];
+
+		/// 新注册的入口，直方图随之变长
+		if (frame.mCalls.size() <= entry) {
+			frame.mCalls.resize(mEntries.size(), 0);
+			frame.mRedundantBinds.resize(mEntries.size(), 0);
+		}
+
+		frame.mCalls[entry]++;
+		frame.mTotalCalls++;
+	}
+
+	auto GLTrace::onBindValues(uint32_t entry, const uint64_t* values, size_t count) noexcept -> void {
+		if (count == 0) {
+			return;
+		}
+
+		const uint64_t object = values[count - 1];
+
+		/// 绑定点：入口编号 + 除最后一个之外的参数，glBindTexture还要加上当前的textureUnit
+		uint64_t point = entry;
+		for (size_t i = 0; i + 1 < count; ++i) {
+			point ^= values[i] + 0x9e3779b97f4a7c15ull + (point << 6) + (point >> 2);
+		}
+
+		if (mEntries[entry].mIsTextureBind) {
+			point ^= mActiveTexture + 0x9e3779b97f4a7c15ull + (point << 6) + (point >> 2);
+		}
+
+		if (mEntries[entry].mIsActiveTexture) {
+			mActiveTexture = object;
+		}
+
+		/// 帧之外的绑定只更新记录，不计入统计
+		auto [iter, inserted] = mBindings.try_emplace(point, object);
+		if (!inserted) {
+			if (iter->second == object && mInFrame) {
+				auto& frame = mFrames[mCurrent];
+				frame.mRedundantBinds[entry]++;
+				frame.mTotalRedundantBinds++;
+			}
+
+			iter->second = object;
+		}
+	}
+
+	void GLTrace::beginFrame() noexcept {
+		/// 环形缓冲，覆盖最老的一帧
+		mCurrent = static_cast<uint32_t>(mFrameCount % FRAME_HISTORY);
+
+		auto& frame = mFrames[mCurrent];
+		frame.mFrame = mFrameCount;
+		frame.mTotalCalls = 0;
+		frame.mTotalRedundantBinds = 0;
+		frame.mCalls.assign(mEntries.size(), 0);
+		frame.mRedundantBinds.assign(mEntries.size(), 0);
+
+		mInFrame = true;
+	}
+
+	void GLTrace::endFrame() noexcept {
+		if (!mInFrame) return;
+
+		mFrameCount++;
+		mInFrame = false;
+	}
+
+	auto GLTrace::getLastFrame() const noexcept -> const Frame& {
+		const auto last = mFrameCount == 0 ? 0 : (mFrameCount - 1) % FRAME_HISTORY;
+		return mFrames[last];
+	}
+}
@@ -0,0 +1,126 @@
+﻿#pragma once
+#include "../global/base.h"
+
+namespace ff {
+
+	/// opengl调用的统一入口与统计
+	/// 1 Driver以及Renderer中所有的opengl调用都写作FF_GL(glXxx, 参数...)，绑定类的调用写作FF_GL_BIND
+	/// 2 编译时开启FF_ENABLE_GL_TRACE，每个入口(比如glBindBuffer)每帧的调用次数都会被记录，最近FRAME_HISTORY帧保存在环形缓冲当中
+	/// 3 绑定类的调用，除最后一个参数之外的参数视为绑定点(glBindTexture还要加上当前的textureUnit)，最后一个参数视为绑定的对象，
+	///   同一个绑定点连续两次绑定同一个对象，记为一次冗余绑定
+	/// 4 只统计帧之内(FF_GL_TRACE_FRAME的作用域)的调用，初始化时创建资源的调用不计入
+	/// 5 关闭时宏直接展开为原始的opengl调用，不产生任何额外代码
+	/// 注意：对象删除之后opengl会自动解除绑定，这种情况下的重新绑定也会被记为冗余
+	class GLTrace {
+	public:
+		static constexpr uint32_t FRAME_HISTORY = 256;
+
+		/// 一帧之内的调用统计，mCalls/mRedundantBinds的下标为入口编号，即每帧的调用直方图
+		struct Frame {
+			uint64_t				mFrame{ 0 };
+			uint32_t				mTotalCalls{ 0 };
+			uint32_t				mTotalRedundantBinds{ 0 };
+			std::vector<uint32_t>	mCalls{};
+			std::vector<uint32_t>	mRedundantBinds{};
+		};
+
+		static GLTrace* getInstance();
+
+		~GLTrace() noexcept;
+
+		/// \brief 注册一个opengl入口，同名的入口返回同一个编号；每个调用点只在第一次调用时注册
+		/// \param name 入口名称，比如glBindBuffer
+		/// \return 入口编号
+		auto registerEntry(const char* name) noexcept -> uint32_t;
+
+		/// \brief 记录一次调用
+		/// \param entry
+		auto onCall(uint32_t entry) noexcept -> void;
+
+		/// \brief 记录一次绑定类的调用，并检查是否冗余
+		/// \param entry
+		/// \param args 调用参数，必须都是整数
+		template<typename... Args>
+		auto onBind(uint32_t entry, Args... args) noexcept -> void {
+			const uint64_t values[] = { static_cast<uint64_t>(args)... };
+			onBindValues(entry, values, sizeof...(Args));
+		}
+
+		void beginFrame() noexcept;
+
+		void endFrame() noexcept;
+
+		auto getEntryName(uint32_t entry) const noexcept -> const std::string& { return mEntries[entry].mName; }
+
+		auto getEntryCount() const noexcept -> uint32_t { return static_cast<uint32_t>(mEntries.size()); }
+
+		/// \brief 最近一个完整结束的帧
+		/// \return
+		auto getLastFrame() const noexcept -> const Frame&;
+
+		/// \brief 环形缓冲中的所有帧，没有记录过的帧mFrame为0且直方图为空
+		/// \return
+		auto getFrames() const noexcept -> const std::vector<Frame>& { return mFrames; }
+
+	private:
+		GLTrace() noexcept;
+
+		auto onBindValues(uint32_t entry, const uint64_t* values, size_t count) noexcept -> void;
+
+	private:
+		static GLTrace* mInstance;
+
+		struct Entry {
+			std::string	mName{};
+			bool		mIsTextureBind{ false };
+			bool		mIsActiveTexture{ false };
+		};
+
+		std::vector<Entry>	mEntries{};
+		std::vector<Frame>	mFrames{};
+
+		/// 当前正在记录的帧在mFrames中的下标
+		uint32_t			mCurrent{ 0 };
+		uint64_t			mFrameCount{ 0 };
+		bool				mInFrame{ false };
+
+		/// 当前的textureUnit，以及每个绑定点最后一次绑定的对象
+		uint64_t							mActiveTexture{ GL_TEXTURE0 };
+		std::unordered_map<uint64_t, uint64_t>	mBindings{};
+	};
+
+	/// 帧统计，构造时开始一帧，析构时结束一帧
+	class GLTraceFrame {
+	public:
+		GLTraceFrame() noexcept { GLTrace::getInstance()->beginFrame(); }
+
+		~GLTraceFrame() noexcept { GLTrace::getInstance()->endFrame(); }
+	};
+}
+
+#define FF_GL_CONCAT_IMPL(a, b) a##b
+#define FF_GL_CONCAT(a, b) FF_GL_CONCAT_IMPL(a, b)
+
+#ifdef FF_ENABLE_GL_TRACE
+#define FF_GL(func, ...) \
+	([&]() { \
+		static const uint32_t ffGLEntry = ff::GLTrace::getInstance()->registerEntry(#func); \
+		ff::GLTrace::getInstance()->onCall(ffGLEntry); \
+		return func(__VA_ARGS__); \
+	}())
+
+/// 参数会被求值两次，只能传入没有副作用的表达式
+#define FF_GL_BIND(func, ...) \
+	([&]() { \
+		static const uint32_t ffGLEntry = ff::GLTrace::getInstance()->registerEntry(#func); \
+		ff::GLTrace::getInstance()->onCall(ffGLEntry); \
+		ff::GLTrace::getInstance()->onBind(ffGLEntry, __VA_ARGS__); \
+		return func(__VA_ARGS__); \
+	}())
+
+#define FF_GL_TRACE_FRAME() ff::GLTraceFrame FF_GL_CONCAT(ffGLTraceFrame, __LINE__)
+#else
+#define FF_GL(func, ...) func(__VA_ARGS__)
+#define FF_GL_BIND(func, ...) func(__VA_ARGS__)
+#define FF_GL_TRACE_FRAME()
+#endif
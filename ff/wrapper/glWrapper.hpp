@@ -1,5 +1,6 @@
 ﻿#pragma once
 #include "../global/base.h"
+#include "glTrace.h"
 
 namespace ff
 {
@@ -10,7 +11,7 @@ namespace ff
 			GLenum errorCode;
 			bool needsAssert = false;
 			std::string error;
-			while ((errorCode = glGetError()) != GL_NO_ERROR)
+			while ((errorCode = FF_GL(glGetError)) != GL_NO_ERROR)
 			{
 				needsAssert = true;
 				switch (errorCode)
@@ -38,31 +39,31 @@ namespace ff
 		/// state
 		static auto enable(GLenum cap) -> void
 		{
-			glEnable(cap);
+			FF_GL(glEnable, cap);
 			checkError();
 		}
 
 		static auto disable(GLenum cap) -> void
 		{
-			glDisable(cap);
+			FF_GL(glDisable, cap);
 			checkError();
 		}
 
 		static auto clearColor(GLfloat r, GLfloat g, GLfloat b, GLfloat a) -> void
 		{
-			glClearColor(r, g, b, a);
+			FF_GL(glClearColor, r, g, b, a);
 			checkError();
 		}
 
 		static auto uniform1iv(GLint location, GLsizei size, GLint* value) -> void
 		{
-			glUniform1iv(location, size, value);
+			FF_GL(glUniform1iv, location, size, value);
 			checkError();
 		}
 
 		static auto uniform1i(GLint location, GLint value) -> void
 		{
-			glUniform1i(location, value);
+			FF_GL(glUniform1i, location, value);
 			checkError();
 		}
 
@@ -74,32 +75,32 @@ namespace ff
 			GLenum srcAlpha,
 			GLenum dstAlpha) -> void
 		{
-			glBlendFuncSeparate(srcRGB, dstRGB, srcAlpha, dstAlpha);
+			FF_GL(glBlendFuncSeparate, srcRGB, dstRGB, srcAlpha, dstAlpha);
 			checkError();
 		}
 
 		static auto blendEquationSeparate(GLenum modeRGB, GLenum modeAlpha) -> void
 		{
-			glBlendEquationSeparate(modeRGB, modeAlpha);
+			FF_GL(glBlendEquationSeparate, modeRGB, modeAlpha);
 			checkError();
 		}
 
 		/// depth
 		static auto depthMask(GLboolean flag) -> void
 		{
-			glDepthMask(flag);
+			FF_GL(glDepthMask, flag);
 			checkError();
 		}
 
 		static auto depthFunc(GLenum func) -> void
 		{
-			glDepthFunc(func);
+			FF_GL(glDepthFunc, func);
 			checkError();
 		}
 
 		static auto clearDepth(GLdouble depth) -> void
 		{
-			glClearDepth(depth);
+			FF_GL(glClearDepth, depth);
 			checkError();
 		}
 	}